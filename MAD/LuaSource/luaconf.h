@@ -794,6 +794,16 @@
 ** without modifying the main part of the file.
 */
 
+/*
+@@ luai_makeseed (MAD) uses a fixed seed for string hashes, so that table
+** traversal order (e.g. 'pairs' over string keys) is the same on every
+** run and replays stay reproducible. Define MAD_LUA_RANDOM_HASH_SEED to
+** get back the default seed randomized by time and address.
+*/
+#if !defined(MAD_LUA_RANDOM_HASH_SEED)
+#define luai_makeseed(L)	((unsigned int)0x4D414421u)
+#endif
+
 
 
 
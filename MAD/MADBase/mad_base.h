@@ -17,5 +17,10 @@
 #include "mad_debugger.h"
 #include "mad_array.h"
 #include "mad_math.h"
+#include "mad_simd.h"
+#include "mad_job.h"
+#include "mad_blob.h"
+#include "mad_fixed.h"
+#include "mad_strict_math.h"
 
 
@@ -0,0 +1,142 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+/*Arrays in a blob start at multiples of this many bytes*/
+#define MAD_BLOB_ALIGN 8
+
+/// <summary>
+/// 把数值与连续数组按内存映像追加到字节缓冲区末尾,用于状态快照.
+/// 每个数组先写入元素数量与占用的元素空间,再整体复制元素,并补零到占用空间末尾、对齐到MAD_BLOB_ALIGN字节.
+/// 长度经常变化的数组可以按较粗的粒度预留空间(_reserve),这样长度的小幅变化不会让之后的数据整体错位,
+/// 相邻两份快照可以直接逐字节做差分.
+/// 注意:数据按本机字节序与结构体布局写入,只能由同一平台的同一版本读取!
+/// </summary>
+class MADBlobWriter
+{
+public:
+	explicit MADBlobWriter(std::vector<unsigned char>& io_data) : Data(io_data) {
+	}
+
+public:
+	template <class T>
+	void Write(const T& _value) {
+		static_assert(std::is_trivially_copyable<T>::value, "Blob values must be trivially copyable");
+		Append(&_value, sizeof(T));
+	}
+
+	template <class T>
+	void WriteArray(const T* _data, size_t _num, size_t _reserve = 0) {
+		static_assert(std::is_trivially_copyable<T>::value, "Blob arrays must be trivially copyable");
+		unsigned long long l_num[2] = { _num, _reserve > _num ? _reserve : _num };
+		Append(l_num, sizeof(l_num));
+		Append(_data, _num * sizeof(T));
+		size_t l_end = Data.size() + static_cast<size_t>(l_num[1] - l_num[0]) * sizeof(T);
+		Data.resize((l_end + MAD_BLOB_ALIGN - 1) / MAD_BLOB_ALIGN * MAD_BLOB_ALIGN, 0);
+	}
+
+	template <class T>
+	void WriteArray(const std::vector<T>& _array, size_t _reserve = 0) {
+		WriteArray(_array.data(), _array.size(), _reserve);
+	}
+
+	size_t GetSize() const {
+		return Data.size();
+	}
+
+private:
+	std::vector<unsigned char>& Data;
+
+	void Append(const void* _data, size_t _bytes) {
+		if (_bytes == 0)
+		{
+			return;
+		}
+		size_t l_offset = Data.size();
+		Data.resize(l_offset + _bytes);
+		std::memcpy(Data.data() + l_offset, _data, _bytes);
+	}
+};
+
+/// <summary>
+/// 按MADBlobWriter的格式依次读出数值与数组.
+/// 读取越界后所有读取都会失败并保持失败状态,调用者只需在最后检查一次IsFailed.
+/// 读取数组时复用目标数组已有的容量,恢复快照的稳定状态下不会分配内存.
+/// </summary>
+class MADBlobReader
+{
+public:
+	MADBlobReader(const unsigned char* _data, size_t _size) {
+		Data = _data;
+		Size = _data != nullptr ? _size : 0;
+		Offset = 0;
+		Failed = false;
+	}
+
+public:
+	template <class T>
+	bool Read(T* out_value) {
+		static_assert(std::is_trivially_copyable<T>::value, "Blob values must be trivially copyable");
+		return Take(out_value, sizeof(T));
+	}
+
+	template <class T>
+	bool ReadArray(std::vector<T>& out_array) {
+		static_assert(std::is_trivially_copyable<T>::value, "Blob arrays must be trivially copyable");
+		unsigned long long l_num[2] = { 0, 0 };
+		if (!Take(l_num, sizeof(l_num)) || l_num[0] > l_num[1] || l_num[1] > (Size - Offset) / sizeof(T))
+		{
+			Failed = true;
+			return false;
+		}
+		out_array.resize(static_cast<size_t>(l_num[0]));
+		if (!Take(out_array.data(), out_array.size() * sizeof(T)))
+		{
+			return false;
+		}
+		size_t l_end = Offset + static_cast<size_t>(l_num[1] - l_num[0]) * sizeof(T);
+		size_t l_aligned = (l_end + MAD_BLOB_ALIGN - 1) / MAD_BLOB_ALIGN * MAD_BLOB_ALIGN;
+		Offset = l_aligned < Size ? l_aligned : Size;
+		return true;
+	}
+
+	bool IsFailed() const {
+		return Failed;
+	}
+
+	size_t GetOffset() const {
+		return Offset;
+	}
+
+	size_t GetRemaining() const {
+		return Size - Offset;
+	}
+
+private:
+	const unsigned char* Data;
+	size_t Size;
+	size_t Offset;
+	bool Failed;
+
+	bool Take(void* out_data, size_t _bytes) {
+		if (Failed || _bytes > Size - Offset)
+		{
+			Failed = true;
+			return false;
+		}
+		if (_bytes != 0)
+		{
+			std::memcpy(out_data, Data + Offset, _bytes);
+		}
+		Offset += _bytes;
+		return true;
+	}
+};
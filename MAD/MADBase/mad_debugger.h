@@ -185,6 +185,8 @@ private:
 #define MAD_RESCODE_ILLEGAL_CALL 3
 #define MAD_RESCODE_FUNC_NOT_FOUND 4
 #define MAD_RESCODE_FUNC_FAILED 5
+#define MAD_RESCODE_BAD_DATA 6
+#define MAD_RESCODE_FILE_ERROR 7
 
 #define MAD_IS_OK(res) res == 0
 
@@ -0,0 +1,159 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <cmath>
+
+/*Fraction bits of a 16.16 fixed-point coordinate*/
+#define MAD_FIXED_SHIFT 16
+
+/*Fraction bits of an 8.8 fixed-point speed (units per tick)*/
+#define MAD_FIXED_SPEED_SHIFT 8
+
+/*Fraction bits of the cosine and sine in the angle table*/
+#define MAD_FIXED_TRIG_SHIFT 14
+
+/*Shift from speed * trig (8.22) to a 16.16 step*/
+#define MAD_FIXED_STEP_SHIFT (MAD_FIXED_SPEED_SHIFT + MAD_FIXED_TRIG_SHIFT - MAD_FIXED_SHIFT)
+
+/*Angle table resolution,a 16-bit angle is looked up by its top bits*/
+#define MAD_FIXED_ANGLE_TABLE_BITS 12
+#define MAD_FIXED_ANGLE_TABLE_SIZE (1 << MAD_FIXED_ANGLE_TABLE_BITS)
+
+/// <summary>
+/// 定点数工具类,供定点子弹池(MADFixedBulletPool)使用.
+/// - 坐标为16.16定点数(int),表示范围为±32768个单位,精度为1/65536;
+/// - 方向为16位角度索引(unsigned short),65536为一整圈,0为+X方向,16384为+Y方向;
+/// - 速率为8.8定点数(short),单位为每tick移动的单位数.
+/// 角度表只由整数运算生成,不调用任何数学库函数,因此在所有编译器与平台上逐位一致.
+/// 与浮点数之间的转换只应在输入与输出时进行,模拟过程中只使用整数运算.
+/// </summary>
+class MADFixed
+{
+public:
+	MADFixed() = delete;
+
+public:
+	/// <summary>
+	/// 将浮点数四舍五入为16.16定点数
+	/// </summary>
+	/// <param name="_value">浮点数,超出表示范围时结果无意义</param>
+	/// <returns>定点数</returns>
+	static int FromFloat(float _value) {
+		return static_cast<int>(std::floor(_value * 65536.0f + 0.5f));
+	}
+
+	/// <summary>
+	/// 将16.16定点数转换为浮点数
+	/// </summary>
+	/// <param name="_value">定点数</param>
+	/// <returns>浮点数</returns>
+	static float ToFloat(int _value) {
+		return static_cast<float>(_value) * (1.0f / 65536.0f);
+	}
+
+	/// <summary>
+	/// 将弧度转换为16位角度索引,任意弧度都会被折回一整圈之内
+	/// </summary>
+	/// <param name="_radians">弧度</param>
+	/// <returns>角度索引</returns>
+	static unsigned short AngleFromRadians(float _radians) {
+		long long l_angle = static_cast<long long>(std::floor(_radians * 10430.378350470453f + 0.5f));
+		return static_cast<unsigned short>(l_angle & 0xFFFF);
+	}
+
+	/// <summary>
+	/// 将16位角度索引转换为弧度,范围为[0, 2pi)
+	/// </summary>
+	/// <param name="_angle">角度索引</param>
+	/// <returns>弧度</returns>
+	static float AngleToRadians(unsigned short _angle) {
+		return static_cast<float>(_angle) * (6.283185307179586f / 65536.0f);
+	}
+
+	/// <summary>
+	/// 将每tick移动的单位数转换为8.8定点速率,负数与过大的值会被钳制到[0, 127.99]
+	/// </summary>
+	/// <param name="_units_per_tick">每tick移动的单位数</param>
+	/// <returns>定点速率</returns>
+	static short SpeedFromFloat(float _units_per_tick) {
+		float l_speed = std::floor(_units_per_tick * 256.0f + 0.5f);
+		l_speed = l_speed > 0.0f ? l_speed : 0.0f;
+		l_speed = l_speed < 32767.0f ? l_speed : 32767.0f;
+		return static_cast<short>(l_speed);
+	}
+
+	/// <summary>
+	/// 获取角度表,第i项的低16位为cos、高16位为sin(均为有符号2.14定点数),
+	/// 对应角度索引 i << (16 - MAD_FIXED_ANGLE_TABLE_BITS)
+	/// </summary>
+	/// <returns>MAD_FIXED_ANGLE_TABLE_SIZE项的角度表</returns>
+	static const unsigned int* GetCosSinTable() {
+		static const CosSinTable table = BuildTable();
+		return table.Data;
+	}
+
+	/// <summary>
+	/// 计算一颗子弹每tick的16.16位移,与定点积分内核的结果逐位一致
+	/// </summary>
+	/// <param name="_angle">角度索引</param>
+	/// <param name="_speed">8.8定点速率</param>
+	/// <param name="out_step_x">X方向位移</param>
+	/// <param name="out_step_y">Y方向位移</param>
+	static void GetStep(unsigned short _angle, short _speed, int* out_step_x, int* out_step_y) {
+		unsigned int l_cos_sin = GetCosSinTable()[_angle >> (16 - MAD_FIXED_ANGLE_TABLE_BITS)];
+		int l_cos = static_cast<short>(l_cos_sin & 0xFFFF);
+		int l_sin = static_cast<short>(l_cos_sin >> 16);
+		*out_step_x = (_speed * l_cos) >> MAD_FIXED_STEP_SHIFT;
+		*out_step_y = (_speed * l_sin) >> MAD_FIXED_STEP_SHIFT;
+	}
+
+private:
+	struct CosSinTable {
+		unsigned int Data[MAD_FIXED_ANGLE_TABLE_SIZE];
+	};
+
+	/// <summary>
+	/// 以2.30定点数的泰勒级数计算四分之一圆周上第 _step 个采样点的正弦,返回2.14定点数
+	/// </summary>
+	static int QuarterSine(int _step, int _steps) {
+		const long long l_one = 1ll << 30;
+		/*pi/2 in 2.30*/
+		long long l_x = (1686629713ll * _step + _steps / 2) / _steps;
+		long long l_term = l_x;
+		long long l_sum = l_x;
+		for (long long k = 1; k <= 7; ++k)
+		{
+			l_term = -(l_term * l_x / l_one) * l_x / l_one / ((2 * k) * (2 * k + 1));
+			l_sum += l_term;
+		}
+		return static_cast<int>((l_sum + (1ll << 15)) >> 16);
+	}
+
+	static CosSinTable BuildTable() {
+		const int l_quarter = MAD_FIXED_ANGLE_TABLE_SIZE / 4;
+		int l_sine[MAD_FIXED_ANGLE_TABLE_SIZE];
+		for (int i = 0; i < MAD_FIXED_ANGLE_TABLE_SIZE; ++i)
+		{
+			int l_step = i % l_quarter;
+			switch (i / l_quarter)
+			{
+			case 0: l_sine[i] = QuarterSine(l_step, l_quarter); break;
+			case 1: l_sine[i] = QuarterSine(l_quarter - l_step, l_quarter); break;
+			case 2: l_sine[i] = -QuarterSine(l_step, l_quarter); break;
+			default: l_sine[i] = -QuarterSine(l_quarter - l_step, l_quarter); break;
+			}
+		}
+		CosSinTable l_table;
+		for (int i = 0; i < MAD_FIXED_ANGLE_TABLE_SIZE; ++i)
+		{
+			int l_cos = l_sine[(i + l_quarter) % MAD_FIXED_ANGLE_TABLE_SIZE];
+			l_table.Data[i] = static_cast<unsigned int>(l_cos & 0xFFFF) | (static_cast<unsigned int>(l_sine[i] & 0xFFFF) << 16);
+		}
+		return l_table;
+	}
+};
@@ -0,0 +1,22 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+/*
+ * Include this header ONLY in .cpp files that run simulation math.
+ * It keeps every multiply and add rounded separately (no FMA contraction),
+ * so results do not depend on compiler, optimization level or /arch flags.
+ * Do NOT include it from other headers, the pragma leaks into the includer.
+ */
+
+#pragma once
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
@@ -0,0 +1,272 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// 区间任务函数,参数依次为区间起点、区间终点(不包含)与分块序号
+/// </summary>
+typedef std::function<void(size_t, size_t, size_t)> MADJobRangeFunc;
+
+/// <summary>
+/// 工作窃取(work-stealing)任务调度器.
+/// 每个线程拥有自己的双端队列,从队首取自己最近放入的任务,空闲时从其他线程队列的队尾窃取最早放入的任务.
+/// 调用ParallelFor的线程同样参与执行,因此在任务内部嵌套调用ParallelFor不会死锁.
+///
+/// 确定性:区间只按 _grain 切分,与线程数无关.只要每个分块写入互不相交的位置,
+/// 或按分块序号保存中间结果再按序合并,结果就与线程数无关.
+/// </summary>
+class MADJobSystem
+{
+private:
+	struct JobTask {
+		const MADJobRangeFunc* Func;
+		size_t Begin;
+		size_t End;
+		size_t Chunk;
+		std::atomic<size_t>* Remaining;
+	};
+	struct WorkerQueue {
+		std::mutex Lock;
+		std::deque<JobTask> Tasks;
+	};
+
+public:
+	MADJobSystem(const MADJobSystem&) = delete;
+	MADJobSystem& operator=(const MADJobSystem&) = delete;
+
+	/// <summary>
+	/// 创建调度器并启动后台线程
+	/// </summary>
+	/// <param name="_thread_num">参与计算的线程总数(包括调用者),为0时使用CPU核心数</param>
+	explicit MADJobSystem(unsigned int _thread_num = 0) {
+		if (_thread_num == 0)
+		{
+			_thread_num = std::thread::hardware_concurrency();
+		}
+		if (_thread_num == 0)
+		{
+			_thread_num = 1;
+		}
+		Stop = false;
+		Pending = 0;
+		for (unsigned int i = 0; i < _thread_num; ++i)
+		{
+			Queues.emplace_back(new WorkerQueue());
+		}
+		for (unsigned int i = 1; i < _thread_num; ++i)
+		{
+			Threads.emplace_back(&MADJobSystem::WorkerLoop, this, i);
+		}
+	}
+
+	~MADJobSystem() {
+		{
+			std::lock_guard<std::mutex> l_lock(SleepLock);
+			Stop = true;
+		}
+		SleepCond.notify_all();
+		for (std::thread& l_thread : Threads)
+		{
+			l_thread.join();
+		}
+	}
+
+	/// <summary>
+	/// 获取参与计算的线程总数(包括调用者)
+	/// </summary>
+	/// <returns>线程数</returns>
+	unsigned int GetThreadNum() const {
+		return static_cast<unsigned int>(Queues.size());
+	}
+
+	/// <summary>
+	/// 获取 _num 个元素按 _grain 切分后的分块数量
+	/// </summary>
+	/// <param name="_num">元素数量</param>
+	/// <param name="_grain">每块的元素数量</param>
+	/// <returns>分块数量</returns>
+	static size_t GetChunkNum(size_t _num, size_t _grain) {
+		if (_grain == 0)
+		{
+			_grain = 1;
+		}
+		return (_num + _grain - 1) / _grain;
+	}
+
+	/// <summary>
+	/// 若 _jobs 不为空则调用其ParallelFor,否则在当前线程按相同的分块顺序依次执行.
+	/// 便于让同一段代码同时支持单线程与多线程.
+	/// </summary>
+	/// <param name="_jobs">任务调度器,可以为nullptr</param>
+	/// <param name="_num">元素数量</param>
+	/// <param name="_grain">每块的元素数量</param>
+	/// <param name="_func">分块任务</param>
+	static void Dispatch(MADJobSystem* _jobs, size_t _num, size_t _grain, const MADJobRangeFunc& _func) {
+		if (_jobs != nullptr)
+		{
+			_jobs->ParallelFor(_num, _grain, _func);
+			return;
+		}
+		if (_grain == 0)
+		{
+			_grain = 1;
+		}
+		size_t l_chunk_num = GetChunkNum(_num, _grain);
+		for (size_t c = 0; c < l_chunk_num; ++c)
+		{
+			size_t l_begin = c * _grain;
+			size_t l_end = l_begin + _grain < _num ? l_begin + _grain : _num;
+			_func(l_begin, l_end, c);
+		}
+	}
+
+	/// <summary>
+	/// 将[0, _num)按 _grain 切分为若干分块并行执行,所有分块完成后返回.
+	/// 第k个分块为[k * _grain, min((k + 1) * _grain, _num)).
+	/// </summary>
+	/// <param name="_num">元素数量</param>
+	/// <param name="_grain">每块的元素数量</param>
+	/// <param name="_func">分块任务</param>
+	void ParallelFor(size_t _num, size_t _grain, const MADJobRangeFunc& _func) {
+		if (_grain == 0)
+		{
+			_grain = 1;
+		}
+		size_t l_chunk_num = GetChunkNum(_num, _grain);
+		if (l_chunk_num == 0)
+		{
+			return;
+		}
+		if (l_chunk_num == 1 || Queues.size() == 1)
+		{
+			Dispatch(nullptr, _num, _grain, _func);
+			return;
+		}
+
+		std::atomic<size_t> l_remaining(l_chunk_num);
+		size_t l_self = GetSelfIndex();
+		{
+			std::lock_guard<std::mutex> l_lock(SleepLock);
+			Pending.fetch_add(l_chunk_num);
+		}
+
+		/*Deal chunks round-robin so every worker starts with local work*/
+		for (size_t c = 0; c < l_chunk_num; ++c)
+		{
+			JobTask l_task;
+			l_task.Func = &_func;
+			l_task.Begin = c * _grain;
+			l_task.End = l_task.Begin + _grain < _num ? l_task.Begin + _grain : _num;
+			l_task.Chunk = c;
+			l_task.Remaining = &l_remaining;
+			WorkerQueue& l_queue = *Queues[(l_self + c) % Queues.size()];
+			std::lock_guard<std::mutex> l_lock(l_queue.Lock);
+			l_queue.Tasks.push_front(l_task);
+		}
+		SleepCond.notify_all();
+
+		/*Help until every chunk of this call has finished*/
+		while (l_remaining.load(std::memory_order_acquire) > 0)
+		{
+			JobTask l_task;
+			if (TryTake(l_self, &l_task))
+			{
+				Run(l_task);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+private:
+	std::vector<std::unique_ptr<WorkerQueue>> Queues;
+	std::vector<std::thread> Threads;
+	std::atomic<size_t> Pending;
+	std::mutex SleepLock;
+	std::condition_variable SleepCond;
+	bool Stop;
+
+private:
+	static MADJobSystem*& CurrentOwner() {
+		static thread_local MADJobSystem* owner = nullptr;
+		return owner;
+	}
+
+	static size_t& CurrentIndex() {
+		static thread_local size_t index = 0;
+		return index;
+	}
+
+	size_t GetSelfIndex() const {
+		return CurrentOwner() == this ? CurrentIndex() : 0;
+	}
+
+	void WorkerLoop(size_t _index) {
+		CurrentOwner() = this;
+		CurrentIndex() = _index;
+		while (true)
+		{
+			JobTask l_task;
+			if (TryTake(_index, &l_task))
+			{
+				Run(l_task);
+				continue;
+			}
+			std::unique_lock<std::mutex> l_lock(SleepLock);
+			SleepCond.wait(l_lock, [this] { return Stop || Pending.load() > 0; });
+			if (Stop)
+			{
+				return;
+			}
+		}
+	}
+
+	/// <summary>
+	/// 先从自己队列的队首(最近放入)取任务,失败后依次从其他队列的队尾窃取
+	/// </summary>
+	bool TryTake(size_t _self, JobTask* out_task) {
+		size_t l_num = Queues.size();
+		for (size_t i = 0; i < l_num; ++i)
+		{
+			WorkerQueue& l_queue = *Queues[(_self + i) % l_num];
+			std::lock_guard<std::mutex> l_lock(l_queue.Lock);
+			if (l_queue.Tasks.empty())
+			{
+				continue;
+			}
+			if (i == 0)
+			{
+				*out_task = l_queue.Tasks.front();
+				l_queue.Tasks.pop_front();
+			}
+			else
+			{
+				*out_task = l_queue.Tasks.back();
+				l_queue.Tasks.pop_back();
+			}
+			Pending.fetch_sub(1);
+			return true;
+		}
+		return false;
+	}
+
+	static void Run(const JobTask& _task) {
+		(*_task.Func)(_task.Begin, _task.End, _task.Chunk);
+		_task.Remaining->fetch_sub(1, std::memory_order_release);
+	}
+};
@@ -0,0 +1,148 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+/*Platform detect*/
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MAD_SIMD_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+#endif
+
+/*Per-function instruction set, MSVC accepts intrinsics without it*/
+#if defined(MAD_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MAD_TARGET_SSE2 __attribute__((target("sse2")))
+#define MAD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MAD_TARGET_SSE2
+#define MAD_TARGET_AVX2
+#endif
+
+/// <summary>
+/// SIMD指令集等级,等级越高可用的指令越宽
+/// </summary>
+enum class MADSimdLevel
+{
+	/// <summary>
+	/// 标量
+	/// </summary>
+	Scalar = 0,
+	/// <summary>
+	/// 128位SSE2
+	/// </summary>
+	SSE2 = 1,
+	/// <summary>
+	/// 256位AVX2
+	/// </summary>
+	AVX2 = 2
+};
+
+/// <summary>
+/// 静态SIMD调度类,
+/// 运行时检测CPU支持的指令集,供各计算内核选择执行路径.
+/// 所有路径的计算结果保证逐位一致,因此可以随时通过SetLevelLimit降级.
+/// </summary>
+class MADSimd
+{
+public:
+	MADSimd(const MADSimd&) = delete;
+	MADSimd& operator=(const MADSimd&) = delete;
+
+public:
+	/// <summary>
+	/// 获取当前生效的指令集等级(CPU支持等级与限制等级中的较小者)
+	/// </summary>
+	/// <returns>指令集等级</returns>
+	static MADSimdLevel GetLevel() {
+		MADSimdLevel l_detected = GetDetectedLevel();
+		MADSimdLevel l_limit = GetLimit();
+		return l_detected < l_limit ? l_detected : l_limit;
+	}
+
+	/// <summary>
+	/// 获取CPU实际支持的指令集等级,只在首次调用时检测一次
+	/// </summary>
+	/// <returns>指令集等级</returns>
+	static MADSimdLevel GetDetectedLevel() {
+		static MADSimdLevel level = Detect();
+		return level;
+	}
+
+	/// <summary>
+	/// 限制可使用的最高指令集等级,用于调试或逐位比对各路径的结果
+	/// </summary>
+	/// <param name="_limit">最高等级</param>
+	static void SetLevelLimit(MADSimdLevel _limit) {
+		GetLimit() = _limit;
+	}
+
+private:
+	static MADSimdLevel& GetLimit() {
+		static MADSimdLevel limit = MADSimdLevel::AVX2;
+		return limit;
+	}
+
+	static MADSimdLevel Detect() {
+#if defined(MAD_SIMD_X86)
+		unsigned int l_regs[4] = { 0, 0, 0, 0 };
+		CpuId(0, l_regs);
+		unsigned int l_max_leaf = l_regs[0];
+
+		CpuId(1, l_regs);
+		bool l_sse2 = (l_regs[3] & (1u << 26)) != 0;
+		bool l_osxsave = (l_regs[2] & (1u << 27)) != 0;
+		bool l_avx = (l_regs[2] & (1u << 28)) != 0;
+		if (!l_sse2)
+		{
+			return MADSimdLevel::Scalar;
+		}
+		if (!l_osxsave || !l_avx || l_max_leaf < 7 || (ReadXcr0() & 0x6) != 0x6)
+		{
+			return MADSimdLevel::SSE2;
+		}
+
+		CpuId(7, l_regs);
+		bool l_avx2 = (l_regs[1] & (1u << 5)) != 0;
+		return l_avx2 ? MADSimdLevel::AVX2 : MADSimdLevel::SSE2;
+#else
+		return MADSimdLevel::Scalar;
+#endif
+	}
+
+#if defined(MAD_SIMD_X86)
+	static void CpuId(unsigned int _leaf, unsigned int* out_regs) {
+#if defined(_MSC_VER)
+		int l_regs[4];
+		__cpuidex(l_regs, static_cast<int>(_leaf), 0);
+		for (int i = 0; i < 4; ++i)
+		{
+			out_regs[i] = static_cast<unsigned int>(l_regs[i]);
+		}
+#else
+		__cpuid_count(_leaf, 0, out_regs[0], out_regs[1], out_regs[2], out_regs[3]);
+#endif
+	}
+
+	static unsigned long long ReadXcr0() {
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		unsigned int l_eax, l_edx;
+		__asm__ volatile("xgetbv" : "=a"(l_eax), "=d"(l_edx) : "c"(0));
+		return (static_cast<unsigned long long>(l_edx) << 32) | l_eax;
+#endif
+	}
+#endif
+
+private:
+	MADSimd() {/*Do NOT instantiation this class*/ };
+	~MADSimd() {/*Do NOT instantiation this class*/ };
+};
@@ -0,0 +1,211 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_strict_math.h"
+#include "mad_fp_strict.h"
+
+#include <cmath>
+
+/*pi/2 split into three parts,the first one has 33 significant bits so n * part is exact for |n| < 2^20*/
+#define MAD_STRICT_PIO2_1 1.57079632673412561417e+00
+#define MAD_STRICT_PIO2_2 6.07710050630396597660e-11
+#define MAD_STRICT_PIO2_3 2.02226624871116645580e-21
+#define MAD_STRICT_INV_PIO2 6.36619772367581382433e-01
+
+#define MAD_STRICT_PI 3.14159265358979311600e+00
+#define MAD_STRICT_PI_LO 1.22464679914735317720e-16
+
+/**
+ * (内部函数)
+ * 把弧度折叠到 [-pi/4, pi/4],返回象限序号(模4)。
+ */
+static int ReduceAngle(double _radians, double* out_reduced)
+{
+	double l_n = std::floor(_radians * MAD_STRICT_INV_PIO2 + 0.5);
+	double l_r = _radians - l_n * MAD_STRICT_PIO2_1;
+	l_r = l_r - l_n * MAD_STRICT_PIO2_2;
+	l_r = l_r - l_n * MAD_STRICT_PIO2_3;
+	*out_reduced = l_r;
+	return static_cast<int>(static_cast<long long>(l_n) & 3);
+}
+
+/**
+ * (内部函数)
+ * [-pi/4, pi/4] 上的正弦多项式(fdlibm __kernel_sin)。
+ */
+static double KernelSin(double _x)
+{
+	double l_z = _x * _x;
+	double l_poly = -1.66666666666666324348e-01 + l_z * (8.33333333332248946124e-03 + l_z * (-1.98412698298579493134e-04 +
+		l_z * (2.75573137070700676789e-06 + l_z * (-2.50507602534068634195e-08 + l_z * 1.58969099521155010221e-10))));
+	return _x + _x * (l_z * l_poly);
+}
+
+/**
+ * (内部函数)
+ * [-pi/4, pi/4] 上的余弦多项式(fdlibm __kernel_cos)。
+ */
+static double KernelCos(double _x)
+{
+	double l_z = _x * _x;
+	double l_poly = 4.16666666666666019037e-02 + l_z * (-1.38888888888741095749e-03 + l_z * (2.48015872894767294178e-05 +
+		l_z * (-2.75573143513906633035e-07 + l_z * (2.08757232129817482790e-09 + l_z * -1.13596475577881948265e-11))));
+	return (1.0 - 0.5 * l_z) + l_z * l_z * l_poly;
+}
+
+/**
+ * (内部函数)
+ * 双精度反正切(fdlibm s_atan)。
+ */
+static double Atan(double _x)
+{
+	static const double l_atan_hi[4] = {
+		4.63647609000806093515e-01, 7.85398163397448278999e-01, 9.82793723247329054082e-01, 1.57079632679489655800e+00 };
+	static const double l_atan_lo[4] = {
+		2.26987774529616870924e-17, 3.06161699786838301793e-17, 1.39033110312309984516e-17, 6.12323399573676603587e-17 };
+
+	bool l_negative = _x < 0.0;
+	double l_x = l_negative ? -_x : _x;
+	int l_id = -1;
+	if (l_x >= 7.378697629483821e+19)
+	{
+		double l_result = l_atan_hi[3] + l_atan_lo[3];
+		return l_negative ? -l_result : l_result;
+	}
+	if (l_x >= 0.4375)
+	{
+		if (l_x < 1.1875)
+		{
+			if (l_x < 0.6875)
+			{
+				l_id = 0;
+				l_x = (2.0 * l_x - 1.0) / (2.0 + l_x);
+			}
+			else
+			{
+				l_id = 1;
+				l_x = (l_x - 1.0) / (l_x + 1.0);
+			}
+		}
+		else
+		{
+			if (l_x < 2.4375)
+			{
+				l_id = 2;
+				l_x = (l_x - 1.5) / (1.0 + 1.5 * l_x);
+			}
+			else
+			{
+				l_id = 3;
+				l_x = -1.0 / l_x;
+			}
+		}
+	}
+	else if (l_x < 7.450580596923828e-09)
+	{
+		return _x;
+	}
+
+	double l_z = l_x * l_x;
+	double l_w = l_z * l_z;
+	double l_s1 = l_z * (3.33333333333329318027e-01 + l_w * (1.42857142725034663711e-01 + l_w * (9.09088713343650656196e-02 +
+		l_w * (6.66107313738753120669e-02 + l_w * (4.97687799461593236017e-02 + l_w * 1.62858201153657823623e-02)))));
+	double l_s2 = l_w * (-1.99999999998764832476e-01 + l_w * (-1.11111104054623557880e-01 + l_w * (-7.69187620504482999495e-02 +
+		l_w * (-5.83357013379057348645e-02 + l_w * -3.65315727442169155270e-02))));
+	if (l_id < 0)
+	{
+		double l_result = l_x - l_x * (l_s1 + l_s2);
+		return l_negative ? -l_result : l_result;
+	}
+	double l_result = l_atan_hi[l_id] - ((l_x * (l_s1 + l_s2) - l_atan_lo[l_id]) - l_x);
+	return l_negative ? -l_result : l_result;
+}
+
+float MADStrictMath::Sin(float _radians)
+{
+	float l_sin, l_cos;
+	SinCos(_radians, &l_sin, &l_cos);
+	return l_sin;
+}
+
+float MADStrictMath::Cos(float _radians)
+{
+	float l_sin, l_cos;
+	SinCos(_radians, &l_sin, &l_cos);
+	return l_cos;
+}
+
+void MADStrictMath::SinCos(float _radians, float* out_sin, float* out_cos)
+{
+	if (!(_radians - _radians == 0.0f))
+	{
+		*out_sin = _radians - _radians;
+		*out_cos = *out_sin;
+		return;
+	}
+	double l_r;
+	int l_quadrant = ReduceAngle(_radians, &l_r);
+	double l_sin = KernelSin(l_r);
+	double l_cos = KernelCos(l_r);
+	switch (l_quadrant)
+	{
+	case 0:
+		*out_sin = static_cast<float>(l_sin);
+		*out_cos = static_cast<float>(l_cos);
+		break;
+	case 1:
+		*out_sin = static_cast<float>(l_cos);
+		*out_cos = static_cast<float>(-l_sin);
+		break;
+	case 2:
+		*out_sin = static_cast<float>(-l_sin);
+		*out_cos = static_cast<float>(-l_cos);
+		break;
+	default:
+		*out_sin = static_cast<float>(-l_cos);
+		*out_cos = static_cast<float>(l_sin);
+		break;
+	}
+}
+
+float MADStrictMath::Atan2(float _y, float _x)
+{
+	if (_x != _x || _y != _y)
+	{
+		return _x + _y;
+	}
+	double l_y = _y;
+	double l_x = _x;
+	bool l_y_negative = std::signbit(_y);
+	bool l_x_negative = std::signbit(_x);
+	double l_result;
+	if (_y == 0.0f)
+	{
+		/*atan2(±0, +x) = ±0,atan2(±0, -x) = ±pi*/
+		l_result = l_x_negative ? MAD_STRICT_PI + MAD_STRICT_PI_LO : 0.0;
+	}
+	else if (_x == 0.0f)
+	{
+		l_result = 0.5 * MAD_STRICT_PI + 0.5 * MAD_STRICT_PI_LO;
+	}
+	else if (std::isinf(_x) && std::isinf(_y))
+	{
+		l_result = l_x_negative ? 0.75 * MAD_STRICT_PI + 0.75 * MAD_STRICT_PI_LO : 0.25 * MAD_STRICT_PI + 0.25 * MAD_STRICT_PI_LO;
+	}
+	else
+	{
+		/*Both signs are folded away,the quotient only decides the angle within the half plane*/
+		double l_angle = Atan((l_y < 0.0 ? -l_y : l_y) / (l_x < 0.0 ? -l_x : l_x));
+		l_result = l_x_negative ? (MAD_STRICT_PI - l_angle) + MAD_STRICT_PI_LO : l_angle;
+	}
+	float l_float = static_cast<float>(l_result);
+	return l_y_negative ? -l_float : l_float;
+}
+
+float MADStrictMath::Fmod(float _x, float _y)
+{
+	return std::fmod(_x, _y);
+}
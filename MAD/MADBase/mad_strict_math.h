@@ -0,0 +1,59 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+/// <summary>
+/// 确定性数学函数类,供需要逐位复现的模拟代码使用.
+/// 各平台C运行库的sin、cos、atan2实现不同,结果可能相差最后一位,录像在另一台机器上回放时就会逐渐偏离;
+/// 本类只用双精度的加减乘除与floor实现这些函数(多项式系数取自fdlibm),并关闭FMA收缩编译,
+/// 因此在所有编译器与平台上逐位一致,结果舍入为float后的误差不超过1ulp.
+/// 注意:参数的绝对值超过约1e6时精度下降(结果仍然是确定的),角度请先折回一圈之内.
+/// </summary>
+class MADStrictMath
+{
+public:
+	MADStrictMath() = delete;
+
+public:
+	/// <summary>
+	/// 正弦
+	/// </summary>
+	/// <param name="_radians">弧度</param>
+	/// <returns>sin(_radians),参数为NaN或无穷大时返回NaN</returns>
+	static float Sin(float _radians);
+
+	/// <summary>
+	/// 余弦
+	/// </summary>
+	/// <param name="_radians">弧度</param>
+	/// <returns>cos(_radians),参数为NaN或无穷大时返回NaN</returns>
+	static float Cos(float _radians);
+
+	/// <summary>
+	/// 同时计算正弦与余弦,只做一次区间折叠
+	/// </summary>
+	/// <param name="_radians">弧度</param>
+	/// <param name="out_sin">正弦</param>
+	/// <param name="out_cos">余弦</param>
+	static void SinCos(float _radians, float* out_sin, float* out_cos);
+
+	/// <summary>
+	/// 四象限反正切,特殊值(±0、无穷大)的处理与C标准一致
+	/// </summary>
+	/// <param name="_y">Y分量</param>
+	/// <param name="_x">X分量</param>
+	/// <returns>向量(_x, _y)的角度,范围为[-pi, pi]</returns>
+	static float Atan2(float _y, float _x);
+
+	/// <summary>
+	/// 浮点取余,IEEE 754的取余结果是精确值,与平台无关,这里统一入口便于审查
+	/// </summary>
+	/// <param name="_x">被除数</param>
+	/// <param name="_y">除数</param>
+	/// <returns>_x - n * _y,n为 _x / _y 向零取整,符号与_x相同</returns>
+	static float Fmod(float _x, float _y);
+};
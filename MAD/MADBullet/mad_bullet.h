@@ -0,0 +1,18 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+/*MAD APIs*/
+#include "mad_bullet_pool.h"
+#include "mad_bullet_kernel.h"
+#include "mad_collision.h"
+#include "mad_entity_index.h"
+#include "mad_flush_channel.h"
+#include "mad_bullet_timer.h"
+#include "mad_laser.h"
+#include "mad_bullet_homing.h"
+#include "mad_fixed_pool.h"
@@ -0,0 +1,390 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_bullet_homing.h"
+#include "../MADBase/mad_fp_strict.h"
+
+#include <cmath>
+
+/*Largest turn per tick,turning further than half a circle is never needed*/
+#define MAD_HOMING_MAX_TURN 3.14159265f
+
+/**
+ * 构造一个空的追踪子弹列表。
+ */
+MADBulletHoming::MADBulletHoming()
+{
+	CachedDt = 0.0f;
+}
+
+/**
+ * MADBulletHoming析构函数。
+ */
+MADBulletHoming::~MADBulletHoming()
+{
+}
+
+/**
+ * 让一颗子弹开始追踪。子弹已经在追踪时只更新其参数与目标。
+ *
+ * @param _bullet 子弹句柄
+ * @param _info 转向参数
+ * @param _target 初始目标在MADEntityIndex中的id,传入MAD_ENTITY_INVALID_ID则在第一次Update时自动索敌
+ * @return 成功时返回true
+ */
+bool MADBulletHoming::Add(MADBulletHandle _bullet, const MADHomingInfo& _info, unsigned int _target)
+{
+	if (_bullet.Index == MAD_BULLET_INVALID_INDEX)
+	{
+		MAD_LOG_ERR("Try to add an invalid bullet handle to homing!");
+		return false;
+	}
+	size_t l_entry = Find(_bullet);
+	if (l_entry == MAD_BULLET_INVALID_INDEX)
+	{
+		l_entry = Bullets.size();
+		if (_bullet.Index >= SlotToEntry.size())
+		{
+			SlotToEntry.resize(_bullet.Index + 1, MAD_BULLET_INVALID_INDEX);
+		}
+		SlotToEntry[_bullet.Index] = static_cast<unsigned int>(l_entry);
+		Bullets.push_back(_bullet);
+		Targets.push_back(_target);
+		TurnRate.push_back(0.0f);
+		SearchRadius.push_back(0.0f);
+		RetargetInterval.push_back(0);
+		RetargetLeft.push_back(0);
+		TurnCos.push_back(1.0f);
+		TurnSin.push_back(0.0f);
+		TurnDirty.push_back(1);
+	}
+	Targets[l_entry] = _target;
+	TurnRate[l_entry] = _info.TurnRate;
+	SearchRadius[l_entry] = _info.SearchRadius;
+	RetargetInterval[l_entry] = _info.RetargetInterval;
+	RetargetLeft[l_entry] = _info.RetargetInterval;
+	TurnDirty[l_entry] = 1;
+	return true;
+}
+
+/**
+ * 让一颗子弹停止追踪,速度保持当前值。
+ *
+ * @param _bullet 子弹句柄
+ * @return 子弹在追踪列表中时返回true
+ */
+bool MADBulletHoming::Remove(MADBulletHandle _bullet)
+{
+	size_t l_entry = Find(_bullet);
+	if (l_entry == MAD_BULLET_INVALID_INDEX)
+	{
+		return false;
+	}
+	RemoveAt(l_entry);
+	return true;
+}
+
+/**
+ * 为一颗追踪子弹指定目标。
+ *
+ * @param _bullet 子弹句柄
+ * @param _target 目标在MADEntityIndex中的id,传入MAD_ENTITY_INVALID_ID则在下一次Update时自动索敌
+ * @return 子弹在追踪列表中时返回true
+ */
+bool MADBulletHoming::SetTarget(MADBulletHandle _bullet, unsigned int _target)
+{
+	size_t l_entry = Find(_bullet);
+	if (l_entry == MAD_BULLET_INVALID_INDEX)
+	{
+		return false;
+	}
+	Targets[l_entry] = _target;
+	return true;
+}
+
+/**
+ * 清空追踪列表。
+ */
+void MADBulletHoming::Clear()
+{
+	SlotToEntry.clear();
+	Bullets.clear();
+	Targets.clear();
+	TurnRate.clear();
+	SearchRadius.clear();
+	RetargetInterval.clear();
+	RetargetLeft.clear();
+	TurnCos.clear();
+	TurnSin.clear();
+	TurnDirty.clear();
+}
+
+/**
+ * 获取追踪列表中的子弹数量,其中可能包含尚未在Update中移除的已销毁子弹。
+ *
+ * @return 子弹数量
+ */
+size_t MADBulletHoming::GetNum() const
+{
+	return Bullets.size();
+}
+
+/**
+ * 获取追踪子弹当前的目标。
+ *
+ * @param _bullet 子弹句柄
+ * @return 目标在MADEntityIndex中的id;子弹不在列表中或没有目标时返回MAD_ENTITY_INVALID_ID
+ */
+unsigned int MADBulletHoming::GetTarget(MADBulletHandle _bullet) const
+{
+	size_t l_entry = Find(_bullet);
+	if (l_entry == MAD_BULLET_INVALID_INDEX)
+	{
+		return MAD_ENTITY_INVALID_ID;
+	}
+	return Targets[l_entry];
+}
+
+/**
+ * 处理一个tick的转向,在子弹池Step之前调用。
+ * 普通积分子弹的速度直接写回速度数组;参数化子弹与子弹组成员通过SetInfo写回,
+ * 转向只改变其总速度,运动模型的偏移从当前状态接续,轨迹保持连续。
+ *
+ * @param _pool 子弹所在的子弹池
+ * @param _entities 目标所在的实体索引
+ * @param _dt 本tick的时间步长(秒)
+ * @return 本次处理的追踪子弹数量
+ */
+size_t MADBulletHoming::Update(MADBulletPool& _pool, const MADEntityIndex& _entities, float _dt)
+{
+	/*Resolve handles,dropping dead bullets*/
+	Index.clear();
+	for (size_t k = 0; k < Bullets.size();)
+	{
+		size_t l_index = _pool.GetIndex(Bullets[k]);
+		if (l_index == MAD_BULLET_INVALID_INDEX)
+		{
+			RemoveAt(k);
+			continue;
+		}
+		Index.push_back(static_cast<unsigned int>(l_index));
+		++k;
+	}
+	size_t l_num = Index.size();
+	if (l_num == 0)
+	{
+		return 0;
+	}
+
+	/*Turn angle per tick*/
+	bool l_dt_changed = _dt != CachedDt;
+	CachedDt = _dt;
+	for (size_t k = 0; k < l_num; ++k)
+	{
+		if (l_dt_changed || TurnDirty[k] != 0)
+		{
+			float l_angle = std::fabs(TurnRate[k] * _dt);
+			l_angle = l_angle < MAD_HOMING_MAX_TURN ? l_angle : MAD_HOMING_MAX_TURN;
+			MADStrictMath::SinCos(l_angle, &TurnSin[k], &TurnCos[k]);
+			TurnDirty[k] = 0;
+		}
+	}
+
+	/*Gather and retarget,the mutable arrays settle far LOD bullets first*/
+	float* l_px = _pool.GetPositionXData();
+	float* l_py = _pool.GetPositionYData();
+	float* l_dx = _pool.GetDirXData();
+	float* l_dy = _pool.GetDirYData();
+	const long long* l_mask = _pool.GetTeamMaskData();
+	Pos_X.resize(l_num);
+	Pos_Y.resize(l_num);
+	Dir_X.resize(l_num);
+	Dir_Y.resize(l_num);
+	Target_X.resize(l_num);
+	Target_Y.resize(l_num);
+	for (size_t k = 0; k < l_num; ++k)
+	{
+		unsigned int i = Index[k];
+		Pos_X[k] = l_px[i];
+		Pos_Y[k] = l_py[i];
+		Dir_X[k] = l_dx[i];
+		Dir_Y[k] = l_dy[i];
+
+		bool l_retarget = !_entities.IsValid(Targets[k]);
+		if (RetargetInterval[k] != 0 && --RetargetLeft[k] == 0)
+		{
+			RetargetLeft[k] = RetargetInterval[k];
+			l_retarget = true;
+		}
+		if (l_retarget)
+		{
+			Targets[k] = _entities.FindNearest(MADVector2DF(Pos_X[k], Pos_Y[k]), l_mask[i], SearchRadius[k]);
+		}
+
+		/*Without a target the target point is the bullet itself,which leaves the direction unchanged*/
+		if (Targets[k] != MAD_ENTITY_INVALID_ID)
+		{
+			const MADEntity& l_target = _entities.GetEntity(Targets[k]);
+			Target_X[k] = l_target.Position.x;
+			Target_Y[k] = l_target.Position.y;
+		}
+		else
+		{
+			Target_X[k] = Pos_X[k];
+			Target_Y[k] = Pos_Y[k];
+		}
+	}
+
+	/*Steer*/
+	MADBulletKernel::Steer(Pos_X.data(), Pos_Y.data(), Dir_X.data(), Dir_Y.data(), Target_X.data(), Target_Y.data(),
+		TurnCos.data(), TurnSin.data(), l_num);
+
+	/*Scatter*/
+	size_t l_parametric_num = _pool.GetParametricNum();
+	for (size_t k = 0; k < l_num; ++k)
+	{
+		unsigned int i = Index[k];
+		if (i >= l_parametric_num && _pool.GetGroup(i) == MAD_BULLET_INVALID_INDEX)
+		{
+			l_dx[i] = Dir_X[k];
+			l_dy[i] = Dir_Y[k];
+			continue;
+		}
+		BulletInfo l_info = _pool.GetInfoAt(i);
+		l_info.OriginDir = MADVector2DF(Dir_X[k], Dir_Y[k]);
+		_pool.SetInfo(Bullets[k], l_info);
+	}
+	return l_num;
+}
+
+/**
+ * 把追踪列表的全部状态追加到 out_data 末尾,包括目标、重新索敌计数与转向角缓存,
+ * 因此恢复后的转向结果与保存时逐位一致。
+ *
+ * @param out_data 输出缓冲区,数据追加在已有内容之后
+ * @return 写入的字节数
+ */
+size_t MADBulletHoming::Snapshot(std::vector<unsigned char>& out_data) const
+{
+	size_t l_begin = out_data.size();
+	MADBlobWriter l_writer(out_data);
+	l_writer.Write(MAD_HOMING_SNAPSHOT_TAG);
+	l_writer.Write(CachedDt);
+	l_writer.WriteArray(SlotToEntry);
+	l_writer.WriteArray(Bullets);
+	l_writer.WriteArray(Targets);
+	l_writer.WriteArray(TurnRate);
+	l_writer.WriteArray(SearchRadius);
+	l_writer.WriteArray(RetargetInterval);
+	l_writer.WriteArray(RetargetLeft);
+	l_writer.WriteArray(TurnCos);
+	l_writer.WriteArray(TurnSin);
+	l_writer.WriteArray(TurnDirty);
+	return out_data.size() - l_begin;
+}
+
+/**
+ * 从快照中恢复追踪列表。
+ * 快照数据损坏或不完整时追踪列表被清空。
+ *
+ * @param io_reader 指向一份由Snapshot写入的数据,读取后前进到该数据之后
+ * @return 成功时返回true
+ */
+bool MADBulletHoming::Restore(MADBlobReader& io_reader)
+{
+	unsigned int l_tag = 0;
+	float l_cached_dt = 0.0f;
+	io_reader.Read(&l_tag);
+	io_reader.Read(&l_cached_dt);
+	io_reader.ReadArray(SlotToEntry);
+	io_reader.ReadArray(Bullets);
+	io_reader.ReadArray(Targets);
+	io_reader.ReadArray(TurnRate);
+	io_reader.ReadArray(SearchRadius);
+	io_reader.ReadArray(RetargetInterval);
+	io_reader.ReadArray(RetargetLeft);
+	io_reader.ReadArray(TurnCos);
+	io_reader.ReadArray(TurnSin);
+	io_reader.ReadArray(TurnDirty);
+
+	/*Every entry array must agree on the entry count,and every slot link must point back to its entry*/
+	size_t l_num = Bullets.size();
+	bool l_valid = !io_reader.IsFailed() && l_tag == MAD_HOMING_SNAPSHOT_TAG &&
+		Targets.size() == l_num && TurnRate.size() == l_num && SearchRadius.size() == l_num &&
+		RetargetInterval.size() == l_num && RetargetLeft.size() == l_num &&
+		TurnCos.size() == l_num && TurnSin.size() == l_num && TurnDirty.size() == l_num;
+	for (size_t k = 0; l_valid && k < l_num; ++k)
+	{
+		l_valid = Bullets[k].Index < SlotToEntry.size();
+	}
+	for (size_t i = 0; l_valid && i < SlotToEntry.size(); ++i)
+	{
+		l_valid = SlotToEntry[i] == MAD_BULLET_INVALID_INDEX || (SlotToEntry[i] < l_num && Bullets[SlotToEntry[i]].Index == i);
+	}
+	if (!l_valid)
+	{
+		MAD_LOG_ERR("Try to restore bullet homing from a broken snapshot!");
+		Clear();
+		return false;
+	}
+	CachedDt = l_cached_dt;
+	return true;
+}
+
+/**
+ * (内部函数)
+ * 查找子弹在追踪列表中的位置,找不到时返回MAD_BULLET_INVALID_INDEX。
+ * 槽位被新子弹复用时代数不同,旧条目不会被误认为新子弹。
+ */
+size_t MADBulletHoming::Find(MADBulletHandle _bullet) const
+{
+	if (_bullet.Index >= SlotToEntry.size())
+	{
+		return MAD_BULLET_INVALID_INDEX;
+	}
+	unsigned int l_entry = SlotToEntry[_bullet.Index];
+	if (l_entry == MAD_BULLET_INVALID_INDEX || Bullets[l_entry] != _bullet)
+	{
+		return MAD_BULLET_INVALID_INDEX;
+	}
+	return l_entry;
+}
+
+/**
+ * (内部函数)
+ * 将列表末尾的条目交换到 _entry 处并删除末尾。
+ */
+void MADBulletHoming::RemoveAt(size_t _entry)
+{
+	size_t l_last = Bullets.size() - 1;
+	/*A dead bullet's slot may already belong to a newer entry*/
+	if (SlotToEntry[Bullets[_entry].Index] == _entry)
+	{
+		SlotToEntry[Bullets[_entry].Index] = MAD_BULLET_INVALID_INDEX;
+	}
+	if (_entry != l_last && SlotToEntry[Bullets[l_last].Index] == l_last)
+	{
+		SlotToEntry[Bullets[l_last].Index] = static_cast<unsigned int>(_entry);
+	}
+	Bullets[_entry] = Bullets[l_last];
+	Targets[_entry] = Targets[l_last];
+	TurnRate[_entry] = TurnRate[l_last];
+	SearchRadius[_entry] = SearchRadius[l_last];
+	RetargetInterval[_entry] = RetargetInterval[l_last];
+	RetargetLeft[_entry] = RetargetLeft[l_last];
+	TurnCos[_entry] = TurnCos[l_last];
+	TurnSin[_entry] = TurnSin[l_last];
+	TurnDirty[_entry] = TurnDirty[l_last];
+	Bullets.pop_back();
+	Targets.pop_back();
+	TurnRate.pop_back();
+	SearchRadius.pop_back();
+	RetargetInterval.pop_back();
+	RetargetLeft.pop_back();
+	TurnCos.pop_back();
+	TurnSin.pop_back();
+	TurnDirty.pop_back();
+}
@@ -0,0 +1,110 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "mad_bullet_pool.h"
+#include "mad_entity_index.h"
+
+/*Tag written at the start of a homing snapshot*/
+#define MAD_HOMING_SNAPSHOT_TAG 0x474D4F48u
+
+/**
+ * \brief MADHomingInfo 描述一颗追踪子弹的转向参数。
+ *
+ * - TurnRate: 最大转向角速度(弧度/秒)
+ * - SearchRadius: 索敌半径,小于0表示不限距离
+ * - RetargetInterval: 重新索敌的间隔(tick),为0时只在目标失效后重新索敌
+ */
+struct MADHomingInfo {
+	float TurnRate;
+	float SearchRadius;
+	unsigned int RetargetInterval;
+
+	MADHomingInfo() {
+		TurnRate = 0.0f;
+		SearchRadius = -1.0f;
+		RetargetInterval = 0;
+	}
+	MADHomingInfo(float _turn_rate, float _search_radius = -1.0f, unsigned int _retarget_interval = 0) {
+		TurnRate = _turn_rate;
+		SearchRadius = _search_radius;
+		RetargetInterval = _retarget_interval;
+	}
+};
+
+/**
+ * MADBulletHoming 批量处理追踪子弹的转向,取代逐颗子弹调用脚本计算角度。
+ *
+ * 每次Update:
+ * - 通过句柄找到所有追踪子弹,已销毁的子弹自动移出列表;
+ * - 目标失效(已从MADEntityIndex中移除)或到达重新索敌间隔的子弹,通过MADEntityIndex::FindNearest
+ *   重新选择TeamMask与子弹匹配的最近实体作为目标;
+ * - 把所有追踪子弹的位置、速度与目标点收集到连续的数组中,由MADBulletKernel::Steer一次完成转向,再写回子弹池。
+ *
+ * 转向角的余弦与正弦只在 _dt 或转向角速度变化时重新计算,固定步长下每帧不调用任何三角函数。
+ * 目标以MADEntityIndex中的实体id记录,因此实体索引需要在Update之前同步到当前帧;
+ * 同理,从快照恢复本对象时,子弹池与实体索引也应恢复到同一tick。
+ *
+ * 注意:该类是线程不安全的!
+ */
+class MADBulletHoming
+{
+public:
+	MADBulletHoming();
+	~MADBulletHoming();
+
+public:
+	/*Homing operator*/
+	bool Add(MADBulletHandle _bullet, const MADHomingInfo& _info, unsigned int _target = MAD_ENTITY_INVALID_ID);
+	bool Remove(MADBulletHandle _bullet);
+	bool SetTarget(MADBulletHandle _bullet, unsigned int _target);
+	void Clear();
+
+	/*Get Data*/
+	size_t GetNum() const;
+	unsigned int GetTarget(MADBulletHandle _bullet) const;
+
+	/*Simulate*/
+	size_t Update(MADBulletPool& _pool, const MADEntityIndex& _entities, float _dt);
+
+	/*Snapshot*/
+	size_t Snapshot(std::vector<unsigned char>& out_data) const;
+	bool Restore(MADBlobReader& io_reader);
+
+private:
+	/*Entry of each bullet slot,entries are swap-removed*/
+	std::vector<unsigned int> SlotToEntry;
+
+	/*Homing Data (SoA)*/
+	std::vector<MADBulletHandle> Bullets;
+	std::vector<unsigned int> Targets;
+	std::vector<float> TurnRate;
+	std::vector<float> SearchRadius;
+	std::vector<unsigned int> RetargetInterval;
+	std::vector<unsigned int> RetargetLeft;
+
+	/*Turn angle cache,valid for CachedDt*/
+	std::vector<float> TurnCos;
+	std::vector<float> TurnSin;
+	std::vector<unsigned char> TurnDirty;
+	float CachedDt;
+
+	/*Gather scratch*/
+	std::vector<unsigned int> Index;
+	std::vector<float> Pos_X;
+	std::vector<float> Pos_Y;
+	std::vector<float> Dir_X;
+	std::vector<float> Dir_Y;
+	std::vector<float> Target_X;
+	std::vector<float> Target_Y;
+
+	/*Common function*/
+	size_t Find(MADBulletHandle _bullet) const;
+	void RemoveAt(size_t _entry);
+};
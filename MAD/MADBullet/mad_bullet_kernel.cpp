@@ -0,0 +1,2084 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_bullet_kernel.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "../MADBase/mad_fp_strict.h"
+
+static_assert(sizeof(MADBulletFlushResData) == 4 * sizeof(float), "MADBulletFlushResData must be 4 packed floats.");
+static_assert(sizeof(MADFixedFlushResData) == 12, "MADFixedFlushResData must be 12 packed bytes.");
+
+/**
+ * (内部函数)
+ * 积分内核的标量路径,同时也是SIMD路径处理尾部元素的方式。
+ */
+static void IntegrateScalar(float* _pos_x, float* _pos_y, const float* _dir_x, const float* _dir_y,
+	float* _alive_time, size_t _num, float _dt, MADBulletFlushResData* out_res)
+{
+	for (size_t i = 0; i < _num; ++i)
+	{
+		float l_step_x = _dir_x[i] * _dt;
+		float l_step_y = _dir_y[i] * _dt;
+		_pos_x[i] = _pos_x[i] + l_step_x;
+		_pos_y[i] = _pos_y[i] + l_step_y;
+		_alive_time[i] = _alive_time[i] + _dt;
+		if (out_res != nullptr)
+		{
+			out_res[i].Position_X = _pos_x[i];
+			out_res[i].Position_Y = _pos_y[i];
+			out_res[i].Dir_X = _dir_x[i];
+			out_res[i].Dir_Y = _dir_y[i];
+		}
+	}
+}
+
+#if defined(MAD_SIMD_X86)
+/**
+ * (内部函数)
+ * 积分内核的SSE2路径,每次处理4颗子弹,
+ * 输出时在寄存器内将SoA转置为MADBulletFlushResData的AoS布局。
+ */
+MAD_TARGET_SSE2
+static void IntegrateSSE2(float* _pos_x, float* _pos_y, const float* _dir_x, const float* _dir_y,
+	float* _alive_time, size_t _num, float _dt, MADBulletFlushResData* out_res)
+{
+	const __m128 l_dt = _mm_set1_ps(_dt);
+	size_t i = 0;
+	for (; i + 4 <= _num; i += 4)
+	{
+		__m128 l_dx = _mm_loadu_ps(_dir_x + i);
+		__m128 l_dy = _mm_loadu_ps(_dir_y + i);
+		__m128 l_px = _mm_add_ps(_mm_loadu_ps(_pos_x + i), _mm_mul_ps(l_dx, l_dt));
+		__m128 l_py = _mm_add_ps(_mm_loadu_ps(_pos_y + i), _mm_mul_ps(l_dy, l_dt));
+		_mm_storeu_ps(_pos_x + i, l_px);
+		_mm_storeu_ps(_pos_y + i, l_py);
+		_mm_storeu_ps(_alive_time + i, _mm_add_ps(_mm_loadu_ps(_alive_time + i), l_dt));
+
+		if (out_res != nullptr)
+		{
+			__m128 l_t0 = _mm_unpacklo_ps(l_px, l_py);
+			__m128 l_t1 = _mm_unpackhi_ps(l_px, l_py);
+			__m128 l_t2 = _mm_unpacklo_ps(l_dx, l_dy);
+			__m128 l_t3 = _mm_unpackhi_ps(l_dx, l_dy);
+			float* l_out = &out_res[i].Position_X;
+			_mm_storeu_ps(l_out, _mm_movelh_ps(l_t0, l_t2));
+			_mm_storeu_ps(l_out + 4, _mm_movehl_ps(l_t2, l_t0));
+			_mm_storeu_ps(l_out + 8, _mm_movelh_ps(l_t1, l_t3));
+			_mm_storeu_ps(l_out + 12, _mm_movehl_ps(l_t3, l_t1));
+		}
+	}
+	IntegrateScalar(_pos_x + i, _pos_y + i, _dir_x + i, _dir_y + i, _alive_time + i, _num - i, _dt,
+		out_res != nullptr ? out_res + i : nullptr);
+}
+
+/**
+ * (内部函数)
+ * 积分内核的AVX2路径,每次处理8颗子弹。
+ * 256位寄存器的转置在两个128位通道内分别完成,最后用permute2f128拼接成连续的8条记录。
+ */
+MAD_TARGET_AVX2
+static void IntegrateAVX2(float* _pos_x, float* _pos_y, const float* _dir_x, const float* _dir_y,
+	float* _alive_time, size_t _num, float _dt, MADBulletFlushResData* out_res)
+{
+	const __m256 l_dt = _mm256_set1_ps(_dt);
+	size_t i = 0;
+	for (; i + 8 <= _num; i += 8)
+	{
+		__m256 l_dx = _mm256_loadu_ps(_dir_x + i);
+		__m256 l_dy = _mm256_loadu_ps(_dir_y + i);
+		__m256 l_px = _mm256_add_ps(_mm256_loadu_ps(_pos_x + i), _mm256_mul_ps(l_dx, l_dt));
+		__m256 l_py = _mm256_add_ps(_mm256_loadu_ps(_pos_y + i), _mm256_mul_ps(l_dy, l_dt));
+		_mm256_storeu_ps(_pos_x + i, l_px);
+		_mm256_storeu_ps(_pos_y + i, l_py);
+		_mm256_storeu_ps(_alive_time + i, _mm256_add_ps(_mm256_loadu_ps(_alive_time + i), l_dt));
+
+		if (out_res != nullptr)
+		{
+			__m256 l_t0 = _mm256_unpacklo_ps(l_px, l_py);
+			__m256 l_t1 = _mm256_unpackhi_ps(l_px, l_py);
+			__m256 l_t2 = _mm256_unpacklo_ps(l_dx, l_dy);
+			__m256 l_t3 = _mm256_unpackhi_ps(l_dx, l_dy);
+			__m256 l_s0 = _mm256_shuffle_ps(l_t0, l_t2, _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 l_s1 = _mm256_shuffle_ps(l_t0, l_t2, _MM_SHUFFLE(3, 2, 3, 2));
+			__m256 l_s2 = _mm256_shuffle_ps(l_t1, l_t3, _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 l_s3 = _mm256_shuffle_ps(l_t1, l_t3, _MM_SHUFFLE(3, 2, 3, 2));
+			float* l_out = &out_res[i].Position_X;
+			_mm256_storeu_ps(l_out, _mm256_permute2f128_ps(l_s0, l_s1, 0x20));
+			_mm256_storeu_ps(l_out + 8, _mm256_permute2f128_ps(l_s2, l_s3, 0x20));
+			_mm256_storeu_ps(l_out + 16, _mm256_permute2f128_ps(l_s0, l_s1, 0x31));
+			_mm256_storeu_ps(l_out + 24, _mm256_permute2f128_ps(l_s2, l_s3, 0x31));
+		}
+	}
+	/*Clear the upper YMM halves before running any SSE code,or every later SSE instruction pays a transition penalty*/
+	_mm256_zeroupper();
+	IntegrateScalar(_pos_x + i, _pos_y + i, _dir_x + i, _dir_y + i, _alive_time + i, _num - i, _dt,
+		out_res != nullptr ? out_res + i : nullptr);
+}
+#endif
+
+/**
+ * 将一段子弹按速度前进 _dt 秒,并可选地同时写出刷新数据。
+ * 执行路径由MADSimd::GetLevel()在运行时决定,各路径结果逐位一致。
+ *
+ * @param _pos_x 位置X数组,原地更新
+ * @param _pos_y 位置Y数组,原地更新
+ * @param _dir_x 速度X数组
+ * @param _dir_y 速度Y数组
+ * @param _alive_time 存活时间数组,原地增加 _dt
+ * @param _num 要处理的子弹数量
+ * @param _dt 时间步长(秒)
+ * @param[out] out_res 可选的刷新数据输出,至少能容纳 _num 条记录;传入nullptr则不输出
+ */
+void MADBulletKernel::Integrate(float* _pos_x, float* _pos_y, const float* _dir_x, const float* _dir_y,
+	float* _alive_time, size_t _num, float _dt, MADBulletFlushResData* out_res)
+{
+#if defined(MAD_SIMD_X86)
+	switch (MADSimd::GetLevel())
+	{
+	case MADSimdLevel::AVX2:
+		IntegrateAVX2(_pos_x, _pos_y, _dir_x, _dir_y, _alive_time, _num, _dt, out_res);
+		return;
+	case MADSimdLevel::SSE2:
+		IntegrateSSE2(_pos_x, _pos_y, _dir_x, _dir_y, _alive_time, _num, _dt, out_res);
+		return;
+	case MADSimdLevel::Scalar:
+		break;
+	}
+#endif
+	IntegrateScalar(_pos_x, _pos_y, _dir_x, _dir_y, _alive_time, _num, _dt, out_res);
+}
+
+/**
+ * (内部函数)
+ * 越界查找的标量路径,NaN坐标同样视为越界。
+ */
+static size_t FindOutsideScalar(const float* _pos_x, const float* _pos_y, size_t _begin, size_t _num,
+	float _min_x, float _min_y, float _max_x, float _max_y, unsigned int* out_index)
+{
+	size_t l_count = 0;
+	for (size_t i = _begin; i < _num; ++i)
+	{
+		float l_x = _pos_x[i];
+		float l_y = _pos_y[i];
+		if (!(l_x >= _min_x && l_x <= _max_x && l_y >= _min_y && l_y <= _max_y))
+		{
+			out_index[l_count++] = static_cast<unsigned int>(i);
+		}
+	}
+	return l_count;
+}
+
+#if defined(MAD_SIMD_X86)
+/**
+ * (内部函数)
+ * 越界查找的SSE2路径,每次比较4颗子弹,整组都在界内时只需一次分支。
+ */
+MAD_TARGET_SSE2
+static size_t FindOutsideSSE2(const float* _pos_x, const float* _pos_y, size_t _num,
+	float _min_x, float _min_y, float _max_x, float _max_y, unsigned int* out_index)
+{
+	const __m128 l_min_x = _mm_set1_ps(_min_x);
+	const __m128 l_min_y = _mm_set1_ps(_min_y);
+	const __m128 l_max_x = _mm_set1_ps(_max_x);
+	const __m128 l_max_y = _mm_set1_ps(_max_y);
+	size_t l_count = 0;
+	size_t i = 0;
+	for (; i + 4 <= _num; i += 4)
+	{
+		__m128 l_x = _mm_loadu_ps(_pos_x + i);
+		__m128 l_y = _mm_loadu_ps(_pos_y + i);
+		__m128 l_inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(l_x, l_min_x), _mm_cmple_ps(l_x, l_max_x)),
+			_mm_and_ps(_mm_cmpge_ps(l_y, l_min_y), _mm_cmple_ps(l_y, l_max_y)));
+		int l_outside = _mm_movemask_ps(l_inside) ^ 0xF;
+		while (l_outside != 0)
+		{
+			int l_bit = 0;
+			while (((l_outside >> l_bit) & 1) == 0)
+			{
+				l_bit++;
+			}
+			out_index[l_count++] = static_cast<unsigned int>(i + l_bit);
+			l_outside &= l_outside - 1;
+		}
+	}
+	return l_count + FindOutsideScalar(_pos_x, _pos_y, i, _num, _min_x, _min_y, _max_x, _max_y, out_index + l_count);
+}
+
+/**
+ * (内部函数)
+ * 越界查找的AVX2路径,每次比较8颗子弹。
+ */
+MAD_TARGET_AVX2
+static size_t FindOutsideAVX2(const float* _pos_x, const float* _pos_y, size_t _num,
+	float _min_x, float _min_y, float _max_x, float _max_y, unsigned int* out_index)
+{
+	const __m256 l_min_x = _mm256_set1_ps(_min_x);
+	const __m256 l_min_y = _mm256_set1_ps(_min_y);
+	const __m256 l_max_x = _mm256_set1_ps(_max_x);
+	const __m256 l_max_y = _mm256_set1_ps(_max_y);
+	size_t l_count = 0;
+	size_t i = 0;
+	for (; i + 8 <= _num; i += 8)
+	{
+		__m256 l_x = _mm256_loadu_ps(_pos_x + i);
+		__m256 l_y = _mm256_loadu_ps(_pos_y + i);
+		__m256 l_inside = _mm256_and_ps(
+			_mm256_and_ps(_mm256_cmp_ps(l_x, l_min_x, _CMP_GE_OQ), _mm256_cmp_ps(l_x, l_max_x, _CMP_LE_OQ)),
+			_mm256_and_ps(_mm256_cmp_ps(l_y, l_min_y, _CMP_GE_OQ), _mm256_cmp_ps(l_y, l_max_y, _CMP_LE_OQ)));
+		int l_outside = _mm256_movemask_ps(l_inside) ^ 0xFF;
+		while (l_outside != 0)
+		{
+			int l_bit = 0;
+			while (((l_outside >> l_bit) & 1) == 0)
+			{
+				l_bit++;
+			}
+			out_index[l_count++] = static_cast<unsigned int>(i + l_bit);
+			l_outside &= l_outside - 1;
+		}
+	}
+	_mm256_zeroupper();
+	return l_count + FindOutsideScalar(_pos_x, _pos_y, i, _num, _min_x, _min_y, _max_x, _max_y, out_index + l_count);
+}
+#endif
+
+/**
+ * 找出位于矩形 [_min, _max] 之外的子弹,按升序写出它们的索引。
+ * 绝大多数子弹都在界内,SIMD路径整组比较后只对越界的子弹逐个写出。
+ *
+ * @param _pos_x 位置X数组
+ * @param _pos_y 位置Y数组
+ * @param _num 子弹数量
+ * @param _min_x 边界左侧
+ * @param _min_y 边界下侧
+ * @param _max_x 边界右侧
+ * @param _max_y 边界上侧
+ * @param[out] out_index 越界子弹的索引,至少能容纳 _num 个元素
+ * @return 越界子弹的数量
+ */
+size_t MADBulletKernel::FindOutside(const float* _pos_x, const float* _pos_y, size_t _num,
+	float _min_x, float _min_y, float _max_x, float _max_y, unsigned int* out_index)
+{
+#if defined(MAD_SIMD_X86)
+	switch (MADSimd::GetLevel())
+	{
+	case MADSimdLevel::AVX2:
+		return FindOutsideAVX2(_pos_x, _pos_y, _num, _min_x, _min_y, _max_x, _max_y, out_index);
+	case MADSimdLevel::SSE2:
+		return FindOutsideSSE2(_pos_x, _pos_y, _num, _min_x, _min_y, _max_x, _max_y, out_index);
+	case MADSimdLevel::Scalar:
+		break;
+	}
+#endif
+	return FindOutsideScalar(_pos_x, _pos_y, 0, _num, _min_x, _min_y, _max_x, _max_y, out_index);
+}
+
+/**
+ * 按闭式运动模型计算一段参数化子弹在当前存活时间下的位置与速度。
+ * 结果只取决于运动模型与存活时间,不存在逐帧积分的累积误差。
+ *
+ * @param _motion 运动模型数组
+ * @param _alive_time 存活时间数组
+ * @param[out] out_pos_x 位置X输出
+ * @param[out] out_pos_y 位置Y输出
+ * @param[out] out_dir_x 速度X输出(位置对时间的导数)
+ * @param[out] out_dir_y 速度Y输出(位置对时间的导数)
+ * @param _num 要处理的子弹数量
+ */
+void MADBulletKernel::EvaluateMotion(const MADBulletMotionState* _motion, const float* _alive_time,
+	float* out_pos_x, float* out_pos_y, float* out_dir_x, float* out_dir_y, size_t _num)
+{
+	for (size_t i = 0; i < _num; ++i)
+	{
+		const MADBulletMotionState& l_motion = _motion[i];
+		float l_t = _alive_time[i] - l_motion.StartTime;
+		float l_px = l_motion.Origin_X + l_motion.Velocity_X * l_t;
+		float l_py = l_motion.Origin_Y + l_motion.Velocity_Y * l_t;
+		float l_dx = l_motion.Velocity_X;
+		float l_dy = l_motion.Velocity_Y;
+
+		switch (l_motion.Type)
+		{
+		case MADBulletMotionType::Accelerating:
+		{
+			float l_half_t2 = 0.5f * l_t * l_t;
+			l_px = l_px + l_motion.Param[0] * l_half_t2;
+			l_py = l_py + l_motion.Param[1] * l_half_t2;
+			l_dx = l_dx + l_motion.Param[0] * l_t;
+			l_dy = l_dy + l_motion.Param[1] * l_t;
+			break;
+		}
+		case MADBulletMotionType::Sine:
+		{
+			float l_phase = l_motion.Param[2] * l_t + l_motion.Param[3];
+			float l_sin, l_cos;
+			MADStrictMath::SinCos(l_phase, &l_sin, &l_cos);
+			l_cos = l_cos * l_motion.Param[2];
+			l_px = l_px + l_motion.Param[0] * l_sin;
+			l_py = l_py + l_motion.Param[1] * l_sin;
+			l_dx = l_dx + l_motion.Param[0] * l_cos;
+			l_dy = l_dy + l_motion.Param[1] * l_cos;
+			break;
+		}
+		case MADBulletMotionType::Spiral:
+		{
+			float l_angle = l_motion.Param[2] + l_motion.Param[1] * l_t;
+			float l_radius = l_motion.Param[3] + l_motion.Param[0] * l_t;
+			float l_sin, l_cos;
+			MADStrictMath::SinCos(l_angle, &l_sin, &l_cos);
+			l_px = l_px + l_radius * l_cos;
+			l_py = l_py + l_radius * l_sin;
+			l_dx = l_dx + l_motion.Param[0] * l_cos - l_radius * l_motion.Param[1] * l_sin;
+			l_dy = l_dy + l_motion.Param[0] * l_sin + l_radius * l_motion.Param[1] * l_cos;
+			break;
+		}
+		default:
+			break;
+		}
+
+		out_pos_x[i] = l_px;
+		out_pos_y[i] = l_py;
+		out_dir_x[i] = l_dx;
+		out_dir_y[i] = l_dy;
+	}
+}
+
+/**
+ * (内部函数)
+ * 将float按就近舍入(偶数优先)转换为IEEE754半精度浮点数的位表示。
+ * 超出半精度范围的值变为无穷大,NaN保持为NaN,过小的值变为非规格化数或带符号的0。
+ */
+static inline unsigned short FloatToHalf(float _value)
+{
+	unsigned int l_bits;
+	memcpy(&l_bits, &_value, sizeof(l_bits));
+	unsigned int l_sign = (l_bits >> 16) & 0x8000u;
+	unsigned int l_abs = l_bits & 0x7FFFFFFFu;
+
+	/*Inf and NaN*/
+	if (l_abs >= 0x7F800000u)
+	{
+		return (unsigned short)(l_sign | 0x7C00u | (l_abs > 0x7F800000u ? 0x200u : 0u));
+	}
+	/*Rounds to 65520 or above*/
+	if (l_abs >= 0x477FF000u)
+	{
+		return (unsigned short)(l_sign | 0x7C00u);
+	}
+	/*Subnormal half,anything at or below 2^-25 rounds to zero*/
+	if (l_abs < 0x38800000u)
+	{
+		if (l_abs <= 0x33000000u)
+		{
+			return (unsigned short)l_sign;
+		}
+		unsigned int l_shift = 126u - (l_abs >> 23);
+		unsigned int l_mantissa = (l_abs & 0x7FFFFFu) | 0x800000u;
+		unsigned int l_result = l_mantissa >> l_shift;
+		unsigned int l_rest = l_mantissa & ((1u << l_shift) - 1u);
+		unsigned int l_halfway = 1u << (l_shift - 1u);
+		if (l_rest > l_halfway || (l_rest == l_halfway && (l_result & 1u) != 0))
+		{
+			++l_result;
+		}
+		return (unsigned short)(l_sign | l_result);
+	}
+	/*Normal half,rebias the exponent and round the mantissa*/
+	l_abs -= 0x38000000u;
+	return (unsigned short)(l_sign | ((l_abs + 0x0FFFu + ((l_abs >> 13) & 1u)) >> 13));
+}
+
+/**
+ * (内部函数)
+ * 返回一种打包格式单条记录中子弹数据部分的字节数,不含精灵与颜色索引。
+ */
+static inline size_t GetPayloadSize(MADFlushFormat _format)
+{
+	switch (_format)
+	{
+	case MADFlushFormat::Half4:
+		return 4 * sizeof(unsigned short);
+	case MADFlushFormat::PosAngle:
+		return 3 * sizeof(float);
+	case MADFlushFormat::Float4:
+	default:
+		return 4 * sizeof(float);
+	}
+}
+
+/**
+ * (内部函数)
+ * 打包内核的标量路径,同时也是SIMD路径处理尾部元素的方式。
+ */
+static void PackScalar(const float* _pos_x, const float* _pos_y, const float* _dir_x, const float* _dir_y,
+	const unsigned int* _appearance, size_t _num, MADFlushFormat _format, size_t _stride, unsigned char* out_data)
+{
+	size_t l_payload = GetPayloadSize(_format);
+	for (size_t i = 0; i < _num; ++i)
+	{
+		unsigned char* l_out = out_data + i * _stride;
+		switch (_format)
+		{
+		case MADFlushFormat::Half4:
+		{
+			unsigned short l_half[4] = {
+				FloatToHalf(_pos_x[i]), FloatToHalf(_pos_y[i]),
+				FloatToHalf(_dir_x[i]), FloatToHalf(_dir_y[i]) };
+			memcpy(l_out, l_half, sizeof(l_half));
+			break;
+		}
+		case MADFlushFormat::PosAngle:
+		{
+			float l_record[3] = { _pos_x[i], _pos_y[i], MADStrictMath::Atan2(_dir_y[i], _dir_x[i]) };
+			memcpy(l_out, l_record, sizeof(l_record));
+			break;
+		}
+		case MADFlushFormat::Float4:
+		default:
+		{
+			float l_record[4] = { _pos_x[i], _pos_y[i], _dir_x[i], _dir_y[i] };
+			memcpy(l_out, l_record, sizeof(l_record));
+			break;
+		}
+		}
+		if (_appearance != nullptr)
+		{
+			memcpy(l_out + l_payload, &_appearance[i], sizeof(unsigned int));
+		}
+	}
+}
+
+#if defined(MAD_SIMD_X86)
+/**
+ * (内部函数)
+ * Float4格式打包的SSE2路径,每次转置4颗子弹并逐条写到各自的步长位置。
+ * 目标缓冲区与步长均按16字节对齐时使用非临时写入(streaming store),
+ * 这正是映射到GPU的写合并内存所需要的写法,结束时以sfence保证写入对其他设备可见。
+ */
+MAD_TARGET_SSE2
+static void PackFloat4SSE2(const float* _pos_x, const float* _pos_y, const float* _dir_x, const float* _dir_y,
+	const unsigned int* _appearance, size_t _num, size_t _stride, unsigned char* out_data)
+{
+	bool l_stream = _appearance == nullptr && ((size_t)out_data & 15) == 0 && (_stride & 15) == 0;
+	size_t i = 0;
+	for (; i + 4 <= _num; i += 4)
+	{
+		__m128 l_px = _mm_loadu_ps(_pos_x + i);
+		__m128 l_py = _mm_loadu_ps(_pos_y + i);
+		__m128 l_dx = _mm_loadu_ps(_dir_x + i);
+		__m128 l_dy = _mm_loadu_ps(_dir_y + i);
+		__m128 l_t0 = _mm_unpacklo_ps(l_px, l_py);
+		__m128 l_t1 = _mm_unpackhi_ps(l_px, l_py);
+		__m128 l_t2 = _mm_unpacklo_ps(l_dx, l_dy);
+		__m128 l_t3 = _mm_unpackhi_ps(l_dx, l_dy);
+		__m128 l_record[4] = {
+			_mm_movelh_ps(l_t0, l_t2), _mm_movehl_ps(l_t2, l_t0),
+			_mm_movelh_ps(l_t1, l_t3), _mm_movehl_ps(l_t3, l_t1) };
+
+		unsigned char* l_out = out_data + i * _stride;
+		for (size_t k = 0; k < 4; ++k)
+		{
+			float* l_dst = (float*)(l_out + k * _stride);
+			if (l_stream)
+			{
+				_mm_stream_ps(l_dst, l_record[k]);
+			}
+			else
+			{
+				_mm_storeu_ps(l_dst, l_record[k]);
+				if (_appearance != nullptr)
+				{
+					memcpy(l_dst + 4, &_appearance[i + k], sizeof(unsigned int));
+				}
+			}
+		}
+	}
+	if (l_stream)
+	{
+		_mm_sfence();
+	}
+	PackScalar(_pos_x + i, _pos_y + i, _dir_x + i, _dir_y + i,
+		_appearance != nullptr ? _appearance + i : nullptr, _num - i, MADFlushFormat::Float4, _stride,
+		out_data + i * _stride);
+}
+#endif
+
+/**
+ * 返回一种刷新布局下单条记录实际占用的最小字节数(子弹数据加上可选的索引)。
+ *
+ * @param _layout 刷新布局
+ * @return 单条记录的字节数
+ */
+size_t MADBulletKernel::GetRecordSize(const MADFlushLayout& _layout)
+{
+	return GetPayloadSize(_layout.Format) + (_layout.WriteIndices ? 2 * sizeof(unsigned short) : 0);
+}
+
+/**
+ * 将一段子弹按指定格式直接写入调用者提供的缓冲区(例如映射后的GPU实例缓冲区),
+ * 第i颗子弹写在 out_data + i * _stride 处,记录之间的字节不会被触碰。
+ *
+ * @param _pos_x 位置X数组
+ * @param _pos_y 位置Y数组
+ * @param _dir_x 速度X数组
+ * @param _dir_y 速度Y数组
+ * @param _appearance 精灵索引(低16位)与颜色索引(高16位)数组,传入nullptr则不写索引
+ * @param _num 要处理的子弹数量
+ * @param _format 打包格式
+ * @param _stride 相邻记录的字节距离,不小于该格式的记录大小
+ * @param[out] out_data 输出缓冲区,至少能容纳 _num 条记录
+ */
+void MADBulletKernel::Pack(const float* _pos_x, const float* _pos_y, const float* _dir_x, const float* _dir_y,
+	const unsigned int* _appearance, size_t _num, MADFlushFormat _format, size_t _stride, unsigned char* out_data)
+{
+#if defined(MAD_SIMD_X86)
+	if (_format == MADFlushFormat::Float4 && MADSimd::GetLevel() != MADSimdLevel::Scalar)
+	{
+		PackFloat4SSE2(_pos_x, _pos_y, _dir_x, _dir_y, _appearance, _num, _stride, out_data);
+		return;
+	}
+#endif
+	PackScalar(_pos_x, _pos_y, _dir_x, _dir_y, _appearance, _num, _format, _stride, out_data);
+}
+
+/**
+ * (内部函数)
+ * 扫掠圆检测的标量路径,同时也是SIMD路径处理尾部元素的方式。
+ * 运算顺序与SIMD路径完全相同,因此各路径得到的碰撞时间逐位一致。
+ */
+static size_t SweepCircleScalar(const float* _pos_x, const float* _pos_y, const float* _dir_x, const float* _dir_y,
+	size_t _begin, size_t _num, float _center_x, float _center_y, float _radius_sq, float _dt,
+	unsigned int* out_index, float* out_time)
+{
+	size_t l_count = 0;
+	for (size_t i = _begin; i < _num; ++i)
+	{
+		float l_dx = _dir_x[i] * _dt;
+		float l_dy = _dir_y[i] * _dt;
+		float l_sx = (_pos_x[i] - l_dx) - _center_x;
+		float l_sy = (_pos_y[i] - l_dy) - _center_y;
+		float l_a = l_dx * l_dx + l_dy * l_dy;
+		float l_b = l_sx * l_dx + l_sy * l_dy;
+		float l_c = (l_sx * l_sx + l_sy * l_sy) - _radius_sq;
+		if (l_c <= 0.0f)
+		{
+			out_index[l_count] = static_cast<unsigned int>(i);
+			out_time[l_count++] = 0.0f;
+			continue;
+		}
+		float l_disc = l_b * l_b - l_a * l_c;
+		if (!(l_b < 0.0f && l_disc >= 0.0f))
+		{
+			continue;
+		}
+		float l_t = (-l_b - std::sqrt(l_disc)) / l_a;
+		if (l_t <= 1.0f)
+		{
+			out_index[l_count] = static_cast<unsigned int>(i);
+			out_time[l_count++] = l_t;
+		}
+	}
+	return l_count;
+}
+
+#if defined(MAD_SIMD_X86)
+/**
+ * (内部函数)
+ * 扫掠圆检测的SSE2路径,每次检测4颗子弹,整组未命中时只需一次分支。
+ */
+MAD_TARGET_SSE2
+static size_t SweepCircleSSE2(const float* _pos_x, const float* _pos_y, const float* _dir_x, const float* _dir_y,
+	size_t _num, float _center_x, float _center_y, float _radius_sq, float _dt,
+	unsigned int* out_index, float* out_time)
+{
+	const __m128 l_center_x = _mm_set1_ps(_center_x);
+	const __m128 l_center_y = _mm_set1_ps(_center_y);
+	const __m128 l_radius_sq = _mm_set1_ps(_radius_sq);
+	const __m128 l_dt = _mm_set1_ps(_dt);
+	const __m128 l_zero = _mm_setzero_ps();
+	const __m128 l_one = _mm_set1_ps(1.0f);
+	const __m128 l_sign = _mm_set1_ps(-0.0f);
+	size_t l_count = 0;
+	size_t i = 0;
+	for (; i + 4 <= _num; i += 4)
+	{
+		__m128 l_dx = _mm_mul_ps(_mm_loadu_ps(_dir_x + i), l_dt);
+		__m128 l_dy = _mm_mul_ps(_mm_loadu_ps(_dir_y + i), l_dt);
+		__m128 l_sx = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(_pos_x + i), l_dx), l_center_x);
+		__m128 l_sy = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(_pos_y + i), l_dy), l_center_y);
+		__m128 l_a = _mm_add_ps(_mm_mul_ps(l_dx, l_dx), _mm_mul_ps(l_dy, l_dy));
+		__m128 l_b = _mm_add_ps(_mm_mul_ps(l_sx, l_dx), _mm_mul_ps(l_sy, l_dy));
+		__m128 l_c = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(l_sx, l_sx), _mm_mul_ps(l_sy, l_sy)), l_radius_sq);
+		__m128 l_disc = _mm_sub_ps(_mm_mul_ps(l_b, l_b), _mm_mul_ps(l_a, l_c));
+
+		__m128 l_inside = _mm_cmple_ps(l_c, l_zero);
+		__m128 l_approach = _mm_and_ps(_mm_cmplt_ps(l_b, l_zero), _mm_cmpge_ps(l_disc, l_zero));
+		int l_candidate = _mm_movemask_ps(_mm_or_ps(l_inside, l_approach));
+		if (l_candidate == 0)
+		{
+			continue;
+		}
+
+		__m128 l_t = _mm_div_ps(_mm_sub_ps(_mm_xor_ps(l_b, l_sign), _mm_sqrt_ps(_mm_max_ps(l_disc, l_zero))), l_a);
+		l_t = _mm_andnot_ps(l_inside, l_t);
+		int l_hit = _mm_movemask_ps(_mm_or_ps(l_inside, _mm_and_ps(l_approach, _mm_cmple_ps(l_t, l_one))));
+		float l_time[4];
+		_mm_storeu_ps(l_time, l_t);
+		while (l_hit != 0)
+		{
+			int l_bit = 0;
+			while (((l_hit >> l_bit) & 1) == 0)
+			{
+				l_bit++;
+			}
+			out_index[l_count] = static_cast<unsigned int>(i + l_bit);
+			out_time[l_count++] = l_time[l_bit];
+			l_hit &= l_hit - 1;
+		}
+	}
+	return l_count + SweepCircleScalar(_pos_x, _pos_y, _dir_x, _dir_y, i, _num, _center_x, _center_y, _radius_sq, _dt,
+		out_index + l_count, out_time + l_count);
+}
+
+/**
+ * (内部函数)
+ * 扫掠圆检测的AVX2路径,每次检测8颗子弹。
+ */
+MAD_TARGET_AVX2
+static size_t SweepCircleAVX2(const float* _pos_x, const float* _pos_y, const float* _dir_x, const float* _dir_y,
+	size_t _num, float _center_x, float _center_y, float _radius_sq, float _dt,
+	unsigned int* out_index, float* out_time)
+{
+	const __m256 l_center_x = _mm256_set1_ps(_center_x);
+	const __m256 l_center_y = _mm256_set1_ps(_center_y);
+	const __m256 l_radius_sq = _mm256_set1_ps(_radius_sq);
+	const __m256 l_dt = _mm256_set1_ps(_dt);
+	const __m256 l_zero = _mm256_setzero_ps();
+	const __m256 l_one = _mm256_set1_ps(1.0f);
+	const __m256 l_sign = _mm256_set1_ps(-0.0f);
+	size_t l_count = 0;
+	size_t i = 0;
+	for (; i + 8 <= _num; i += 8)
+	{
+		__m256 l_dx = _mm256_mul_ps(_mm256_loadu_ps(_dir_x + i), l_dt);
+		__m256 l_dy = _mm256_mul_ps(_mm256_loadu_ps(_dir_y + i), l_dt);
+		__m256 l_sx = _mm256_sub_ps(_mm256_sub_ps(_mm256_loadu_ps(_pos_x + i), l_dx), l_center_x);
+		__m256 l_sy = _mm256_sub_ps(_mm256_sub_ps(_mm256_loadu_ps(_pos_y + i), l_dy), l_center_y);
+		__m256 l_a = _mm256_add_ps(_mm256_mul_ps(l_dx, l_dx), _mm256_mul_ps(l_dy, l_dy));
+		__m256 l_b = _mm256_add_ps(_mm256_mul_ps(l_sx, l_dx), _mm256_mul_ps(l_sy, l_dy));
+		__m256 l_c = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(l_sx, l_sx), _mm256_mul_ps(l_sy, l_sy)), l_radius_sq);
+		__m256 l_disc = _mm256_sub_ps(_mm256_mul_ps(l_b, l_b), _mm256_mul_ps(l_a, l_c));
+
+		__m256 l_inside = _mm256_cmp_ps(l_c, l_zero, _CMP_LE_OQ);
+		__m256 l_approach = _mm256_and_ps(_mm256_cmp_ps(l_b, l_zero, _CMP_LT_OQ), _mm256_cmp_ps(l_disc, l_zero, _CMP_GE_OQ));
+		int l_candidate = _mm256_movemask_ps(_mm256_or_ps(l_inside, l_approach));
+		if (l_candidate == 0)
+		{
+			continue;
+		}
+
+		__m256 l_t = _mm256_div_ps(_mm256_sub_ps(_mm256_xor_ps(l_b, l_sign), _mm256_sqrt_ps(_mm256_max_ps(l_disc, l_zero))), l_a);
+		l_t = _mm256_blendv_ps(l_t, l_zero, l_inside);
+		int l_hit = _mm256_movemask_ps(_mm256_or_ps(l_inside, _mm256_and_ps(l_approach, _mm256_cmp_ps(l_t, l_one, _CMP_LE_OQ))));
+		float l_time[8];
+		_mm256_storeu_ps(l_time, l_t);
+		while (l_hit != 0)
+		{
+			int l_bit = 0;
+			while (((l_hit >> l_bit) & 1) == 0)
+			{
+				l_bit++;
+			}
+			out_index[l_count] = static_cast<unsigned int>(i + l_bit);
+			out_time[l_count++] = l_time[l_bit];
+			l_hit &= l_hit - 1;
+		}
+	}
+	_mm256_zeroupper();
+	return l_count + SweepCircleScalar(_pos_x, _pos_y, _dir_x, _dir_y, i, _num, _center_x, _center_y, _radius_sq, _dt,
+		out_index + l_count, out_time + l_count);
+}
+#endif
+
+/**
+ * 对一段子弹做扫掠圆检测:子弹在本tick内从 Pos - Dir * _dt 匀速移动到 Pos,
+ * 求它与以 (_center_x, _center_y) 为圆心、半径平方为 _radius_sq 的静止圆首次接触的时刻。
+ * 即使单tick的位移远大于判定半径,也不会发生穿透。
+ *
+ * @param _pos_x 当前位置X数组
+ * @param _pos_y 当前位置Y数组
+ * @param _dir_x 速度X数组
+ * @param _dir_y 速度Y数组
+ * @param _num 子弹数量
+ * @param _center_x 圆心X
+ * @param _center_y 圆心Y
+ * @param _radius_sq 判定半径(实体与子弹半径之和)的平方
+ * @param _dt 本tick的时间步长(秒)
+ * @param[out] out_index 命中子弹的索引(升序),至少能容纳 _num 个元素
+ * @param[out] out_time 对应的接触时刻,为本tick内的比例 [0, 1],tick开始时已经重叠则为0
+ * @return 命中子弹的数量
+ */
+size_t MADBulletKernel::SweepCircle(const float* _pos_x, const float* _pos_y, const float* _dir_x, const float* _dir_y,
+	size_t _num, float _center_x, float _center_y, float _radius_sq, float _dt, unsigned int* out_index, float* out_time)
+{
+#if defined(MAD_SIMD_X86)
+	switch (MADSimd::GetLevel())
+	{
+	case MADSimdLevel::AVX2:
+		return SweepCircleAVX2(_pos_x, _pos_y, _dir_x, _dir_y, _num, _center_x, _center_y, _radius_sq, _dt, out_index, out_time);
+	case MADSimdLevel::SSE2:
+		return SweepCircleSSE2(_pos_x, _pos_y, _dir_x, _dir_y, _num, _center_x, _center_y, _radius_sq, _dt, out_index, out_time);
+	case MADSimdLevel::Scalar:
+		break;
+	}
+#endif
+	return SweepCircleScalar(_pos_x, _pos_y, _dir_x, _dir_y, 0, _num, _center_x, _center_y, _radius_sq, _dt, out_index, out_time);
+}
+
+/**
+ * (内部函数)
+ * 圆形检测的标量路径,同时也是SIMD路径处理尾部元素的方式。
+ */
+static size_t OverlapCircleScalar(const float* _pos_x, const float* _pos_y, const long long* _team_mask,
+	size_t _begin, size_t _num, float _center_x, float _center_y, float _radius_sq, long long _mask,
+	unsigned int* out_index)
+{
+	size_t l_count = 0;
+	for (size_t i = _begin; i < _num; ++i)
+	{
+		if (_team_mask != nullptr && (_team_mask[i] & _mask) == 0)
+		{
+			continue;
+		}
+		float l_dx = _pos_x[i] - _center_x;
+		float l_dy = _pos_y[i] - _center_y;
+		if (l_dx * l_dx + l_dy * l_dy <= _radius_sq)
+		{
+			out_index[l_count++] = static_cast<unsigned int>(i);
+		}
+	}
+	return l_count;
+}
+
+#if defined(MAD_SIMD_X86)
+/**
+ * (内部函数)
+ * 圆形检测的SSE2路径,每次检测4颗子弹。
+ * SSE2没有64位整数比较,按位与的结果先做32位比较,再与交换高低半后的自身相与,得到64位的全零判断。
+ */
+MAD_TARGET_SSE2
+static size_t OverlapCircleSSE2(const float* _pos_x, const float* _pos_y, const long long* _team_mask,
+	size_t _num, float _center_x, float _center_y, float _radius_sq, long long _mask,
+	unsigned int* out_index)
+{
+	const __m128 l_center_x = _mm_set1_ps(_center_x);
+	const __m128 l_center_y = _mm_set1_ps(_center_y);
+	const __m128 l_radius_sq = _mm_set1_ps(_radius_sq);
+	const __m128i l_mask = _mm_set1_epi64x(_mask);
+	const __m128i l_zero = _mm_setzero_si128();
+	size_t l_count = 0;
+	size_t i = 0;
+	for (; i + 4 <= _num; i += 4)
+	{
+		__m128 l_dx = _mm_sub_ps(_mm_loadu_ps(_pos_x + i), l_center_x);
+		__m128 l_dy = _mm_sub_ps(_mm_loadu_ps(_pos_y + i), l_center_y);
+		__m128 l_inside = _mm_cmple_ps(_mm_add_ps(_mm_mul_ps(l_dx, l_dx), _mm_mul_ps(l_dy, l_dy)), l_radius_sq);
+		if (_team_mask != nullptr)
+		{
+			__m128i l_lo = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_team_mask + i)), l_mask), l_zero);
+			__m128i l_hi = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_team_mask + i + 2)), l_mask), l_zero);
+			l_lo = _mm_and_si128(l_lo, _mm_shuffle_epi32(l_lo, _MM_SHUFFLE(2, 3, 0, 1)));
+			l_hi = _mm_and_si128(l_hi, _mm_shuffle_epi32(l_hi, _MM_SHUFFLE(2, 3, 0, 1)));
+			__m128 l_miss = _mm_shuffle_ps(_mm_castsi128_ps(l_lo), _mm_castsi128_ps(l_hi), _MM_SHUFFLE(2, 0, 2, 0));
+			l_inside = _mm_andnot_ps(l_miss, l_inside);
+		}
+		int l_hit = _mm_movemask_ps(l_inside);
+		while (l_hit != 0)
+		{
+			int l_bit = 0;
+			while (((l_hit >> l_bit) & 1) == 0)
+			{
+				l_bit++;
+			}
+			out_index[l_count++] = static_cast<unsigned int>(i + l_bit);
+			l_hit &= l_hit - 1;
+		}
+	}
+	return l_count + OverlapCircleScalar(_pos_x, _pos_y, _team_mask, i, _num, _center_x, _center_y, _radius_sq, _mask,
+		out_index + l_count);
+}
+
+/**
+ * (内部函数)
+ * 圆形检测的AVX2路径,每次检测8颗子弹。
+ * 两组64位比较结果按128位通道取低半后,需要再按64位重排一次才能与8个浮点结果对齐。
+ */
+MAD_TARGET_AVX2
+static size_t OverlapCircleAVX2(const float* _pos_x, const float* _pos_y, const long long* _team_mask,
+	size_t _num, float _center_x, float _center_y, float _radius_sq, long long _mask,
+	unsigned int* out_index)
+{
+	const __m256 l_center_x = _mm256_set1_ps(_center_x);
+	const __m256 l_center_y = _mm256_set1_ps(_center_y);
+	const __m256 l_radius_sq = _mm256_set1_ps(_radius_sq);
+	const __m256i l_mask = _mm256_set1_epi64x(_mask);
+	const __m256i l_zero = _mm256_setzero_si256();
+	size_t l_count = 0;
+	size_t i = 0;
+	for (; i + 8 <= _num; i += 8)
+	{
+		__m256 l_dx = _mm256_sub_ps(_mm256_loadu_ps(_pos_x + i), l_center_x);
+		__m256 l_dy = _mm256_sub_ps(_mm256_loadu_ps(_pos_y + i), l_center_y);
+		__m256 l_inside = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(l_dx, l_dx), _mm256_mul_ps(l_dy, l_dy)), l_radius_sq, _CMP_LE_OQ);
+		if (_team_mask != nullptr)
+		{
+			__m256i l_lo = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(_team_mask + i)), l_mask), l_zero);
+			__m256i l_hi = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(_team_mask + i + 4)), l_mask), l_zero);
+			__m256 l_miss = _mm256_shuffle_ps(_mm256_castsi256_ps(l_lo), _mm256_castsi256_ps(l_hi), _MM_SHUFFLE(2, 0, 2, 0));
+			l_miss = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(l_miss), _MM_SHUFFLE(3, 1, 2, 0)));
+			l_inside = _mm256_andnot_ps(l_miss, l_inside);
+		}
+		int l_hit = _mm256_movemask_ps(l_inside);
+		while (l_hit != 0)
+		{
+			int l_bit = 0;
+			while (((l_hit >> l_bit) & 1) == 0)
+			{
+				l_bit++;
+			}
+			out_index[l_count++] = static_cast<unsigned int>(i + l_bit);
+			l_hit &= l_hit - 1;
+		}
+	}
+	_mm256_zeroupper();
+	return l_count + OverlapCircleScalar(_pos_x, _pos_y, _team_mask, i, _num, _center_x, _center_y, _radius_sq, _mask,
+		out_index + l_count);
+}
+#endif
+
+/**
+ * 对一段子弹做圆形检测,找出位于以 (_center_x, _center_y) 为圆心、半径平方为 _radius_sq 的圆内的子弹。
+ * 传入 _team_mask 时,同时过滤掉TeamMask与 _mask 按位与为0的子弹;
+ * 调用者已知整段子弹都属于匹配的队伍时可以传入nullptr,跳过这一步。
+ *
+ * @param _pos_x 位置X数组
+ * @param _pos_y 位置Y数组
+ * @param _team_mask TeamMask数组,可为nullptr
+ * @param _num 子弹数量
+ * @param _center_x 圆心X
+ * @param _center_y 圆心Y
+ * @param _radius_sq 判定半径(实体与子弹半径之和)的平方
+ * @param _mask 实体的TeamMask
+ * @param[out] out_index 命中子弹的索引(升序),至少能容纳 _num 个元素
+ * @return 命中子弹的数量
+ */
+size_t MADBulletKernel::OverlapCircle(const float* _pos_x, const float* _pos_y, const long long* _team_mask,
+	size_t _num, float _center_x, float _center_y, float _radius_sq, long long _mask, unsigned int* out_index)
+{
+#if defined(MAD_SIMD_X86)
+	switch (MADSimd::GetLevel())
+	{
+	case MADSimdLevel::AVX2:
+		return OverlapCircleAVX2(_pos_x, _pos_y, _team_mask, _num, _center_x, _center_y, _radius_sq, _mask, out_index);
+	case MADSimdLevel::SSE2:
+		return OverlapCircleSSE2(_pos_x, _pos_y, _team_mask, _num, _center_x, _center_y, _radius_sq, _mask, out_index);
+	case MADSimdLevel::Scalar:
+		break;
+	}
+#endif
+	return OverlapCircleScalar(_pos_x, _pos_y, _team_mask, 0, _num, _center_x, _center_y, _radius_sq, _mask, out_index);
+}
+
+/**
+ * (内部函数)
+ * 矩形检测的标量路径,同时也是SIMD路径处理尾部元素的方式。
+ */
+static size_t OverlapRectScalar(const float* _pos_x, const float* _pos_y, const long long* _team_mask,
+	size_t _begin, size_t _num, float _min_x, float _min_y, float _max_x, float _max_y, long long _mask,
+	unsigned int* out_index)
+{
+	size_t l_count = 0;
+	for (size_t i = _begin; i < _num; ++i)
+	{
+		if (_team_mask != nullptr && (_team_mask[i] & _mask) == 0)
+		{
+			continue;
+		}
+		float l_x = _pos_x[i];
+		float l_y = _pos_y[i];
+		if (l_x >= _min_x && l_x <= _max_x && l_y >= _min_y && l_y <= _max_y)
+		{
+			out_index[l_count++] = static_cast<unsigned int>(i);
+		}
+	}
+	return l_count;
+}
+
+#if defined(MAD_SIMD_X86)
+/**
+ * (内部函数)
+ * 矩形检测的SSE2路径,每次检测4颗子弹,TeamMask的64位判断方式与圆形检测相同。
+ */
+MAD_TARGET_SSE2
+static size_t OverlapRectSSE2(const float* _pos_x, const float* _pos_y, const long long* _team_mask,
+	size_t _num, float _min_x, float _min_y, float _max_x, float _max_y, long long _mask,
+	unsigned int* out_index)
+{
+	const __m128 l_min_x = _mm_set1_ps(_min_x);
+	const __m128 l_min_y = _mm_set1_ps(_min_y);
+	const __m128 l_max_x = _mm_set1_ps(_max_x);
+	const __m128 l_max_y = _mm_set1_ps(_max_y);
+	const __m128i l_mask = _mm_set1_epi64x(_mask);
+	const __m128i l_zero = _mm_setzero_si128();
+	size_t l_count = 0;
+	size_t i = 0;
+	for (; i + 4 <= _num; i += 4)
+	{
+		__m128 l_x = _mm_loadu_ps(_pos_x + i);
+		__m128 l_y = _mm_loadu_ps(_pos_y + i);
+		__m128 l_inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(l_x, l_min_x), _mm_cmple_ps(l_x, l_max_x)),
+			_mm_and_ps(_mm_cmpge_ps(l_y, l_min_y), _mm_cmple_ps(l_y, l_max_y)));
+		if (_team_mask != nullptr)
+		{
+			__m128i l_lo = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_team_mask + i)), l_mask), l_zero);
+			__m128i l_hi = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_team_mask + i + 2)), l_mask), l_zero);
+			l_lo = _mm_and_si128(l_lo, _mm_shuffle_epi32(l_lo, _MM_SHUFFLE(2, 3, 0, 1)));
+			l_hi = _mm_and_si128(l_hi, _mm_shuffle_epi32(l_hi, _MM_SHUFFLE(2, 3, 0, 1)));
+			__m128 l_miss = _mm_shuffle_ps(_mm_castsi128_ps(l_lo), _mm_castsi128_ps(l_hi), _MM_SHUFFLE(2, 0, 2, 0));
+			l_inside = _mm_andnot_ps(l_miss, l_inside);
+		}
+		int l_hit = _mm_movemask_ps(l_inside);
+		while (l_hit != 0)
+		{
+			int l_bit = 0;
+			while (((l_hit >> l_bit) & 1) == 0)
+			{
+				l_bit++;
+			}
+			out_index[l_count++] = static_cast<unsigned int>(i + l_bit);
+			l_hit &= l_hit - 1;
+		}
+	}
+	return l_count + OverlapRectScalar(_pos_x, _pos_y, _team_mask, i, _num, _min_x, _min_y, _max_x, _max_y, _mask,
+		out_index + l_count);
+}
+
+/**
+ * (内部函数)
+ * 矩形检测的AVX2路径,每次检测8颗子弹。
+ */
+MAD_TARGET_AVX2
+static size_t OverlapRectAVX2(const float* _pos_x, const float* _pos_y, const long long* _team_mask,
+	size_t _num, float _min_x, float _min_y, float _max_x, float _max_y, long long _mask,
+	unsigned int* out_index)
+{
+	const __m256 l_min_x = _mm256_set1_ps(_min_x);
+	const __m256 l_min_y = _mm256_set1_ps(_min_y);
+	const __m256 l_max_x = _mm256_set1_ps(_max_x);
+	const __m256 l_max_y = _mm256_set1_ps(_max_y);
+	const __m256i l_mask = _mm256_set1_epi64x(_mask);
+	const __m256i l_zero = _mm256_setzero_si256();
+	size_t l_count = 0;
+	size_t i = 0;
+	for (; i + 8 <= _num; i += 8)
+	{
+		__m256 l_x = _mm256_loadu_ps(_pos_x + i);
+		__m256 l_y = _mm256_loadu_ps(_pos_y + i);
+		__m256 l_inside = _mm256_and_ps(
+			_mm256_and_ps(_mm256_cmp_ps(l_x, l_min_x, _CMP_GE_OQ), _mm256_cmp_ps(l_x, l_max_x, _CMP_LE_OQ)),
+			_mm256_and_ps(_mm256_cmp_ps(l_y, l_min_y, _CMP_GE_OQ), _mm256_cmp_ps(l_y, l_max_y, _CMP_LE_OQ)));
+		if (_team_mask != nullptr)
+		{
+			__m256i l_lo = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(_team_mask + i)), l_mask), l_zero);
+			__m256i l_hi = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(_team_mask + i + 4)), l_mask), l_zero);
+			__m256 l_miss = _mm256_shuffle_ps(_mm256_castsi256_ps(l_lo), _mm256_castsi256_ps(l_hi), _MM_SHUFFLE(2, 0, 2, 0));
+			l_miss = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(l_miss), _MM_SHUFFLE(3, 1, 2, 0)));
+			l_inside = _mm256_andnot_ps(l_miss, l_inside);
+		}
+		int l_hit = _mm256_movemask_ps(l_inside);
+		while (l_hit != 0)
+		{
+			int l_bit = 0;
+			while (((l_hit >> l_bit) & 1) == 0)
+			{
+				l_bit++;
+			}
+			out_index[l_count++] = static_cast<unsigned int>(i + l_bit);
+			l_hit &= l_hit - 1;
+		}
+	}
+	_mm256_zeroupper();
+	return l_count + OverlapRectScalar(_pos_x, _pos_y, _team_mask, i, _num, _min_x, _min_y, _max_x, _max_y, _mask,
+		out_index + l_count);
+}
+#endif
+
+/**
+ * 对一段子弹做矩形检测,找出位于 [_min, _max] 之内(含边界)的子弹,NaN坐标视为不在矩形内。
+ * 传入 _team_mask 时,同时过滤掉TeamMask与 _mask 按位与为0的子弹。
+ *
+ * @param _pos_x 位置X数组
+ * @param _pos_y 位置Y数组
+ * @param _team_mask TeamMask数组,可为nullptr
+ * @param _num 子弹数量
+ * @param _min_x 矩形左侧
+ * @param _min_y 矩形下侧
+ * @param _max_x 矩形右侧
+ * @param _max_y 矩形上侧
+ * @param _mask 要匹配的TeamMask
+ * @param[out] out_index 命中子弹的索引(升序),至少能容纳 _num 个元素
+ * @return 命中子弹的数量
+ */
+size_t MADBulletKernel::OverlapRect(const float* _pos_x, const float* _pos_y, const long long* _team_mask,
+	size_t _num, float _min_x, float _min_y, float _max_x, float _max_y, long long _mask, unsigned int* out_index)
+{
+#if defined(MAD_SIMD_X86)
+	switch (MADSimd::GetLevel())
+	{
+	case MADSimdLevel::AVX2:
+		return OverlapRectAVX2(_pos_x, _pos_y, _team_mask, _num, _min_x, _min_y, _max_x, _max_y, _mask, out_index);
+	case MADSimdLevel::SSE2:
+		return OverlapRectSSE2(_pos_x, _pos_y, _team_mask, _num, _min_x, _min_y, _max_x, _max_y, _mask, out_index);
+	case MADSimdLevel::Scalar:
+		break;
+	}
+#endif
+	return OverlapRectScalar(_pos_x, _pos_y, _team_mask, 0, _num, _min_x, _min_y, _max_x, _max_y, _mask, out_index);
+}
+
+/**
+ * (内部函数)
+ * 胶囊检测的标量路径,同时也是SIMD路径处理尾部元素的方式。
+ * 线段退化为点时 0/0 得到NaN,与SIMD路径的max/min一样被钳制为0,因此各路径逐位一致。
+ */
+static size_t OverlapCapsuleScalar(const float* _a_x, const float* _a_y, const float* _b_x, const float* _b_y,
+	const float* _radius, const long long* _team_mask, size_t _begin, size_t _num,
+	float _center_x, float _center_y, float _center_radius, long long _mask, unsigned int* out_index)
+{
+	size_t l_count = 0;
+	for (size_t i = _begin; i < _num; ++i)
+	{
+		if (_team_mask != nullptr && (_team_mask[i] & _mask) == 0)
+		{
+			continue;
+		}
+		float l_ex = _b_x[i] - _a_x[i];
+		float l_ey = _b_y[i] - _a_y[i];
+		float l_px = _center_x - _a_x[i];
+		float l_py = _center_y - _a_y[i];
+		float l_t = (l_px * l_ex + l_py * l_ey) / (l_ex * l_ex + l_ey * l_ey);
+		l_t = l_t > 0.0f ? l_t : 0.0f;
+		l_t = l_t < 1.0f ? l_t : 1.0f;
+		float l_dx = l_px - l_ex * l_t;
+		float l_dy = l_py - l_ey * l_t;
+		float l_reach = _radius[i] + _center_radius;
+		if (l_dx * l_dx + l_dy * l_dy <= l_reach * l_reach)
+		{
+			out_index[l_count++] = static_cast<unsigned int>(i);
+		}
+	}
+	return l_count;
+}
+
+#if defined(MAD_SIMD_X86)
+/**
+ * (内部函数)
+ * 胶囊检测的SSE2路径,每次检测4条线段,TeamMask的过滤方式与OverlapCircleSSE2相同。
+ */
+MAD_TARGET_SSE2
+static size_t OverlapCapsuleSSE2(const float* _a_x, const float* _a_y, const float* _b_x, const float* _b_y,
+	const float* _radius, const long long* _team_mask, size_t _num,
+	float _center_x, float _center_y, float _center_radius, long long _mask, unsigned int* out_index)
+{
+	const __m128 l_center_x = _mm_set1_ps(_center_x);
+	const __m128 l_center_y = _mm_set1_ps(_center_y);
+	const __m128 l_center_radius = _mm_set1_ps(_center_radius);
+	const __m128 l_zero = _mm_setzero_ps();
+	const __m128 l_one = _mm_set1_ps(1.0f);
+	const __m128i l_mask = _mm_set1_epi64x(_mask);
+	const __m128i l_izero = _mm_setzero_si128();
+	size_t l_count = 0;
+	size_t i = 0;
+	for (; i + 4 <= _num; i += 4)
+	{
+		__m128 l_ax = _mm_loadu_ps(_a_x + i);
+		__m128 l_ay = _mm_loadu_ps(_a_y + i);
+		__m128 l_ex = _mm_sub_ps(_mm_loadu_ps(_b_x + i), l_ax);
+		__m128 l_ey = _mm_sub_ps(_mm_loadu_ps(_b_y + i), l_ay);
+		__m128 l_px = _mm_sub_ps(l_center_x, l_ax);
+		__m128 l_py = _mm_sub_ps(l_center_y, l_ay);
+		__m128 l_t = _mm_div_ps(_mm_add_ps(_mm_mul_ps(l_px, l_ex), _mm_mul_ps(l_py, l_ey)),
+			_mm_add_ps(_mm_mul_ps(l_ex, l_ex), _mm_mul_ps(l_ey, l_ey)));
+		l_t = _mm_min_ps(_mm_max_ps(l_t, l_zero), l_one);
+		__m128 l_dx = _mm_sub_ps(l_px, _mm_mul_ps(l_ex, l_t));
+		__m128 l_dy = _mm_sub_ps(l_py, _mm_mul_ps(l_ey, l_t));
+		__m128 l_reach = _mm_add_ps(_mm_loadu_ps(_radius + i), l_center_radius);
+		__m128 l_inside = _mm_cmple_ps(_mm_add_ps(_mm_mul_ps(l_dx, l_dx), _mm_mul_ps(l_dy, l_dy)), _mm_mul_ps(l_reach, l_reach));
+		if (_team_mask != nullptr)
+		{
+			__m128i l_lo = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_team_mask + i)), l_mask), l_izero);
+			__m128i l_hi = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_team_mask + i + 2)), l_mask), l_izero);
+			l_lo = _mm_and_si128(l_lo, _mm_shuffle_epi32(l_lo, _MM_SHUFFLE(2, 3, 0, 1)));
+			l_hi = _mm_and_si128(l_hi, _mm_shuffle_epi32(l_hi, _MM_SHUFFLE(2, 3, 0, 1)));
+			__m128 l_miss = _mm_shuffle_ps(_mm_castsi128_ps(l_lo), _mm_castsi128_ps(l_hi), _MM_SHUFFLE(2, 0, 2, 0));
+			l_inside = _mm_andnot_ps(l_miss, l_inside);
+		}
+		int l_hit = _mm_movemask_ps(l_inside);
+		while (l_hit != 0)
+		{
+			int l_bit = 0;
+			while (((l_hit >> l_bit) & 1) == 0)
+			{
+				l_bit++;
+			}
+			out_index[l_count++] = static_cast<unsigned int>(i + l_bit);
+			l_hit &= l_hit - 1;
+		}
+	}
+	return l_count + OverlapCapsuleScalar(_a_x, _a_y, _b_x, _b_y, _radius, _team_mask, i, _num,
+		_center_x, _center_y, _center_radius, _mask, out_index + l_count);
+}
+
+/**
+ * (内部函数)
+ * 胶囊检测的AVX2路径,每次检测8条线段。
+ */
+MAD_TARGET_AVX2
+static size_t OverlapCapsuleAVX2(const float* _a_x, const float* _a_y, const float* _b_x, const float* _b_y,
+	const float* _radius, const long long* _team_mask, size_t _num,
+	float _center_x, float _center_y, float _center_radius, long long _mask, unsigned int* out_index)
+{
+	const __m256 l_center_x = _mm256_set1_ps(_center_x);
+	const __m256 l_center_y = _mm256_set1_ps(_center_y);
+	const __m256 l_center_radius = _mm256_set1_ps(_center_radius);
+	const __m256 l_zero = _mm256_setzero_ps();
+	const __m256 l_one = _mm256_set1_ps(1.0f);
+	const __m256i l_mask = _mm256_set1_epi64x(_mask);
+	const __m256i l_izero = _mm256_setzero_si256();
+	size_t l_count = 0;
+	size_t i = 0;
+	for (; i + 8 <= _num; i += 8)
+	{
+		__m256 l_ax = _mm256_loadu_ps(_a_x + i);
+		__m256 l_ay = _mm256_loadu_ps(_a_y + i);
+		__m256 l_ex = _mm256_sub_ps(_mm256_loadu_ps(_b_x + i), l_ax);
+		__m256 l_ey = _mm256_sub_ps(_mm256_loadu_ps(_b_y + i), l_ay);
+		__m256 l_px = _mm256_sub_ps(l_center_x, l_ax);
+		__m256 l_py = _mm256_sub_ps(l_center_y, l_ay);
+		__m256 l_t = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(l_px, l_ex), _mm256_mul_ps(l_py, l_ey)),
+			_mm256_add_ps(_mm256_mul_ps(l_ex, l_ex), _mm256_mul_ps(l_ey, l_ey)));
+		l_t = _mm256_min_ps(_mm256_max_ps(l_t, l_zero), l_one);
+		__m256 l_dx = _mm256_sub_ps(l_px, _mm256_mul_ps(l_ex, l_t));
+		__m256 l_dy = _mm256_sub_ps(l_py, _mm256_mul_ps(l_ey, l_t));
+		__m256 l_reach = _mm256_add_ps(_mm256_loadu_ps(_radius + i), l_center_radius);
+		__m256 l_inside = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(l_dx, l_dx), _mm256_mul_ps(l_dy, l_dy)),
+			_mm256_mul_ps(l_reach, l_reach), _CMP_LE_OQ);
+		if (_team_mask != nullptr)
+		{
+			__m256i l_lo = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(_team_mask + i)), l_mask), l_izero);
+			__m256i l_hi = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(_team_mask + i + 4)), l_mask), l_izero);
+			__m256 l_miss = _mm256_shuffle_ps(_mm256_castsi256_ps(l_lo), _mm256_castsi256_ps(l_hi), _MM_SHUFFLE(2, 0, 2, 0));
+			l_miss = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(l_miss), _MM_SHUFFLE(3, 1, 2, 0)));
+			l_inside = _mm256_andnot_ps(l_miss, l_inside);
+		}
+		int l_hit = _mm256_movemask_ps(l_inside);
+		while (l_hit != 0)
+		{
+			int l_bit = 0;
+			while (((l_hit >> l_bit) & 1) == 0)
+			{
+				l_bit++;
+			}
+			out_index[l_count++] = static_cast<unsigned int>(i + l_bit);
+			l_hit &= l_hit - 1;
+		}
+	}
+	_mm256_zeroupper();
+	return l_count + OverlapCapsuleScalar(_a_x, _a_y, _b_x, _b_y, _radius, _team_mask, i, _num,
+		_center_x, _center_y, _center_radius, _mask, out_index + l_count);
+}
+#endif
+
+/**
+ * 对一组胶囊(带半径的线段)做圆形检测,找出与以 (_center_x, _center_y) 为圆心、_center_radius 为半径的圆相交的胶囊。
+ * 第i个胶囊为从 (_a_x[i], _a_y[i]) 到 (_b_x[i], _b_y[i]) 的线段,半径为 _radius[i]。
+ * 折线可以把 _b_x、_b_y 传为 _a_x + 1、_a_y + 1,一次检测所有相邻节点之间的线段。
+ * TeamMask的过滤方式与OverlapCircle相同。
+ *
+ * @param _a_x 线段起点X数组
+ * @param _a_y 线段起点Y数组
+ * @param _b_x 线段终点X数组
+ * @param _b_y 线段终点Y数组
+ * @param _radius 胶囊半径数组
+ * @param _team_mask TeamMask数组,可为nullptr
+ * @param _num 胶囊数量
+ * @param _center_x 圆心X
+ * @param _center_y 圆心Y
+ * @param _center_radius 圆的半径(实体的TestRadius)
+ * @param _mask 实体的TeamMask
+ * @param[out] out_index 相交胶囊的索引(升序),至少能容纳 _num 个元素
+ * @return 相交胶囊的数量
+ */
+size_t MADBulletKernel::OverlapCapsule(const float* _a_x, const float* _a_y, const float* _b_x, const float* _b_y,
+	const float* _radius, const long long* _team_mask, size_t _num,
+	float _center_x, float _center_y, float _center_radius, long long _mask, unsigned int* out_index)
+{
+#if defined(MAD_SIMD_X86)
+	switch (MADSimd::GetLevel())
+	{
+	case MADSimdLevel::AVX2:
+		return OverlapCapsuleAVX2(_a_x, _a_y, _b_x, _b_y, _radius, _team_mask, _num, _center_x, _center_y, _center_radius, _mask, out_index);
+	case MADSimdLevel::SSE2:
+		return OverlapCapsuleSSE2(_a_x, _a_y, _b_x, _b_y, _radius, _team_mask, _num, _center_x, _center_y, _center_radius, _mask, out_index);
+	case MADSimdLevel::Scalar:
+		break;
+	}
+#endif
+	return OverlapCapsuleScalar(_a_x, _a_y, _b_x, _b_y, _radius, _team_mask, 0, _num,
+		_center_x, _center_y, _center_radius, _mask, out_index);
+}
+
+/**
+ * (内部函数)
+ * 转向的标量路径,同时也是SIMD路径处理尾部元素的方式。
+ * 符号翻转与SIMD路径一样只改变sin的符号位,因此各路径逐位一致。
+ */
+static void SteerScalar(const float* _pos_x, const float* _pos_y, float* _dir_x, float* _dir_y,
+	const float* _target_x, const float* _target_y, const float* _turn_cos, const float* _turn_sin,
+	size_t _begin, size_t _num)
+{
+	for (size_t i = _begin; i < _num; ++i)
+	{
+		float l_dx = _dir_x[i];
+		float l_dy = _dir_y[i];
+		float l_tx = _target_x[i] - _pos_x[i];
+		float l_ty = _target_y[i] - _pos_y[i];
+		float l_speed = std::sqrt(l_dx * l_dx + l_dy * l_dy);
+		float l_dist = std::sqrt(l_tx * l_tx + l_ty * l_ty);
+		if (!(l_speed > 0.0f && l_dist > 0.0f))
+		{
+			continue;
+		}
+		float l_dot = l_dx * l_tx + l_dy * l_ty;
+		float l_cross = l_dx * l_ty - l_dy * l_tx;
+		if (l_dot >= (l_speed * l_dist) * _turn_cos[i])
+		{
+			float l_scale = l_speed / l_dist;
+			_dir_x[i] = l_tx * l_scale;
+			_dir_y[i] = l_ty * l_scale;
+		}
+		else
+		{
+			float l_sin = l_cross < 0.0f ? -_turn_sin[i] : _turn_sin[i];
+			_dir_x[i] = l_dx * _turn_cos[i] - l_dy * l_sin;
+			_dir_y[i] = l_dx * l_sin + l_dy * _turn_cos[i];
+		}
+	}
+}
+
+#if defined(MAD_SIMD_X86)
+/**
+ * (内部函数)
+ * 转向的SSE2路径,每次处理4颗子弹,两种结果都计算后按掩码选择。
+ */
+MAD_TARGET_SSE2
+static void SteerSSE2(const float* _pos_x, const float* _pos_y, float* _dir_x, float* _dir_y,
+	const float* _target_x, const float* _target_y, const float* _turn_cos, const float* _turn_sin, size_t _num)
+{
+	const __m128 l_zero = _mm_setzero_ps();
+	const __m128 l_sign = _mm_set1_ps(-0.0f);
+	size_t i = 0;
+	for (; i + 4 <= _num; i += 4)
+	{
+		__m128 l_dx = _mm_loadu_ps(_dir_x + i);
+		__m128 l_dy = _mm_loadu_ps(_dir_y + i);
+		__m128 l_tx = _mm_sub_ps(_mm_loadu_ps(_target_x + i), _mm_loadu_ps(_pos_x + i));
+		__m128 l_ty = _mm_sub_ps(_mm_loadu_ps(_target_y + i), _mm_loadu_ps(_pos_y + i));
+		__m128 l_cos = _mm_loadu_ps(_turn_cos + i);
+		__m128 l_speed = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(l_dx, l_dx), _mm_mul_ps(l_dy, l_dy)));
+		__m128 l_dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(l_tx, l_tx), _mm_mul_ps(l_ty, l_ty)));
+		__m128 l_valid = _mm_and_ps(_mm_cmpgt_ps(l_speed, l_zero), _mm_cmpgt_ps(l_dist, l_zero));
+		if (_mm_movemask_ps(l_valid) == 0)
+		{
+			continue;
+		}
+		__m128 l_dot = _mm_add_ps(_mm_mul_ps(l_dx, l_tx), _mm_mul_ps(l_dy, l_ty));
+		__m128 l_cross = _mm_sub_ps(_mm_mul_ps(l_dx, l_ty), _mm_mul_ps(l_dy, l_tx));
+		__m128 l_reach = _mm_cmpge_ps(l_dot, _mm_mul_ps(_mm_mul_ps(l_speed, l_dist), l_cos));
+
+		__m128 l_scale = _mm_div_ps(l_speed, l_dist);
+		__m128 l_ax = _mm_mul_ps(l_tx, l_scale);
+		__m128 l_ay = _mm_mul_ps(l_ty, l_scale);
+		__m128 l_sin = _mm_xor_ps(_mm_loadu_ps(_turn_sin + i), _mm_and_ps(_mm_cmplt_ps(l_cross, l_zero), l_sign));
+		__m128 l_rx = _mm_sub_ps(_mm_mul_ps(l_dx, l_cos), _mm_mul_ps(l_dy, l_sin));
+		__m128 l_ry = _mm_add_ps(_mm_mul_ps(l_dx, l_sin), _mm_mul_ps(l_dy, l_cos));
+
+		__m128 l_nx = _mm_or_ps(_mm_and_ps(l_reach, l_ax), _mm_andnot_ps(l_reach, l_rx));
+		__m128 l_ny = _mm_or_ps(_mm_and_ps(l_reach, l_ay), _mm_andnot_ps(l_reach, l_ry));
+		_mm_storeu_ps(_dir_x + i, _mm_or_ps(_mm_and_ps(l_valid, l_nx), _mm_andnot_ps(l_valid, l_dx)));
+		_mm_storeu_ps(_dir_y + i, _mm_or_ps(_mm_and_ps(l_valid, l_ny), _mm_andnot_ps(l_valid, l_dy)));
+	}
+	SteerScalar(_pos_x, _pos_y, _dir_x, _dir_y, _target_x, _target_y, _turn_cos, _turn_sin, i, _num);
+}
+
+/**
+ * (内部函数)
+ * 转向的AVX2路径,每次处理8颗子弹。
+ */
+MAD_TARGET_AVX2
+static void SteerAVX2(const float* _pos_x, const float* _pos_y, float* _dir_x, float* _dir_y,
+	const float* _target_x, const float* _target_y, const float* _turn_cos, const float* _turn_sin, size_t _num)
+{
+	const __m256 l_zero = _mm256_setzero_ps();
+	const __m256 l_sign = _mm256_set1_ps(-0.0f);
+	size_t i = 0;
+	for (; i + 8 <= _num; i += 8)
+	{
+		__m256 l_dx = _mm256_loadu_ps(_dir_x + i);
+		__m256 l_dy = _mm256_loadu_ps(_dir_y + i);
+		__m256 l_tx = _mm256_sub_ps(_mm256_loadu_ps(_target_x + i), _mm256_loadu_ps(_pos_x + i));
+		__m256 l_ty = _mm256_sub_ps(_mm256_loadu_ps(_target_y + i), _mm256_loadu_ps(_pos_y + i));
+		__m256 l_cos = _mm256_loadu_ps(_turn_cos + i);
+		__m256 l_speed = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(l_dx, l_dx), _mm256_mul_ps(l_dy, l_dy)));
+		__m256 l_dist = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(l_tx, l_tx), _mm256_mul_ps(l_ty, l_ty)));
+		__m256 l_valid = _mm256_and_ps(_mm256_cmp_ps(l_speed, l_zero, _CMP_GT_OQ), _mm256_cmp_ps(l_dist, l_zero, _CMP_GT_OQ));
+		if (_mm256_movemask_ps(l_valid) == 0)
+		{
+			continue;
+		}
+		__m256 l_dot = _mm256_add_ps(_mm256_mul_ps(l_dx, l_tx), _mm256_mul_ps(l_dy, l_ty));
+		__m256 l_cross = _mm256_sub_ps(_mm256_mul_ps(l_dx, l_ty), _mm256_mul_ps(l_dy, l_tx));
+		__m256 l_reach = _mm256_cmp_ps(l_dot, _mm256_mul_ps(_mm256_mul_ps(l_speed, l_dist), l_cos), _CMP_GE_OQ);
+
+		__m256 l_scale = _mm256_div_ps(l_speed, l_dist);
+		__m256 l_ax = _mm256_mul_ps(l_tx, l_scale);
+		__m256 l_ay = _mm256_mul_ps(l_ty, l_scale);
+		__m256 l_sin = _mm256_xor_ps(_mm256_loadu_ps(_turn_sin + i), _mm256_and_ps(_mm256_cmp_ps(l_cross, l_zero, _CMP_LT_OQ), l_sign));
+		__m256 l_rx = _mm256_sub_ps(_mm256_mul_ps(l_dx, l_cos), _mm256_mul_ps(l_dy, l_sin));
+		__m256 l_ry = _mm256_add_ps(_mm256_mul_ps(l_dx, l_sin), _mm256_mul_ps(l_dy, l_cos));
+
+		__m256 l_nx = _mm256_blendv_ps(l_rx, l_ax, l_reach);
+		__m256 l_ny = _mm256_blendv_ps(l_ry, l_ay, l_reach);
+		_mm256_storeu_ps(_dir_x + i, _mm256_blendv_ps(l_dx, l_nx, l_valid));
+		_mm256_storeu_ps(_dir_y + i, _mm256_blendv_ps(l_dy, l_ny, l_valid));
+	}
+	_mm256_zeroupper();
+	SteerScalar(_pos_x, _pos_y, _dir_x, _dir_y, _target_x, _target_y, _turn_cos, _turn_sin, i, _num);
+}
+#endif
+
+/**
+ * 让一组子弹的速度方向以有限的转向角转向各自的目标点,速度大小保持不变。
+ * 转向角以 (cos, sin) 的形式传入,运算只使用点积、叉积与开方,不调用三角函数:
+ * - 速度与目标方向的夹角不超过转向角时,速度直接对准目标;
+ * - 否则按叉积的符号向目标一侧旋转转向角。
+ * 速度为0或目标与子弹重合的子弹保持不变,因此没有目标的子弹可以把目标点设为自身位置。
+ *
+ * @param _pos_x 位置X数组
+ * @param _pos_y 位置Y数组
+ * @param[in,out] _dir_x 速度X数组
+ * @param[in,out] _dir_y 速度Y数组
+ * @param _target_x 目标点X数组
+ * @param _target_y 目标点Y数组
+ * @param _turn_cos 本次最大转向角的余弦数组
+ * @param _turn_sin 本次最大转向角的正弦数组,应不小于0
+ * @param _num 子弹数量
+ */
+void MADBulletKernel::Steer(const float* _pos_x, const float* _pos_y, float* _dir_x, float* _dir_y,
+	const float* _target_x, const float* _target_y, const float* _turn_cos, const float* _turn_sin, size_t _num)
+{
+#if defined(MAD_SIMD_X86)
+	switch (MADSimd::GetLevel())
+	{
+	case MADSimdLevel::AVX2:
+		SteerAVX2(_pos_x, _pos_y, _dir_x, _dir_y, _target_x, _target_y, _turn_cos, _turn_sin, _num);
+		return;
+	case MADSimdLevel::SSE2:
+		SteerSSE2(_pos_x, _pos_y, _dir_x, _dir_y, _target_x, _target_y, _turn_cos, _turn_sin, _num);
+		return;
+	case MADSimdLevel::Scalar:
+		break;
+	}
+#endif
+	SteerScalar(_pos_x, _pos_y, _dir_x, _dir_y, _target_x, _target_y, _turn_cos, _turn_sin, 0, _num);
+}
+
+/**
+ * (内部函数)
+ * 子弹组变换的标量路径,同时也是SIMD路径处理尾部元素的方式。
+ */
+static void TransformScalar(const float* _local_x, const float* _local_y, const float* _local_dx, const float* _local_dy,
+	size_t _num, const MADBulletTransform& _transform,
+	float* out_pos_x, float* out_pos_y, float* out_dir_x, float* out_dir_y)
+{
+	const float l_cos = _transform.Cos;
+	const float l_sin = _transform.Sin;
+	for (size_t i = 0; i < _num; ++i)
+	{
+		float l_rx = l_cos * _local_x[i] - l_sin * _local_y[i];
+		float l_ry = l_sin * _local_x[i] + l_cos * _local_y[i];
+		float l_vx = l_cos * _local_dx[i] - l_sin * _local_dy[i];
+		float l_vy = l_sin * _local_dx[i] + l_cos * _local_dy[i];
+		out_pos_x[i] = _transform.Offset_X + l_rx;
+		out_pos_y[i] = _transform.Offset_Y + l_ry;
+		out_dir_x[i] = (_transform.Velocity_X + l_vx) - _transform.Angular * l_ry;
+		out_dir_y[i] = (_transform.Velocity_Y + l_vy) + _transform.Angular * l_rx;
+	}
+}
+
+#if defined(MAD_SIMD_X86)
+/**
+ * (内部函数)
+ * 子弹组变换的SSE2路径,每次变换4颗子弹。
+ */
+MAD_TARGET_SSE2
+static void TransformSSE2(const float* _local_x, const float* _local_y, const float* _local_dx, const float* _local_dy,
+	size_t _num, const MADBulletTransform& _transform,
+	float* out_pos_x, float* out_pos_y, float* out_dir_x, float* out_dir_y)
+{
+	const __m128 l_cos = _mm_set1_ps(_transform.Cos);
+	const __m128 l_sin = _mm_set1_ps(_transform.Sin);
+	const __m128 l_offset_x = _mm_set1_ps(_transform.Offset_X);
+	const __m128 l_offset_y = _mm_set1_ps(_transform.Offset_Y);
+	const __m128 l_velocity_x = _mm_set1_ps(_transform.Velocity_X);
+	const __m128 l_velocity_y = _mm_set1_ps(_transform.Velocity_Y);
+	const __m128 l_angular = _mm_set1_ps(_transform.Angular);
+	size_t i = 0;
+	for (; i + 4 <= _num; i += 4)
+	{
+		__m128 l_x = _mm_loadu_ps(_local_x + i);
+		__m128 l_y = _mm_loadu_ps(_local_y + i);
+		__m128 l_dx = _mm_loadu_ps(_local_dx + i);
+		__m128 l_dy = _mm_loadu_ps(_local_dy + i);
+		__m128 l_rx = _mm_sub_ps(_mm_mul_ps(l_cos, l_x), _mm_mul_ps(l_sin, l_y));
+		__m128 l_ry = _mm_add_ps(_mm_mul_ps(l_sin, l_x), _mm_mul_ps(l_cos, l_y));
+		__m128 l_vx = _mm_sub_ps(_mm_mul_ps(l_cos, l_dx), _mm_mul_ps(l_sin, l_dy));
+		__m128 l_vy = _mm_add_ps(_mm_mul_ps(l_sin, l_dx), _mm_mul_ps(l_cos, l_dy));
+		_mm_storeu_ps(out_pos_x + i, _mm_add_ps(l_offset_x, l_rx));
+		_mm_storeu_ps(out_pos_y + i, _mm_add_ps(l_offset_y, l_ry));
+		_mm_storeu_ps(out_dir_x + i, _mm_sub_ps(_mm_add_ps(l_velocity_x, l_vx), _mm_mul_ps(l_angular, l_ry)));
+		_mm_storeu_ps(out_dir_y + i, _mm_add_ps(_mm_add_ps(l_velocity_y, l_vy), _mm_mul_ps(l_angular, l_rx)));
+	}
+	TransformScalar(_local_x + i, _local_y + i, _local_dx + i, _local_dy + i, _num - i, _transform,
+		out_pos_x + i, out_pos_y + i, out_dir_x + i, out_dir_y + i);
+}
+
+/**
+ * (内部函数)
+ * 子弹组变换的AVX2路径,每次变换8颗子弹。
+ */
+MAD_TARGET_AVX2
+static void TransformAVX2(const float* _local_x, const float* _local_y, const float* _local_dx, const float* _local_dy,
+	size_t _num, const MADBulletTransform& _transform,
+	float* out_pos_x, float* out_pos_y, float* out_dir_x, float* out_dir_y)
+{
+	const __m256 l_cos = _mm256_set1_ps(_transform.Cos);
+	const __m256 l_sin = _mm256_set1_ps(_transform.Sin);
+	const __m256 l_offset_x = _mm256_set1_ps(_transform.Offset_X);
+	const __m256 l_offset_y = _mm256_set1_ps(_transform.Offset_Y);
+	const __m256 l_velocity_x = _mm256_set1_ps(_transform.Velocity_X);
+	const __m256 l_velocity_y = _mm256_set1_ps(_transform.Velocity_Y);
+	const __m256 l_angular = _mm256_set1_ps(_transform.Angular);
+	size_t i = 0;
+	for (; i + 8 <= _num; i += 8)
+	{
+		__m256 l_x = _mm256_loadu_ps(_local_x + i);
+		__m256 l_y = _mm256_loadu_ps(_local_y + i);
+		__m256 l_dx = _mm256_loadu_ps(_local_dx + i);
+		__m256 l_dy = _mm256_loadu_ps(_local_dy + i);
+		__m256 l_rx = _mm256_sub_ps(_mm256_mul_ps(l_cos, l_x), _mm256_mul_ps(l_sin, l_y));
+		__m256 l_ry = _mm256_add_ps(_mm256_mul_ps(l_sin, l_x), _mm256_mul_ps(l_cos, l_y));
+		__m256 l_vx = _mm256_sub_ps(_mm256_mul_ps(l_cos, l_dx), _mm256_mul_ps(l_sin, l_dy));
+		__m256 l_vy = _mm256_add_ps(_mm256_mul_ps(l_sin, l_dx), _mm256_mul_ps(l_cos, l_dy));
+		_mm256_storeu_ps(out_pos_x + i, _mm256_add_ps(l_offset_x, l_rx));
+		_mm256_storeu_ps(out_pos_y + i, _mm256_add_ps(l_offset_y, l_ry));
+		_mm256_storeu_ps(out_dir_x + i, _mm256_sub_ps(_mm256_add_ps(l_velocity_x, l_vx), _mm256_mul_ps(l_angular, l_ry)));
+		_mm256_storeu_ps(out_dir_y + i, _mm256_add_ps(_mm256_add_ps(l_velocity_y, l_vy), _mm256_mul_ps(l_angular, l_rx)));
+	}
+	_mm256_zeroupper();
+	TransformScalar(_local_x + i, _local_y + i, _local_dx + i, _local_dy + i, _num - i, _transform,
+		out_pos_x + i, out_pos_y + i, out_dir_x + i, out_dir_y + i);
+}
+#endif
+
+/**
+ * 将一段子弹组成员从局部空间变换到世界空间,写出世界坐标与世界速度。
+ * 整组共享同一个变换,因此只是一次对连续数组的矩阵乘加,执行路径由MADSimd::GetLevel()决定,各路径结果逐位一致。
+ *
+ * @param _local_x 局部位置X数组
+ * @param _local_y 局部位置Y数组
+ * @param _local_dx 局部速度X数组
+ * @param _local_dy 局部速度Y数组
+ * @param _num 要处理的子弹数量
+ * @param _transform 组的世界变换
+ * @param[out] out_pos_x 世界位置X输出
+ * @param[out] out_pos_y 世界位置Y输出
+ * @param[out] out_dir_x 世界速度X输出
+ * @param[out] out_dir_y 世界速度Y输出
+ */
+void MADBulletKernel::Transform(const float* _local_x, const float* _local_y, const float* _local_dx, const float* _local_dy,
+	size_t _num, const MADBulletTransform& _transform,
+	float* out_pos_x, float* out_pos_y, float* out_dir_x, float* out_dir_y)
+{
+#if defined(MAD_SIMD_X86)
+	switch (MADSimd::GetLevel())
+	{
+	case MADSimdLevel::AVX2:
+		TransformAVX2(_local_x, _local_y, _local_dx, _local_dy, _num, _transform, out_pos_x, out_pos_y, out_dir_x, out_dir_y);
+		return;
+	case MADSimdLevel::SSE2:
+		TransformSSE2(_local_x, _local_y, _local_dx, _local_dy, _num, _transform, out_pos_x, out_pos_y, out_dir_x, out_dir_y);
+		return;
+	case MADSimdLevel::Scalar:
+		break;
+	}
+#endif
+	TransformScalar(_local_x, _local_y, _local_dx, _local_dy, _num, _transform, out_pos_x, out_pos_y, out_dir_x, out_dir_y);
+}
+
+/**
+ * (内部函数)
+ * 按补码回绕相加两个16.16定点数,与SIMD路径的32位整数加法一致,避免有符号溢出。
+ */
+static inline int FixedAdd(int _a, int _b)
+{
+	return static_cast<int>(static_cast<unsigned int>(_a) + static_cast<unsigned int>(_b));
+}
+
+/**
+ * (内部函数)
+ * 定点积分内核的标量路径,同时也是SIMD路径处理尾部元素的方式。
+ */
+static void IntegrateFixedScalar(int* _pos_x, int* _pos_y, const unsigned short* _angle, const short* _speed,
+	unsigned int* _alive_tick, size_t _num, MADFixedFlushResData* out_res)
+{
+	for (size_t i = 0; i < _num; ++i)
+	{
+		int l_step_x, l_step_y;
+		MADFixed::GetStep(_angle[i], _speed[i], &l_step_x, &l_step_y);
+		_pos_x[i] = FixedAdd(_pos_x[i], l_step_x);
+		_pos_y[i] = FixedAdd(_pos_y[i], l_step_y);
+		_alive_tick[i] = _alive_tick[i] + 1;
+		if (out_res != nullptr)
+		{
+			out_res[i].Position_X = _pos_x[i];
+			out_res[i].Position_Y = _pos_y[i];
+			out_res[i].Angle = _angle[i];
+			out_res[i].Speed = _speed[i];
+		}
+	}
+}
+
+#if defined(MAD_SIMD_X86)
+/**
+ * (内部函数)
+ * 把4颗子弹的位置与(角度,速率)对转置为4条12字节的MADFixedFlushResData,共3次写入。
+ * 浮点重排指令只搬运位模式,不解释数值,因此可以用来重排整数。
+ */
+MAD_TARGET_SSE2
+static inline void StoreFixedRecords(__m128i _pos_x, __m128i _pos_y, __m128i _angle_speed, MADFixedFlushResData* out_res)
+{
+	__m128 l_x = _mm_castsi128_ps(_pos_x);
+	__m128 l_y = _mm_castsi128_ps(_pos_y);
+	__m128 l_a = _mm_castsi128_ps(_angle_speed);
+	__m128 l_t0 = _mm_unpacklo_ps(l_x, l_y);
+	__m128 l_t1 = _mm_unpackhi_ps(l_x, l_y);
+	__m128 l_s0 = _mm_shuffle_ps(l_a, l_t0, _MM_SHUFFLE(2, 2, 0, 0));
+	__m128 l_s1 = _mm_shuffle_ps(l_t0, l_a, _MM_SHUFFLE(1, 1, 3, 3));
+	__m128 l_s2 = _mm_shuffle_ps(l_a, l_t1, _MM_SHUFFLE(3, 2, 3, 2));
+	float* l_out = reinterpret_cast<float*>(out_res);
+	_mm_storeu_ps(l_out, _mm_shuffle_ps(l_t0, l_s0, _MM_SHUFFLE(2, 0, 1, 0)));
+	_mm_storeu_ps(l_out + 4, _mm_shuffle_ps(l_s1, l_t1, _MM_SHUFFLE(1, 0, 2, 0)));
+	_mm_storeu_ps(l_out + 8, _mm_shuffle_ps(l_s2, l_s2, _MM_SHUFFLE(1, 3, 2, 0)));
+}
+
+/**
+ * (内部函数)
+ * 定点积分内核的SSE2路径,每次处理4颗子弹。
+ * SSE2没有查表指令,角度表按标量读取;速率与0交错成16位对后,pmaddwd一次得到 speed * cos 或 speed * sin。
+ */
+MAD_TARGET_SSE2
+static void IntegrateFixedSSE2(int* _pos_x, int* _pos_y, const unsigned short* _angle, const short* _speed,
+	unsigned int* _alive_tick, size_t _num, MADFixedFlushResData* out_res)
+{
+	const unsigned int* l_table = MADFixed::GetCosSinTable();
+	const int l_shift = 16 - MAD_FIXED_ANGLE_TABLE_BITS;
+	const __m128i l_zero = _mm_setzero_si128();
+	const __m128i l_one = _mm_set1_epi32(1);
+	size_t i = 0;
+	for (; i + 4 <= _num; i += 4)
+	{
+		__m128i l_cos_sin = _mm_set_epi32(static_cast<int>(l_table[_angle[i + 3] >> l_shift]),
+			static_cast<int>(l_table[_angle[i + 2] >> l_shift]), static_cast<int>(l_table[_angle[i + 1] >> l_shift]),
+			static_cast<int>(l_table[_angle[i] >> l_shift]));
+		__m128i l_speed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(_speed + i));
+		__m128i l_step_x = _mm_srai_epi32(_mm_madd_epi16(l_cos_sin, _mm_unpacklo_epi16(l_speed, l_zero)), MAD_FIXED_STEP_SHIFT);
+		__m128i l_step_y = _mm_srai_epi32(_mm_madd_epi16(l_cos_sin, _mm_unpacklo_epi16(l_zero, l_speed)), MAD_FIXED_STEP_SHIFT);
+		__m128i l_px = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_pos_x + i)), l_step_x);
+		__m128i l_py = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_pos_y + i)), l_step_y);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_pos_x + i), l_px);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_pos_y + i), l_py);
+		__m128i l_alive = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_alive_tick + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_alive_tick + i), _mm_add_epi32(l_alive, l_one));
+
+		if (out_res != nullptr)
+		{
+			__m128i l_angle = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(_angle + i));
+			StoreFixedRecords(l_px, l_py, _mm_unpacklo_epi16(l_angle, l_speed), out_res + i);
+		}
+	}
+	IntegrateFixedScalar(_pos_x + i, _pos_y + i, _angle + i, _speed + i, _alive_tick + i, _num - i,
+		out_res != nullptr ? out_res + i : nullptr);
+}
+
+/**
+ * (内部函数)
+ * 定点积分内核的AVX2路径,每次处理8颗子弹,角度表用vpgatherdd一次读取8项。
+ */
+MAD_TARGET_AVX2
+static void IntegrateFixedAVX2(int* _pos_x, int* _pos_y, const unsigned short* _angle, const short* _speed,
+	unsigned int* _alive_tick, size_t _num, MADFixedFlushResData* out_res)
+{
+	const int* l_table = reinterpret_cast<const int*>(MADFixed::GetCosSinTable());
+	const __m256i l_one = _mm256_set1_epi32(1);
+	size_t i = 0;
+	for (; i + 8 <= _num; i += 8)
+	{
+		__m128i l_angle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_angle + i));
+		__m128i l_speed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_speed + i));
+		__m256i l_index = _mm256_srli_epi32(_mm256_cvtepu16_epi32(l_angle), 16 - MAD_FIXED_ANGLE_TABLE_BITS);
+		__m256i l_cos_sin = _mm256_i32gather_epi32(l_table, l_index, 4);
+		__m256i l_speed_x = _mm256_cvtepu16_epi32(l_speed);
+		__m256i l_speed_y = _mm256_slli_epi32(l_speed_x, 16);
+		__m256i l_step_x = _mm256_srai_epi32(_mm256_madd_epi16(l_cos_sin, l_speed_x), MAD_FIXED_STEP_SHIFT);
+		__m256i l_step_y = _mm256_srai_epi32(_mm256_madd_epi16(l_cos_sin, l_speed_y), MAD_FIXED_STEP_SHIFT);
+		__m256i l_px = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(_pos_x + i)), l_step_x);
+		__m256i l_py = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(_pos_y + i)), l_step_y);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(_pos_x + i), l_px);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(_pos_y + i), l_py);
+		__m256i l_alive = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_alive_tick + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(_alive_tick + i), _mm256_add_epi32(l_alive, l_one));
+
+		if (out_res != nullptr)
+		{
+			StoreFixedRecords(_mm256_castsi256_si128(l_px), _mm256_castsi256_si128(l_py),
+				_mm_unpacklo_epi16(l_angle, l_speed), out_res + i);
+			StoreFixedRecords(_mm256_extracti128_si256(l_px, 1), _mm256_extracti128_si256(l_py, 1),
+				_mm_unpackhi_epi16(l_angle, l_speed), out_res + i + 4);
+		}
+	}
+	_mm256_zeroupper();
+	IntegrateFixedScalar(_pos_x + i, _pos_y + i, _angle + i, _speed + i, _alive_tick + i, _num - i,
+		out_res != nullptr ? out_res + i : nullptr);
+}
+#endif
+
+/**
+ * 将一段定点子弹沿各自的角度前进一个tick,并可选地同时写出定点刷新数据。
+ * 只使用整数运算:位移 = (速率 * 角度表中的cos或sin) >> MAD_FIXED_STEP_SHIFT,坐标按32位补码回绕相加,
+ * 因此结果与编译器、优化等级和指令集无关,各路径逐位一致。
+ *
+ * @param _pos_x 16.16位置X数组,原地更新
+ * @param _pos_y 16.16位置Y数组,原地更新
+ * @param _angle 16位角度数组
+ * @param _speed 8.8速率数组(单位/tick)
+ * @param _alive_tick 存活tick数组,原地加1
+ * @param _num 要处理的子弹数量
+ * @param[out] out_res 可选的刷新数据输出,至少能容纳 _num 条记录;传入nullptr则不输出
+ */
+void MADBulletKernel::IntegrateFixed(int* _pos_x, int* _pos_y, const unsigned short* _angle, const short* _speed,
+	unsigned int* _alive_tick, size_t _num, MADFixedFlushResData* out_res)
+{
+#if defined(MAD_SIMD_X86)
+	switch (MADSimd::GetLevel())
+	{
+	case MADSimdLevel::AVX2:
+		IntegrateFixedAVX2(_pos_x, _pos_y, _angle, _speed, _alive_tick, _num, out_res);
+		return;
+	case MADSimdLevel::SSE2:
+		IntegrateFixedSSE2(_pos_x, _pos_y, _angle, _speed, _alive_tick, _num, out_res);
+		return;
+	case MADSimdLevel::Scalar:
+		break;
+	}
+#endif
+	IntegrateFixedScalar(_pos_x, _pos_y, _angle, _speed, _alive_tick, _num, out_res);
+}
+
+/**
+ * (内部函数)
+ * 定点越界查找的标量路径。
+ */
+static size_t FindOutsideFixedScalar(const int* _pos_x, const int* _pos_y, size_t _begin, size_t _num,
+	int _min_x, int _min_y, int _max_x, int _max_y, unsigned int* out_index)
+{
+	size_t l_count = 0;
+	for (size_t i = _begin; i < _num; ++i)
+	{
+		if (_pos_x[i] < _min_x || _pos_x[i] > _max_x || _pos_y[i] < _min_y || _pos_y[i] > _max_y)
+		{
+			out_index[l_count++] = static_cast<unsigned int>(i);
+		}
+	}
+	return l_count;
+}
+
+#if defined(MAD_SIMD_X86)
+/**
+ * (内部函数)
+ * 定点越界查找的SSE2路径,每次比较4颗子弹。
+ */
+MAD_TARGET_SSE2
+static size_t FindOutsideFixedSSE2(const int* _pos_x, const int* _pos_y, size_t _num,
+	int _min_x, int _min_y, int _max_x, int _max_y, unsigned int* out_index)
+{
+	const __m128i l_min_x = _mm_set1_epi32(_min_x);
+	const __m128i l_min_y = _mm_set1_epi32(_min_y);
+	const __m128i l_max_x = _mm_set1_epi32(_max_x);
+	const __m128i l_max_y = _mm_set1_epi32(_max_y);
+	size_t l_count = 0;
+	size_t i = 0;
+	for (; i + 4 <= _num; i += 4)
+	{
+		__m128i l_x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_pos_x + i));
+		__m128i l_y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_pos_y + i));
+		__m128i l_out = _mm_or_si128(_mm_or_si128(_mm_cmplt_epi32(l_x, l_min_x), _mm_cmpgt_epi32(l_x, l_max_x)),
+			_mm_or_si128(_mm_cmplt_epi32(l_y, l_min_y), _mm_cmpgt_epi32(l_y, l_max_y)));
+		int l_outside = _mm_movemask_ps(_mm_castsi128_ps(l_out));
+		while (l_outside != 0)
+		{
+			int l_bit = 0;
+			while (((l_outside >> l_bit) & 1) == 0)
+			{
+				l_bit++;
+			}
+			out_index[l_count++] = static_cast<unsigned int>(i + l_bit);
+			l_outside &= l_outside - 1;
+		}
+	}
+	return l_count + FindOutsideFixedScalar(_pos_x, _pos_y, i, _num, _min_x, _min_y, _max_x, _max_y, out_index + l_count);
+}
+
+/**
+ * (内部函数)
+ * 定点越界查找的AVX2路径,每次比较8颗子弹。AVX2只有大于比较,小于比较交换操作数完成。
+ */
+MAD_TARGET_AVX2
+static size_t FindOutsideFixedAVX2(const int* _pos_x, const int* _pos_y, size_t _num,
+	int _min_x, int _min_y, int _max_x, int _max_y, unsigned int* out_index)
+{
+	const __m256i l_min_x = _mm256_set1_epi32(_min_x);
+	const __m256i l_min_y = _mm256_set1_epi32(_min_y);
+	const __m256i l_max_x = _mm256_set1_epi32(_max_x);
+	const __m256i l_max_y = _mm256_set1_epi32(_max_y);
+	size_t l_count = 0;
+	size_t i = 0;
+	for (; i + 8 <= _num; i += 8)
+	{
+		__m256i l_x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_pos_x + i));
+		__m256i l_y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_pos_y + i));
+		__m256i l_out = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(l_min_x, l_x), _mm256_cmpgt_epi32(l_x, l_max_x)),
+			_mm256_or_si256(_mm256_cmpgt_epi32(l_min_y, l_y), _mm256_cmpgt_epi32(l_y, l_max_y)));
+		int l_outside = _mm256_movemask_ps(_mm256_castsi256_ps(l_out));
+		while (l_outside != 0)
+		{
+			int l_bit = 0;
+			while (((l_outside >> l_bit) & 1) == 0)
+			{
+				l_bit++;
+			}
+			out_index[l_count++] = static_cast<unsigned int>(i + l_bit);
+			l_outside &= l_outside - 1;
+		}
+	}
+	_mm256_zeroupper();
+	return l_count + FindOutsideFixedScalar(_pos_x, _pos_y, i, _num, _min_x, _min_y, _max_x, _max_y, out_index + l_count);
+}
+#endif
+
+/**
+ * 找出位于定点矩形 [_min, _max] 之外的定点子弹,按升序写出它们的索引。
+ *
+ * @param _pos_x 16.16位置X数组
+ * @param _pos_y 16.16位置Y数组
+ * @param _num 子弹数量
+ * @param _min_x 边界左侧(16.16)
+ * @param _min_y 边界下侧(16.16)
+ * @param _max_x 边界右侧(16.16)
+ * @param _max_y 边界上侧(16.16)
+ * @param[out] out_index 越界子弹的索引,至少能容纳 _num 个元素
+ * @return 越界子弹的数量
+ */
+size_t MADBulletKernel::FindOutsideFixed(const int* _pos_x, const int* _pos_y, size_t _num,
+	int _min_x, int _min_y, int _max_x, int _max_y, unsigned int* out_index)
+{
+#if defined(MAD_SIMD_X86)
+	switch (MADSimd::GetLevel())
+	{
+	case MADSimdLevel::AVX2:
+		return FindOutsideFixedAVX2(_pos_x, _pos_y, _num, _min_x, _min_y, _max_x, _max_y, out_index);
+	case MADSimdLevel::SSE2:
+		return FindOutsideFixedSSE2(_pos_x, _pos_y, _num, _min_x, _min_y, _max_x, _max_y, out_index);
+	case MADSimdLevel::Scalar:
+		break;
+	}
+#endif
+	return FindOutsideFixedScalar(_pos_x, _pos_y, 0, _num, _min_x, _min_y, _max_x, _max_y, out_index);
+}
+
+/**
+ * (内部函数)
+ * 定点圆形检测的标量路径,同时也是SIMD路径处理尾部元素的方式。
+ * 坐标差先右移8位(精度1/256单位)并钳制到16位,与SIMD路径的饱和打包一致,平方和不会溢出32位。
+ */
+static size_t OverlapCircleFixedScalar(const int* _pos_x, const int* _pos_y, const long long* _team_mask,
+	size_t _begin, size_t _num, int _center_x, int _center_y, int _radius_sq, long long _mask,
+	unsigned int* out_index)
+{
+	size_t l_count = 0;
+	for (size_t i = _begin; i < _num; ++i)
+	{
+		if (_team_mask != nullptr && (_team_mask[i] & _mask) == 0)
+		{
+			continue;
+		}
+		int l_dx = FixedAdd(_pos_x[i], -_center_x) >> 8;
+		int l_dy = FixedAdd(_pos_y[i], -_center_y) >> 8;
+		l_dx = l_dx < -32767 ? -32767 : (l_dx > 32767 ? 32767 : l_dx);
+		l_dy = l_dy < -32767 ? -32767 : (l_dy > 32767 ? 32767 : l_dy);
+		if (l_dx * l_dx + l_dy * l_dy <= _radius_sq)
+		{
+			out_index[l_count++] = static_cast<unsigned int>(i);
+		}
+	}
+	return l_count;
+}
+
+#if defined(MAD_SIMD_X86)
+/**
+ * (内部函数)
+ * 定点圆形检测的SSE2路径,每次检测4颗子弹。
+ * X与Y的坐标差饱和打包到同一寄存器并交错,pmaddwd一次得到 dx*dx + dy*dy。
+ */
+MAD_TARGET_SSE2
+static size_t OverlapCircleFixedSSE2(const int* _pos_x, const int* _pos_y, const long long* _team_mask,
+	size_t _num, int _center_x, int _center_y, int _radius_sq, long long _mask,
+	unsigned int* out_index)
+{
+	const __m128i l_center_x = _mm_set1_epi32(_center_x);
+	const __m128i l_center_y = _mm_set1_epi32(_center_y);
+	const __m128i l_radius_sq = _mm_set1_epi32(_radius_sq);
+	const __m128i l_low = _mm_set1_epi16(-32767);
+	const __m128i l_mask = _mm_set1_epi64x(_mask);
+	const __m128i l_zero = _mm_setzero_si128();
+	size_t l_count = 0;
+	size_t i = 0;
+	for (; i + 4 <= _num; i += 4)
+	{
+		__m128i l_dx = _mm_srai_epi32(_mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_pos_x + i)), l_center_x), 8);
+		__m128i l_dy = _mm_srai_epi32(_mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_pos_y + i)), l_center_y), 8);
+		__m128i l_d = _mm_max_epi16(_mm_packs_epi32(l_dx, l_dy), l_low);
+		l_d = _mm_unpacklo_epi16(l_d, _mm_unpackhi_epi64(l_d, l_d));
+		__m128i l_miss = _mm_cmpgt_epi32(_mm_madd_epi16(l_d, l_d), l_radius_sq);
+		if (_team_mask != nullptr)
+		{
+			__m128i l_lo = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_team_mask + i)), l_mask), l_zero);
+			__m128i l_hi = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_team_mask + i + 2)), l_mask), l_zero);
+			l_lo = _mm_and_si128(l_lo, _mm_shuffle_epi32(l_lo, _MM_SHUFFLE(2, 3, 0, 1)));
+			l_hi = _mm_and_si128(l_hi, _mm_shuffle_epi32(l_hi, _MM_SHUFFLE(2, 3, 0, 1)));
+			__m128 l_team_miss = _mm_shuffle_ps(_mm_castsi128_ps(l_lo), _mm_castsi128_ps(l_hi), _MM_SHUFFLE(2, 0, 2, 0));
+			l_miss = _mm_or_si128(l_miss, _mm_castps_si128(l_team_miss));
+		}
+		int l_hit = _mm_movemask_ps(_mm_castsi128_ps(l_miss)) ^ 0xF;
+		while (l_hit != 0)
+		{
+			int l_bit = 0;
+			while (((l_hit >> l_bit) & 1) == 0)
+			{
+				l_bit++;
+			}
+			out_index[l_count++] = static_cast<unsigned int>(i + l_bit);
+			l_hit &= l_hit - 1;
+		}
+	}
+	return l_count + OverlapCircleFixedScalar(_pos_x, _pos_y, _team_mask, i, _num, _center_x, _center_y, _radius_sq, _mask,
+		out_index + l_count);
+}
+
+/**
+ * (内部函数)
+ * 定点圆形检测的AVX2路径,每次检测8颗子弹。打包与交错都在各自的128位通道内进行,结果顺序不变。
+ */
+MAD_TARGET_AVX2
+static size_t OverlapCircleFixedAVX2(const int* _pos_x, const int* _pos_y, const long long* _team_mask,
+	size_t _num, int _center_x, int _center_y, int _radius_sq, long long _mask,
+	unsigned int* out_index)
+{
+	const __m256i l_center_x = _mm256_set1_epi32(_center_x);
+	const __m256i l_center_y = _mm256_set1_epi32(_center_y);
+	const __m256i l_radius_sq = _mm256_set1_epi32(_radius_sq);
+	const __m256i l_low = _mm256_set1_epi16(-32767);
+	const __m256i l_mask = _mm256_set1_epi64x(_mask);
+	const __m256i l_zero = _mm256_setzero_si256();
+	size_t l_count = 0;
+	size_t i = 0;
+	for (; i + 8 <= _num; i += 8)
+	{
+		__m256i l_dx = _mm256_srai_epi32(_mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(_pos_x + i)), l_center_x), 8);
+		__m256i l_dy = _mm256_srai_epi32(_mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(_pos_y + i)), l_center_y), 8);
+		__m256i l_d = _mm256_max_epi16(_mm256_packs_epi32(l_dx, l_dy), l_low);
+		l_d = _mm256_unpacklo_epi16(l_d, _mm256_unpackhi_epi64(l_d, l_d));
+		__m256i l_miss = _mm256_cmpgt_epi32(_mm256_madd_epi16(l_d, l_d), l_radius_sq);
+		if (_team_mask != nullptr)
+		{
+			__m256i l_lo = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(_team_mask + i)), l_mask), l_zero);
+			__m256i l_hi = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(_team_mask + i + 4)), l_mask), l_zero);
+			__m256 l_team_miss = _mm256_shuffle_ps(_mm256_castsi256_ps(l_lo), _mm256_castsi256_ps(l_hi), _MM_SHUFFLE(2, 0, 2, 0));
+			l_team_miss = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(l_team_miss), _MM_SHUFFLE(3, 1, 2, 0)));
+			l_miss = _mm256_or_si256(l_miss, _mm256_castps_si256(l_team_miss));
+		}
+		int l_hit = _mm256_movemask_ps(_mm256_castsi256_ps(l_miss)) ^ 0xFF;
+		while (l_hit != 0)
+		{
+			int l_bit = 0;
+			while (((l_hit >> l_bit) & 1) == 0)
+			{
+				l_bit++;
+			}
+			out_index[l_count++] = static_cast<unsigned int>(i + l_bit);
+			l_hit &= l_hit - 1;
+		}
+	}
+	_mm256_zeroupper();
+	return l_count + OverlapCircleFixedScalar(_pos_x, _pos_y, _team_mask, i, _num, _center_x, _center_y, _radius_sq, _mask,
+		out_index + l_count);
+}
+#endif
+
+/**
+ * 对一段定点子弹做圆形检测,找出与圆心距离不超过 _radius 的子弹,全部为整数运算。
+ * 距离按1/256单位的精度比较,判定半径最大为127.99单位(超出时被钳制),足以覆盖实体与子弹半径之和。
+ * 传入 _team_mask 时,同时过滤掉TeamMask与 _mask 按位与为0的子弹。
+ *
+ * @param _pos_x 16.16位置X数组
+ * @param _pos_y 16.16位置Y数组
+ * @param _team_mask TeamMask数组,可为nullptr
+ * @param _num 子弹数量
+ * @param _center_x 圆心X(16.16)
+ * @param _center_y 圆心Y(16.16)
+ * @param _radius 判定半径(16.16)
+ * @param _mask 实体的TeamMask
+ * @param[out] out_index 命中子弹的索引(升序),至少能容纳 _num 个元素
+ * @return 命中子弹的数量
+ */
+size_t MADBulletKernel::OverlapCircleFixed(const int* _pos_x, const int* _pos_y, const long long* _team_mask,
+	size_t _num, int _center_x, int _center_y, int _radius, long long _mask, unsigned int* out_index)
+{
+	int l_radius = _radius >> 8;
+	l_radius = l_radius < 0 ? 0 : (l_radius > 32766 ? 32766 : l_radius);
+	int l_radius_sq = l_radius * l_radius;
+#if defined(MAD_SIMD_X86)
+	switch (MADSimd::GetLevel())
+	{
+	case MADSimdLevel::AVX2:
+		return OverlapCircleFixedAVX2(_pos_x, _pos_y, _team_mask, _num, _center_x, _center_y, l_radius_sq, _mask, out_index);
+	case MADSimdLevel::SSE2:
+		return OverlapCircleFixedSSE2(_pos_x, _pos_y, _team_mask, _num, _center_x, _center_y, l_radius_sq, _mask, out_index);
+	case MADSimdLevel::Scalar:
+		break;
+	}
+#endif
+	return OverlapCircleFixedScalar(_pos_x, _pos_y, _team_mask, 0, _num, _center_x, _center_y, l_radius_sq, _mask, out_index);
+}
+
+/**
+ * (内部函数)
+ * 定点转浮点输出的标量路径,同时也是SSE2路径处理尾部元素的方式。
+ */
+static void UnpackFixedScalar(const int* _pos_x, const int* _pos_y, const unsigned short* _angle, const short* _speed,
+	size_t _num, float _dir_scale, MADBulletFlushResData* out_res)
+{
+	for (size_t i = 0; i < _num; ++i)
+	{
+		int l_step_x, l_step_y;
+		MADFixed::GetStep(_angle[i], _speed[i], &l_step_x, &l_step_y);
+		out_res[i].Position_X = static_cast<float>(_pos_x[i]) * (1.0f / 65536.0f);
+		out_res[i].Position_Y = static_cast<float>(_pos_y[i]) * (1.0f / 65536.0f);
+		out_res[i].Dir_X = static_cast<float>(l_step_x) * _dir_scale;
+		out_res[i].Dir_Y = static_cast<float>(l_step_y) * _dir_scale;
+	}
+}
+
+#if defined(MAD_SIMD_X86)
+/**
+ * (内部函数)
+ * 定点转浮点输出的SSE2路径,每次处理4颗子弹,位移的计算与定点积分内核相同。
+ */
+MAD_TARGET_SSE2
+static void UnpackFixedSSE2(const int* _pos_x, const int* _pos_y, const unsigned short* _angle, const short* _speed,
+	size_t _num, float _dir_scale, MADBulletFlushResData* out_res)
+{
+	const unsigned int* l_table = MADFixed::GetCosSinTable();
+	const int l_shift = 16 - MAD_FIXED_ANGLE_TABLE_BITS;
+	const __m128i l_zero = _mm_setzero_si128();
+	const __m128 l_pos_scale = _mm_set1_ps(1.0f / 65536.0f);
+	const __m128 l_dir_scale = _mm_set1_ps(_dir_scale);
+	size_t i = 0;
+	for (; i + 4 <= _num; i += 4)
+	{
+		__m128i l_cos_sin = _mm_set_epi32(static_cast<int>(l_table[_angle[i + 3] >> l_shift]),
+			static_cast<int>(l_table[_angle[i + 2] >> l_shift]), static_cast<int>(l_table[_angle[i + 1] >> l_shift]),
+			static_cast<int>(l_table[_angle[i] >> l_shift]));
+		__m128i l_speed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(_speed + i));
+		__m128i l_step_x = _mm_srai_epi32(_mm_madd_epi16(l_cos_sin, _mm_unpacklo_epi16(l_speed, l_zero)), MAD_FIXED_STEP_SHIFT);
+		__m128i l_step_y = _mm_srai_epi32(_mm_madd_epi16(l_cos_sin, _mm_unpacklo_epi16(l_zero, l_speed)), MAD_FIXED_STEP_SHIFT);
+		__m128 l_px = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_pos_x + i))), l_pos_scale);
+		__m128 l_py = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_pos_y + i))), l_pos_scale);
+		__m128 l_dx = _mm_mul_ps(_mm_cvtepi32_ps(l_step_x), l_dir_scale);
+		__m128 l_dy = _mm_mul_ps(_mm_cvtepi32_ps(l_step_y), l_dir_scale);
+
+		__m128 l_t0 = _mm_unpacklo_ps(l_px, l_py);
+		__m128 l_t1 = _mm_unpackhi_ps(l_px, l_py);
+		__m128 l_t2 = _mm_unpacklo_ps(l_dx, l_dy);
+		__m128 l_t3 = _mm_unpackhi_ps(l_dx, l_dy);
+		float* l_out = &out_res[i].Position_X;
+		_mm_storeu_ps(l_out, _mm_movelh_ps(l_t0, l_t2));
+		_mm_storeu_ps(l_out + 4, _mm_movehl_ps(l_t2, l_t0));
+		_mm_storeu_ps(l_out + 8, _mm_movelh_ps(l_t1, l_t3));
+		_mm_storeu_ps(l_out + 12, _mm_movehl_ps(l_t3, l_t1));
+	}
+	UnpackFixedScalar(_pos_x + i, _pos_y + i, _angle + i, _speed + i, _num - i, _dir_scale, out_res + i);
+}
+#endif
+
+/**
+ * 将一段定点子弹转换为浮点的MADBulletFlushResData,供沿用浮点格式的渲染端使用。
+ * 速度由每tick的定点位移乘以 _tick_rate 得到(单位/秒)。整数到浮点的转换与一次乘法在各路径上结果相同。
+ *
+ * @param _pos_x 16.16位置X数组
+ * @param _pos_y 16.16位置Y数组
+ * @param _angle 16位角度数组
+ * @param _speed 8.8速率数组(单位/tick)
+ * @param _num 子弹数量
+ * @param _tick_rate 每秒的tick数
+ * @param[out] out_res 输出,至少能容纳 _num 条记录
+ */
+void MADBulletKernel::UnpackFixed(const int* _pos_x, const int* _pos_y, const unsigned short* _angle, const short* _speed,
+	size_t _num, float _tick_rate, MADBulletFlushResData* out_res)
+{
+	float l_dir_scale = _tick_rate * (1.0f / 65536.0f);
+#if defined(MAD_SIMD_X86)
+	if (MADSimd::GetLevel() != MADSimdLevel::Scalar)
+	{
+		UnpackFixedSSE2(_pos_x, _pos_y, _angle, _speed, _num, l_dir_scale, out_res);
+		return;
+	}
+#endif
+	UnpackFixedScalar(_pos_x, _pos_y, _angle, _speed, _num, l_dir_scale, out_res);
+}
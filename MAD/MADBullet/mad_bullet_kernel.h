@@ -0,0 +1,108 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include "../MADProtocol/mad_protocol.h"
+
+/**
+ * \brief MADBulletMotionState 是参数化子弹的运动模型,由MADBulletPool在生成子弹时根据MADBulletMotion换算得到。
+ *
+ * 设局部时间 t = AliveTime - StartTime,所有模型的基准位置均为 Origin + Velocity * t,再叠加各自的偏移:
+ * - Linear: 无偏移
+ * - Accelerating: 0.5 * (Param[0], Param[1]) * t^2
+ * - Sine: (Param[0], Param[1]) * sin(Param[2] * t + Param[3]),其中前两项为已乘上振幅的法向量
+ * - Spiral: (Param[3] + Param[0] * t) * (cos(a), sin(a)),a = Param[2] + Param[1] * t
+ */
+struct MADBulletMotionState {
+	MADBulletMotionType Type;
+	float StartTime;
+	float Origin_X, Origin_Y;
+	float Velocity_X, Velocity_Y;
+	float Param[4];
+};
+
+/**
+ * \brief MADBulletTransform 是子弹组从局部空间到世界空间的刚体变换,由MADBulletPool按组的层级关系合成。
+ *
+ * 局部点 l 的世界坐标为 Offset + R * l,其中 R 为旋转(Cos, Sin);
+ * 世界速度为 Velocity + Angular × (R * l) + R * l',即组原点的速度、组旋转带来的切向速度与局部速度之和。
+ */
+struct MADBulletTransform {
+	float Offset_X, Offset_Y;
+	float Cos, Sin;
+	float Velocity_X, Velocity_Y;
+	float Angular;
+};
+
+/**
+ * MADBulletKernel 提供对SoA子弹数据的批量计算内核。
+ *
+ * 内核的路径在运行时通过MADSimd选择:
+ * - Integrate、FindOutside、Transform、SweepCircle、OverlapCircle、OverlapRect、OverlapCapsule、Steer
+ *   以及IntegrateFixed、FindOutsideFixed、OverlapCircleFixed有标量、SSE2与AVX2三条路径;
+ * - Pack只有Float4格式有SSE2路径,其余格式与不支持SIMD时使用标量路径;UnpackFixed有标量与SSE2两条路径;
+ * - EvaluateMotion只有标量路径。
+ * 各路径只使用相同顺序的乘法与加法(不使用FMA),因此结果逐位一致。
+ * 名称以Fixed结尾的内核处理定点子弹(见MADFixed),模拟只使用整数运算,结果与编译器和平台无关。
+ *
+ * 注意:
+ * -内核只处理传入的区间,可以安全地把不相交的区间交给不同线程。
+ * -该类只包含静态方法,请勿实例化。
+ */
+class MADBulletKernel
+{
+public:
+	/*Integrate*/
+	static void Integrate(float* _pos_x, float* _pos_y, const float* _dir_x, const float* _dir_y,
+		float* _alive_time, size_t _num, float _dt, MADBulletFlushResData* out_res = nullptr);
+
+	/*Boundary*/
+	static size_t FindOutside(const float* _pos_x, const float* _pos_y, size_t _num,
+		float _min_x, float _min_y, float _max_x, float _max_y, unsigned int* out_index);
+
+	/*Motion*/
+	static void EvaluateMotion(const MADBulletMotionState* _motion, const float* _alive_time,
+		float* out_pos_x, float* out_pos_y, float* out_dir_x, float* out_dir_y, size_t _num);
+
+	/*Group*/
+	static void Transform(const float* _local_x, const float* _local_y, const float* _local_dx, const float* _local_dy,
+		size_t _num, const MADBulletTransform& _transform,
+		float* out_pos_x, float* out_pos_y, float* out_dir_x, float* out_dir_y);
+
+	/*Collision*/
+	static size_t SweepCircle(const float* _pos_x, const float* _pos_y, const float* _dir_x, const float* _dir_y,
+		size_t _num, float _center_x, float _center_y, float _radius_sq, float _dt, unsigned int* out_index, float* out_time);
+	static size_t OverlapCircle(const float* _pos_x, const float* _pos_y, const long long* _team_mask,
+		size_t _num, float _center_x, float _center_y, float _radius_sq, long long _mask, unsigned int* out_index);
+	static size_t OverlapRect(const float* _pos_x, const float* _pos_y, const long long* _team_mask,
+		size_t _num, float _min_x, float _min_y, float _max_x, float _max_y, long long _mask, unsigned int* out_index);
+	static size_t OverlapCapsule(const float* _a_x, const float* _a_y, const float* _b_x, const float* _b_y,
+		const float* _radius, const long long* _team_mask, size_t _num,
+		float _center_x, float _center_y, float _center_radius, long long _mask, unsigned int* out_index);
+
+	/*Steer*/
+	static void Steer(const float* _pos_x, const float* _pos_y, float* _dir_x, float* _dir_y,
+		const float* _target_x, const float* _target_y, const float* _turn_cos, const float* _turn_sin, size_t _num);
+
+	/*Pack*/
+	static size_t GetRecordSize(const MADFlushLayout& _layout);
+	static void Pack(const float* _pos_x, const float* _pos_y, const float* _dir_x, const float* _dir_y,
+		const unsigned int* _appearance, size_t _num, MADFlushFormat _format, size_t _stride, unsigned char* out_data);
+
+	/*Fixed point*/
+	static void IntegrateFixed(int* _pos_x, int* _pos_y, const unsigned short* _angle, const short* _speed,
+		unsigned int* _alive_tick, size_t _num, MADFixedFlushResData* out_res = nullptr);
+	static size_t FindOutsideFixed(const int* _pos_x, const int* _pos_y, size_t _num,
+		int _min_x, int _min_y, int _max_x, int _max_y, unsigned int* out_index);
+	static size_t OverlapCircleFixed(const int* _pos_x, const int* _pos_y, const long long* _team_mask,
+		size_t _num, int _center_x, int _center_y, int _radius, long long _mask, unsigned int* out_index);
+	static void UnpackFixed(const int* _pos_x, const int* _pos_y, const unsigned short* _angle, const short* _speed,
+		size_t _num, float _tick_rate, MADBulletFlushResData* out_res);
+
+private:
+	MADBulletKernel() = delete;
+};
@@ -0,0 +1,2127 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_bullet_pool.h"
+#include "mad_bullet_kernel.h"
+#include "../MADBase/mad_fp_strict.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+/*Group rotations are wrapped into (-2pi, 2pi) so that they keep their precision over long stages*/
+#define MAD_BULLET_TWO_PI 6.283185307179586f
+
+/**
+ * (内部函数)
+ * 从数组中移除一组升序排列的索引,存活的元素保持原有顺序。
+ * _source 为空时每个连续存活段用一次memmove搬运;
+ * 否则按 _source 中前 _source_num 个存活索引逐个收集到 _sorted[0] 之后,销毁较密集时存活段很短,收集比逐段memmove更快。
+ */
+template <typename T>
+static void CompactArray(std::vector<T>& io_array, const unsigned int* _sorted, size_t _num,
+	const std::vector<unsigned int>* _source, size_t _source_num)
+{
+	if (_num == 0)
+	{
+		return;
+	}
+	T* l_data = io_array.data();
+	size_t l_write = _sorted[0];
+	if (_source != nullptr)
+	{
+		for (size_t j = 0; j < _source_num; ++j)
+		{
+			l_data[l_write + j] = l_data[(*_source)[j]];
+		}
+		io_array.resize(l_write + _source_num);
+		return;
+	}
+	for (size_t k = 0; k < _num; ++k)
+	{
+		size_t l_begin = static_cast<size_t>(_sorted[k]) + 1;
+		size_t l_end = k + 1 < _num ? _sorted[k + 1] : io_array.size();
+		memmove(l_data + l_write, l_data + l_begin, (l_end - l_begin) * sizeof(T));
+		l_write += l_end - l_begin;
+	}
+	io_array.resize(l_write);
+}
+
+/**
+ * (内部函数)
+ * 将运动模型关于直线 x = _wall (_axis_x为true) 或 y = _wall 镜像,
+ * 镜像后的轨迹恰好是原轨迹的反射,对所有模型都是精确的。
+ */
+static void MirrorMotion(MADBulletMotionState& io_motion, bool _axis_x, float _wall)
+{
+	if (_axis_x)
+	{
+		io_motion.Origin_X = 2.0f * _wall - io_motion.Origin_X;
+		io_motion.Velocity_X = -io_motion.Velocity_X;
+	}
+	else
+	{
+		io_motion.Origin_Y = 2.0f * _wall - io_motion.Origin_Y;
+		io_motion.Velocity_Y = -io_motion.Velocity_Y;
+	}
+	switch (io_motion.Type)
+	{
+	case MADBulletMotionType::Accelerating:
+	case MADBulletMotionType::Sine:
+		io_motion.Param[_axis_x ? 0 : 1] = -io_motion.Param[_axis_x ? 0 : 1];
+		break;
+	case MADBulletMotionType::Spiral:
+		/*cos(a) -> -cos(a) is a -> pi - a,sin(a) -> -sin(a) is a -> -a*/
+		io_motion.Param[2] = _axis_x ? 3.14159265358979f - io_motion.Param[2] : -io_motion.Param[2];
+		io_motion.Param[1] = -io_motion.Param[1];
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * (内部函数)
+ * 以存活时间 _alive_time 为新的起点重写运动模型,使模型在该时刻的位置与速度分别为 _pos 与 _dir。
+ * 模型在该时刻的相位、角度与半径被折算进参数,偏移从当前状态继续,而不是从初始状态重新开始。
+ */
+static void RebaseMotion(MADBulletMotionState& io_motion, float _alive_time, const MADVector2DF& _pos, const MADVector2DF& _dir)
+{
+	float l_t = _alive_time - io_motion.StartTime;
+	float l_offset_x = 0.0f, l_offset_y = 0.0f;
+	float l_rate_x = 0.0f, l_rate_y = 0.0f;
+	switch (io_motion.Type)
+	{
+	case MADBulletMotionType::Sine:
+	{
+		float l_phase = io_motion.Param[2] * l_t + io_motion.Param[3];
+		float l_sin, l_cos;
+		MADStrictMath::SinCos(l_phase, &l_sin, &l_cos);
+		l_cos = l_cos * io_motion.Param[2];
+		l_offset_x = io_motion.Param[0] * l_sin;
+		l_offset_y = io_motion.Param[1] * l_sin;
+		l_rate_x = io_motion.Param[0] * l_cos;
+		l_rate_y = io_motion.Param[1] * l_cos;
+		io_motion.Param[3] = l_phase;
+		break;
+	}
+	case MADBulletMotionType::Spiral:
+	{
+		float l_angle = io_motion.Param[2] + io_motion.Param[1] * l_t;
+		float l_radius = io_motion.Param[3] + io_motion.Param[0] * l_t;
+		float l_sin, l_cos;
+		MADStrictMath::SinCos(l_angle, &l_sin, &l_cos);
+		l_offset_x = l_radius * l_cos;
+		l_offset_y = l_radius * l_sin;
+		l_rate_x = io_motion.Param[0] * l_cos - l_radius * io_motion.Param[1] * l_sin;
+		l_rate_y = io_motion.Param[0] * l_sin + l_radius * io_motion.Param[1] * l_cos;
+		io_motion.Param[2] = l_angle;
+		io_motion.Param[3] = l_radius;
+		break;
+	}
+	default:
+		/*Accelerating restarts at zero offset and zero added speed,Linear has no offset*/
+		break;
+	}
+	io_motion.StartTime = _alive_time;
+	io_motion.Origin_X = _pos.x - l_offset_x;
+	io_motion.Origin_Y = _pos.y - l_offset_y;
+	io_motion.Velocity_X = _dir.x - l_rate_x;
+	io_motion.Velocity_Y = _dir.y - l_rate_y;
+}
+
+/**
+ * (内部函数)
+ * 将子弹池中 [_begin, _end) 区间的子弹写入 out_res 的对应位置,调用前世界坐标必须是最新的。
+ */
+static void CopyFlushRange(const MADBulletPool& _pool, size_t _begin, size_t _end, MADBulletFlushResData* out_res)
+{
+	const float* l_px = _pool.GetPositionXData();
+	const float* l_py = _pool.GetPositionYData();
+	const float* l_dx = _pool.GetDirXData();
+	const float* l_dy = _pool.GetDirYData();
+	for (size_t i = _begin; i < _end; ++i)
+	{
+		out_res[i].Position_X = l_px[i];
+		out_res[i].Position_Y = l_py[i];
+		out_res[i].Dir_X = l_dx[i];
+		out_res[i].Dir_Y = l_dy[i];
+	}
+}
+
+/**
+ * 构造一个空的子弹池。
+ * 构造时不会分配任何内存,如果已知子弹规模,请调用Reserve预留容量以避免运行中扩容。
+ */
+MADBulletPool::MADBulletPool()
+{
+	ParametricNum = 0;
+	MotionDirty = false;
+	GroupBegin = 0;
+	GroupDirty = false;
+	LodParametricNum = 0;
+	LodPlainNum = 0;
+	LodCounter = 0;
+	LodDebt = 0.0f;
+	NearMotionDirty = false;
+}
+
+/**
+ * MADBulletPool析构函数。
+ * 所有子弹数据都储存在连续数组中,随对象一同释放,无需逐个删除。
+ */
+MADBulletPool::~MADBulletPool()
+{
+}
+
+/**
+ * 生成一颗子弹并返回其句柄。
+ * 若存在空闲槽位则复用该槽位(代数保持不变,已在销毁时递增)。
+ * 子弹被追加到普通子弹区间的末尾,存在子弹组时每个非空的组会把首个成员换到末尾来让出位置。
+ * 新子弹总是近处子弹,存在远处子弹时会与第一颗远处子弹交换。
+ *
+ * @param _info 子弹的初始数据
+ * @return 新子弹的句柄
+ */
+MADBulletHandle MADBulletPool::Spawn(const BulletInfo& _info)
+{
+	MADBulletHandle l_handle = PushBullet(_info);
+	InsertBeforeGroups(0);
+	GroupBegin++;
+	if (LodPlainNum > 0)
+	{
+		SwapBullets(GroupBegin - 1, GroupBegin - 1 - LodPlainNum);
+	}
+	return l_handle;
+}
+
+/**
+ * (内部函数)
+ * 把一颗子弹追加到所有数组的末尾并分配句柄,不调整任何区间。
+ */
+MADBulletHandle MADBulletPool::PushBullet(const BulletInfo& _info)
+{
+	unsigned int l_dense = static_cast<unsigned int>(AliveTime.size());
+	unsigned int l_slot;
+	if (!FreeSlots.empty())
+	{
+		l_slot = FreeSlots.back();
+		FreeSlots.pop_back();
+		SlotToDense[l_slot] = l_dense;
+	}
+	else
+	{
+		l_slot = static_cast<unsigned int>(SlotToDense.size());
+		SlotToDense.push_back(l_dense);
+		SlotGeneration.push_back(0);
+	}
+
+	AliveTime.push_back(_info.AliveTime);
+	OriginPos_X.push_back(_info.OriginPos.x);
+	OriginPos_Y.push_back(_info.OriginPos.y);
+	OriginDir_X.push_back(_info.OriginDir.x);
+	OriginDir_Y.push_back(_info.OriginDir.y);
+	TeamMask.push_back(_info.TeamMask);
+	Boundary.push_back(MADBulletBoundary::Kill);
+	BounceLeft.push_back(0);
+	Appearance.push_back(0);
+	Flags.push_back(0);
+	LocalPos_X.push_back(0.0f);
+	LocalPos_Y.push_back(0.0f);
+	LocalDir_X.push_back(0.0f);
+	LocalDir_Y.push_back(0.0f);
+	DenseToSlot.push_back(l_slot);
+
+	return MADBulletHandle(l_slot, SlotGeneration[l_slot]);
+}
+
+/**
+ * 生成一颗按闭式运动模型移动的参数化子弹并返回其句柄。
+ * _info.OriginPos 为运动起点(Spiral为螺旋中心),_info.OriginDir 为起点的平移速度,
+ * _info.AliveTime 为起始存活时间,此后子弹的位置只由存活时间决定。
+ *
+ * 各模型的参数:
+ * - Linear: 无参数,沿 OriginDir 匀速直线运动
+ * - Accelerating: Param[0], Param[1] 为加速度的X与Y分量(单位/秒^2)
+ * - Sine: Param[0] 为振幅,Param[1] 为角频率(弧度/秒),Param[2] 为初相位(弧度),沿 OriginDir 的左侧法向摆动
+ * - Spiral: Param[0] 为径向速度,Param[1] 为角速度(弧度/秒),Param[2] 为初始角(弧度),Param[3] 为初始半径
+ *
+ * @param _info 子弹的初始数据
+ * @param _motion 运动模型,类型为Integrated时等同于Spawn(_info)
+ * @return 新子弹的句柄
+ */
+MADBulletHandle MADBulletPool::Spawn(const BulletInfo& _info, const MADBulletMotion& _motion)
+{
+	if (_motion.Type == MADBulletMotionType::Integrated)
+	{
+		return Spawn(_info);
+	}
+
+	/*Zeroed padding keeps snapshots of equal states byte-identical*/
+	MADBulletMotionState l_state;
+	std::memset(&l_state, 0, sizeof(l_state));
+	l_state.Type = _motion.Type;
+	l_state.StartTime = _info.AliveTime;
+	l_state.Origin_X = _info.OriginPos.x;
+	l_state.Origin_Y = _info.OriginPos.y;
+	l_state.Velocity_X = _info.OriginDir.x;
+	l_state.Velocity_Y = _info.OriginDir.y;
+	for (int i = 0; i < 4; ++i)
+	{
+		l_state.Param[i] = _motion.Param[i];
+	}
+	if (_motion.Type == MADBulletMotionType::Sine)
+	{
+		float l_length = std::sqrt(_info.OriginDir.x * _info.OriginDir.x + _info.OriginDir.y * _info.OriginDir.y);
+		float l_normal_x = l_length > 0.0f ? -_info.OriginDir.y / l_length : 0.0f;
+		float l_normal_y = l_length > 0.0f ? _info.OriginDir.x / l_length : 1.0f;
+		l_state.Param[0] = _motion.Param[0] * l_normal_x;
+		l_state.Param[1] = _motion.Param[0] * l_normal_y;
+		l_state.Param[2] = _motion.Param[1];
+		l_state.Param[3] = _motion.Param[2];
+	}
+
+	MADBulletHandle l_handle = Spawn(_info);
+	size_t l_dense = GetIndex(l_handle);
+	if (l_dense != ParametricNum)
+	{
+		SwapBullets(ParametricNum, l_dense);
+	}
+	Motion.push_back(l_state);
+	ParametricNum++;
+
+	/*New bullets are near,move the first far parametric bullet out of the way*/
+	l_dense = ParametricNum - 1;
+	if (LodParametricNum > 0)
+	{
+		size_t l_far_begin = ParametricNum - 1 - LodParametricNum;
+		SwapBullets(l_dense, l_far_begin);
+		std::swap(Motion[l_dense], Motion[l_far_begin]);
+		l_dense = l_far_begin;
+	}
+	MADBulletKernel::EvaluateMotion(&Motion[l_dense], &AliveTime[l_dense],
+		&OriginPos_X[l_dense], &OriginPos_Y[l_dense],
+		&OriginDir_X[l_dense], &OriginDir_Y[l_dense], 1);
+	return l_handle;
+}
+
+/**
+ * 通过句柄销毁一颗子弹。
+ *
+ * @param _handle 要销毁的子弹句柄
+ * @return 句柄有效并成功销毁时返回true;句柄已失效时返回false。
+ */
+bool MADBulletPool::Kill(MADBulletHandle _handle)
+{
+	size_t l_index = GetIndex(_handle);
+	if (l_index == MAD_BULLET_INVALID_INDEX)
+	{
+		return false;
+	}
+	KillAt(l_index);
+	return true;
+}
+
+/**
+ * 通过密集索引销毁一颗子弹。
+ * 末尾的子弹会被交换到该位置(swap-remove),因此遍历中销毁子弹时不要递增索引。
+ * 销毁参数化子弹时,最后一颗参数化子弹与末尾的子弹会依次补位,同样为O(1)。
+ * 存在子弹组时,空位会依次穿过其后的每个组(每组一次交换)移动到末尾,代价与组的数量成正比。
+ * 存在远处子弹时,空位会先与最后一颗近处子弹、再与最后一颗远处子弹交换,远近区间保持紧密。
+ *
+ * @param _index 要销毁的子弹的密集索引,必须小于GetNum()
+ */
+void MADBulletPool::KillAt(size_t _index)
+{
+	/*Move a parametric bullet to the border of the two ranges first*/
+	if (_index < ParametricNum)
+	{
+		size_t l_border = ParametricNum - 1;
+		if (LodParametricNum > 0)
+		{
+			size_t l_far_begin = ParametricNum - LodParametricNum;
+			if (_index < l_far_begin)
+			{
+				if (_index != l_far_begin - 1)
+				{
+					SwapBullets(_index, l_far_begin - 1);
+					Motion[_index] = Motion[l_far_begin - 1];
+				}
+				_index = l_far_begin - 1;
+			}
+			else
+			{
+				LodParametricNum--;
+			}
+		}
+		if (_index != l_border)
+		{
+			SwapBullets(_index, l_border);
+			Motion[_index] = Motion[l_border];
+		}
+		Motion.pop_back();
+		ParametricNum--;
+		_index = l_border;
+	}
+
+	/*Move a plain hole to the end of the plain range,keeping far bullets behind near ones*/
+	if (_index < GroupBegin && LodPlainNum > 0)
+	{
+		size_t l_far_begin = GroupBegin - LodPlainNum;
+		if (_index < l_far_begin)
+		{
+			if (_index != l_far_begin - 1)
+			{
+				SwapBullets(_index, l_far_begin - 1);
+			}
+			_index = l_far_begin - 1;
+		}
+		else
+		{
+			LodPlainNum--;
+		}
+		if (_index != GroupBegin - 1)
+		{
+			SwapBullets(_index, GroupBegin - 1);
+		}
+		_index = GroupBegin - 1;
+	}
+
+	/*Move the hole past the plain range and every group after it*/
+	if (!Groups.empty())
+	{
+		size_t l_first_group;
+		if (_index < GroupBegin)
+		{
+			GroupBegin--;
+			if (_index != GroupBegin)
+			{
+				SwapBullets(_index, GroupBegin);
+			}
+			_index = GroupBegin;
+			l_first_group = 0;
+		}
+		else
+		{
+			l_first_group = GetGroup(_index);
+			BulletGroup& l_group = Groups[l_first_group];
+			l_group.Count--;
+			size_t l_group_last = l_group.Begin + l_group.Count;
+			if (_index != l_group_last)
+			{
+				SwapBullets(_index, l_group_last);
+			}
+			_index = l_group_last;
+			l_first_group++;
+		}
+		MoveHoleToEnd(_index, l_first_group);
+		_index = AliveTime.size() - 1;
+	}
+	else
+	{
+		GroupBegin--;
+	}
+
+	size_t l_last = AliveTime.size() - 1;
+	unsigned int l_slot = DenseToSlot[_index];
+
+	if (_index != l_last)
+	{
+		AliveTime[_index] = AliveTime[l_last];
+		OriginPos_X[_index] = OriginPos_X[l_last];
+		OriginPos_Y[_index] = OriginPos_Y[l_last];
+		OriginDir_X[_index] = OriginDir_X[l_last];
+		OriginDir_Y[_index] = OriginDir_Y[l_last];
+		TeamMask[_index] = TeamMask[l_last];
+		Boundary[_index] = Boundary[l_last];
+		BounceLeft[_index] = BounceLeft[l_last];
+		Appearance[_index] = Appearance[l_last];
+		Flags[_index] = Flags[l_last];
+		LocalPos_X[_index] = LocalPos_X[l_last];
+		LocalPos_Y[_index] = LocalPos_Y[l_last];
+		LocalDir_X[_index] = LocalDir_X[l_last];
+		LocalDir_Y[_index] = LocalDir_Y[l_last];
+		DenseToSlot[_index] = DenseToSlot[l_last];
+		SlotToDense[DenseToSlot[_index]] = static_cast<unsigned int>(_index);
+	}
+
+	AliveTime.pop_back();
+	OriginPos_X.pop_back();
+	OriginPos_Y.pop_back();
+	OriginDir_X.pop_back();
+	OriginDir_Y.pop_back();
+	TeamMask.pop_back();
+	Boundary.pop_back();
+	BounceLeft.pop_back();
+	Appearance.pop_back();
+	Flags.pop_back();
+	LocalPos_X.pop_back();
+	LocalPos_Y.pop_back();
+	LocalDir_X.pop_back();
+	LocalDir_Y.pop_back();
+	DenseToSlot.pop_back();
+
+	SlotToDense[l_slot] = MAD_BULLET_INVALID_INDEX;
+	SlotGeneration[l_slot]++;
+	FreeSlots.push_back(l_slot);
+}
+
+/**
+ * 一次销毁一组子弹,存活的子弹保持原有的相对顺序。
+ * 与逐个KillAt不同,所有数组只做一遍压缩,适合一帧内大量销毁的情况:
+ * 销毁稀疏时逐段memmove,销毁密集时先求出一次存活索引,再按它收集每个数组。
+ *
+ * @param _indices 要销毁的子弹的密集索引,必须严格升序且小于GetNum()
+ * @param _num 索引数量
+ */
+void MADBulletPool::KillBatch(const unsigned int* _indices, size_t _num)
+{
+	if (_num == 0)
+	{
+		return;
+	}
+	for (size_t k = 0; k < _num; ++k)
+	{
+		unsigned int l_slot = DenseToSlot[_indices[k]];
+		SlotToDense[l_slot] = MAD_BULLET_INVALID_INDEX;
+		SlotGeneration[l_slot]++;
+		FreeSlots.push_back(l_slot);
+	}
+
+	size_t l_parametric_kill = std::lower_bound(_indices, _indices + _num, static_cast<unsigned int>(ParametricNum)) - _indices;
+	size_t l_plain_kill = std::lower_bound(_indices, _indices + _num, static_cast<unsigned int>(GroupBegin)) - _indices;
+
+	/*Survivors keep their order,so each far range only shrinks by its own kills*/
+	LodParametricNum -= l_parametric_kill - (std::lower_bound(_indices, _indices + l_parametric_kill,
+		static_cast<unsigned int>(ParametricNum - LodParametricNum)) - _indices);
+	LodPlainNum -= l_plain_kill - (std::lower_bound(_indices + l_parametric_kill, _indices + l_plain_kill,
+		static_cast<unsigned int>(GroupBegin - LodPlainNum)) - _indices);
+	size_t l_group_kill = l_plain_kill;
+	size_t l_group_begin = GroupBegin - l_plain_kill;
+	for (size_t g = 0; g < Groups.size(); ++g)
+	{
+		BulletGroup& l_group = Groups[g];
+		size_t l_end = std::lower_bound(_indices + l_group_kill, _indices + _num,
+			static_cast<unsigned int>(l_group.Begin + l_group.Count)) - _indices;
+		l_group.Begin = l_group_begin;
+		l_group.Count -= l_end - l_group_kill;
+		l_group_begin += l_group.Count;
+		l_group_kill = l_end;
+	}
+	GroupBegin -= l_plain_kill;
+
+	/*Dense kills leave short survivor runs,collect the survivors once and gather every array through them*/
+	const std::vector<unsigned int>* l_source = nullptr;
+	size_t l_source_num = 0;
+	size_t l_parametric_source = 0;
+	if ((DenseToSlot.size() - _indices[0]) < _num * MAD_BULLET_COMPACT_RUN)
+	{
+		CompactSource.clear();
+		for (size_t i = _indices[0], k = 0; i < DenseToSlot.size(); ++i)
+		{
+			if (k < _num && _indices[k] == i)
+			{
+				++k;
+				continue;
+			}
+			CompactSource.push_back(static_cast<unsigned int>(i));
+		}
+		l_source = &CompactSource;
+		l_source_num = CompactSource.size();
+		l_parametric_source = std::lower_bound(CompactSource.begin(), CompactSource.end(),
+			static_cast<unsigned int>(ParametricNum)) - CompactSource.begin();
+	}
+	CompactArray(AliveTime, _indices, _num, l_source, l_source_num);
+	CompactArray(OriginPos_X, _indices, _num, l_source, l_source_num);
+	CompactArray(OriginPos_Y, _indices, _num, l_source, l_source_num);
+	CompactArray(OriginDir_X, _indices, _num, l_source, l_source_num);
+	CompactArray(OriginDir_Y, _indices, _num, l_source, l_source_num);
+	CompactArray(TeamMask, _indices, _num, l_source, l_source_num);
+	CompactArray(Boundary, _indices, _num, l_source, l_source_num);
+	CompactArray(BounceLeft, _indices, _num, l_source, l_source_num);
+	CompactArray(Appearance, _indices, _num, l_source, l_source_num);
+	CompactArray(Flags, _indices, _num, l_source, l_source_num);
+	CompactArray(LocalPos_X, _indices, _num, l_source, l_source_num);
+	CompactArray(LocalPos_Y, _indices, _num, l_source, l_source_num);
+	CompactArray(LocalDir_X, _indices, _num, l_source, l_source_num);
+	CompactArray(LocalDir_Y, _indices, _num, l_source, l_source_num);
+	CompactArray(DenseToSlot, _indices, _num, l_source, l_source_num);
+	CompactArray(Motion, _indices, l_parametric_kill, l_source, l_parametric_source);
+	ParametricNum -= l_parametric_kill;
+
+	for (size_t i = _indices[0]; i < DenseToSlot.size(); ++i)
+	{
+		SlotToDense[DenseToSlot[i]] = static_cast<unsigned int>(i);
+	}
+}
+
+/**
+ * 清空子弹池。
+ * 所有已发出的句柄都会失效,但已分配的容量会被保留,以便下一波弹幕复用。
+ */
+void MADBulletPool::Clear()
+{
+	while (!AliveTime.empty())
+	{
+		KillAt(AliveTime.size() - 1);
+	}
+}
+
+/**
+ * 预留至少能容纳 _capacity 颗子弹的容量。
+ *
+ * @param _capacity 期望的子弹容量
+ */
+void MADBulletPool::Reserve(size_t _capacity)
+{
+	AliveTime.reserve(_capacity);
+	OriginPos_X.reserve(_capacity);
+	OriginPos_Y.reserve(_capacity);
+	OriginDir_X.reserve(_capacity);
+	OriginDir_Y.reserve(_capacity);
+	TeamMask.reserve(_capacity);
+	Boundary.reserve(_capacity);
+	BounceLeft.reserve(_capacity);
+	Appearance.reserve(_capacity);
+	Flags.reserve(_capacity);
+	LocalPos_X.reserve(_capacity);
+	LocalPos_Y.reserve(_capacity);
+	LocalDir_X.reserve(_capacity);
+	LocalDir_Y.reserve(_capacity);
+	DenseToSlot.reserve(_capacity);
+	SlotToDense.reserve(_capacity);
+	SlotGeneration.reserve(_capacity);
+	FreeSlots.reserve(_capacity);
+}
+
+/**
+ * 创建一个子弹组并返回其id。
+ * 组的id按创建顺序递增且不会复用,父组总是先于子组创建,因此按id顺序即可逐层合成变换。
+ *
+ * @param _info 组相对于父组的变换与时间缩放
+ * @param _parent 父组id,传入MAD_BULLET_INVALID_INDEX表示没有父组
+ * @return 新组的id;父组无效时返回MAD_BULLET_INVALID_INDEX
+ */
+unsigned int MADBulletPool::CreateGroup(const MADBulletGroupInfo& _info, unsigned int _parent)
+{
+	if (_parent != MAD_BULLET_INVALID_INDEX && !IsGroupAlive(_parent))
+	{
+		MAD_LOG_ERR("Try to create a bullet group under a parent group which does not exist!");
+		return MAD_BULLET_INVALID_INDEX;
+	}
+	/*Zeroed padding keeps snapshots of equal states byte-identical*/
+	BulletGroup l_group;
+	std::memset(static_cast<void*>(&l_group), 0, sizeof(l_group));
+	l_group.Info = _info;
+	l_group.Parent = _parent;
+	l_group.Begin = AliveTime.size();
+	l_group.Count = 0;
+	l_group.Alive = true;
+	l_group.World = MADBulletTransform();
+	l_group.WorldRotation = 0.0f;
+	l_group.WorldTimeScale = 1.0f;
+	l_group.TransformDirty = true;
+	l_group.MembersDirty = false;
+	l_group.WorldChanged = false;
+	Groups.push_back(l_group);
+	GroupDirty = true;
+	return static_cast<unsigned int>(Groups.size() - 1);
+}
+
+/**
+ * 销毁一个子弹组,其所有成员与所有子组(及其成员)都会被销毁。
+ * 成员是连续的,因此只需一次KillBatch。
+ *
+ * @param _group 组id
+ * @return 组有效时返回true
+ */
+bool MADBulletPool::DestroyGroup(unsigned int _group)
+{
+	if (!IsGroupAlive(_group))
+	{
+		return false;
+	}
+	for (size_t g = _group + 1; g < Groups.size(); ++g)
+	{
+		if (Groups[g].Alive && Groups[g].Parent == _group)
+		{
+			DestroyGroup(static_cast<unsigned int>(g));
+		}
+	}
+
+	BulletGroup& l_group = Groups[_group];
+	BatchIndex.resize(l_group.Count);
+	for (size_t k = 0; k < l_group.Count; ++k)
+	{
+		BatchIndex[k] = static_cast<unsigned int>(l_group.Begin + k);
+	}
+	KillBatch(BatchIndex.data(), BatchIndex.size());
+	Groups[_group].Alive = false;
+	return true;
+}
+
+/**
+ * 在子弹组中生成一颗子弹并返回其句柄。
+ * 子弹被追加到该组区间的末尾,其后每个非空的组会把首个成员换到末尾来让出位置。
+ *
+ * @param _group 组id
+ * @param _local_info 子弹的初始数据,位置与速度均为组的局部坐标
+ * @return 新子弹的句柄;组无效时返回无效句柄
+ */
+MADBulletHandle MADBulletPool::SpawnInGroup(unsigned int _group, const BulletInfo& _local_info)
+{
+	if (!IsGroupAlive(_group))
+	{
+		MAD_LOG_ERR("Try to spawn a bullet in a bullet group which does not exist!");
+		return MADBulletHandle();
+	}
+	MADBulletHandle l_handle = PushBullet(_local_info);
+	size_t l_dense = InsertBeforeGroups(_group + 1);
+	LocalPos_X[l_dense] = _local_info.OriginPos.x;
+	LocalPos_Y[l_dense] = _local_info.OriginPos.y;
+	LocalDir_X[l_dense] = _local_info.OriginDir.x;
+	LocalDir_Y[l_dense] = _local_info.OriginDir.y;
+
+	BulletGroup& l_group = Groups[_group];
+	l_group.Count++;
+	l_group.MembersDirty = true;
+	GroupDirty = true;
+	return l_handle;
+}
+
+/**
+ * 设置子弹组的变换与时间缩放,所有成员与子组的世界坐标会在下一次读取时更新。
+ *
+ * @param _group 组id
+ * @param _info 组相对于父组的变换与时间缩放
+ * @return 组有效时返回true
+ */
+bool MADBulletPool::SetGroupInfo(unsigned int _group, const MADBulletGroupInfo& _info)
+{
+	if (!IsGroupAlive(_group))
+	{
+		return false;
+	}
+	Groups[_group].Info = _info;
+	Groups[_group].TransformDirty = true;
+	GroupDirty = true;
+	return true;
+}
+
+/**
+ * 设置子弹组的时间缩放,为0时冻结整组(包括子组),恢复时传入非0值即可。
+ * 只修改一个数值,不触碰任何成员,为 O(1)。
+ *
+ * @param _group 组id
+ * @param _time_scale 时间缩放
+ * @return 组有效时返回true
+ */
+bool MADBulletPool::SetGroupTimeScale(unsigned int _group, float _time_scale)
+{
+	if (!IsGroupAlive(_group))
+	{
+		return false;
+	}
+	Groups[_group].Info.TimeScale = _time_scale;
+	return true;
+}
+
+/**
+ * 读取子弹组当前的变换与时间缩放。
+ *
+ * @param _group 组id
+ * @param[out] out_info 接收组数据的指针
+ * @return 组有效时返回true
+ */
+bool MADBulletPool::GetGroupInfo(unsigned int _group, MADBulletGroupInfo* out_info) const
+{
+	if (!IsGroupAlive(_group) || out_info == nullptr)
+	{
+		return false;
+	}
+	*out_info = Groups[_group].Info;
+	return true;
+}
+
+/**
+ * 检查组id是否指向一个存活的子弹组。
+ *
+ * @param _group 组id
+ * @return 组有效时返回true
+ */
+bool MADBulletPool::IsGroupAlive(unsigned int _group) const
+{
+	return _group < Groups.size() && Groups[_group].Alive;
+}
+
+/**
+ * 获取已创建过的组的数量,组id位于 [0, GetGroupNum()) 区间,其中可能包含已销毁的组。
+ *
+ * @return 组的数量
+ */
+size_t MADBulletPool::GetGroupNum() const
+{
+	return Groups.size();
+}
+
+/**
+ * 获取组的父组。
+ *
+ * @param _group 组id
+ * @return 父组id;没有父组或组不存在时返回MAD_BULLET_INVALID_INDEX
+ */
+unsigned int MADBulletPool::GetGroupParent(unsigned int _group) const
+{
+	if (!IsGroupAlive(_group))
+	{
+		return MAD_BULLET_INVALID_INDEX;
+	}
+	return Groups[_group].Parent;
+}
+
+/**
+ * 获取指定密集索引处子弹所属的组。
+ *
+ * @param _index 子弹的密集索引
+ * @return 组id;不属于任何组时返回MAD_BULLET_INVALID_INDEX
+ */
+unsigned int MADBulletPool::GetGroup(size_t _index) const
+{
+	if (_index < GroupBegin || _index >= AliveTime.size())
+	{
+		return MAD_BULLET_INVALID_INDEX;
+	}
+	std::vector<BulletGroup>::const_iterator l_it = std::partition_point(Groups.begin(), Groups.end(),
+		[=](const BulletGroup& _group) { return _group.Begin + _group.Count <= _index; });
+	return static_cast<unsigned int>(l_it - Groups.begin());
+}
+
+/**
+ * 获取子弹组成员所在的密集索引区间 [out_begin, out_begin + out_num)。
+ *
+ * @param _group 组id
+ * @param[out] out_begin 区间起点
+ * @param[out] out_num 成员数量
+ * @return 组有效时返回true
+ */
+bool MADBulletPool::GetGroupRange(unsigned int _group, size_t* out_begin, size_t* out_num) const
+{
+	if (!IsGroupAlive(_group))
+	{
+		return false;
+	}
+	if (out_begin != nullptr)
+	{
+		*out_begin = Groups[_group].Begin;
+	}
+	if (out_num != nullptr)
+	{
+		*out_num = Groups[_group].Count;
+	}
+	return true;
+}
+
+/**
+ * 设置细节层级(LOD)策略。
+ * 远处子弹先按之前的策略补上跳过的时间,再按新的关注区域立即重新划分远近;Interval不大于1时所有子弹恢复为近处子弹。
+ *
+ * @param _info LOD策略
+ *
+ * 注意:
+ * - 远处子弹最多落后Interval个tick,关注区域应在可见范围与判定范围之外留出这段时间内子弹的移动距离,否则子弹会在回到区域之前就出现在画面或判定中。
+ * - 远处子弹的坐标是上一次推进时的值,ApplyBoundary与碰撞检测对它们使用的也是这个值。
+ */
+void MADBulletPool::SetLod(const MADBulletLodInfo& _info)
+{
+	SyncLod();
+	LodInfo = _info;
+	LodCounter = 0;
+	if (LodInfo.Interval > 1)
+	{
+		ClassifyLod();
+	}
+	else
+	{
+		LodParametricNum = 0;
+		LodPlainNum = 0;
+	}
+}
+
+const MADBulletLodInfo& MADBulletPool::GetLod() const
+{
+	return LodInfo;
+}
+
+/**
+ * 获取当前远处子弹的数量。
+ *
+ * @return 远处参数化子弹与远处普通子弹的数量之和
+ */
+size_t MADBulletPool::GetLodNum() const
+{
+	return LodParametricNum + LodPlainNum;
+}
+
+/**
+ * 获取LOD的内部状态,用于状态哈希等需要区分每一处差异的场合。
+ *
+ * @param out_parametric_num 远处参数化子弹的数量,可为nullptr
+ * @param out_plain_num 远处普通子弹的数量,可为nullptr
+ * @param out_counter 距离上一次推进远处子弹经过的tick数,可为nullptr
+ * @param out_debt 远处子弹尚未补上的时间,可为nullptr
+ */
+void MADBulletPool::GetLodState(size_t* out_parametric_num, size_t* out_plain_num, unsigned int* out_counter, float* out_debt) const
+{
+	if (out_parametric_num != nullptr)
+	{
+		*out_parametric_num = LodParametricNum;
+	}
+	if (out_plain_num != nullptr)
+	{
+		*out_plain_num = LodPlainNum;
+	}
+	if (out_counter != nullptr)
+	{
+		*out_counter = LodCounter;
+	}
+	if (out_debt != nullptr)
+	{
+		*out_debt = LodDebt;
+	}
+}
+
+/**
+ * 获取存活子弹的数量。
+ *
+ * @return 存活子弹数量
+ */
+size_t MADBulletPool::GetNum() const
+{
+	return AliveTime.size();
+}
+
+/**
+ * 获取当前无需扩容即可容纳的子弹数量。
+ *
+ * @return 子弹容量
+ */
+size_t MADBulletPool::GetCapacity() const
+{
+	return AliveTime.capacity();
+}
+
+/**
+ * 获取参数化子弹的数量,它们位于密集索引 [0, GetParametricNum()) 区间。
+ *
+ * @return 参数化子弹数量
+ */
+size_t MADBulletPool::GetParametricNum() const
+{
+	return ParametricNum;
+}
+
+/**
+ * 获取指定密集索引处子弹的运动模型类型。
+ *
+ * @param _index 子弹的密集索引,必须小于GetNum()
+ * @return 运动模型类型,逐帧积分的子弹返回Integrated
+ */
+MADBulletMotionType MADBulletPool::GetMotionType(size_t _index) const
+{
+	return _index < ParametricNum ? Motion[_index].Type : MADBulletMotionType::Integrated;
+}
+
+/**
+ * 查看子弹池是否为空。
+ *
+ * @return 子弹池是否为空
+ */
+bool MADBulletPool::Is_Empty() const
+{
+	return AliveTime.empty();
+}
+
+/**
+ * 检查句柄是否仍指向一颗存活的子弹。
+ *
+ * @param _handle 要检查的子弹句柄
+ * @return 句柄有效时返回true
+ */
+bool MADBulletPool::IsAlive(MADBulletHandle _handle) const
+{
+	return GetIndex(_handle) != MAD_BULLET_INVALID_INDEX;
+}
+
+/**
+ * 将句柄转换为当前的密集索引。
+ * 密集索引会在任何销毁操作之后发生变化,仅可在下一次Spawn/Kill之前使用。
+ *
+ * @param _handle 子弹句柄
+ * @return 子弹的密集索引;句柄失效时返回MAD_BULLET_INVALID_INDEX。
+ */
+size_t MADBulletPool::GetIndex(MADBulletHandle _handle) const
+{
+	if (_handle.Index >= SlotToDense.size() || SlotGeneration[_handle.Index] != _handle.Generation)
+	{
+		return MAD_BULLET_INVALID_INDEX;
+	}
+	return SlotToDense[_handle.Index];
+}
+
+/**
+ * 获取指定密集索引处子弹的句柄。
+ *
+ * @param _index 子弹的密集索引,必须小于GetNum()
+ * @return 该子弹的句柄
+ */
+MADBulletHandle MADBulletPool::GetHandle(size_t _index) const
+{
+	unsigned int l_slot = DenseToSlot[_index];
+	return MADBulletHandle(l_slot, SlotGeneration[l_slot]);
+}
+
+/**
+ * 通过句柄读取子弹数据。
+ *
+ * @param _handle 子弹句柄
+ * @param[out] out_info 接收子弹数据的指针
+ * @return 句柄有效时返回true;句柄失效时返回false且不修改out_info。
+ */
+bool MADBulletPool::GetInfo(MADBulletHandle _handle, BulletInfo* out_info) const
+{
+	size_t l_index = GetIndex(_handle);
+	if (l_index == MAD_BULLET_INVALID_INDEX || out_info == nullptr)
+	{
+		return false;
+	}
+	UpdateMotion();
+	out_info->AliveTime = AliveTime[l_index];
+	out_info->OriginPos = MADVector2DF(OriginPos_X[l_index], OriginPos_Y[l_index]);
+	out_info->OriginDir = MADVector2DF(OriginDir_X[l_index], OriginDir_Y[l_index]);
+	out_info->TeamMask = TeamMask[l_index];
+	return true;
+}
+
+/**
+ * 将指定密集索引处的子弹重新组装为BulletInfo。
+ *
+ * @param _index 子弹的密集索引,必须小于GetNum()
+ * @return 子弹数据的副本
+ */
+BulletInfo MADBulletPool::GetInfoAt(size_t _index) const
+{
+	UpdateMotion();
+	BulletInfo l_info(MADVector2DF(OriginPos_X[_index], OriginPos_Y[_index]),
+		MADVector2DF(OriginDir_X[_index], OriginDir_Y[_index]),
+		TeamMask[_index]);
+	l_info.AliveTime = AliveTime[_index];
+	return l_info;
+}
+
+/**
+ * 通过句柄覆盖子弹数据。
+ * 参数化子弹的运动模型以新的位置、速度与存活时间为起点继续,相位、角度与半径从当前状态接续,速度为包含模型偏移在内的总速度;
+ * 写回的运动状态与模型当前算出的完全相同时模型保持不变,因此 SetInfo(GetInfo()) 不会改变之后的轨迹。
+ * 子弹组成员的新位置与速度按世界坐标给出,会被换算回组的局部坐标。
+ *
+ * @param _handle 子弹句柄
+ * @param _info 新的子弹数据
+ * @return 句柄有效时返回true
+ */
+bool MADBulletPool::SetInfo(MADBulletHandle _handle, const BulletInfo& _info)
+{
+	size_t l_index = GetIndex(_handle);
+	if (l_index == MAD_BULLET_INVALID_INDEX)
+	{
+		return false;
+	}
+
+	/*Settle far bullets first,otherwise the skipped time would be added on top of the new state*/
+	SyncLod();
+	bool l_rebase = false;
+	if (l_index < ParametricNum)
+	{
+		UpdateMotion();
+		l_rebase = _info.AliveTime != AliveTime[l_index] ||
+			_info.OriginPos.x != OriginPos_X[l_index] || _info.OriginPos.y != OriginPos_Y[l_index] ||
+			_info.OriginDir.x != OriginDir_X[l_index] || _info.OriginDir.y != OriginDir_Y[l_index];
+	}
+	AliveTime[l_index] = _info.AliveTime;
+	OriginPos_X[l_index] = _info.OriginPos.x;
+	OriginPos_Y[l_index] = _info.OriginPos.y;
+	OriginDir_X[l_index] = _info.OriginDir.x;
+	OriginDir_Y[l_index] = _info.OriginDir.y;
+	TeamMask[l_index] = _info.TeamMask;
+	if (l_index >= GroupBegin)
+	{
+		UpdateMotion();
+		BulletGroup& l_group = Groups[GetGroup(l_index)];
+		const MADBulletTransform& l_world = l_group.World;
+		float l_rx = _info.OriginPos.x - l_world.Offset_X;
+		float l_ry = _info.OriginPos.y - l_world.Offset_Y;
+		float l_vx = (_info.OriginDir.x - l_world.Velocity_X) + l_world.Angular * l_ry;
+		float l_vy = (_info.OriginDir.y - l_world.Velocity_Y) - l_world.Angular * l_rx;
+		LocalPos_X[l_index] = l_world.Cos * l_rx + l_world.Sin * l_ry;
+		LocalPos_Y[l_index] = l_world.Cos * l_ry - l_world.Sin * l_rx;
+		LocalDir_X[l_index] = l_world.Cos * l_vx + l_world.Sin * l_vy;
+		LocalDir_Y[l_index] = l_world.Cos * l_vy - l_world.Sin * l_vx;
+		l_group.MembersDirty = true;
+		GroupDirty = true;
+	}
+	if (l_rebase)
+	{
+		RebaseMotion(Motion[l_index], _info.AliveTime, _info.OriginPos, _info.OriginDir);
+		MADBulletKernel::EvaluateMotion(&Motion[l_index], &AliveTime[l_index],
+			&OriginPos_X[l_index], &OriginPos_Y[l_index], &OriginDir_X[l_index], &OriginDir_Y[l_index], 1);
+	}
+	return true;
+}
+
+/**
+ * 设置子弹离开边界时的处理方式,新生成的子弹默认为Kill。
+ * 子弹组成员的世界坐标由组变换决定,无法单独环绕或反弹,因此对它们而言Wrap与Reflect等同于Kill。
+ *
+ * @param _handle 子弹句柄
+ * @param _boundary 边界处理方式
+ * @param _bounce_num Reflect方式下允许的反弹次数,超过65535按65535处理
+ * @return 句柄有效时返回true
+ */
+bool MADBulletPool::SetBoundary(MADBulletHandle _handle, MADBulletBoundary _boundary, unsigned int _bounce_num)
+{
+	size_t l_index = GetIndex(_handle);
+	if (l_index == MAD_BULLET_INVALID_INDEX)
+	{
+		return false;
+	}
+	Boundary[l_index] = _boundary;
+	BounceLeft[l_index] = static_cast<unsigned short>(_bounce_num < 0xFFFFu ? _bounce_num : 0xFFFFu);
+	return true;
+}
+
+/**
+ * 获取指定密集索引处子弹的边界处理方式。
+ *
+ * @param _index 子弹的密集索引,必须小于GetNum()
+ * @return 边界处理方式
+ */
+MADBulletBoundary MADBulletPool::GetBoundary(size_t _index) const
+{
+	return Boundary[_index];
+}
+
+/**
+ * 获取指定密集索引处子弹的剩余反弹次数。
+ *
+ * @param _index 子弹的密集索引,必须小于GetNum()
+ * @return 剩余反弹次数
+ */
+unsigned int MADBulletPool::GetBounceLeft(size_t _index) const
+{
+	return BounceLeft[_index];
+}
+
+/**
+ * 设置子弹的精灵索引与颜色索引,新生成的子弹默认均为0。
+ * 这两个索引不参与模拟,只在FlushTo的布局要求时随子弹一起输出,供渲染端查表。
+ *
+ * @param _handle 子弹句柄
+ * @param _sprite 精灵索引
+ * @param _color 颜色索引
+ * @return 句柄有效时返回true
+ */
+bool MADBulletPool::SetAppearance(MADBulletHandle _handle, unsigned short _sprite, unsigned short _color)
+{
+	size_t l_index = GetIndex(_handle);
+	if (l_index == MAD_BULLET_INVALID_INDEX)
+	{
+		return false;
+	}
+	Appearance[l_index] = static_cast<unsigned int>(_sprite) | (static_cast<unsigned int>(_color) << 16);
+	return true;
+}
+
+/**
+ * 获取指定密集索引处子弹的精灵索引。
+ *
+ * @param _index 子弹的密集索引,必须小于GetNum()
+ * @return 精灵索引
+ */
+unsigned short MADBulletPool::GetSprite(size_t _index) const
+{
+	return static_cast<unsigned short>(Appearance[_index] & 0xFFFFu);
+}
+
+/**
+ * 获取指定密集索引处子弹的颜色索引。
+ *
+ * @param _index 子弹的密集索引,必须小于GetNum()
+ * @return 颜色索引
+ */
+unsigned short MADBulletPool::GetColor(size_t _index) const
+{
+	return static_cast<unsigned short>(Appearance[_index] >> 16);
+}
+
+/**
+ * 设置或清除子弹的擦弹标记。
+ * MADCollisionWorld::QueryGraze只对未标记的子弹报告擦弹并随即标记,因此每颗子弹在其生命周期内只计一次擦弹;
+ * 清除标记可以让子弹再次被计入,例如被转化后重新发射的子弹。
+ *
+ * @param _handle 子弹句柄
+ * @param _grazed 是否已被擦弹
+ * @return 句柄有效时返回true
+ */
+bool MADBulletPool::SetGrazed(MADBulletHandle _handle, bool _grazed)
+{
+	size_t l_index = GetIndex(_handle);
+	if (l_index == MAD_BULLET_INVALID_INDEX)
+	{
+		return false;
+	}
+	MarkGrazed(l_index, _grazed);
+	return true;
+}
+
+/**
+ * 按密集索引设置或清除子弹的擦弹标记。
+ *
+ * @param _index 子弹的密集索引,必须小于GetNum()
+ * @param _grazed 是否已被擦弹
+ */
+void MADBulletPool::MarkGrazed(size_t _index, bool _grazed)
+{
+	if (_grazed)
+	{
+		Flags[_index] |= MAD_BULLET_FLAG_GRAZED;
+	}
+	else
+	{
+		Flags[_index] &= static_cast<unsigned char>(~MAD_BULLET_FLAG_GRAZED);
+	}
+}
+
+/**
+ * 获取指定密集索引处的子弹是否已被擦弹。
+ *
+ * @param _index 子弹的密集索引,必须小于GetNum()
+ * @return 已被擦弹时返回true
+ */
+bool MADBulletPool::IsGrazed(size_t _index) const
+{
+	return (Flags[_index] & MAD_BULLET_FLAG_GRAZED) != 0;
+}
+
+/*Raw arrays,position and direction of parametric bullets are evaluated before returning*/
+float* MADBulletPool::GetAliveTimeData() { SyncLod(); return AliveTime.data(); }
+float* MADBulletPool::GetPositionXData() { SyncLod(); UpdateMotion(); return OriginPos_X.data(); }
+float* MADBulletPool::GetPositionYData() { SyncLod(); UpdateMotion(); return OriginPos_Y.data(); }
+float* MADBulletPool::GetDirXData() { SyncLod(); UpdateMotion(); return OriginDir_X.data(); }
+float* MADBulletPool::GetDirYData() { SyncLod(); UpdateMotion(); return OriginDir_Y.data(); }
+long long* MADBulletPool::GetTeamMaskData() { return TeamMask.data(); }
+const float* MADBulletPool::GetAliveTimeData() const { return AliveTime.data(); }
+const float* MADBulletPool::GetPositionXData() const { UpdateMotion(); return OriginPos_X.data(); }
+const float* MADBulletPool::GetPositionYData() const { UpdateMotion(); return OriginPos_Y.data(); }
+const float* MADBulletPool::GetDirXData() const { UpdateMotion(); return OriginDir_X.data(); }
+const float* MADBulletPool::GetDirYData() const { UpdateMotion(); return OriginDir_Y.data(); }
+const long long* MADBulletPool::GetTeamMaskData() const { return TeamMask.data(); }
+const MADBulletBoundary* MADBulletPool::GetBoundaryData() const { return Boundary.data(); }
+const unsigned short* MADBulletPool::GetBounceLeftData() const { return BounceLeft.data(); }
+const unsigned int* MADBulletPool::GetAppearanceData() const { return Appearance.data(); }
+const unsigned char* MADBulletPool::GetFlagsData() const { return Flags.data(); }
+const MADBulletMotionState* MADBulletPool::GetMotionData() const { return Motion.data(); }
+
+/**
+ * 将所有存活子弹按速度前进 _dt 秒,并可选地在同一次遍历中写出刷新数据。
+ * 计算由MADBulletKernel::Integrate完成,会根据CPU自动选择SIMD路径。
+ * 传入调度器时按MAD_BULLET_JOB_GRAIN切分到多个线程,每颗子弹的计算互不依赖,结果与单线程逐位一致。
+ *
+ * 参数化子弹只增加存活时间;子弹组按各自的时间缩放推进组变换并积分成员的局部坐标,时间缩放为0的组被跳过。
+ * 这两类子弹的世界坐标在首次被读取(或需要输出刷新数据)时才统一计算。
+ *
+ * 开启LOD时,远处子弹只在每Interval个tick中的最后一个tick推进,先补上之前跳过的时间,再重新划分远近,
+ * 其余tick只推进近处子弹与子弹组;输出的刷新数据中远处子弹保持上一次推进后的状态。
+ *
+ * @param _dt 时间步长(秒)
+ * @param[out] out_res 可选的刷新数据输出,至少能容纳GetNum()条记录;传入nullptr则不输出
+ * @param _jobs 可选的任务调度器,传入nullptr则在当前线程执行
+ */
+void MADBulletPool::Step(float _dt, MADBulletFlushResData* out_res, MADJobSystem* _jobs)
+{
+	/*Far bullets skip the tick and keep its time,or catch up and get reclassified on the last tick of the interval*/
+	bool l_far_skip = false;
+	if (LodInfo.Interval > 1)
+	{
+		LodCounter++;
+		if (LodCounter < LodInfo.Interval)
+		{
+			LodDebt = LodDebt + _dt;
+			l_far_skip = true;
+		}
+		else
+		{
+			SyncLod();
+			ClassifyLod();
+			LodCounter = 0;
+		}
+	}
+	size_t l_parametric = ParametricNum;
+	size_t l_parametric_end = l_far_skip ? ParametricNum - LodParametricNum : ParametricNum;
+	size_t l_plain_end = l_far_skip ? GroupBegin - LodPlainNum : GroupBegin;
+
+	/*Parametric bullets only age,their positions are evaluated on demand*/
+	if (l_parametric_end > 0)
+	{
+		float* l_alive = AliveTime.data();
+		for (size_t i = 0; i < l_parametric_end; ++i)
+		{
+			l_alive[i] = l_alive[i] + _dt;
+		}
+		if (l_parametric_end == l_parametric)
+		{
+			MotionDirty = true;
+		}
+		else
+		{
+			NearMotionDirty = true;
+		}
+	}
+
+	/*Plain integrated bullets*/
+	{
+		float* l_px = OriginPos_X.data() + l_parametric;
+		float* l_py = OriginPos_Y.data() + l_parametric;
+		const float* l_dx = OriginDir_X.data() + l_parametric;
+		const float* l_dy = OriginDir_Y.data() + l_parametric;
+		float* l_alive = AliveTime.data() + l_parametric;
+		MADBulletFlushResData* l_res = out_res != nullptr ? out_res + l_parametric : nullptr;
+		MADJobSystem::Dispatch(_jobs, l_plain_end - l_parametric, MAD_BULLET_JOB_GRAIN, [=](size_t _begin, size_t _end, size_t) {
+			MADBulletKernel::Integrate(l_px + _begin, l_py + _begin, l_dx + _begin, l_dy + _begin, l_alive + _begin,
+				_end - _begin, _dt, l_res != nullptr ? l_res + _begin : nullptr);
+		});
+	}
+
+	/*Groups,parents always come before their children*/
+	for (size_t g = 0; g < Groups.size(); ++g)
+	{
+		BulletGroup& l_group = Groups[g];
+		if (!l_group.Alive)
+		{
+			continue;
+		}
+		l_group.WorldTimeScale = l_group.Info.TimeScale;
+		if (l_group.Parent != MAD_BULLET_INVALID_INDEX)
+		{
+			l_group.WorldTimeScale = l_group.WorldTimeScale * Groups[l_group.Parent].WorldTimeScale;
+		}
+		float l_dt = _dt * l_group.WorldTimeScale;
+		if (l_dt == 0.0f)
+		{
+			continue;
+		}
+
+		MADBulletGroupInfo& l_info = l_group.Info;
+		if (l_info.Velocity.x != 0.0f || l_info.Velocity.y != 0.0f || l_info.AngularVelocity != 0.0f)
+		{
+			l_info.Offset.x = l_info.Offset.x + l_info.Velocity.x * l_dt;
+			l_info.Offset.y = l_info.Offset.y + l_info.Velocity.y * l_dt;
+			l_info.Rotation = MADStrictMath::Fmod(l_info.Rotation + l_info.AngularVelocity * l_dt, MAD_BULLET_TWO_PI);
+			l_group.TransformDirty = true;
+			GroupDirty = true;
+		}
+		if (l_group.Count > 0)
+		{
+			float* l_px = LocalPos_X.data() + l_group.Begin;
+			float* l_py = LocalPos_Y.data() + l_group.Begin;
+			const float* l_dx = LocalDir_X.data() + l_group.Begin;
+			const float* l_dy = LocalDir_Y.data() + l_group.Begin;
+			float* l_alive = AliveTime.data() + l_group.Begin;
+			MADJobSystem::Dispatch(_jobs, l_group.Count, MAD_BULLET_JOB_GRAIN, [=](size_t _begin, size_t _end, size_t) {
+				MADBulletKernel::Integrate(l_px + _begin, l_py + _begin, l_dx + _begin, l_dy + _begin, l_alive + _begin,
+					_end - _begin, l_dt, nullptr);
+			});
+			l_group.MembersDirty = true;
+			GroupDirty = true;
+		}
+	}
+
+	/*Parametric bullets,skipped far bullets and group members are written once their world positions are known*/
+	if (out_res != nullptr && (l_parametric > 0 || l_plain_end < AliveTime.size()))
+	{
+		UpdateMotion(_jobs);
+		CopyFlushRange(*this, 0, l_parametric, out_res);
+		CopyFlushRange(*this, l_plain_end, AliveTime.size(), out_res);
+	}
+}
+
+/**
+ * 将所有存活子弹前进 _dt 秒,并把刷新数据写入 out_res。
+ *
+ * @param _dt 时间步长(秒)
+ * @param[out] out_res 接收输出的数组,原有内容会被覆盖
+ * @param _jobs 可选的任务调度器,传入nullptr则在当前线程执行
+ */
+void MADBulletPool::Step(float _dt, std::vector<MADBulletFlushResData>& out_res, MADJobSystem* _jobs)
+{
+	out_res.resize(AliveTime.size());
+	Step(_dt, out_res.data(), _jobs);
+}
+
+/**
+ * 将所有存活子弹按密集索引顺序输出为MADBulletFlushResData。
+ * 只对SoA数组做一次线性遍历,out_res的容量会被复用。
+ *
+ * @param[out] out_res 接收输出的数组,原有内容会被覆盖
+ */
+void MADBulletPool::Flush(std::vector<MADBulletFlushResData>& out_res) const
+{
+	out_res.resize(AliveTime.size());
+	Flush(out_res.data(), out_res.size());
+}
+
+/**
+ * 将存活子弹输出到调用者提供的缓冲区中。
+ *
+ * @param[out] out_res 输出缓冲区
+ * @param _capacity 输出缓冲区可容纳的元素数量
+ * @return 实际写入的元素数量,超出容量的子弹会被忽略
+ */
+size_t MADBulletPool::Flush(MADBulletFlushResData* out_res, size_t _capacity) const
+{
+	UpdateMotion();
+	size_t l_num = AliveTime.size() < _capacity ? AliveTime.size() : _capacity;
+	const float* l_px = OriginPos_X.data();
+	const float* l_py = OriginPos_Y.data();
+	const float* l_dx = OriginDir_X.data();
+	const float* l_dy = OriginDir_Y.data();
+	for (size_t i = 0; i < l_num; ++i)
+	{
+		out_res[i].Position_X = l_px[i];
+		out_res[i].Position_Y = l_py[i];
+		out_res[i].Dir_X = l_dx[i];
+		out_res[i].Dir_Y = l_dy[i];
+	}
+	return l_num;
+}
+
+/**
+ * 将存活子弹按指定布局直接写入调用者提供的缓冲区,例如映射后的GPU实例缓冲区,省去一次中间拷贝。
+ * 第i颗子弹写在 out_buffer + i * Stride 处,各格式的记录布局为:
+ * - Float4: float x, y, dir_x, dir_y (16字节)
+ * - Half4: 半精度 x, y, dir_x, dir_y (8字节)
+ * - PosAngle: float x, y, angle (12字节),angle = atan2(dir_y, dir_x),单位为弧度
+ * WriteIndices为true时,紧随其后再写入 uint16 精灵索引与 uint16 颜色索引(4字节)。
+ * 记录之间超出记录大小的字节不会被触碰,可以留给顶点属性的其他字段。
+ *
+ * @param[out] out_buffer 输出缓冲区
+ * @param _capacity 输出缓冲区可容纳的记录数量
+ * @param _layout 输出布局,Stride为0时使用紧密排列的记录大小
+ * @param _jobs 可选的任务调度器,传入nullptr则在当前线程执行
+ * @return 实际写入的记录数量,超出容量的子弹会被忽略;Stride小于记录大小时不写入并返回0
+ *
+ * 注意:
+ * - 半精度只有11位有效数字,坐标超过2048时精度低于1个单位,请根据场景尺寸选择格式。
+ * - 对齐到16字节的Float4缓冲区会使用非临时写入,适合写合并内存,但之后不宜再由CPU读取。
+ */
+size_t MADBulletPool::FlushTo(void* out_buffer, size_t _capacity, const MADFlushLayout& _layout, MADJobSystem* _jobs) const
+{
+	size_t l_record = MADBulletKernel::GetRecordSize(_layout);
+	size_t l_stride = _layout.Stride != 0 ? _layout.Stride : l_record;
+	if (l_stride < l_record)
+	{
+		MAD_LOG_ERR("Try to flush bullets with a stride of " + std::to_string(l_stride) +
+			" bytes,which is smaller than the record size of " + std::to_string(l_record) + " bytes!");
+		return 0;
+	}
+
+	UpdateMotion(_jobs);
+	size_t l_num = AliveTime.size() < _capacity ? AliveTime.size() : _capacity;
+	const float* l_px = OriginPos_X.data();
+	const float* l_py = OriginPos_Y.data();
+	const float* l_dx = OriginDir_X.data();
+	const float* l_dy = OriginDir_Y.data();
+	const unsigned int* l_appearance = _layout.WriteIndices ? Appearance.data() : nullptr;
+	unsigned char* l_out = static_cast<unsigned char*>(out_buffer);
+	MADFlushFormat l_format = _layout.Format;
+	MADJobSystem::Dispatch(_jobs, l_num, MAD_BULLET_JOB_GRAIN, [=](size_t _begin, size_t _end, size_t) {
+		MADBulletKernel::Pack(l_px + _begin, l_py + _begin, l_dx + _begin, l_dy + _begin,
+			l_appearance != nullptr ? l_appearance + _begin : nullptr, _end - _begin,
+			l_format, l_stride, l_out + _begin * l_stride);
+	});
+	return l_num;
+}
+
+/**
+ * 把子弹池的全部状态追加到 out_data 末尾。
+ * 每个连续数组按内存映像整体复制,不逐颗子弹处理;尚未计算的参数化子弹与子弹组成员连同脏标记一起保存,
+ * 因此恢复后的子弹池与保存时逐位一致。
+ * 子弹数组按MAD_BULLET_SNAPSHOT_GRAIN颗子弹的粒度预留空间,子弹数量小幅变化时各数组在快照中的偏移不变。
+ *
+ * @param out_data 输出缓冲区,数据追加在已有内容之后
+ * @return 写入的字节数
+ */
+size_t MADBulletPool::Snapshot(std::vector<unsigned char>& out_data) const
+{
+	size_t l_begin = out_data.size();
+	MADBlobWriter l_writer(out_data);
+	size_t l_reserve = (AliveTime.size() / MAD_BULLET_SNAPSHOT_GRAIN + 1) * MAD_BULLET_SNAPSHOT_GRAIN;
+	size_t l_motion_reserve = (ParametricNum / MAD_BULLET_SNAPSHOT_GRAIN + 1) * MAD_BULLET_SNAPSHOT_GRAIN;
+	size_t l_slot_reserve = (SlotToDense.size() / MAD_BULLET_SNAPSHOT_GRAIN + 1) * MAD_BULLET_SNAPSHOT_GRAIN;
+	l_writer.Write(MAD_BULLET_POOL_SNAPSHOT_TAG);
+	l_writer.Write((MotionDirty ? 1u : 0u) | (GroupDirty ? 2u : 0u) | (NearMotionDirty ? 4u : 0u));
+	l_writer.Write(static_cast<unsigned long long>(ParametricNum));
+	l_writer.Write(static_cast<unsigned long long>(GroupBegin));
+	l_writer.Write(LodInfo.Min.x);
+	l_writer.Write(LodInfo.Min.y);
+	l_writer.Write(LodInfo.Max.x);
+	l_writer.Write(LodInfo.Max.y);
+	l_writer.Write(LodInfo.Interval);
+	l_writer.Write(LodCounter);
+	l_writer.Write(LodDebt);
+	l_writer.Write(static_cast<unsigned long long>(LodParametricNum));
+	l_writer.Write(static_cast<unsigned long long>(LodPlainNum));
+	l_writer.WriteArray(AliveTime, l_reserve);
+	l_writer.WriteArray(OriginPos_X, l_reserve);
+	l_writer.WriteArray(OriginPos_Y, l_reserve);
+	l_writer.WriteArray(OriginDir_X, l_reserve);
+	l_writer.WriteArray(OriginDir_Y, l_reserve);
+	l_writer.WriteArray(TeamMask, l_reserve);
+	l_writer.WriteArray(Boundary, l_reserve);
+	l_writer.WriteArray(BounceLeft, l_reserve);
+	l_writer.WriteArray(Appearance, l_reserve);
+	l_writer.WriteArray(Flags, l_reserve);
+	l_writer.WriteArray(LocalPos_X, l_reserve);
+	l_writer.WriteArray(LocalPos_Y, l_reserve);
+	l_writer.WriteArray(LocalDir_X, l_reserve);
+	l_writer.WriteArray(LocalDir_Y, l_reserve);
+	l_writer.WriteArray(Motion, l_motion_reserve);
+	l_writer.WriteArray(DenseToSlot, l_reserve);
+	l_writer.WriteArray(SlotToDense, l_slot_reserve);
+	l_writer.WriteArray(SlotGeneration, l_slot_reserve);
+	l_writer.WriteArray(FreeSlots, l_slot_reserve);
+	l_writer.WriteArray(Groups);
+	return out_data.size() - l_begin;
+}
+
+/**
+ * 从快照中恢复子弹池的全部状态,已有数组的容量会被复用。
+ * 快照数据损坏或不完整时子弹池被清空。
+ *
+ * @param io_reader 指向一份由Snapshot写入的数据,读取后前进到该数据之后
+ * @return 成功时返回true
+ */
+bool MADBulletPool::Restore(MADBlobReader& io_reader)
+{
+	unsigned int l_tag = 0;
+	unsigned int l_dirty = 0;
+	unsigned long long l_parametric_num = 0;
+	unsigned long long l_group_begin = 0;
+	MADBulletLodInfo l_lod_info;
+	unsigned int l_lod_counter = 0;
+	float l_lod_debt = 0.0f;
+	unsigned long long l_lod_parametric_num = 0;
+	unsigned long long l_lod_plain_num = 0;
+	io_reader.Read(&l_tag);
+	io_reader.Read(&l_dirty);
+	io_reader.Read(&l_parametric_num);
+	io_reader.Read(&l_group_begin);
+	io_reader.Read(&l_lod_info.Min.x);
+	io_reader.Read(&l_lod_info.Min.y);
+	io_reader.Read(&l_lod_info.Max.x);
+	io_reader.Read(&l_lod_info.Max.y);
+	io_reader.Read(&l_lod_info.Interval);
+	io_reader.Read(&l_lod_counter);
+	io_reader.Read(&l_lod_debt);
+	io_reader.Read(&l_lod_parametric_num);
+	io_reader.Read(&l_lod_plain_num);
+	io_reader.ReadArray(AliveTime);
+	io_reader.ReadArray(OriginPos_X);
+	io_reader.ReadArray(OriginPos_Y);
+	io_reader.ReadArray(OriginDir_X);
+	io_reader.ReadArray(OriginDir_Y);
+	io_reader.ReadArray(TeamMask);
+	io_reader.ReadArray(Boundary);
+	io_reader.ReadArray(BounceLeft);
+	io_reader.ReadArray(Appearance);
+	io_reader.ReadArray(Flags);
+	io_reader.ReadArray(LocalPos_X);
+	io_reader.ReadArray(LocalPos_Y);
+	io_reader.ReadArray(LocalDir_X);
+	io_reader.ReadArray(LocalDir_Y);
+	io_reader.ReadArray(Motion);
+	io_reader.ReadArray(DenseToSlot);
+	io_reader.ReadArray(SlotToDense);
+	io_reader.ReadArray(SlotGeneration);
+	io_reader.ReadArray(FreeSlots);
+	io_reader.ReadArray(Groups);
+
+	/*Every per-bullet array must agree on the bullet count*/
+	size_t l_num = AliveTime.size();
+	bool l_valid = !io_reader.IsFailed() && l_tag == MAD_BULLET_POOL_SNAPSHOT_TAG &&
+		l_parametric_num <= l_group_begin && l_group_begin <= l_num && Motion.size() == l_parametric_num &&
+		l_lod_parametric_num <= l_parametric_num && l_lod_plain_num <= l_group_begin - l_parametric_num &&
+		OriginPos_X.size() == l_num && OriginPos_Y.size() == l_num &&
+		OriginDir_X.size() == l_num && OriginDir_Y.size() == l_num &&
+		TeamMask.size() == l_num && Boundary.size() == l_num && BounceLeft.size() == l_num &&
+		Appearance.size() == l_num && Flags.size() == l_num &&
+		LocalPos_X.size() == l_num && LocalPos_Y.size() == l_num &&
+		LocalDir_X.size() == l_num && LocalDir_Y.size() == l_num &&
+		DenseToSlot.size() == l_num && SlotToDense.size() == SlotGeneration.size();
+	for (size_t i = 0; l_valid && i < l_num; ++i)
+	{
+		l_valid = DenseToSlot[i] < SlotToDense.size() && SlotToDense[DenseToSlot[i]] == i &&
+			static_cast<unsigned char>(Boundary[i]) <= static_cast<unsigned char>(MADBulletBoundary::Ignore);
+	}
+	for (size_t i = 0; l_valid && i < Motion.size(); ++i)
+	{
+		l_valid = static_cast<unsigned char>(Motion[i].Type) <= static_cast<unsigned char>(MADBulletMotionType::Spiral);
+	}
+
+	/*Every slot without a bullet is free exactly once*/
+	l_valid = l_valid && l_num + FreeSlots.size() == SlotToDense.size();
+	for (size_t i = 0; l_valid && i < FreeSlots.size(); ++i)
+	{
+		unsigned int l_slot = FreeSlots[i];
+		l_valid = l_slot < SlotToDense.size() && SlotToDense[l_slot] == MAD_BULLET_INVALID_INDEX;
+		if (l_valid)
+		{
+			/*Mark the slot so a repeated free slot fails the check above*/
+			SlotToDense[l_slot] = MAD_BULLET_INVALID_INDEX - 1;
+		}
+	}
+	for (size_t i = 0; l_valid && i < FreeSlots.size(); ++i)
+	{
+		SlotToDense[FreeSlots[i]] = MAD_BULLET_INVALID_INDEX;
+	}
+
+	/*Group ranges follow each other from GroupBegin to the end,and parents come before their children*/
+	size_t l_group_end = static_cast<size_t>(l_group_begin);
+	for (size_t g = 0; l_valid && g < Groups.size(); ++g)
+	{
+		const BulletGroup& l_group = Groups[g];
+		l_valid = l_group.Begin == l_group_end && l_group.Count <= l_num - l_group_end &&
+			(l_group.Parent == MAD_BULLET_INVALID_INDEX || l_group.Parent < g);
+		l_group_end += l_valid ? l_group.Count : 0;
+	}
+	l_valid = l_valid && l_group_end == l_num;
+	if (!l_valid)
+	{
+		MAD_LOG_ERR("Try to restore a bullet pool from a broken snapshot!");
+		AliveTime.clear();
+		OriginPos_X.clear();
+		OriginPos_Y.clear();
+		OriginDir_X.clear();
+		OriginDir_Y.clear();
+		TeamMask.clear();
+		Boundary.clear();
+		BounceLeft.clear();
+		Appearance.clear();
+		Flags.clear();
+		LocalPos_X.clear();
+		LocalPos_Y.clear();
+		LocalDir_X.clear();
+		LocalDir_Y.clear();
+		Motion.clear();
+		DenseToSlot.clear();
+		SlotToDense.clear();
+		SlotGeneration.clear();
+		FreeSlots.clear();
+		Groups.clear();
+		ParametricNum = 0;
+		GroupBegin = 0;
+		MotionDirty = false;
+		GroupDirty = false;
+		LodParametricNum = 0;
+		LodPlainNum = 0;
+		LodCounter = 0;
+		LodDebt = 0.0f;
+		NearMotionDirty = false;
+		return false;
+	}
+	ParametricNum = static_cast<size_t>(l_parametric_num);
+	GroupBegin = static_cast<size_t>(l_group_begin);
+	MotionDirty = (l_dirty & 1u) != 0;
+	GroupDirty = (l_dirty & 2u) != 0;
+	NearMotionDirty = (l_dirty & 4u) != 0;
+	LodInfo = l_lod_info;
+	LodCounter = l_lod_counter;
+	LodDebt = l_lod_debt;
+	LodParametricNum = static_cast<size_t>(l_lod_parametric_num);
+	LodPlainNum = static_cast<size_t>(l_lod_plain_num);
+	return true;
+}
+
+/**
+ * 按存活时间计算所有参数化子弹的位置与速度,并把有变化的子弹组成员变换到世界空间,写入位置与速度数组。
+ * 读取位置与速度的接口会自动调用本方法,只有在上次计算之后执行过Step或修改过子弹组才会真正计算;
+ * 远处子弹被跳过的tick只计算近处的参数化子弹。
+ * 需要多线程计算时,可以在读取之前主动传入调度器调用。
+ *
+ * @param _jobs 可选的任务调度器,传入nullptr则在当前线程执行
+ */
+void MADBulletPool::UpdateMotion(MADJobSystem* _jobs) const
+{
+	if (GroupDirty)
+	{
+		GroupDirty = false;
+		UpdateGroups(_jobs);
+	}
+	if (!MotionDirty && !NearMotionDirty)
+	{
+		return;
+	}
+	size_t l_num = MotionDirty ? ParametricNum : ParametricNum - LodParametricNum;
+	MotionDirty = false;
+	NearMotionDirty = false;
+
+	const MADBulletMotionState* l_motion = Motion.data();
+	const float* l_alive = AliveTime.data();
+	float* l_px = OriginPos_X.data();
+	float* l_py = OriginPos_Y.data();
+	float* l_dx = OriginDir_X.data();
+	float* l_dy = OriginDir_Y.data();
+	MADJobSystem::Dispatch(_jobs, l_num, MAD_BULLET_JOB_GRAIN, [=](size_t _begin, size_t _end, size_t) {
+		MADBulletKernel::EvaluateMotion(l_motion + _begin, l_alive + _begin,
+			l_px + _begin, l_py + _begin, l_dx + _begin, l_dy + _begin, _end - _begin);
+	});
+}
+
+/**
+ * 对所有子弹执行一次边界检查,按每颗子弹的边界处理方式销毁、环绕或反弹。
+ * 先用SIMD扫描找出越界的子弹,只对这些子弹逐个处理,最后用KillBatch一次性压缩所有被销毁的子弹。
+ * 参数化子弹的环绕与反弹通过平移或镜像其运动模型实现,轨迹依旧精确。
+ *
+ * @param _min 边界的最小角(左下)
+ * @param _max 边界的最大角(右上)
+ * @return 被销毁的子弹数量
+ *
+ * 注意:
+ * - 环绕每次只平移一个边界宽度,单tick内越过整个边界的子弹会在之后的检查中继续环绕。
+ * - 坐标为NaN的子弹无论处理方式如何都会被销毁。
+ */
+size_t MADBulletPool::ApplyBoundary(const MADVector2DF& _min, const MADVector2DF& _max)
+{
+	UpdateMotion();
+	size_t l_num = AliveTime.size();
+	if (l_num == 0)
+	{
+		return 0;
+	}
+	BatchIndex.resize(l_num);
+	unsigned int* l_index = BatchIndex.data();
+	size_t l_outside = MADBulletKernel::FindOutside(OriginPos_X.data(), OriginPos_Y.data(), l_num,
+		_min.x, _min.y, _max.x, _max.y, l_index);
+
+	float l_width = _max.x - _min.x;
+	float l_height = _max.y - _min.y;
+	size_t l_kill = 0;
+	for (size_t k = 0; k < l_outside; ++k)
+	{
+		unsigned int i = l_index[k];
+		float l_x = OriginPos_X[i];
+		float l_y = OriginPos_Y[i];
+		MADBulletBoundary l_boundary = Boundary[i];
+		if (l_boundary == MADBulletBoundary::Ignore)
+		{
+			continue;
+		}
+		if (l_boundary == MADBulletBoundary::Kill || l_x != l_x || l_y != l_y || i >= GroupBegin ||
+			(l_boundary == MADBulletBoundary::Reflect && BounceLeft[i] == 0))
+		{
+			l_index[l_kill++] = i;
+			continue;
+		}
+
+		if (l_boundary == MADBulletBoundary::Wrap)
+		{
+			float l_shift_x = l_x < _min.x ? l_width : (l_x > _max.x ? -l_width : 0.0f);
+			float l_shift_y = l_y < _min.y ? l_height : (l_y > _max.y ? -l_height : 0.0f);
+			OriginPos_X[i] = l_x + l_shift_x;
+			OriginPos_Y[i] = l_y + l_shift_y;
+			if (i < ParametricNum)
+			{
+				Motion[i].Origin_X += l_shift_x;
+				Motion[i].Origin_Y += l_shift_y;
+			}
+			continue;
+		}
+
+		/*Reflect*/
+		BounceLeft[i]--;
+		if (l_x < _min.x || l_x > _max.x)
+		{
+			float l_wall = l_x < _min.x ? _min.x : _max.x;
+			OriginPos_X[i] = 2.0f * l_wall - l_x;
+			OriginDir_X[i] = -OriginDir_X[i];
+			if (i < ParametricNum)
+			{
+				MirrorMotion(Motion[i], true, l_wall);
+			}
+		}
+		if (l_y < _min.y || l_y > _max.y)
+		{
+			float l_wall = l_y < _min.y ? _min.y : _max.y;
+			OriginPos_Y[i] = 2.0f * l_wall - l_y;
+			OriginDir_Y[i] = -OriginDir_Y[i];
+			if (i < ParametricNum)
+			{
+				MirrorMotion(Motion[i], false, l_wall);
+			}
+		}
+	}
+
+	KillBatch(l_index, l_kill);
+	return l_kill;
+}
+
+/**
+ * 消除位于圆内且TeamMask与 _mask 相交的子弹,例如炸弹的消弹范围,并输出被消除子弹的位置供生成得点道具。
+ * 查找由MADBulletKernel::OverlapCircle完成,销毁只做一遍KillBatch压缩,存活的子弹保持原有顺序。
+ *
+ * @param _center 圆心
+ * @param _radius 半径
+ * @param _mask 要消除的队伍,传入-1消除所有队伍
+ * @param[out] out_pos 被消除子弹的位置(按密集索引顺序),原有内容会被覆盖
+ * @return 被消除的子弹数量
+ */
+size_t MADBulletPool::CancelCircle(const MADVector2DF& _center, float _radius, long long _mask, std::vector<MADVector2DF>& out_pos)
+{
+	UpdateMotion();
+	BatchIndex.resize(AliveTime.size());
+	size_t l_num = MADBulletKernel::OverlapCircle(OriginPos_X.data(), OriginPos_Y.data(), TeamMask.data(), AliveTime.size(),
+		_center.x, _center.y, _radius * _radius, _mask, BatchIndex.data());
+	return CancelBatch(l_num, out_pos);
+}
+
+/**
+ * 消除位于矩形 [_min, _max] 之内(含边界)且TeamMask与 _mask 相交的子弹,例如符卡切换时清屏。
+ *
+ * @param _min 矩形的最小角
+ * @param _max 矩形的最大角
+ * @param _mask 要消除的队伍,传入-1消除所有队伍
+ * @param[out] out_pos 被消除子弹的位置(按密集索引顺序),原有内容会被覆盖
+ * @return 被消除的子弹数量
+ */
+size_t MADBulletPool::CancelRect(const MADVector2DF& _min, const MADVector2DF& _max, long long _mask, std::vector<MADVector2DF>& out_pos)
+{
+	UpdateMotion();
+	BatchIndex.resize(AliveTime.size());
+	size_t l_num = MADBulletKernel::OverlapRect(OriginPos_X.data(), OriginPos_Y.data(), TeamMask.data(), AliveTime.size(),
+		_min.x, _min.y, _max.x, _max.y, _mask, BatchIndex.data());
+	return CancelBatch(l_num, out_pos);
+}
+
+/**
+ * 消除TeamMask与 _mask 相交的全部子弹,不限位置。
+ *
+ * @param _mask 要消除的队伍,传入-1消除所有子弹
+ * @param[out] out_pos 被消除子弹的位置(按密集索引顺序),原有内容会被覆盖
+ * @return 被消除的子弹数量
+ */
+size_t MADBulletPool::CancelTeam(long long _mask, std::vector<MADVector2DF>& out_pos)
+{
+	UpdateMotion();
+	BatchIndex.resize(AliveTime.size());
+	unsigned int* l_index = BatchIndex.data();
+	const long long* l_team_mask = TeamMask.data();
+	size_t l_num = 0;
+	for (size_t i = 0; i < AliveTime.size(); ++i)
+	{
+		if ((l_team_mask[i] & _mask) != 0)
+		{
+			l_index[l_num++] = static_cast<unsigned int>(i);
+		}
+	}
+	return CancelBatch(l_num, out_pos);
+}
+
+/**
+ * 消除一个子弹组的全部成员,组本身保留,之后仍可继续向组内生成子弹。子组的成员不受影响。
+ * 组成员在密集数组中是连续的区间,因此不需要逐颗查找。
+ *
+ * @param _group 子弹组id
+ * @param[out] out_pos 被消除子弹的世界坐标(按密集索引顺序),原有内容会被覆盖
+ * @return 被消除的子弹数量;组无效时返回0
+ */
+size_t MADBulletPool::CancelGroup(unsigned int _group, std::vector<MADVector2DF>& out_pos)
+{
+	size_t l_begin = 0;
+	size_t l_count = 0;
+	if (!GetGroupRange(_group, &l_begin, &l_count))
+	{
+		MAD_LOG_ERR("Try to cancel the bullets of an invalid group!");
+		out_pos.clear();
+		return 0;
+	}
+	UpdateMotion();
+	BatchIndex.resize(l_count);
+	for (size_t k = 0; k < l_count; ++k)
+	{
+		BatchIndex[k] = static_cast<unsigned int>(l_begin + k);
+	}
+	return CancelBatch(l_count, out_pos);
+}
+
+/**
+ * (内部函数)
+ * 输出BatchIndex前 _num 个(升序)子弹的位置,再一次性销毁它们。调用前世界坐标必须是最新的。
+ */
+size_t MADBulletPool::CancelBatch(size_t _num, std::vector<MADVector2DF>& out_pos)
+{
+	out_pos.resize(_num);
+	const unsigned int* l_index = BatchIndex.data();
+	const float* l_px = OriginPos_X.data();
+	const float* l_py = OriginPos_Y.data();
+	MADVector2DF* l_out = out_pos.data();
+	for (size_t k = 0; k < _num; ++k)
+	{
+		l_out[k].x = l_px[l_index[k]];
+		l_out[k].y = l_py[l_index[k]];
+	}
+	KillBatch(l_index, _num);
+	return _num;
+}
+
+/**
+ * (内部函数)
+ * 交换两颗子弹的全部数据与句柄映射,不处理运动模型数组。
+ */
+void MADBulletPool::SwapBullets(size_t _a, size_t _b)
+{
+	std::swap(AliveTime[_a], AliveTime[_b]);
+	std::swap(OriginPos_X[_a], OriginPos_X[_b]);
+	std::swap(OriginPos_Y[_a], OriginPos_Y[_b]);
+	std::swap(OriginDir_X[_a], OriginDir_X[_b]);
+	std::swap(OriginDir_Y[_a], OriginDir_Y[_b]);
+	std::swap(TeamMask[_a], TeamMask[_b]);
+	std::swap(Boundary[_a], Boundary[_b]);
+	std::swap(BounceLeft[_a], BounceLeft[_b]);
+	std::swap(Appearance[_a], Appearance[_b]);
+	std::swap(Flags[_a], Flags[_b]);
+	std::swap(LocalPos_X[_a], LocalPos_X[_b]);
+	std::swap(LocalPos_Y[_a], LocalPos_Y[_b]);
+	std::swap(LocalDir_X[_a], LocalDir_X[_b]);
+	std::swap(LocalDir_Y[_a], LocalDir_Y[_b]);
+	std::swap(DenseToSlot[_a], DenseToSlot[_b]);
+	SlotToDense[DenseToSlot[_a]] = static_cast<unsigned int>(_a);
+	SlotToDense[DenseToSlot[_b]] = static_cast<unsigned int>(_b);
+}
+
+/**
+ * (内部函数)
+ * 把刚追加到末尾的子弹移动到组 _first_group 区间的起点(即其前一个组区间的末尾)。
+ * 从最后一个组开始,每个非空的组把首个成员换到自己的末尾,空位因此逐组向前移动。
+ *
+ * @return 子弹移动后的密集索引
+ */
+size_t MADBulletPool::InsertBeforeGroups(size_t _first_group)
+{
+	size_t l_position = AliveTime.size() - 1;
+	for (size_t g = Groups.size(); g > _first_group; --g)
+	{
+		BulletGroup& l_group = Groups[g - 1];
+		if (l_group.Count > 0)
+		{
+			SwapBullets(l_group.Begin, l_position);
+			l_position = l_group.Begin;
+		}
+		l_group.Begin++;
+	}
+	return l_position;
+}
+
+/**
+ * (内部函数)
+ * 把位于组 _first_group 区间之前的空位移动到密集数组末尾。
+ * 每个非空的组把最后一个成员换到空位上,组区间因此整体前移一位。
+ */
+void MADBulletPool::MoveHoleToEnd(size_t _hole, size_t _first_group)
+{
+	for (size_t g = _first_group; g < Groups.size(); ++g)
+	{
+		BulletGroup& l_group = Groups[g];
+		l_group.Begin--;
+		if (l_group.Count > 0)
+		{
+			size_t l_last = l_group.Begin + l_group.Count;
+			SwapBullets(_hole, l_last);
+			_hole = l_last;
+		}
+	}
+}
+
+/**
+ * (内部函数)
+ * 按id顺序合成各子弹组的世界变换,并对变换或成员有变化的组执行一次变换内核。
+ * 冻结且父组未变化的组在这里只做一次判断。
+ */
+void MADBulletPool::UpdateGroups(MADJobSystem* _jobs) const
+{
+	for (size_t g = 0; g < Groups.size(); ++g)
+	{
+		BulletGroup& l_group = Groups[g];
+		l_group.WorldChanged = false;
+		if (!l_group.Alive)
+		{
+			continue;
+		}
+		const BulletGroup* l_parent = l_group.Parent != MAD_BULLET_INVALID_INDEX ? &Groups[l_group.Parent] : nullptr;
+
+		if (l_group.TransformDirty || (l_parent != nullptr && l_parent->WorldChanged))
+		{
+			const MADBulletGroupInfo& l_info = l_group.Info;
+			MADBulletTransform& l_world = l_group.World;
+			if (l_parent == nullptr)
+			{
+				l_group.WorldRotation = l_info.Rotation;
+				l_world.Offset_X = l_info.Offset.x;
+				l_world.Offset_Y = l_info.Offset.y;
+				l_world.Velocity_X = l_info.Velocity.x;
+				l_world.Velocity_Y = l_info.Velocity.y;
+				l_world.Angular = l_info.AngularVelocity;
+			}
+			else
+			{
+				/*The group origin is a point of the parent frame,moving with it*/
+				const MADBulletTransform& l_up = l_parent->World;
+				float l_rx = l_up.Cos * l_info.Offset.x - l_up.Sin * l_info.Offset.y;
+				float l_ry = l_up.Sin * l_info.Offset.x + l_up.Cos * l_info.Offset.y;
+				float l_vx = l_up.Cos * l_info.Velocity.x - l_up.Sin * l_info.Velocity.y;
+				float l_vy = l_up.Sin * l_info.Velocity.x + l_up.Cos * l_info.Velocity.y;
+				l_group.WorldRotation = l_parent->WorldRotation + l_info.Rotation;
+				l_world.Offset_X = l_up.Offset_X + l_rx;
+				l_world.Offset_Y = l_up.Offset_Y + l_ry;
+				l_world.Velocity_X = (l_up.Velocity_X + l_vx) - l_up.Angular * l_ry;
+				l_world.Velocity_Y = (l_up.Velocity_Y + l_vy) + l_up.Angular * l_rx;
+				l_world.Angular = l_up.Angular + l_info.AngularVelocity;
+			}
+			MADStrictMath::SinCos(l_group.WorldRotation, &l_world.Sin, &l_world.Cos);
+			l_group.TransformDirty = false;
+			l_group.WorldChanged = true;
+		}
+
+		if ((l_group.WorldChanged || l_group.MembersDirty) && l_group.Count > 0)
+		{
+			size_t l_begin = l_group.Begin;
+			const float* l_lx = LocalPos_X.data() + l_begin;
+			const float* l_ly = LocalPos_Y.data() + l_begin;
+			const float* l_ldx = LocalDir_X.data() + l_begin;
+			const float* l_ldy = LocalDir_Y.data() + l_begin;
+			float* l_px = OriginPos_X.data() + l_begin;
+			float* l_py = OriginPos_Y.data() + l_begin;
+			float* l_dx = OriginDir_X.data() + l_begin;
+			float* l_dy = OriginDir_Y.data() + l_begin;
+			const MADBulletTransform l_world = l_group.World;
+			MADJobSystem::Dispatch(_jobs, l_group.Count, MAD_BULLET_JOB_GRAIN, [=](size_t _b, size_t _e, size_t) {
+				MADBulletKernel::Transform(l_lx + _b, l_ly + _b, l_ldx + _b, l_ldy + _b, _e - _b, l_world,
+					l_px + _b, l_py + _b, l_dx + _b, l_dy + _b);
+			});
+		}
+		l_group.MembersDirty = false;
+	}
+}
+
+/**
+ * 让远处子弹立即补上被跳过的时间。
+ * 参数化子弹只增加存活时间;普通子弹匀速运动,按累计时间积分一次与逐tick积分的结果相同。
+ *
+ * SetInfo与非const的原始数组访问会自动调用;读取远处子弹的数据(GetInfo/GetInfoAt)并写回之前应先调用,
+ * 否则写回的是上一次推进时的旧数据,跳过的时间会丢失。
+ */
+void MADBulletPool::SyncLod()
+{
+	float l_dt = LodDebt;
+	LodDebt = 0.0f;
+	if (l_dt == 0.0f)
+	{
+		return;
+	}
+	if (LodParametricNum > 0)
+	{
+		float* l_alive = AliveTime.data();
+		for (size_t i = ParametricNum - LodParametricNum; i < ParametricNum; ++i)
+		{
+			l_alive[i] = l_alive[i] + l_dt;
+		}
+		MotionDirty = true;
+	}
+	if (LodPlainNum > 0)
+	{
+		size_t l_begin = GroupBegin - LodPlainNum;
+		MADBulletKernel::Integrate(OriginPos_X.data() + l_begin, OriginPos_Y.data() + l_begin,
+			OriginDir_X.data() + l_begin, OriginDir_Y.data() + l_begin, AliveTime.data() + l_begin,
+			LodPlainNum, l_dt, nullptr);
+	}
+}
+
+/**
+ * (内部函数)
+ * 按关注区域重新划分参数化子弹与普通子弹的远近,调用前远处子弹必须已经补齐时间。
+ */
+void MADBulletPool::ClassifyLod()
+{
+	UpdateMotion();
+	if (GroupBegin == 0)
+	{
+		return;
+	}
+	BatchIndex.resize(GroupBegin);
+	LodParametricNum = ParametricNum - PartitionLod(0, ParametricNum - LodParametricNum, ParametricNum, true);
+	LodPlainNum = GroupBegin - PartitionLod(ParametricNum, GroupBegin - LodPlainNum, GroupBegin, false);
+}
+
+/**
+ * (内部函数)
+ * 把 [_far_begin, _end) 中回到关注区域的子弹换到近处区间的末尾,再把 [_begin, 近处末尾) 中离开关注区域的子弹换到远处区间的开头。
+ *
+ * @return 划分后远处区间的起点
+ */
+size_t MADBulletPool::PartitionLod(size_t _begin, size_t _far_begin, size_t _end, bool _swap_motion)
+{
+	const float* l_px = OriginPos_X.data();
+	const float* l_py = OriginPos_Y.data();
+	unsigned int* l_index = BatchIndex.data();
+
+	/*Promote,the far range is partitioned into [inside][outside]*/
+	size_t l_outside = MADBulletKernel::FindOutside(l_px + _far_begin, l_py + _far_begin, _end - _far_begin,
+		LodInfo.Min.x, LodInfo.Min.y, LodInfo.Max.x, LodInfo.Max.y, l_index);
+	size_t l_near_end = _far_begin;
+	for (size_t i = _far_begin, k = 0; i < _end; ++i)
+	{
+		if (k < l_outside && _far_begin + l_index[k] == i)
+		{
+			++k;
+			continue;
+		}
+		if (i != l_near_end)
+		{
+			SwapBullets(i, l_near_end);
+			if (_swap_motion)
+			{
+				std::swap(Motion[i], Motion[l_near_end]);
+			}
+		}
+		l_near_end++;
+	}
+
+	/*Demote from the back,so the bullet swapped in from the near end has been checked already*/
+	l_outside = MADBulletKernel::FindOutside(l_px + _begin, l_py + _begin, l_near_end - _begin,
+		LodInfo.Min.x, LodInfo.Min.y, LodInfo.Max.x, LodInfo.Max.y, l_index);
+	for (size_t k = l_outside; k > 0; --k)
+	{
+		size_t l_dense = _begin + l_index[k - 1];
+		l_near_end--;
+		if (l_dense != l_near_end)
+		{
+			SwapBullets(l_dense, l_near_end);
+			if (_swap_motion)
+			{
+				std::swap(Motion[l_dense], Motion[l_near_end]);
+			}
+		}
+	}
+	return l_near_end;
+}
@@ -0,0 +1,326 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "../MADProtocol/mad_protocol.h"
+#include "mad_bullet_kernel.h"
+
+/*Invalid index for bullet slots and dense indices*/
+#define MAD_BULLET_INVALID_INDEX 0xFFFFFFFFu
+
+/*Bullets per job when a bullet pass is split across threads*/
+#define MAD_BULLET_JOB_GRAIN 8192
+
+/*KillBatch gathers survivors instead of moving runs once the average survivor run is shorter than this*/
+#define MAD_BULLET_COMPACT_RUN 32
+
+/*Tag written at the start of a pool snapshot*/
+#define MAD_BULLET_POOL_SNAPSHOT_TAG 0x4C4F4F50u
+
+/*Bullet arrays in a pool snapshot reserve space in multiples of this many bullets*/
+#define MAD_BULLET_SNAPSHOT_GRAIN 4096
+
+/*Per-bullet flag bits*/
+#define MAD_BULLET_FLAG_GRAZED 0x01
+
+/**
+ * \brief MADBulletHandle 是子弹池中子弹的弱引用句柄。
+ *
+ * 句柄由槽位索引 `Index` 与代数 `Generation` 组成,子弹被销毁后其槽位代数会递增,
+ * 因此旧句柄会自动失效,不会误指向复用该槽位的新子弹。
+ */
+struct MADBulletHandle {
+	unsigned int Index;
+	unsigned int Generation;
+
+	MADBulletHandle() {
+		Index = MAD_BULLET_INVALID_INDEX;
+		Generation = 0;
+	}
+	MADBulletHandle(unsigned int _index, unsigned int _generation) {
+		Index = _index;
+		Generation = _generation;
+	}
+
+	bool operator==(const MADBulletHandle& _other) const {
+		return Index == _other.Index && Generation == _other.Generation;
+	}
+	bool operator!=(const MADBulletHandle& _other) const {
+		return !(*this == _other);
+	}
+};
+
+/**
+ * \brief MADBulletBoundary 枚举定义了子弹离开边界时的处理方式。
+ *
+ * - Kill: 销毁子弹(默认)
+ * - Wrap: 从对侧边界重新进入
+ * - Reflect: 在边界处反弹,每次反弹消耗一次反弹次数,次数用尽后再越界则被销毁
+ * - Ignore: 不受边界影响
+ */
+enum class MADBulletBoundary : unsigned char { Kill = 0, Wrap, Reflect, Ignore };
+
+/**
+ * \brief MADBulletGroupInfo 描述子弹组相对于父组(无父组时为世界)的变换与时间缩放。
+ *
+ * - Offset: 组原点的位置
+ * - Rotation: 组的旋转角(弧度)
+ * - Velocity: 组原点的移动速度(单位/秒)
+ * - AngularVelocity: 组的旋转角速度(弧度/秒)
+ * - TimeScale: 时间缩放,作用于组自身的运动、成员的运动与存活时间,并会乘到所有子组上;为0时整组冻结
+ */
+struct MADBulletGroupInfo {
+	MADVector2DF Offset;
+	float Rotation;
+	MADVector2DF Velocity;
+	float AngularVelocity;
+	float TimeScale;
+
+	MADBulletGroupInfo() {
+		Offset = MADVector2DF();
+		Rotation = 0.0f;
+		Velocity = MADVector2DF();
+		AngularVelocity = 0.0f;
+		TimeScale = 1.0f;
+	}
+	MADBulletGroupInfo(MADVector2DF _offset, float _rotation = 0.0f,
+		MADVector2DF _velocity = MADVector2DF(), float _angular_velocity = 0.0f, float _time_scale = 1.0f) {
+		Offset = _offset;
+		Rotation = _rotation;
+		Velocity = _velocity;
+		AngularVelocity = _angular_velocity;
+		TimeScale = _time_scale;
+	}
+};
+
+/**
+ * \brief MADBulletLodInfo 描述子弹池的细节层级(LOD)策略。
+ *
+ * - Min, Max: 关注区域的两个角,区域外的子弹降为远处子弹
+ * - Interval: 远处子弹每隔多少个tick推进一次;不大于1时关闭LOD(默认)
+ */
+struct MADBulletLodInfo {
+	MADVector2DF Min;
+	MADVector2DF Max;
+	unsigned int Interval;
+
+	MADBulletLodInfo() {
+		Min = MADVector2DF();
+		Max = MADVector2DF();
+		Interval = 1;
+	}
+	MADBulletLodInfo(MADVector2DF _min, MADVector2DF _max, unsigned int _interval) {
+		Min = _min;
+		Max = _max;
+		Interval = _interval;
+	}
+};
+
+/**
+ * MADBulletPool 是以结构数组(SoA)方式储存子弹的连续容器,用于取代 MADRing<BulletInfo>。
+ *
+ * BulletInfo 的各个字段被拆分到独立的连续数组中,存活的子弹始终紧密排列在 [0, GetNum()) 区间内:
+ * - 生成(Spawn)与销毁(Kill)均为 O(1),销毁时将末尾子弹交换到空位(swap-remove);
+ * - 外部通过带代数校验的 MADBulletHandle 引用子弹,密集索引会因交换而变化,请勿长期保存;
+ * - 扩容只按倍数增长数组容量,不会为单个子弹单独分配内存。
+ *
+ * 约定:OriginPos 表示子弹当前位置,OriginDir 表示子弹当前速度(单位/秒)。
+ *
+ * 参数化子弹(MADBulletMotion)的位置由存活时间直接算出,而不是逐帧积分:
+ * - 参数化子弹紧密排列在 [0, GetParametricNum()) 区间,其余为逐帧积分的子弹;
+ * - Step时参数化子弹只增加存活时间,位置与速度在首次被读取时(GetPositionXData、Flush等)才统一计算;
+ * - 计算结果只取决于存活时间,不会累积误差。
+ *
+ * 子弹组(CreateGroup)让一批子弹作为整体运动,例如旋转的环、跟随使魔移动的子弹、整体冻结的符卡:
+ * - 组成员以组的局部坐标储存,并紧密排列在密集数组末尾的连续区间内,各组按id顺序依次排列;
+ * - 每个tick只积分局部坐标,再用组的世界变换对整段成员做一次SIMD变换得到世界坐标;
+ * - 组可以有父组,变换与时间缩放沿层级合成;时间缩放为0的组既不积分也不重新变换,冻结为 O(1)。
+ *
+ * 细节层级(SetLod)让远离玩家的子弹降低更新频率,大量子弹飞出关注区域时每个tick的代价只与区域内的子弹数量成正比:
+ * - 参数化子弹与普通子弹各自把远处子弹排在本区间的末尾,平时的Step只推进近处子弹;
+ * - 每隔Interval个tick,远处子弹一次补上跳过的时间:参数化子弹直接增加存活时间,是精确的闭式解;普通子弹匀速运动,按累计的时间积分同样精确;
+ * - 补齐之后重新按关注区域划分远近,回到区域内的子弹恢复为每tick更新;
+ * - 子弹组成员始终每tick更新;
+ * - SetInfo与非const的原始数组访问会先让远处子弹补齐时间(SyncLod),外部写入不会与之后的补齐叠加。
+ *
+ * 密集数组的排列为:[近处参数化][远处参数化][近处普通][远处普通][组0成员][组1成员]...
+ *
+ * 注意:该类是线程不安全的!
+ */
+class MADBulletPool
+{
+public:
+	MADBulletPool();
+	~MADBulletPool();
+
+public:
+	/*Bullet operator*/
+	MADBulletHandle Spawn(const BulletInfo& _info);
+	MADBulletHandle Spawn(const BulletInfo& _info, const MADBulletMotion& _motion);
+	bool Kill(MADBulletHandle _handle);
+	void KillAt(size_t _index);
+	void KillBatch(const unsigned int* _indices, size_t _num);
+	void Clear();
+	void Reserve(size_t _capacity);
+
+	/*Group operator*/
+	unsigned int CreateGroup(const MADBulletGroupInfo& _info, unsigned int _parent = MAD_BULLET_INVALID_INDEX);
+	bool DestroyGroup(unsigned int _group);
+	MADBulletHandle SpawnInGroup(unsigned int _group, const BulletInfo& _local_info);
+	bool SetGroupInfo(unsigned int _group, const MADBulletGroupInfo& _info);
+	bool SetGroupTimeScale(unsigned int _group, float _time_scale);
+	bool GetGroupInfo(unsigned int _group, MADBulletGroupInfo* out_info) const;
+	bool IsGroupAlive(unsigned int _group) const;
+	size_t GetGroupNum() const;
+	unsigned int GetGroupParent(unsigned int _group) const;
+	unsigned int GetGroup(size_t _index) const;
+	bool GetGroupRange(unsigned int _group, size_t* out_begin, size_t* out_num) const;
+
+	/*Level of detail*/
+	void SetLod(const MADBulletLodInfo& _info);
+	const MADBulletLodInfo& GetLod() const;
+	size_t GetLodNum() const;
+	void GetLodState(size_t* out_parametric_num, size_t* out_plain_num, unsigned int* out_counter, float* out_debt) const;
+	void SyncLod();
+
+	/*Cancel,cancelled positions are written in dense index order*/
+	size_t CancelCircle(const MADVector2DF& _center, float _radius, long long _mask, std::vector<MADVector2DF>& out_pos);
+	size_t CancelRect(const MADVector2DF& _min, const MADVector2DF& _max, long long _mask, std::vector<MADVector2DF>& out_pos);
+	size_t CancelTeam(long long _mask, std::vector<MADVector2DF>& out_pos);
+	size_t CancelGroup(unsigned int _group, std::vector<MADVector2DF>& out_pos);
+
+	/*Get Data*/
+	size_t GetNum() const;
+	size_t GetCapacity() const;
+	size_t GetParametricNum() const;
+	MADBulletMotionType GetMotionType(size_t _index) const;
+	bool Is_Empty() const;
+	bool IsAlive(MADBulletHandle _handle) const;
+	size_t GetIndex(MADBulletHandle _handle) const;
+	MADBulletHandle GetHandle(size_t _index) const;
+	bool GetInfo(MADBulletHandle _handle, BulletInfo* out_info) const;
+	BulletInfo GetInfoAt(size_t _index) const;
+	bool SetInfo(MADBulletHandle _handle, const BulletInfo& _info);
+	bool SetBoundary(MADBulletHandle _handle, MADBulletBoundary _boundary, unsigned int _bounce_num = 0);
+	MADBulletBoundary GetBoundary(size_t _index) const;
+	unsigned int GetBounceLeft(size_t _index) const;
+	bool SetAppearance(MADBulletHandle _handle, unsigned short _sprite, unsigned short _color);
+	unsigned short GetSprite(size_t _index) const;
+	unsigned short GetColor(size_t _index) const;
+	bool SetGrazed(MADBulletHandle _handle, bool _grazed);
+	void MarkGrazed(size_t _index, bool _grazed = true);
+	bool IsGrazed(size_t _index) const;
+
+	/*Raw arrays,valid until the next Spawn/Kill/Clear*/
+	float* GetAliveTimeData();
+	float* GetPositionXData();
+	float* GetPositionYData();
+	float* GetDirXData();
+	float* GetDirYData();
+	long long* GetTeamMaskData();
+	const float* GetAliveTimeData() const;
+	const float* GetPositionXData() const;
+	const float* GetPositionYData() const;
+	const float* GetDirXData() const;
+	const float* GetDirYData() const;
+	const long long* GetTeamMaskData() const;
+	const MADBulletBoundary* GetBoundaryData() const;
+	const unsigned short* GetBounceLeftData() const;
+	const unsigned int* GetAppearanceData() const;
+	const unsigned char* GetFlagsData() const;
+	const MADBulletMotionState* GetMotionData() const;
+
+	/*Simulate*/
+	void UpdateMotion(MADJobSystem* _jobs = nullptr) const;
+	size_t ApplyBoundary(const MADVector2DF& _min, const MADVector2DF& _max);
+	void Step(float _dt, MADBulletFlushResData* out_res = nullptr, MADJobSystem* _jobs = nullptr);
+	void Step(float _dt, std::vector<MADBulletFlushResData>& out_res, MADJobSystem* _jobs = nullptr);
+
+	/*Flush*/
+	void Flush(std::vector<MADBulletFlushResData>& out_res) const;
+	size_t Flush(MADBulletFlushResData* out_res, size_t _capacity) const;
+	size_t FlushTo(void* out_buffer, size_t _capacity, const MADFlushLayout& _layout, MADJobSystem* _jobs = nullptr) const;
+
+	/*Snapshot*/
+	size_t Snapshot(std::vector<unsigned char>& out_data) const;
+	bool Restore(MADBlobReader& io_reader);
+
+private:
+	/*Bullet Data (SoA)*/
+	std::vector<float> AliveTime;
+	mutable std::vector<float> OriginPos_X;
+	mutable std::vector<float> OriginPos_Y;
+	mutable std::vector<float> OriginDir_X;
+	mutable std::vector<float> OriginDir_Y;
+	std::vector<long long> TeamMask;
+	std::vector<MADBulletBoundary> Boundary;
+	std::vector<unsigned short> BounceLeft;
+	std::vector<unsigned int> Appearance;
+	std::vector<unsigned char> Flags;
+
+	/*Parametric motion, indexed by dense index in [0, ParametricNum)*/
+	std::vector<MADBulletMotionState> Motion;
+	size_t ParametricNum;
+	mutable bool MotionDirty;
+
+	/*Handle Data*/
+	std::vector<unsigned int> DenseToSlot;
+	std::vector<unsigned int> SlotToDense;
+	std::vector<unsigned int> SlotGeneration;
+	std::vector<unsigned int> FreeSlots;
+
+	/*Bullet groups,members occupy [GroupBegin, GetNum()) in group id order*/
+	typedef struct BulletGroup
+	{
+		MADBulletGroupInfo Info = MADBulletGroupInfo();
+		unsigned int Parent = MAD_BULLET_INVALID_INDEX;
+		size_t Begin = 0;
+		size_t Count = 0;
+		bool Alive = true;
+
+		/*World transform cache,rebuilt by UpdateMotion*/
+		MADBulletTransform World = MADBulletTransform();
+		float WorldRotation = 0.0f;
+		float WorldTimeScale = 1.0f;
+		bool TransformDirty = true;
+		bool MembersDirty = false;
+		bool WorldChanged = false;
+	}BulletGroup;
+
+	/*Local position and velocity of group members,unused outside the group range*/
+	std::vector<float> LocalPos_X;
+	std::vector<float> LocalPos_Y;
+	std::vector<float> LocalDir_X;
+	std::vector<float> LocalDir_Y;
+	mutable std::vector<BulletGroup> Groups;
+	size_t GroupBegin;
+	mutable bool GroupDirty;
+
+	/*Level of detail,far bullets occupy the last LodParametricNum parametric and the last LodPlainNum plain slots*/
+	MADBulletLodInfo LodInfo;
+	size_t LodParametricNum;
+	size_t LodPlainNum;
+	unsigned int LodCounter;
+	float LodDebt;
+	mutable bool NearMotionDirty;
+
+	/*Scratch indices for batch passes*/
+	std::vector<unsigned int> BatchIndex;
+	std::vector<unsigned int> CompactSource;
+
+	/*Common function*/
+	MADBulletHandle PushBullet(const BulletInfo& _info);
+	size_t CancelBatch(size_t _num, std::vector<MADVector2DF>& out_pos);
+	void SwapBullets(size_t _a, size_t _b);
+	size_t InsertBeforeGroups(size_t _first_group);
+	void MoveHoleToEnd(size_t _hole, size_t _first_group);
+	void UpdateGroups(MADJobSystem* _jobs) const;
+	void ClassifyLod();
+	size_t PartitionLod(size_t _begin, size_t _far_begin, size_t _end, bool _swap_motion);
+};
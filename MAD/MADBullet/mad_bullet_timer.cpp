@@ -0,0 +1,333 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_bullet_timer.h"
+#include "../MADBase/mad_fp_strict.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/*Ticks covered by all wheel levels together*/
+#define MAD_TIMER_SPAN_BITS (MAD_TIMER_SLOT_BITS * MAD_TIMER_LEVEL_NUM)
+
+/**
+ * 构造一个空的时间轮。
+ *
+ * @param _tick 当前tick,第一次Advance处理的是 _tick + 1
+ */
+MADBulletTimer::MADBulletTimer(unsigned long long _tick)
+{
+	Tick = _tick;
+	EntryNum = 0;
+}
+
+/**
+ * MADBulletTimer析构函数。
+ */
+MADBulletTimer::~MADBulletTimer()
+{
+}
+
+/**
+ * 登记一个在 _delay 个tick之后到期的事件。
+ * _delay 为0时视为1,即在下一次Advance中处理。
+ *
+ * @param _delay 距离当前tick的延迟
+ * @param _event 事件
+ */
+void MADBulletTimer::Schedule(unsigned long long _delay, const MADBulletEvent& _event)
+{
+	ScheduleAt(Tick + std::max<unsigned long long>(_delay, 1), _event);
+}
+
+/**
+ * 登记一个在指定tick到期的事件。
+ * 不晚于当前tick的事件会在下一次Advance中处理。
+ *
+ * @param _tick 到期tick
+ * @param _event 事件
+ */
+void MADBulletTimer::ScheduleAt(unsigned long long _tick, const MADBulletEvent& _event)
+{
+	/*Copied field by field over zeroed padding,so snapshots of equal timers are byte-identical*/
+	TimerEntry l_entry;
+	std::memset(static_cast<void*>(&l_entry), 0, sizeof(l_entry));
+	l_entry.Due = std::max(_tick, Tick + 1);
+	l_entry.Event.Bullet = _event.Bullet;
+	l_entry.Event.Type = _event.Type;
+	l_entry.Event.Param[0] = _event.Param[0];
+	l_entry.Event.Param[1] = _event.Param[1];
+	l_entry.Event.UserData = _event.UserData;
+	/*Placed relative to the current tick,the same base CascadeSlot uses,so an event never lands in a
+	  lower level ahead of an earlier one still waiting to cascade into the same slot*/
+	Insert(l_entry, Tick);
+	EntryNum++;
+}
+
+/**
+ * 登记子弹在 _delay 个tick之后销毁。
+ *
+ * @param _bullet 子弹句柄
+ * @param _delay 距离当前tick的延迟
+ */
+void MADBulletTimer::ScheduleExpire(MADBulletHandle _bullet, unsigned long long _delay)
+{
+	Schedule(_delay, MADBulletEvent(_bullet, MADBulletEventType::Expire));
+}
+
+/**
+ * 清空所有未到期的事件,当前tick保持不变。
+ */
+void MADBulletTimer::Clear()
+{
+	for (size_t l = 0; l < MAD_TIMER_LEVEL_NUM; ++l)
+	{
+		for (size_t s = 0; s < MAD_TIMER_SLOT_NUM; ++s)
+		{
+			Wheels[l][s].clear();
+		}
+	}
+	Overflow.clear();
+	EntryNum = 0;
+}
+
+/**
+ * 前进一个tick,并处理在该tick到期的事件。
+ *
+ * 同一tick到期的事件先按顺序应用修改(SetDir、ScaleSpeed、Rotate),再一次性销毁所有Expire的子弹,
+ * 因此同一tick内的修改事件不会因销毁导致的索引变化而失效。
+ * 修改事件通过SetInfo写回速度,参数化子弹的运动模型从当前状态接续,不会跳变。
+ * 引用已销毁子弹的事件会被丢弃;User事件不检查句柄,总是交给调用者。
+ *
+ * @param _pool 事件作用的子弹池
+ * @param out_user 接收到期User事件的数组,可为nullptr;结果会追加在末尾
+ * @return 本tick处理的事件数量(不含被丢弃的事件)
+ */
+size_t MADBulletTimer::Advance(MADBulletPool& _pool, std::vector<MADBulletEvent>* out_user)
+{
+	Tick++;
+
+	/*Cascade higher levels whose slot boundary is reached,from the top down*/
+	if ((Tick & ((1ull << MAD_TIMER_SPAN_BITS) - 1)) == 0 && !Overflow.empty())
+	{
+		CascadeSlot(Overflow);
+	}
+	for (size_t l = MAD_TIMER_LEVEL_NUM - 1; l > 0; --l)
+	{
+		unsigned int l_shift = static_cast<unsigned int>(l * MAD_TIMER_SLOT_BITS);
+		if ((Tick & ((1ull << l_shift) - 1)) == 0)
+		{
+			std::vector<TimerEntry>& l_slot = Wheels[l][(Tick >> l_shift) & (MAD_TIMER_SLOT_NUM - 1)];
+			if (!l_slot.empty())
+			{
+				CascadeSlot(l_slot);
+			}
+		}
+	}
+
+	std::vector<TimerEntry>& l_slot = Wheels[0][Tick & (MAD_TIMER_SLOT_NUM - 1)];
+	if (l_slot.empty())
+	{
+		return 0;
+	}
+	Due.swap(l_slot);
+	l_slot.clear();
+	EntryNum -= Due.size();
+
+	/*Far LOD bullets catch up once,before any state is read and written back*/
+	_pool.SyncLod();
+
+	/*Apply*/
+	size_t l_applied = 0;
+	KillIndex.clear();
+	for (size_t k = 0; k < Due.size(); ++k)
+	{
+		const MADBulletEvent& l_event = Due[k].Event;
+		if (l_event.Type == MADBulletEventType::User)
+		{
+			if (out_user != nullptr)
+			{
+				out_user->push_back(l_event);
+			}
+			l_applied++;
+			continue;
+		}
+		if (!_pool.IsAlive(l_event.Bullet))
+		{
+			continue;
+		}
+		l_applied++;
+		if (l_event.Type == MADBulletEventType::Expire)
+		{
+			KillIndex.push_back(static_cast<unsigned int>(_pool.GetIndex(l_event.Bullet)));
+			continue;
+		}
+
+		BulletInfo l_info;
+		_pool.GetInfo(l_event.Bullet, &l_info);
+		switch (l_event.Type)
+		{
+		case MADBulletEventType::SetDir:
+			l_info.OriginDir = MADVector2DF(l_event.Param[0], l_event.Param[1]);
+			break;
+		case MADBulletEventType::ScaleSpeed:
+			l_info.OriginDir.x *= l_event.Param[0];
+			l_info.OriginDir.y *= l_event.Param[0];
+			break;
+		case MADBulletEventType::Rotate:
+		{
+			float l_sin, l_cos;
+			MADStrictMath::SinCos(l_event.Param[0], &l_sin, &l_cos);
+			float l_dx = l_info.OriginDir.x;
+			float l_dy = l_info.OriginDir.y;
+			l_info.OriginDir.x = l_dx * l_cos - l_dy * l_sin;
+			l_info.OriginDir.y = l_dx * l_sin + l_dy * l_cos;
+			break;
+		}
+		default:
+			break;
+		}
+		_pool.SetInfo(l_event.Bullet, l_info);
+	}
+	Due.clear();
+
+	/*Kill*/
+	if (!KillIndex.empty())
+	{
+		std::sort(KillIndex.begin(), KillIndex.end());
+		KillIndex.erase(std::unique(KillIndex.begin(), KillIndex.end()), KillIndex.end());
+		_pool.KillBatch(KillIndex.data(), KillIndex.size());
+	}
+	return l_applied;
+}
+
+/**
+ * 获取当前tick,即最近一次Advance处理的tick。
+ *
+ * @return 当前tick
+ */
+unsigned long long MADBulletTimer::GetTick() const
+{
+	return Tick;
+}
+
+/**
+ * 获取尚未到期的事件数量,包括引用已销毁子弹、到期时会被丢弃的事件。
+ *
+ * @return 事件数量
+ */
+size_t MADBulletTimer::GetNum() const
+{
+	return EntryNum;
+}
+
+/**
+ * 把时间轮的当前tick与所有未到期事件追加到 out_data 末尾,每个槽的事件数组整体复制。
+ *
+ * @param out_data 输出缓冲区,数据追加在已有内容之后
+ * @return 写入的字节数
+ */
+size_t MADBulletTimer::Snapshot(std::vector<unsigned char>& out_data) const
+{
+	size_t l_begin = out_data.size();
+	MADBlobWriter l_writer(out_data);
+	l_writer.Write(MAD_TIMER_SNAPSHOT_TAG);
+	l_writer.Write(static_cast<unsigned int>(MAD_TIMER_LEVEL_NUM * MAD_TIMER_SLOT_NUM));
+	l_writer.Write(Tick);
+	l_writer.Write(static_cast<unsigned long long>(EntryNum));
+	for (size_t l = 0; l < MAD_TIMER_LEVEL_NUM; ++l)
+	{
+		for (size_t s = 0; s < MAD_TIMER_SLOT_NUM; ++s)
+		{
+			l_writer.WriteArray(Wheels[l][s]);
+		}
+	}
+	l_writer.WriteArray(Overflow);
+	return out_data.size() - l_begin;
+}
+
+/**
+ * 从快照中恢复时间轮,恢复后的事件与保存时按相同的顺序到期。
+ * 快照数据损坏或不完整时时间轮被清空。
+ *
+ * @param io_reader 指向一份由Snapshot写入的数据,读取后前进到该数据之后
+ * @return 成功时返回true
+ */
+bool MADBulletTimer::Restore(MADBlobReader& io_reader)
+{
+	unsigned int l_tag = 0;
+	unsigned int l_slot_num = 0;
+	unsigned long long l_tick = 0;
+	unsigned long long l_entry_num = 0;
+	io_reader.Read(&l_tag);
+	io_reader.Read(&l_slot_num);
+	io_reader.Read(&l_tick);
+	io_reader.Read(&l_entry_num);
+	bool l_valid = l_tag == MAD_TIMER_SNAPSHOT_TAG && l_slot_num == MAD_TIMER_LEVEL_NUM * MAD_TIMER_SLOT_NUM;
+	size_t l_count = 0;
+	for (size_t l = 0; l_valid && l < MAD_TIMER_LEVEL_NUM; ++l)
+	{
+		for (size_t s = 0; s < MAD_TIMER_SLOT_NUM; ++s)
+		{
+			io_reader.ReadArray(Wheels[l][s]);
+			l_count += Wheels[l][s].size();
+		}
+	}
+	if (l_valid)
+	{
+		io_reader.ReadArray(Overflow);
+		l_count += Overflow.size();
+	}
+	if (!l_valid || io_reader.IsFailed() || l_count != l_entry_num)
+	{
+		MAD_LOG_ERR("Try to restore a bullet timer from a broken snapshot!");
+		Clear();
+		return false;
+	}
+	Tick = l_tick;
+	EntryNum = l_count;
+	return true;
+}
+
+/**
+ * (内部函数)将事件放入最低的合适层。
+ * 第l层的槽只接收与 _base 处于同一个 64^(l+1) tick区间的事件,因此槽号总是不早于 _base 所在的槽,
+ * 该槽轮转到时事件恰好下移到更低层。超出所有层范围的事件放入溢出列表。
+ * 登记与下移使用相同的基准,同一个槽中的事件因此始终保持登记顺序。
+ *
+ * @param _entry 事件,Due不得早于 _base
+ * @param _base 当前tick,即最近一次处理的tick
+ */
+void MADBulletTimer::Insert(const TimerEntry& _entry, unsigned long long _base)
+{
+	for (size_t l = 0; l < MAD_TIMER_LEVEL_NUM; ++l)
+	{
+		unsigned int l_shift = static_cast<unsigned int>(l * MAD_TIMER_SLOT_BITS);
+		if ((_entry.Due >> (l_shift + MAD_TIMER_SLOT_BITS)) == (_base >> (l_shift + MAD_TIMER_SLOT_BITS)))
+		{
+			Wheels[l][(_entry.Due >> l_shift) & (MAD_TIMER_SLOT_NUM - 1)].push_back(_entry);
+			return;
+		}
+	}
+	Overflow.push_back(_entry);
+}
+
+/**
+ * (内部函数)把一个槽中的所有事件按当前tick重新放入较低的层,保持原有的相对顺序。
+ *
+ * @param io_slot 要下移的槽,完成后为空
+ */
+void MADBulletTimer::CascadeSlot(std::vector<TimerEntry>& io_slot)
+{
+	Cascade.swap(io_slot);
+	io_slot.clear();
+	for (size_t k = 0; k < Cascade.size(); ++k)
+	{
+		Insert(Cascade[k], Tick);
+	}
+	Cascade.clear();
+}
@@ -0,0 +1,118 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "mad_bullet_pool.h"
+
+/*Slots per wheel level,as a power of two*/
+#define MAD_TIMER_SLOT_BITS 6
+#define MAD_TIMER_SLOT_NUM (1 << MAD_TIMER_SLOT_BITS)
+/*Tag written at the start of a timer snapshot*/
+#define MAD_TIMER_SNAPSHOT_TAG 0x524D4954u
+
+/*Wheel levels,events further than 2^(levels * slot bits) ticks wait in an overflow list*/
+#define MAD_TIMER_LEVEL_NUM 4
+
+/**
+ * \brief MADBulletEventType 枚举定义了定时事件对子弹的操作。
+ *
+ * - Expire: 销毁子弹
+ * - SetDir: 将速度设为 (Param[0], Param[1])
+ * - ScaleSpeed: 速度乘以 Param[0]
+ * - Rotate: 速度方向旋转 Param[0] 弧度
+ * - User: 不修改子弹,事件原样交给调用者处理,可通过UserData区分
+ */
+enum class MADBulletEventType : unsigned char { Expire = 0, SetDir, ScaleSpeed, Rotate, User };
+
+/**
+ * \brief MADBulletEvent 是登记在MADBulletTimer中的一个定时事件。
+ */
+struct MADBulletEvent {
+	MADBulletHandle Bullet;
+	MADBulletEventType Type;
+	float Param[2];
+	unsigned long long UserData;
+
+	MADBulletEvent() {
+		Bullet = MADBulletHandle();
+		Type = MADBulletEventType::Expire;
+		Param[0] = 0.0f;
+		Param[1] = 0.0f;
+		UserData = 0;
+	}
+	MADBulletEvent(MADBulletHandle _bullet, MADBulletEventType _type, float _param0 = 0.0f, float _param1 = 0.0f) {
+		Bullet = _bullet;
+		Type = _type;
+		Param[0] = _param0;
+		Param[1] = _param1;
+		UserData = 0;
+	}
+};
+
+/**
+ * MADBulletTimer 是按tick计时的分层时间轮,用于子弹的寿命到期与定时行为变化。
+ *
+ * 子弹的存活时间只会递增,逐帧检查每颗子弹是否到期会让大多数无事可做的子弹也被访问一遍。
+ * 时间轮只在事件到期的tick处理该事件:
+ * - 共 MAD_TIMER_LEVEL_NUM 层,每层 MAD_TIMER_SLOT_NUM 个槽,第l层的一个槽覆盖 64^l 个tick;
+ * - 登记事件时按到期tick与当前tick的距离放入最低的合适层,为 O(1);
+ * - 每个tick只处理最低层的一个槽,较高层的槽在轮转到时才整体下移一层(每个事件最多下移 MAD_TIMER_LEVEL_NUM 次)。
+ * 因此Advance的代价与到期事件数量成正比,与存活子弹数量无关。
+ *
+ * 事件通过句柄引用子弹,子弹在到期前被销毁时事件会被静默丢弃,不需要手动取消。
+ * 同一tick到期的事件按确定的顺序处理:先按登记顺序应用修改,再统一销毁到期的子弹。
+ *
+ * 注意:该类是线程不安全的!
+ */
+class MADBulletTimer
+{
+public:
+	MADBulletTimer(unsigned long long _tick = 0);
+	~MADBulletTimer();
+
+private:
+	typedef struct TimerEntry
+	{
+		unsigned long long Due = 0;
+		MADBulletEvent Event = MADBulletEvent();
+	}TimerEntry;
+
+public:
+	/*Schedule*/
+	void Schedule(unsigned long long _delay, const MADBulletEvent& _event);
+	void ScheduleAt(unsigned long long _tick, const MADBulletEvent& _event);
+	void ScheduleExpire(MADBulletHandle _bullet, unsigned long long _delay);
+	void Clear();
+
+	/*Advance*/
+	size_t Advance(MADBulletPool& _pool, std::vector<MADBulletEvent>* out_user = nullptr);
+
+	/*Get Data*/
+	unsigned long long GetTick() const;
+	size_t GetNum() const;
+
+	/*Snapshot*/
+	size_t Snapshot(std::vector<unsigned char>& out_data) const;
+	bool Restore(MADBlobReader& io_reader);
+
+private:
+	std::vector<TimerEntry> Wheels[MAD_TIMER_LEVEL_NUM][MAD_TIMER_SLOT_NUM];
+	std::vector<TimerEntry> Overflow;
+	unsigned long long Tick;
+	size_t EntryNum;
+
+	/*Scratch*/
+	std::vector<TimerEntry> Due;
+	std::vector<TimerEntry> Cascade;
+	std::vector<unsigned int> KillIndex;
+
+	/*Common function*/
+	void Insert(const TimerEntry& _entry, unsigned long long _base);
+	void CascadeSlot(std::vector<TimerEntry>& io_slot);
+};
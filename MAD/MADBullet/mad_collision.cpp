@@ -0,0 +1,739 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_collision.h"
+#include "../MADBase/mad_fp_strict.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+/*Upper bound of grid cells, the cell size is doubled until the grid fits*/
+#define MAD_COLLISION_MAX_CELLS (1 << 20)
+/*Upper bound of per-chunk histogram entries used by a parallel Build*/
+#define MAD_COLLISION_MAX_HISTOGRAM (1 << 22)
+/*Entities per job when Query is split across threads*/
+#define MAD_COLLISION_ENTITY_GRAIN 16
+/*Bullets handed to the query kernels at once,bounds the stack scratch of QueryEntity and QueryEntitySwept*/
+#define MAD_COLLISION_SWEEP_BLOCK 256
+/*Team bucket keys: 0~63 hold bullets of exactly one team bit*/
+#define MAD_COLLISION_MIXED_TEAM 64
+#define MAD_COLLISION_NO_TEAM 65
+
+/**
+ * (内部函数)
+ * 获取TeamMask对应的队伍桶:只有一位为1时为该位的序号,多位为1时为MAD_COLLISION_MIXED_TEAM,
+ * 为0时为MAD_COLLISION_NO_TEAM(不会与任何实体碰撞)。
+ */
+static unsigned int GetTeamBucket(long long _mask)
+{
+	static const unsigned char s_debruijn[64] = {
+		0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+		62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+		63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+		46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6
+	};
+	unsigned long long l_mask = static_cast<unsigned long long>(_mask);
+	if (l_mask == 0)
+	{
+		return MAD_COLLISION_NO_TEAM;
+	}
+	if ((l_mask & (l_mask - 1)) != 0)
+	{
+		return MAD_COLLISION_MIXED_TEAM;
+	}
+	return s_debruijn[(l_mask * 0x03F79D71B4CB0A89ull) >> 58];
+}
+
+/**
+ * 构造一个碰撞世界。
+ *
+ * @param _cell_size 网格边长,建议取实体检测半径的2~4倍;不是有限正数时使用MAD_COLLISION_DEFAULT_CELL_SIZE
+ * @param _bullet_radius 子弹的判定半径,对所有子弹统一生效
+ */
+MADCollisionWorld::MADCollisionWorld(float _cell_size, float _bullet_radius)
+{
+	if (!(_cell_size > 0.0f && _cell_size <= FLT_MAX))
+	{
+		MAD_LOG_ERR("Try to create a collision world with an invalid cell size!");
+		_cell_size = MAD_COLLISION_DEFAULT_CELL_SIZE;
+	}
+	CellSize = _cell_size;
+	BulletRadius = _bullet_radius;
+	GridOrigin_X = 0.0f;
+	GridOrigin_Y = 0.0f;
+	GridCellSize = _cell_size;
+	GridWidth = 0;
+	GridHeight = 0;
+	GridCellNum = 0;
+	MaxSpeed = 0.0f;
+	CellStart.assign(1, 0);
+}
+
+/**
+ * MADCollisionWorld析构函数。
+ */
+MADCollisionWorld::~MADCollisionWorld()
+{
+}
+
+/**
+ * 设置网格边长,在下一次Build时生效。
+ * 边长过小会导致实体覆盖的格子过多,过大则会使每个格子中的子弹过多。
+ *
+ * @param _cell_size 网格边长,必须是有限的正数
+ */
+void MADCollisionWorld::SetCellSize(float _cell_size)
+{
+	if (!(_cell_size > 0.0f && _cell_size <= FLT_MAX))
+	{
+		MAD_LOG_ERR("Try to set an invalid cell size to collision world!");
+		return;
+	}
+	CellSize = _cell_size;
+}
+
+/**
+ * 获取设置的网格边长。
+ * 若子弹分布过广,Build时实际使用的边长可能会被放大,但不会修改此设置。
+ *
+ * @return 网格边长
+ */
+float MADCollisionWorld::GetCellSize() const
+{
+	return CellSize;
+}
+
+/**
+ * 设置子弹的判定半径,立即对后续查询生效。
+ *
+ * @param _bullet_radius 子弹判定半径
+ */
+void MADCollisionWorld::SetBulletRadius(float _bullet_radius)
+{
+	BulletRadius = _bullet_radius;
+}
+
+/**
+ * 获取子弹的判定半径。
+ *
+ * @return 子弹判定半径
+ */
+float MADCollisionWorld::GetBulletRadius() const
+{
+	return BulletRadius;
+}
+
+/**
+ * 将子弹池中的所有子弹装入网格。
+ * 网格范围取所有子弹的包围盒,子弹通过稳定的计数排序按(队伍桶,格子)重新排列,
+ * 因此同一个格子中的子弹按密集索引递增排列,且Build的结果与调用历史无关。
+ * 只属于一个队伍的子弹按队伍分桶,每个桶各有一份网格;属于多个队伍的子弹共用一个混合桶;
+ * TeamMask为0的子弹不会与任何实体碰撞,不装入网格;坐标为NaN或无穷大的子弹不参与网格范围的计算,被放入边缘的格子。
+ * 每帧子弹移动之后、查询之前调用一次。
+ *
+ * 传入调度器时,包围盒、分格与散射都按分块并行:每个分块统计自己的格子直方图,
+ * 再按(格子,分块)的顺序求前缀和,因此排列结果与单线程完全相同。
+ *
+ * @param _pool 要装入的子弹池
+ * @param _jobs 可选的任务调度器,传入nullptr则在当前线程执行
+ */
+void MADCollisionWorld::Build(const MADBulletPool& _pool, MADJobSystem* _jobs)
+{
+	size_t l_num = _pool.GetNum();
+	const float* l_px = _pool.GetPositionXData();
+	const float* l_py = _pool.GetPositionYData();
+	const float* l_dx = _pool.GetDirXData();
+	const float* l_dy = _pool.GetDirYData();
+	const long long* l_mask = _pool.GetTeamMaskData();
+
+	BulletCell.resize(l_num);
+	SortedIndex.resize(l_num);
+	SortedPos_X.resize(l_num);
+	SortedPos_Y.resize(l_num);
+	SortedDir_X.resize(l_num);
+	SortedDir_Y.resize(l_num);
+	SortedTeamMask.resize(l_num);
+	MaxSpeed = 0.0f;
+
+	if (l_num == 0)
+	{
+		Clear();
+		return;
+	}
+
+	/*Bounds and team buckets*/
+	size_t l_grain = _jobs != nullptr ? MAD_BULLET_JOB_GRAIN : l_num;
+	size_t l_chunk_num = MADJobSystem::GetChunkNum(l_num, l_grain);
+	ChunkBounds.resize(l_chunk_num * 5);
+	ChunkTeams.resize(l_chunk_num * 2);
+	float* l_bounds = ChunkBounds.data();
+	unsigned long long* l_teams = ChunkTeams.data();
+	unsigned int* l_bullet_cell = BulletCell.data();
+	MADJobSystem::Dispatch(_jobs, l_num, l_grain, [=](size_t _begin, size_t _end, size_t _chunk) {
+		float l_min_x = FLT_MAX, l_max_x = -FLT_MAX;
+		float l_min_y = FLT_MAX, l_max_y = -FLT_MAX;
+		float l_speed_sq = 0.0f;
+		unsigned long long l_single = 0;
+		unsigned long long l_mixed = 0;
+		for (size_t i = _begin; i < _end; ++i)
+		{
+			unsigned int l_bucket = GetTeamBucket(l_mask[i]);
+			l_bullet_cell[i] = l_bucket;
+			if (l_bucket < MAD_COLLISION_MIXED_TEAM)
+			{
+				l_single |= 1ull << l_bucket;
+			}
+			else if (l_bucket == MAD_COLLISION_MIXED_TEAM)
+			{
+				l_mixed = 1;
+			}
+			/*NaN and infinite positions stay out of the bounds,binning clamps them to an edge cell*/
+			if (std::isfinite(l_px[i]) && std::isfinite(l_py[i]))
+			{
+				l_min_x = l_px[i] < l_min_x ? l_px[i] : l_min_x;
+				l_max_x = l_px[i] > l_max_x ? l_px[i] : l_max_x;
+				l_min_y = l_py[i] < l_min_y ? l_py[i] : l_min_y;
+				l_max_y = l_py[i] > l_max_y ? l_py[i] : l_max_y;
+			}
+			float l_sq = l_dx[i] * l_dx[i] + l_dy[i] * l_dy[i];
+			l_speed_sq = l_sq > l_speed_sq ? l_sq : l_speed_sq;
+		}
+		l_bounds[_chunk * 5 + 0] = l_min_x;
+		l_bounds[_chunk * 5 + 1] = l_min_y;
+		l_bounds[_chunk * 5 + 2] = l_max_x;
+		l_bounds[_chunk * 5 + 3] = l_max_y;
+		l_bounds[_chunk * 5 + 4] = l_speed_sq;
+		l_teams[_chunk * 2 + 0] = l_single;
+		l_teams[_chunk * 2 + 1] = l_mixed;
+	});
+	float l_min_x = l_bounds[0], l_min_y = l_bounds[1];
+	float l_max_x = l_bounds[2], l_max_y = l_bounds[3];
+	float l_speed_sq = l_bounds[4];
+	for (size_t k = 1; k < l_chunk_num; ++k)
+	{
+		l_min_x = l_bounds[k * 5 + 0] < l_min_x ? l_bounds[k * 5 + 0] : l_min_x;
+		l_min_y = l_bounds[k * 5 + 1] < l_min_y ? l_bounds[k * 5 + 1] : l_min_y;
+		l_max_x = l_bounds[k * 5 + 2] > l_max_x ? l_bounds[k * 5 + 2] : l_max_x;
+		l_max_y = l_bounds[k * 5 + 3] > l_max_y ? l_bounds[k * 5 + 3] : l_max_y;
+		l_speed_sq = l_bounds[k * 5 + 4] > l_speed_sq ? l_bounds[k * 5 + 4] : l_speed_sq;
+	}
+	MaxSpeed = std::sqrt(l_speed_sq);
+	if (l_min_x > l_max_x || l_min_y > l_max_y)
+	{
+		l_min_x = 0.0f;
+		l_min_y = 0.0f;
+		l_max_x = 0.0f;
+		l_max_y = 0.0f;
+	}
+
+	/*Occupied buckets in team bit order,the mixed bucket last*/
+	unsigned long long l_single = 0;
+	unsigned long long l_mixed = 0;
+	for (size_t k = 0; k < l_chunk_num; ++k)
+	{
+		l_single |= l_teams[k * 2 + 0];
+		l_mixed |= l_teams[k * 2 + 1];
+	}
+	unsigned int l_bucket_index[MAD_COLLISION_NO_TEAM + 1];
+	BucketTeam.clear();
+	for (unsigned int b = 0; b < MAD_COLLISION_MIXED_TEAM; ++b)
+	{
+		l_bucket_index[b] = static_cast<unsigned int>(BucketTeam.size());
+		if ((l_single >> b) & 1)
+		{
+			BucketTeam.push_back(static_cast<long long>(1ull << b));
+		}
+	}
+	l_bucket_index[MAD_COLLISION_MIXED_TEAM] = static_cast<unsigned int>(BucketTeam.size());
+	if (l_mixed != 0)
+	{
+		BucketTeam.push_back(0);
+	}
+	l_bucket_index[MAD_COLLISION_NO_TEAM] = static_cast<unsigned int>(BucketTeam.size());
+	size_t l_bucket_num = BucketTeam.empty() ? 1 : BucketTeam.size();
+
+	/*Grid size*/
+	double l_extent_x = static_cast<double>(l_max_x) - l_min_x;
+	double l_extent_y = static_cast<double>(l_max_y) - l_min_y;
+	double l_cell = CellSize;
+	while ((std::floor(l_extent_x / l_cell) + 1.0) * (std::floor(l_extent_y / l_cell) + 1.0) * l_bucket_num > MAD_COLLISION_MAX_CELLS)
+	{
+		l_cell *= 2.0;
+	}
+	GridOrigin_X = l_min_x;
+	GridOrigin_Y = l_min_y;
+	GridCellSize = static_cast<float>(l_cell);
+	GridWidth = static_cast<int>(std::floor(l_extent_x / l_cell)) + 1;
+	GridHeight = static_cast<int>(std::floor(l_extent_y / l_cell)) + 1;
+
+	GridCellNum = static_cast<size_t>(GridWidth) * static_cast<size_t>(GridHeight);
+
+	/*Bins are (bucket, cell) pairs,followed by one bin for bullets without a team*/
+	size_t l_cell_num = GridCellNum;
+	size_t l_bin_num = BucketTeam.size() * l_cell_num + 1;
+	CellStart.resize(l_bin_num);
+
+	/*Keep one histogram per chunk within MAD_COLLISION_MAX_HISTOGRAM entries*/
+	size_t l_max_chunk = MAD_COLLISION_MAX_HISTOGRAM / l_bin_num;
+	l_max_chunk = l_max_chunk == 0 ? 1 : l_max_chunk;
+	if (l_chunk_num > l_max_chunk)
+	{
+		l_grain = (l_num + l_max_chunk - 1) / l_max_chunk;
+		l_chunk_num = MADJobSystem::GetChunkNum(l_num, l_grain);
+	}
+	ChunkCursor.assign(l_chunk_num * l_bin_num, 0);
+
+	/*Bin*/
+	unsigned int* l_cursor = ChunkCursor.data();
+	const unsigned int* l_bucket_base = l_bucket_index;
+	float l_origin_x = GridOrigin_X;
+	float l_origin_y = GridOrigin_Y;
+	float l_inv_cell = 1.0f / GridCellSize;
+	int l_width = GridWidth;
+	int l_height = GridHeight;
+	MADJobSystem::Dispatch(_jobs, l_num, l_grain, [=](size_t _begin, size_t _end, size_t _chunk) {
+		unsigned int* l_count = l_cursor + _chunk * l_bin_num;
+		for (size_t i = _begin; i < _end; ++i)
+		{
+			if (l_bullet_cell[i] == MAD_COLLISION_NO_TEAM)
+			{
+				l_bullet_cell[i] = static_cast<unsigned int>(l_bin_num - 1);
+				l_count[l_bin_num - 1]++;
+				continue;
+			}
+			size_t l_base = l_bucket_base[l_bullet_cell[i]] * l_cell_num;
+			float l_fx = (l_px[i] - l_origin_x) * l_inv_cell;
+			float l_fy = (l_py[i] - l_origin_y) * l_inv_cell;
+			int l_cx = !(l_fx > 0.0f) ? 0 : (l_fx >= l_width ? l_width - 1 : static_cast<int>(l_fx));
+			int l_cy = !(l_fy > 0.0f) ? 0 : (l_fy >= l_height ? l_height - 1 : static_cast<int>(l_fy));
+			unsigned int l_id = static_cast<unsigned int>(l_base + l_cy * l_width + l_cx);
+			l_bullet_cell[i] = l_id;
+			l_count[l_id]++;
+		}
+	});
+
+	/*Prefix sum in (bin, chunk) order, turning counts into write cursors*/
+	unsigned int l_run = 0;
+	for (size_t c = 0; c < l_bin_num; ++c)
+	{
+		CellStart[c] = l_run;
+		for (size_t k = 0; k < l_chunk_num; ++k)
+		{
+			unsigned int l_count = l_cursor[k * l_bin_num + c];
+			l_cursor[k * l_bin_num + c] = l_run;
+			l_run += l_count;
+		}
+	}
+
+	/*Scatter*/
+	unsigned int* l_sorted_index = SortedIndex.data();
+	float* l_sorted_x = SortedPos_X.data();
+	float* l_sorted_y = SortedPos_Y.data();
+	float* l_sorted_dx = SortedDir_X.data();
+	float* l_sorted_dy = SortedDir_Y.data();
+	long long* l_sorted_mask = SortedTeamMask.data();
+	MADJobSystem::Dispatch(_jobs, l_num, l_grain, [=](size_t _begin, size_t _end, size_t _chunk) {
+		unsigned int* l_write = l_cursor + _chunk * l_bin_num;
+		for (size_t i = _begin; i < _end; ++i)
+		{
+			unsigned int l_dst = l_write[l_bullet_cell[i]]++;
+			l_sorted_index[l_dst] = static_cast<unsigned int>(i);
+			l_sorted_x[l_dst] = l_px[i];
+			l_sorted_y[l_dst] = l_py[i];
+			l_sorted_dx[l_dst] = l_dx[i];
+			l_sorted_dy[l_dst] = l_dy[i];
+			l_sorted_mask[l_dst] = l_mask[i];
+		}
+	});
+}
+
+/**
+ * 清空网格,之后的查询不会返回任何命中。
+ */
+void MADCollisionWorld::Clear()
+{
+	GridWidth = 0;
+	GridHeight = 0;
+	GridCellNum = 0;
+	CellStart.assign(1, 0);
+	BucketTeam.clear();
+	BulletCell.clear();
+	SortedIndex.clear();
+	SortedPos_X.clear();
+	SortedPos_Y.clear();
+	SortedDir_X.clear();
+	SortedDir_Y.clear();
+	SortedTeamMask.clear();
+	MaxSpeed = 0.0f;
+}
+
+/**
+ * 获取上一次Build装入网格的子弹数量,不含TeamMask为0的子弹。
+ *
+ * @return 子弹数量
+ */
+size_t MADCollisionWorld::GetBulletNum() const
+{
+	return CellStart.back();
+}
+
+/**
+ * 获取上一次Build中有子弹的队伍桶数量,包括混合桶。
+ *
+ * @return 队伍桶数量
+ */
+size_t MADCollisionWorld::GetBucketNum() const
+{
+	return BucketTeam.size();
+}
+
+/**
+ * 查询一组实体与网格中子弹的命中情况。
+ * 命中记录追加到 out_hits 末尾,先按实体下标、再按队伍桶与格子排列。
+ * 传入调度器时实体按MAD_COLLISION_ENTITY_GRAIN分块并行查询,各分块的结果按分块顺序拼接。
+ *
+ * @param _entities 实体数组
+ * @param _num 实体数量
+ * @param[out] out_hits 接收命中记录的数组,原有内容会被保留
+ * @param _jobs 可选的任务调度器,传入nullptr则在当前线程执行
+ * @return 本次查询新增的命中数量
+ */
+size_t MADCollisionWorld::Query(const MADEntity* _entities, size_t _num, std::vector<MADCollisionHit>& out_hits,
+	MADJobSystem* _jobs) const
+{
+	size_t l_before = out_hits.size();
+	if (_jobs == nullptr)
+	{
+		for (size_t e = 0; e < _num; ++e)
+		{
+			QueryEntity(_entities[e], static_cast<unsigned int>(e), out_hits);
+		}
+		return out_hits.size() - l_before;
+	}
+
+	ChunkHits.resize(MADJobSystem::GetChunkNum(_num, MAD_COLLISION_ENTITY_GRAIN));
+	_jobs->ParallelFor(_num, MAD_COLLISION_ENTITY_GRAIN, [&](size_t _begin, size_t _end, size_t _chunk) {
+		std::vector<MADCollisionHit>& l_hits = ChunkHits[_chunk];
+		l_hits.clear();
+		for (size_t e = _begin; e < _end; ++e)
+		{
+			QueryEntity(_entities[e], static_cast<unsigned int>(e), l_hits);
+		}
+	});
+	for (size_t k = 0; k < ChunkHits.size(); ++k)
+	{
+		out_hits.insert(out_hits.end(), ChunkHits[k].begin(), ChunkHits[k].end());
+	}
+	return out_hits.size() - l_before;
+}
+
+/**
+ * 查询单个实体与网格中子弹的命中情况。
+ * 实体与子弹的TeamMask按位与为0时视为不会互相命中:与实体无关的队伍桶整个跳过,
+ * 混合桶中的子弹由MADBulletKernel::OverlapCircle在距离检测的同时逐颗过滤。
+ * 判定条件为两者距离不大于实体TestRadius与子弹判定半径之和。
+ *
+ * @param _entity 要查询的实体
+ * @param _entity_index 写入命中记录的实体下标
+ * @param[out] out_hits 接收命中记录的数组,原有内容会被保留
+ * @return 本次查询新增的命中数量
+ */
+size_t MADCollisionWorld::QueryEntity(const MADEntity& _entity, unsigned int _entity_index,
+	std::vector<MADCollisionHit>& out_hits) const
+{
+	if (_entity.TeamMask == 0 || BucketTeam.empty())
+	{
+		return 0;
+	}
+
+	float l_radius = _entity.TestRadius + BulletRadius;
+	float l_radius_sq = l_radius * l_radius;
+	float l_ex = _entity.Position.x;
+	float l_ey = _entity.Position.y;
+	long long l_mask = _entity.TeamMask;
+
+	int l_x0, l_y0, l_x1, l_y1;
+	GetCellRange(l_ex - l_radius, l_ey - l_radius, l_ex + l_radius, l_ey + l_radius, &l_x0, &l_y0, &l_x1, &l_y1);
+
+	unsigned int l_index[MAD_COLLISION_SWEEP_BLOCK];
+	size_t l_before = out_hits.size();
+	for (size_t b = 0; b < BucketTeam.size(); ++b)
+	{
+		/*Single team buckets either match as a whole or are skipped,only the mixed bucket is filtered per bullet*/
+		if (BucketTeam[b] != 0 && (BucketTeam[b] & l_mask) == 0)
+		{
+			continue;
+		}
+		const long long* l_team_mask = BucketTeam[b] != 0 ? nullptr : SortedTeamMask.data();
+		size_t l_base = b * GridCellNum;
+		for (int y = l_y0; y <= l_y1; ++y)
+		{
+			/*Cells of one row are contiguous in the sorted arrays*/
+			unsigned int l_begin = CellStart[l_base + y * GridWidth + l_x0];
+			unsigned int l_end = CellStart[l_base + y * GridWidth + l_x1 + 1];
+			for (unsigned int i = l_begin; i < l_end; i += MAD_COLLISION_SWEEP_BLOCK)
+			{
+				size_t l_block = l_end - i < MAD_COLLISION_SWEEP_BLOCK ? l_end - i : MAD_COLLISION_SWEEP_BLOCK;
+				size_t l_hit = MADBulletKernel::OverlapCircle(SortedPos_X.data() + i, SortedPos_Y.data() + i,
+					l_team_mask != nullptr ? l_team_mask + i : nullptr, l_block, l_ex, l_ey, l_radius_sq, l_mask, l_index);
+				for (size_t k = 0; k < l_hit; ++k)
+				{
+					out_hits.push_back(MADCollisionHit(SortedIndex[i + l_index[k]], _entity_index));
+				}
+			}
+		}
+	}
+	return out_hits.size() - l_before;
+}
+
+/**
+ * 以扫掠圆(连续碰撞检测)查询一组实体与网格中子弹的命中情况,用于防止高速子弹穿过很小的判定点。
+ * 每颗子弹视为在本tick内从 Pos - Dir * _dt 匀速移动到当前位置,实体视为静止在当前位置,
+ * 求出两者首次接触的时刻,因此不需要对整个世界做子步(sub-step)。
+ *
+ * 新增的命中记录按(接触时刻,实体下标,子弹密集索引)排序,可以直接按顺序结算,
+ * 例如同一实体只响应最早命中它的子弹。
+ *
+ * @param _entities 实体数组
+ * @param _num 实体数量
+ * @param _dt 上一次Step使用的时间步长(秒)
+ * @param[out] out_hits 接收命中记录的数组,原有内容会被保留
+ * @param _jobs 可选的任务调度器,传入nullptr则在当前线程执行
+ * @return 本次查询新增的命中数量
+ *
+ * 注意:粗检测范围会按本次Build中最快子弹的位移扩大,个别极快的子弹会让所有实体检查更多的格子。
+ */
+size_t MADCollisionWorld::QuerySwept(const MADEntity* _entities, size_t _num, float _dt,
+	std::vector<MADSweptHit>& out_hits, MADJobSystem* _jobs) const
+{
+	size_t l_before = out_hits.size();
+	if (_jobs == nullptr)
+	{
+		for (size_t e = 0; e < _num; ++e)
+		{
+			QueryEntitySwept(_entities[e], static_cast<unsigned int>(e), _dt, out_hits);
+		}
+	}
+	else
+	{
+		ChunkSweptHits.resize(MADJobSystem::GetChunkNum(_num, MAD_COLLISION_ENTITY_GRAIN));
+		_jobs->ParallelFor(_num, MAD_COLLISION_ENTITY_GRAIN, [&](size_t _begin, size_t _end, size_t _chunk) {
+			std::vector<MADSweptHit>& l_hits = ChunkSweptHits[_chunk];
+			l_hits.clear();
+			for (size_t e = _begin; e < _end; ++e)
+			{
+				QueryEntitySwept(_entities[e], static_cast<unsigned int>(e), _dt, l_hits);
+			}
+		});
+		for (size_t k = 0; k < ChunkSweptHits.size(); ++k)
+		{
+			out_hits.insert(out_hits.end(), ChunkSweptHits[k].begin(), ChunkSweptHits[k].end());
+		}
+	}
+
+	std::sort(out_hits.begin() + l_before, out_hits.end(), [](const MADSweptHit& _a, const MADSweptHit& _b) {
+		if (_a.Time != _b.Time)
+		{
+			return _a.Time < _b.Time;
+		}
+		if (_a.Entity != _b.Entity)
+		{
+			return _a.Entity < _b.Entity;
+		}
+		return _a.Bullet < _b.Bullet;
+	});
+	return out_hits.size() - l_before;
+}
+
+/**
+ * 以扫掠圆查询单个实体与网格中子弹的命中情况。
+ * 粗检测范围为实体判定圆按最快子弹的位移扩大后的包围盒,精检测由MADBulletKernel::SweepCircle批量完成。
+ * 命中记录按格子顺序追加,不做排序。
+ *
+ * @param _entity 要查询的实体
+ * @param _entity_index 写入命中记录的实体下标
+ * @param _dt 上一次Step使用的时间步长(秒)
+ * @param[out] out_hits 接收命中记录的数组,原有内容会被保留
+ * @return 本次查询新增的命中数量
+ */
+size_t MADCollisionWorld::QueryEntitySwept(const MADEntity& _entity, unsigned int _entity_index, float _dt,
+	std::vector<MADSweptHit>& out_hits) const
+{
+	if (_entity.TeamMask == 0 || BucketTeam.empty())
+	{
+		return 0;
+	}
+
+	float l_radius = _entity.TestRadius + BulletRadius;
+	float l_reach = l_radius + MaxSpeed * (_dt < 0.0f ? -_dt : _dt);
+	float l_ex = _entity.Position.x;
+	float l_ey = _entity.Position.y;
+	long long l_mask = _entity.TeamMask;
+
+	int l_x0, l_y0, l_x1, l_y1;
+	GetCellRange(l_ex - l_reach, l_ey - l_reach, l_ex + l_reach, l_ey + l_reach, &l_x0, &l_y0, &l_x1, &l_y1);
+
+	unsigned int l_index[MAD_COLLISION_SWEEP_BLOCK];
+	float l_time[MAD_COLLISION_SWEEP_BLOCK];
+	size_t l_before = out_hits.size();
+	for (size_t t = 0; t < BucketTeam.size(); ++t)
+	{
+		if (BucketTeam[t] != 0 && (BucketTeam[t] & l_mask) == 0)
+		{
+			continue;
+		}
+		bool l_mixed = BucketTeam[t] == 0;
+		size_t l_base = t * GridCellNum;
+		for (int y = l_y0; y <= l_y1; ++y)
+		{
+			unsigned int l_begin = CellStart[l_base + y * GridWidth + l_x0];
+			unsigned int l_end = CellStart[l_base + y * GridWidth + l_x1 + 1];
+			for (unsigned int b = l_begin; b < l_end; b += MAD_COLLISION_SWEEP_BLOCK)
+			{
+				size_t l_block = l_end - b < MAD_COLLISION_SWEEP_BLOCK ? l_end - b : MAD_COLLISION_SWEEP_BLOCK;
+				size_t l_hit = MADBulletKernel::SweepCircle(SortedPos_X.data() + b, SortedPos_Y.data() + b,
+					SortedDir_X.data() + b, SortedDir_Y.data() + b, l_block, l_ex, l_ey, l_radius * l_radius, _dt,
+					l_index, l_time);
+				for (size_t k = 0; k < l_hit; ++k)
+				{
+					unsigned int l_sorted = b + l_index[k];
+					if (!l_mixed || (SortedTeamMask[l_sorted] & l_mask) != 0)
+					{
+						out_hits.push_back(MADSweptHit(SortedIndex[l_sorted], _entity_index, l_time[k]));
+					}
+				}
+			}
+		}
+	}
+	return out_hits.size() - l_before;
+}
+
+/**
+ * 查询一组实体的命中与擦弹情况,两者来自同一次粗检测遍历。
+ * 子弹与实体的距离不大于判定半径之和时为命中;超出判定半径但不超过 _graze_distance 时为擦弹。
+ * 擦弹只报告尚未被擦弹的子弹,并立即在 _pool 中标记(MADBulletPool::MarkGrazed),
+ * 因此每颗子弹在其生命周期内只计一次擦弹,同一帧内先查询的实体优先。
+ * 命中的子弹不会计为擦弹,也不会被标记。
+ *
+ * 由于擦弹标记需要按实体顺序依次写入,该查询总是在当前线程执行。
+ *
+ * @param _entities 实体数组
+ * @param _num 实体数量
+ * @param _graze_distance 擦弹带的宽度,从判定圆的边缘向外计算
+ * @param _pool 上一次Build使用的子弹池,Build之后不得再Spawn或Kill
+ * @param[out] out_hits 接收命中记录的数组,原有内容会被保留
+ * @param[out] out_grazes 接收擦弹记录的数组,原有内容会被保留
+ * @return 本次查询新增的擦弹数量
+ */
+size_t MADCollisionWorld::QueryGraze(const MADEntity* _entities, size_t _num, float _graze_distance, MADBulletPool& _pool,
+	std::vector<MADCollisionHit>& out_hits, std::vector<MADCollisionHit>& out_grazes) const
+{
+	size_t l_before = out_grazes.size();
+	for (size_t e = 0; e < _num; ++e)
+	{
+		QueryEntityGraze(_entities[e], static_cast<unsigned int>(e), _graze_distance, _pool, out_hits, out_grazes);
+	}
+	return out_grazes.size() - l_before;
+}
+
+/**
+ * 查询单个实体的命中与擦弹情况。
+ * 粗检测与精检测都按擦弹带的外径进行,再对落在外径内的少量子弹按判定半径区分命中与擦弹,
+ * 命中的判定与QueryEntity完全一致。
+ *
+ * @param _entity 要查询的实体
+ * @param _entity_index 写入记录的实体下标
+ * @param _graze_distance 擦弹带的宽度,从判定圆的边缘向外计算
+ * @param _pool 上一次Build使用的子弹池
+ * @param[out] out_hits 接收命中记录的数组,原有内容会被保留
+ * @param[out] out_grazes 接收擦弹记录的数组,原有内容会被保留
+ * @return 本次查询新增的擦弹数量
+ */
+size_t MADCollisionWorld::QueryEntityGraze(const MADEntity& _entity, unsigned int _entity_index, float _graze_distance,
+	MADBulletPool& _pool, std::vector<MADCollisionHit>& out_hits, std::vector<MADCollisionHit>& out_grazes) const
+{
+	if (_entity.TeamMask == 0 || BucketTeam.empty())
+	{
+		return 0;
+	}
+
+	float l_radius = _entity.TestRadius + BulletRadius;
+	float l_radius_sq = l_radius * l_radius;
+	float l_reach = l_radius + (_graze_distance > 0.0f ? _graze_distance : 0.0f);
+	float l_ex = _entity.Position.x;
+	float l_ey = _entity.Position.y;
+	long long l_mask = _entity.TeamMask;
+
+	int l_x0, l_y0, l_x1, l_y1;
+	GetCellRange(l_ex - l_reach, l_ey - l_reach, l_ex + l_reach, l_ey + l_reach, &l_x0, &l_y0, &l_x1, &l_y1);
+
+	unsigned int l_index[MAD_COLLISION_SWEEP_BLOCK];
+	size_t l_before = out_grazes.size();
+	for (size_t b = 0; b < BucketTeam.size(); ++b)
+	{
+		if (BucketTeam[b] != 0 && (BucketTeam[b] & l_mask) == 0)
+		{
+			continue;
+		}
+		const long long* l_team_mask = BucketTeam[b] != 0 ? nullptr : SortedTeamMask.data();
+		size_t l_base = b * GridCellNum;
+		for (int y = l_y0; y <= l_y1; ++y)
+		{
+			unsigned int l_begin = CellStart[l_base + y * GridWidth + l_x0];
+			unsigned int l_end = CellStart[l_base + y * GridWidth + l_x1 + 1];
+			for (unsigned int i = l_begin; i < l_end; i += MAD_COLLISION_SWEEP_BLOCK)
+			{
+				size_t l_block = l_end - i < MAD_COLLISION_SWEEP_BLOCK ? l_end - i : MAD_COLLISION_SWEEP_BLOCK;
+				size_t l_hit = MADBulletKernel::OverlapCircle(SortedPos_X.data() + i, SortedPos_Y.data() + i,
+					l_team_mask != nullptr ? l_team_mask + i : nullptr, l_block, l_ex, l_ey, l_reach * l_reach, l_mask, l_index);
+				for (size_t k = 0; k < l_hit; ++k)
+				{
+					unsigned int l_sorted = i + l_index[k];
+					float l_dx = SortedPos_X[l_sorted] - l_ex;
+					float l_dy = SortedPos_Y[l_sorted] - l_ey;
+					if (l_dx * l_dx + l_dy * l_dy <= l_radius_sq)
+					{
+						out_hits.push_back(MADCollisionHit(SortedIndex[l_sorted], _entity_index));
+					}
+					else if (!_pool.IsGrazed(SortedIndex[l_sorted]))
+					{
+						_pool.MarkGrazed(SortedIndex[l_sorted]);
+						out_grazes.push_back(MADCollisionHit(SortedIndex[l_sorted], _entity_index));
+					}
+				}
+			}
+		}
+	}
+	return out_grazes.size() - l_before;
+}
+
+/**
+ * (内部函数)
+ * 计算包围盒覆盖的格子范围(闭区间),超出网格的部分会被裁剪。
+ * 若包围盒与网格完全不相交,返回的范围满足 x1 < x0 或 y1 < y0。
+ */
+void MADCollisionWorld::GetCellRange(float _min_x, float _min_y, float _max_x, float _max_y,
+	int* out_x0, int* out_y0, int* out_x1, int* out_y1) const
+{
+	float l_inv_cell = 1.0f / GridCellSize;
+	float l_fx0 = std::floor((_min_x - GridOrigin_X) * l_inv_cell);
+	float l_fy0 = std::floor((_min_y - GridOrigin_Y) * l_inv_cell);
+	float l_fx1 = std::floor((_max_x - GridOrigin_X) * l_inv_cell);
+	float l_fy1 = std::floor((_max_y - GridOrigin_Y) * l_inv_cell);
+	if (!(l_fx1 >= 0.0f && l_fy1 >= 0.0f && l_fx0 < GridWidth && l_fy0 < GridHeight))
+	{
+		*out_x0 = 0;
+		*out_y0 = 0;
+		*out_x1 = -1;
+		*out_y1 = -1;
+		return;
+	}
+	*out_x0 = l_fx0 < 0.0f ? 0 : static_cast<int>(l_fx0);
+	*out_y0 = l_fy0 < 0.0f ? 0 : static_cast<int>(l_fy0);
+	*out_x1 = l_fx1 >= GridWidth ? GridWidth - 1 : static_cast<int>(l_fx1);
+	*out_y1 = l_fy1 >= GridHeight ? GridHeight - 1 : static_cast<int>(l_fy1);
+}
@@ -0,0 +1,147 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "mad_bullet_pool.h"
+
+/*Cell size used when the one passed to the constructor is not a positive finite number*/
+#define MAD_COLLISION_DEFAULT_CELL_SIZE 32.0f
+
+/**
+ * \brief MADCollisionHit 是一次子弹与实体的命中记录。
+ *
+ * `Bullet` 为子弹在MADBulletPool中的密集索引(在下一次Spawn/Kill前有效,可通过GetHandle转换为句柄),
+ * `Entity` 为实体在查询时传入的数组中的下标。
+ */
+struct MADCollisionHit {
+	unsigned int Bullet;
+	unsigned int Entity;
+
+	MADCollisionHit() {
+		Bullet = MAD_BULLET_INVALID_INDEX;
+		Entity = MAD_BULLET_INVALID_INDEX;
+	}
+	MADCollisionHit(unsigned int _bullet, unsigned int _entity) {
+		Bullet = _bullet;
+		Entity = _entity;
+	}
+};
+
+/**
+ * \brief MADSweptHit 是一次扫掠(连续)碰撞检测的命中记录。
+ *
+ * `Bullet` 与 `Entity` 的含义与MADCollisionHit相同,`Time` 为首次接触的时刻,
+ * 以本tick内的比例表示:0为tick开始(子弹上一位置),1为tick结束(子弹当前位置)。
+ */
+struct MADSweptHit {
+	unsigned int Bullet;
+	unsigned int Entity;
+	float Time;
+
+	MADSweptHit() {
+		Bullet = MAD_BULLET_INVALID_INDEX;
+		Entity = MAD_BULLET_INVALID_INDEX;
+		Time = 0.0f;
+	}
+	MADSweptHit(unsigned int _bullet, unsigned int _entity, float _time) {
+		Bullet = _bullet;
+		Entity = _entity;
+		Time = _time;
+	}
+};
+
+/**
+ * MADCollisionWorld 是子弹与MADEntity之间的碰撞查询器,以均匀网格作为粗检测(broadphase)。
+ *
+ * 使用方式:
+ * - 每帧子弹移动后调用Build,将所有子弹通过计数排序装入网格,子弹数据按格子重新连续排列;
+ * - 调用Query传入实体数组,每个实体只检查其包围盒覆盖的格子,同一行相邻格子在内存中是连续的;
+ * - 只属于一个队伍的子弹按队伍分桶存放,查询时与实体TeamMask无关的桶整个跳过;
+ *   属于多个队伍的子弹共用一个混合桶,由SIMD内核在距离检测的同时按位与过滤。
+ *   例如只有自机能被敌弹命中时,敌机查询不会访问任何敌弹。
+ *
+ * 高速子弹可以改用QuerySwept做连续碰撞检测,按接触时刻排序输出,不会穿过很小的判定点。
+ * 需要擦弹判定时改用QueryGraze,在同一次遍历中同时得到命中与擦弹,每颗子弹只计一次擦弹。
+ *
+ * 命中结果按(实体下标,队伍桶,格子,子弹密集索引)的顺序输出,与内存布局无关,结果是确定的。
+ * 队伍桶按队伍位的序号递增排列,混合桶在最后。
+ * Build与Query都可以传入MADJobSystem拆分到多个线程,输出与单线程完全相同。
+ *
+ * 注意:该类是线程不安全的!
+ */
+class MADCollisionWorld
+{
+public:
+	MADCollisionWorld(float _cell_size = MAD_COLLISION_DEFAULT_CELL_SIZE, float _bullet_radius = 0.0f);
+	~MADCollisionWorld();
+
+public:
+	/*Config*/
+	void SetCellSize(float _cell_size);
+	float GetCellSize() const;
+	void SetBulletRadius(float _bullet_radius);
+	float GetBulletRadius() const;
+
+	/*Broadphase*/
+	void Build(const MADBulletPool& _pool, MADJobSystem* _jobs = nullptr);
+	void Clear();
+	size_t GetBulletNum() const;
+	size_t GetBucketNum() const;
+
+	/*Query*/
+	size_t Query(const MADEntity* _entities, size_t _num, std::vector<MADCollisionHit>& out_hits,
+		MADJobSystem* _jobs = nullptr) const;
+	size_t QueryEntity(const MADEntity& _entity, unsigned int _entity_index, std::vector<MADCollisionHit>& out_hits) const;
+	size_t QuerySwept(const MADEntity* _entities, size_t _num, float _dt, std::vector<MADSweptHit>& out_hits,
+		MADJobSystem* _jobs = nullptr) const;
+	size_t QueryEntitySwept(const MADEntity& _entity, unsigned int _entity_index, float _dt,
+		std::vector<MADSweptHit>& out_hits) const;
+	size_t QueryGraze(const MADEntity* _entities, size_t _num, float _graze_distance, MADBulletPool& _pool,
+		std::vector<MADCollisionHit>& out_hits, std::vector<MADCollisionHit>& out_grazes) const;
+	size_t QueryEntityGraze(const MADEntity& _entity, unsigned int _entity_index, float _graze_distance,
+		MADBulletPool& _pool, std::vector<MADCollisionHit>& out_hits, std::vector<MADCollisionHit>& out_grazes) const;
+
+private:
+	/*Config*/
+	float CellSize;
+	float BulletRadius;
+
+	/*Grid Data*/
+	float GridOrigin_X;
+	float GridOrigin_Y;
+	float GridCellSize;
+	int GridWidth;
+	int GridHeight;
+	size_t GridCellNum;
+	float MaxSpeed;
+	std::vector<unsigned int> CellStart;
+
+	/*Team bit of each occupied bucket,0 marks the bucket of multi-team bullets*/
+	std::vector<long long> BucketTeam;
+
+	/*Bullets sorted by (bucket, cell) (SoA)*/
+	std::vector<unsigned int> BulletCell;
+	std::vector<unsigned int> SortedIndex;
+	std::vector<float> SortedPos_X;
+	std::vector<float> SortedPos_Y;
+	std::vector<float> SortedDir_X;
+	std::vector<float> SortedDir_Y;
+	std::vector<long long> SortedTeamMask;
+
+	/*Job scratch*/
+	std::vector<unsigned int> ChunkCursor;
+	std::vector<float> ChunkBounds;
+	std::vector<unsigned long long> ChunkTeams;
+	mutable std::vector<std::vector<MADCollisionHit>> ChunkHits;
+	mutable std::vector<std::vector<MADSweptHit>> ChunkSweptHits;
+
+	/*Common function*/
+	void GetCellRange(float _min_x, float _min_y, float _max_x, float _max_y,
+		int* out_x0, int* out_y0, int* out_x1, int* out_y1) const;
+};
@@ -0,0 +1,839 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_entity_index.h"
+#include "../MADBase/mad_fp_strict.h"
+
+#include <algorithm>
+#include <cmath>
+
+/*Cell coordinates are clamped to this range so that far away or NaN positions still land in a valid cell*/
+#define MAD_ENTITY_INDEX_MAX_CELL (1 << 30)
+
+/*Bytes one entity takes in a snapshot:position,radius,padding,team mask and user data*/
+#define MAD_ENTITY_INDEX_SNAPSHOT_ENTITY_SIZE 32
+
+/**
+ * 构造一个空的实体索引。
+ *
+ * @param _cell_size 格子边长,建议取常见实体检测半径的2~4倍
+ */
+MADEntityIndex::MADEntityIndex(float _cell_size)
+{
+	if (!(_cell_size > 0.0f))
+	{
+		MAD_LOG_ERR("Try to create an entity index with a non-positive cell size!");
+		_cell_size = 64.0f;
+	}
+	CellSize = _cell_size;
+	InvCellSize = 1.0f / _cell_size;
+	AliveNum = 0;
+	MaxRadius = 0.0f;
+	MaxRadiusDirty = false;
+	Buckets.resize(MAD_ENTITY_INDEX_BUCKETS);
+	CurrentStamp = 0;
+	RebinCount = 0;
+}
+
+/**
+ * MADEntityIndex析构函数。
+ */
+MADEntityIndex::~MADEntityIndex()
+{
+}
+
+/**
+ * 插入一个实体并返回其id。
+ * 实体数据会被复制到索引中,之后请通过Move或SetEntity更新。
+ *
+ * @param _entity 实体数据
+ * @return 实体id
+ */
+unsigned int MADEntityIndex::Insert(const MADEntity& _entity)
+{
+	unsigned int l_id;
+	if (!FreeIds.empty())
+	{
+		l_id = FreeIds.back();
+		FreeIds.pop_back();
+	}
+	else
+	{
+		l_id = static_cast<unsigned int>(Entities.size());
+		Entities.push_back(_entity);
+		Cell_X.push_back(0);
+		Cell_Y.push_back(0);
+		BucketSlot.push_back(0);
+		Alive.push_back(0);
+		VisitStamp.push_back(0);
+	}
+
+	Entities[l_id].Position = _entity.Position;
+	Entities[l_id].TestRadius = _entity.TestRadius;
+	Entities[l_id].TeamMask = _entity.TeamMask;
+	Entities[l_id].UserData = _entity.UserData;
+	Cell_X[l_id] = ToCell(_entity.Position.x);
+	Cell_Y[l_id] = ToCell(_entity.Position.y);
+	Alive[l_id] = 1;
+	AliveNum++;
+	Link(l_id);
+	if (!MaxRadiusDirty && _entity.TestRadius > MaxRadius)
+	{
+		MaxRadius = _entity.TestRadius;
+	}
+	return l_id;
+}
+
+/**
+ * 移除一个实体,其id会在之后的Insert中被复用。
+ *
+ * @param _id 实体id
+ * @return id有效时返回true
+ */
+bool MADEntityIndex::Remove(unsigned int _id)
+{
+	if (!IsValid(_id))
+	{
+		return false;
+	}
+	Unlink(_id);
+	Alive[_id] = 0;
+	AliveNum--;
+	FreeIds.push_back(_id);
+	if (Entities[_id].TestRadius >= MaxRadius)
+	{
+		MaxRadiusDirty = true;
+	}
+	return true;
+}
+
+/**
+ * 移动一个实体。
+ * 只有圆心跨越格子边界时才会换桶,否则只更新坐标。
+ *
+ * @param _id 实体id
+ * @param _position 新的圆心位置
+ * @return id有效时返回true
+ */
+bool MADEntityIndex::Move(unsigned int _id, const MADVector2DF& _position)
+{
+	if (!IsValid(_id))
+	{
+		return false;
+	}
+	Entities[_id].Position = _position;
+
+	int l_cell_x = ToCell(_position.x);
+	int l_cell_y = ToCell(_position.y);
+	if (l_cell_x != Cell_X[_id] || l_cell_y != Cell_Y[_id])
+	{
+		Unlink(_id);
+		Cell_X[_id] = l_cell_x;
+		Cell_Y[_id] = l_cell_y;
+		Link(_id);
+		RebinCount++;
+	}
+	return true;
+}
+
+/**
+ * 更新一个实体的全部数据(位置、检测半径、TeamMask与UserData)。
+ *
+ * @param _id 实体id
+ * @param _entity 新的实体数据
+ * @return id有效时返回true
+ */
+bool MADEntityIndex::SetEntity(unsigned int _id, const MADEntity& _entity)
+{
+	if (!IsValid(_id))
+	{
+		return false;
+	}
+	float l_old_radius = Entities[_id].TestRadius;
+	Entities[_id].TestRadius = _entity.TestRadius;
+	Entities[_id].TeamMask = _entity.TeamMask;
+	Entities[_id].UserData = _entity.UserData;
+	if (_entity.TestRadius > MaxRadius)
+	{
+		MaxRadius = _entity.TestRadius;
+	}
+	else if (_entity.TestRadius < l_old_radius && l_old_radius >= MaxRadius)
+	{
+		MaxRadiusDirty = true;
+	}
+	return Move(_id, _entity.Position);
+}
+
+/**
+ * 将索引与外部的实体数组同步,同步后实体id即为数组下标。
+ * 已存在的实体按SetEntity更新(不跨格子时不换桶),多出的id被移除,缺少的id被插入。
+ * 适合每帧整体提交实体数组的用法,请勿与Insert/Remove混用。
+ *
+ * @param _entities 实体数组
+ * @param _num 实体数量
+ */
+void MADEntityIndex::Sync(const MADEntity* _entities, size_t _num)
+{
+	for (size_t i = _num; i < Entities.size(); ++i)
+	{
+		Remove(static_cast<unsigned int>(i));
+	}
+
+	/*Hand out the missing ids in ascending order*/
+	FreeIds.clear();
+	for (size_t i = (_num < Entities.size() ? _num : Entities.size()); i > 0; --i)
+	{
+		if (!Alive[i - 1])
+		{
+			FreeIds.push_back(static_cast<unsigned int>(i - 1));
+		}
+	}
+
+	for (size_t i = 0; i < _num; ++i)
+	{
+		if (i < Entities.size() && Alive[i])
+		{
+			SetEntity(static_cast<unsigned int>(i), _entities[i]);
+		}
+		else
+		{
+			Insert(_entities[i]);
+		}
+	}
+
+	/*Ids above the array stay free,hand them out from the lowest*/
+	FreeIds.clear();
+	for (size_t i = Entities.size(); i > _num; --i)
+	{
+		FreeIds.push_back(static_cast<unsigned int>(i - 1));
+	}
+}
+
+/**
+ * 清空索引,所有id都会失效。
+ */
+void MADEntityIndex::Clear()
+{
+	Entities.clear();
+	Cell_X.clear();
+	Cell_Y.clear();
+	BucketSlot.clear();
+	Alive.clear();
+	FreeIds.clear();
+	VisitStamp.clear();
+	for (size_t i = 0; i < Buckets.size(); ++i)
+	{
+		Buckets[i].clear();
+	}
+	AliveNum = 0;
+	MaxRadius = 0.0f;
+	MaxRadiusDirty = false;
+}
+
+/**
+ * 获取索引中的实体数量。
+ *
+ * @return 实体数量
+ */
+size_t MADEntityIndex::GetNum() const
+{
+	return AliveNum;
+}
+
+/**
+ * 获取格子边长。
+ *
+ * @return 格子边长
+ */
+float MADEntityIndex::GetCellSize() const
+{
+	return CellSize;
+}
+
+/**
+ * 判断id是否指向索引中的实体。
+ *
+ * @param _id 实体id
+ * @return id有效时返回true
+ */
+bool MADEntityIndex::IsValid(unsigned int _id) const
+{
+	return _id < Alive.size() && Alive[_id] != 0;
+}
+
+/**
+ * 获取实体数据。
+ *
+ * @param _id 实体id,必须有效
+ * @return 实体数据
+ */
+const MADEntity& MADEntityIndex::GetEntity(unsigned int _id) const
+{
+	return Entities[_id];
+}
+
+/**
+ * 获取自构造以来实体跨越格子而换桶的次数,用于评估格子边长是否合适。
+ *
+ * @return 换桶次数
+ */
+unsigned long long MADEntityIndex::GetRebinCount() const
+{
+	return RebinCount;
+}
+
+/**
+ * 查询与给定圆相交的实体。
+ *
+ * @param _center 圆心
+ * @param _radius 半径
+ * @param _team_mask 只返回TeamMask与之按位与不为0的实体,传入-1表示不过滤
+ * @param[out] out_ids 命中的实体id,按递增排列,原有内容会被覆盖
+ * @return 命中的实体数量
+ */
+size_t MADEntityIndex::QueryRadius(const MADVector2DF& _center, float _radius, long long _team_mask,
+	std::vector<unsigned int>& out_ids) const
+{
+	out_ids.clear();
+	if (AliveNum == 0)
+	{
+		return 0;
+	}
+
+	float l_reach = _radius + GetMaxRadius();
+	int l_x0 = ToCell(_center.x - l_reach);
+	int l_y0 = ToCell(_center.y - l_reach);
+	int l_x1 = ToCell(_center.x + l_reach);
+	int l_y1 = ToCell(_center.y + l_reach);
+	long long l_cell_num = (static_cast<long long>(l_x1) - l_x0 + 1) * (static_cast<long long>(l_y1) - l_y0 + 1);
+
+	/*Tests one entity,shared by the cell walk and the linear fallback*/
+	auto l_test = [&](unsigned int _id) {
+		const MADEntity& l_entity = Entities[_id];
+		if ((l_entity.TeamMask & _team_mask) == 0)
+		{
+			return;
+		}
+		float l_dx = l_entity.Position.x - _center.x;
+		float l_dy = l_entity.Position.y - _center.y;
+		float l_r = _radius + l_entity.TestRadius;
+		if (l_dx * l_dx + l_dy * l_dy <= l_r * l_r)
+		{
+			out_ids.push_back(_id);
+		}
+	};
+
+	if (l_cell_num > static_cast<long long>(Entities.size()))
+	{
+		for (unsigned int i = 0; i < Entities.size(); ++i)
+		{
+			if (Alive[i])
+			{
+				l_test(i);
+			}
+		}
+		return out_ids.size();
+	}
+
+	for (int y = l_y0; y <= l_y1; ++y)
+	{
+		for (int x = l_x0; x <= l_x1; ++x)
+		{
+			const std::vector<unsigned int>& l_bucket = Buckets[GetBucket(x, y)];
+			for (size_t k = 0; k < l_bucket.size(); ++k)
+			{
+				unsigned int l_id = l_bucket[k];
+				if (Cell_X[l_id] == x && Cell_Y[l_id] == y)
+				{
+					l_test(l_id);
+				}
+			}
+		}
+	}
+	std::sort(out_ids.begin(), out_ids.end());
+	return out_ids.size();
+}
+
+/**
+ * 查找圆心距离给定位置最近的实体,常用于自机狙与诱导弹索敌。
+ * 以给定位置所在的格子为中心逐圈向外搜索,一旦已找到的最近距离不大于下一圈的最小距离即停止。
+ *
+ * @param _position 查询位置
+ * @param _team_mask 只考虑TeamMask与之按位与不为0的实体,传入-1表示不过滤
+ * @param _max_distance 最大搜索距离,小于0表示不限制
+ * @return 最近实体的id,距离相同时取较小的id;没有符合条件的实体时返回MAD_ENTITY_INVALID_ID
+ */
+unsigned int MADEntityIndex::FindNearest(const MADVector2DF& _position, long long _team_mask, float _max_distance) const
+{
+	unsigned int l_best = MAD_ENTITY_INVALID_ID;
+	float l_best_d2 = 0.0f;
+	bool l_limited = _max_distance >= 0.0f;
+	float l_max_d2 = _max_distance * _max_distance;
+
+	auto l_test = [&](unsigned int _id) {
+		const MADEntity& l_entity = Entities[_id];
+		if ((l_entity.TeamMask & _team_mask) == 0)
+		{
+			return;
+		}
+		float l_dx = l_entity.Position.x - _position.x;
+		float l_dy = l_entity.Position.y - _position.y;
+		float l_d2 = l_dx * l_dx + l_dy * l_dy;
+		if (l_limited && l_d2 > l_max_d2)
+		{
+			return;
+		}
+		if (l_best == MAD_ENTITY_INVALID_ID || l_d2 < l_best_d2 || (l_d2 == l_best_d2 && _id < l_best))
+		{
+			l_best = _id;
+			l_best_d2 = l_d2;
+		}
+	};
+	auto l_visit = [&](int _x, int _y) {
+		const std::vector<unsigned int>& l_bucket = Buckets[GetBucket(_x, _y)];
+		for (size_t k = 0; k < l_bucket.size(); ++k)
+		{
+			unsigned int l_id = l_bucket[k];
+			if (Cell_X[l_id] == _x && Cell_Y[l_id] == _y)
+			{
+				l_test(l_id);
+			}
+		}
+	};
+
+	if (AliveNum == 0)
+	{
+		return l_best;
+	}
+
+	int l_cx = ToCell(_position.x);
+	int l_cy = ToCell(_position.y);
+	size_t l_visited = 0;
+	for (int r = 0; ; ++r)
+	{
+		/*The ring walk got more expensive than a plain scan,finish linearly*/
+		l_visited += r == 0 ? 1 : 8 * static_cast<size_t>(r);
+		if (l_visited > Entities.size())
+		{
+			l_best = MAD_ENTITY_INVALID_ID;
+			for (unsigned int i = 0; i < Entities.size(); ++i)
+			{
+				if (Alive[i])
+				{
+					l_test(i);
+				}
+			}
+			return l_best;
+		}
+
+		if (r == 0)
+		{
+			l_visit(l_cx, l_cy);
+		}
+		else
+		{
+			for (int x = -r; x <= r; ++x)
+			{
+				l_visit(l_cx + x, l_cy - r);
+				l_visit(l_cx + x, l_cy + r);
+			}
+			for (int y = -r + 1; y <= r - 1; ++y)
+			{
+				l_visit(l_cx - r, l_cy + y);
+				l_visit(l_cx + r, l_cy + y);
+			}
+		}
+
+		/*Every unvisited cell is at least r cells away*/
+		float l_ring_distance = static_cast<float>(r) * CellSize;
+		if (l_best != MAD_ENTITY_INVALID_ID && l_best_d2 <= l_ring_distance * l_ring_distance)
+		{
+			return l_best;
+		}
+		if (l_limited && l_ring_distance > _max_distance)
+		{
+			return l_best;
+		}
+	}
+}
+
+/**
+ * 查找射线命中的第一个实体,可用于激光与视线判定。
+ * 沿射线按格子前进,并检查每个格子周围最大检测半径范围内的格子;
+ * 当前格子的入口距离超过已找到的命中距离加上最大检测半径时提前结束。
+ *
+ * @param _origin 射线起点
+ * @param _dir 射线方向,不需要归一化
+ * @param _max_distance 射线长度
+ * @param _team_mask 只考虑TeamMask与之按位与不为0的实体,传入-1表示不过滤
+ * @param[out] out_hit 命中结果,起点位于实体内部时距离为0
+ * @return 命中任意实体时返回true
+ */
+bool MADEntityIndex::Raycast(const MADVector2DF& _origin, const MADVector2DF& _dir, float _max_distance, long long _team_mask,
+	MADEntityRayHit* out_hit) const
+{
+	MADEntityRayHit l_hit;
+	if (out_hit != nullptr)
+	{
+		*out_hit = l_hit;
+	}
+	float l_length = std::sqrt(_dir.x * _dir.x + _dir.y * _dir.y);
+	if (AliveNum == 0 || !(l_length > 0.0f) || !(_max_distance >= 0.0f) ||
+		!std::isfinite(_origin.x) || !std::isfinite(_origin.y) || !std::isfinite(l_length))
+	{
+		return false;
+	}
+	float l_dir_x = _dir.x / l_length;
+	float l_dir_y = _dir.y / l_length;
+
+	auto l_test = [&](unsigned int _id) {
+		const MADEntity& l_entity = Entities[_id];
+		if ((l_entity.TeamMask & _team_mask) == 0)
+		{
+			return;
+		}
+		float l_mx = _origin.x - l_entity.Position.x;
+		float l_my = _origin.y - l_entity.Position.y;
+		float l_b = l_mx * l_dir_x + l_my * l_dir_y;
+		float l_c = l_mx * l_mx + l_my * l_my - l_entity.TestRadius * l_entity.TestRadius;
+		float l_t;
+		if (l_c <= 0.0f)
+		{
+			l_t = 0.0f;
+		}
+		else
+		{
+			float l_disc = l_b * l_b - l_c;
+			if (l_b > 0.0f || l_disc < 0.0f)
+			{
+				return;
+			}
+			l_t = -l_b - std::sqrt(l_disc);
+		}
+		if (l_t > _max_distance)
+		{
+			return;
+		}
+		if (l_hit.Entity == MAD_ENTITY_INVALID_ID || l_t < l_hit.Distance || (l_t == l_hit.Distance && _id < l_hit.Entity))
+		{
+			l_hit.Entity = _id;
+			l_hit.Distance = l_t;
+		}
+	};
+
+	float l_max_radius = GetMaxRadius();
+	int l_reach = static_cast<int>(std::ceil(l_max_radius * InvCellSize));
+	double l_steps = 2.0 * (static_cast<double>(_max_distance) + l_max_radius) * InvCellSize + 2.0;
+	double l_cells = l_steps * (2.0 * l_reach + 1.0) * (2.0 * l_reach + 1.0);
+
+	if (l_cells > static_cast<double>(Entities.size()))
+	{
+		for (unsigned int i = 0; i < Entities.size(); ++i)
+		{
+			if (Alive[i])
+			{
+				l_test(i);
+			}
+		}
+	}
+	else
+	{
+		unsigned int l_stamp = NextStamp();
+		int l_cx = ToCell(_origin.x);
+		int l_cy = ToCell(_origin.y);
+		int l_step_x = l_dir_x > 0.0f ? 1 : (l_dir_x < 0.0f ? -1 : 0);
+		int l_step_y = l_dir_y > 0.0f ? 1 : (l_dir_y < 0.0f ? -1 : 0);
+		const float l_inf = INFINITY;
+		float l_next_x = l_step_x == 0 ? l_inf :
+			((static_cast<float>(l_cx + (l_step_x > 0 ? 1 : 0)) * CellSize) - _origin.x) / l_dir_x;
+		float l_next_y = l_step_y == 0 ? l_inf :
+			((static_cast<float>(l_cy + (l_step_y > 0 ? 1 : 0)) * CellSize) - _origin.y) / l_dir_y;
+		float l_delta_x = l_step_x == 0 ? l_inf : CellSize / std::fabs(l_dir_x);
+		float l_delta_y = l_step_y == 0 ? l_inf : CellSize / std::fabs(l_dir_y);
+		float l_enter = 0.0f;
+
+		for (;;)
+		{
+			float l_limit = l_hit.Entity != MAD_ENTITY_INVALID_ID && l_hit.Distance < _max_distance ? l_hit.Distance : _max_distance;
+			if (l_enter > l_limit + l_max_radius)
+			{
+				break;
+			}
+
+			for (int y = l_cy - l_reach; y <= l_cy + l_reach; ++y)
+			{
+				for (int x = l_cx - l_reach; x <= l_cx + l_reach; ++x)
+				{
+					const std::vector<unsigned int>& l_bucket = Buckets[GetBucket(x, y)];
+					for (size_t k = 0; k < l_bucket.size(); ++k)
+					{
+						unsigned int l_id = l_bucket[k];
+						if (Cell_X[l_id] == x && Cell_Y[l_id] == y && VisitStamp[l_id] != l_stamp)
+						{
+							VisitStamp[l_id] = l_stamp;
+							l_test(l_id);
+						}
+					}
+				}
+			}
+
+			if (l_next_x < l_next_y)
+			{
+				l_cx += l_step_x;
+				l_enter = l_next_x;
+				l_next_x += l_delta_x;
+			}
+			else
+			{
+				l_cy += l_step_y;
+				l_enter = l_next_y;
+				l_next_y += l_delta_y;
+			}
+		}
+	}
+
+	if (out_hit != nullptr)
+	{
+		*out_hit = l_hit;
+	}
+	return l_hit.Entity != MAD_ENTITY_INVALID_ID;
+}
+
+/**
+ * 把索引的全部状态追加到 out_data 末尾,包括哈希桶内的排列顺序,因此恢复后的查询结果与保存时一致。
+ * 实体的UserData按指针值保存,只在同一进程内恢复时有意义。
+ *
+ * @param out_data 输出缓冲区,数据追加在已有内容之后
+ * @return 写入的字节数
+ */
+size_t MADEntityIndex::Snapshot(std::vector<unsigned char>& out_data) const
+{
+	size_t l_begin = out_data.size();
+	MADBlobWriter l_writer(out_data);
+	l_writer.Write(MAD_ENTITY_INDEX_SNAPSHOT_TAG);
+	l_writer.Write(CellSize);
+	l_writer.Write(static_cast<unsigned long long>(Entities.size()));
+	l_writer.Write(static_cast<unsigned long long>(AliveNum));
+	l_writer.Write(RebinCount);
+	for (size_t i = 0; i < Entities.size(); ++i)
+	{
+		const MADEntity& l_entity = Entities[i];
+		l_writer.Write(l_entity.Position.x);
+		l_writer.Write(l_entity.Position.y);
+		l_writer.Write(l_entity.TestRadius);
+		l_writer.Write(0u);
+		l_writer.Write(l_entity.TeamMask);
+		l_writer.Write(reinterpret_cast<unsigned long long>(l_entity.UserData));
+	}
+	l_writer.WriteArray(Cell_X);
+	l_writer.WriteArray(Cell_Y);
+	l_writer.WriteArray(BucketSlot);
+	l_writer.WriteArray(Alive);
+	l_writer.WriteArray(FreeIds);
+	l_writer.Write(static_cast<unsigned long long>(Buckets.size()));
+	for (size_t i = 0; i < Buckets.size(); ++i)
+	{
+		l_writer.WriteArray(Buckets[i]);
+	}
+	return out_data.size() - l_begin;
+}
+
+/**
+ * 从快照中恢复索引,格子边长也一并恢复。
+ * 恢复时会校验哈希桶、桶内位置与空闲id之间的对应关系,快照数据损坏、不完整或前后矛盾时索引被清空。
+ *
+ * @param io_reader 指向一份由Snapshot写入的数据,读取后前进到该数据之后
+ * @return 成功时返回true
+ */
+bool MADEntityIndex::Restore(MADBlobReader& io_reader)
+{
+	unsigned int l_tag = 0;
+	float l_cell_size = 0.0f;
+	unsigned long long l_entity_num = 0;
+	unsigned long long l_alive_num = 0;
+	unsigned long long l_bucket_num = 0;
+	unsigned long long l_rebin_count = 0;
+	io_reader.Read(&l_tag);
+	io_reader.Read(&l_cell_size);
+	io_reader.Read(&l_entity_num);
+	io_reader.Read(&l_alive_num);
+	io_reader.Read(&l_rebin_count);
+
+	/*The entity count is bounded by the bytes left,so a broken count can not force a huge allocation*/
+	bool l_valid = !io_reader.IsFailed() && l_tag == MAD_ENTITY_INDEX_SNAPSHOT_TAG && l_cell_size > 0.0f &&
+		l_entity_num <= MAD_BULLET_INVALID_INDEX &&
+		l_entity_num <= io_reader.GetRemaining() / MAD_ENTITY_INDEX_SNAPSHOT_ENTITY_SIZE;
+	if (l_valid)
+	{
+		Entities.resize(static_cast<size_t>(l_entity_num));
+	}
+	for (size_t i = 0; l_valid && i < Entities.size(); ++i)
+	{
+		MADEntity& l_entity = Entities[i];
+		unsigned int l_pad = 0;
+		unsigned long long l_user_data = 0;
+		io_reader.Read(&l_entity.Position.x);
+		io_reader.Read(&l_entity.Position.y);
+		io_reader.Read(&l_entity.TestRadius);
+		io_reader.Read(&l_pad);
+		io_reader.Read(&l_entity.TeamMask);
+		l_valid = io_reader.Read(&l_user_data);
+		l_entity.UserData = reinterpret_cast<void**>(l_user_data);
+	}
+	if (l_valid)
+	{
+		io_reader.ReadArray(Cell_X);
+		io_reader.ReadArray(Cell_Y);
+		io_reader.ReadArray(BucketSlot);
+		io_reader.ReadArray(Alive);
+		io_reader.ReadArray(FreeIds);
+		io_reader.Read(&l_bucket_num);
+		l_valid = !io_reader.IsFailed() && l_bucket_num == Buckets.size() &&
+			Cell_X.size() == Entities.size() && Cell_Y.size() == Entities.size() &&
+			BucketSlot.size() == Entities.size() && Alive.size() == Entities.size();
+	}
+	for (size_t i = 0; l_valid && i < Buckets.size(); ++i)
+	{
+		l_valid = io_reader.ReadArray(Buckets[i]);
+	}
+
+	/*Every bucket entry is an alive id linked back to this bucket and slot,so each alive id is linked exactly once*/
+	size_t l_num = Entities.size();
+	size_t l_alive = 0;
+	for (size_t i = 0; l_valid && i < l_num; ++i)
+	{
+		l_valid = Alive[i] <= 1;
+		l_alive += Alive[i];
+	}
+	l_valid = l_valid && l_alive == l_alive_num && l_alive + FreeIds.size() == l_num;
+	size_t l_linked = 0;
+	for (size_t b = 0; l_valid && b < Buckets.size(); ++b)
+	{
+		const std::vector<unsigned int>& l_bucket = Buckets[b];
+		for (size_t k = 0; l_valid && k < l_bucket.size(); ++k)
+		{
+			unsigned int l_id = l_bucket[k];
+			l_valid = l_id < l_num && Alive[l_id] != 0 && BucketSlot[l_id] == k &&
+				GetBucket(Cell_X[l_id], Cell_Y[l_id]) == b;
+		}
+		l_linked += l_bucket.size();
+	}
+	l_valid = l_valid && l_linked == l_alive;
+
+	/*Free ids are dead and distinct*/
+	VisitStamp.assign(l_num, 0u);
+	for (size_t i = 0; l_valid && i < FreeIds.size(); ++i)
+	{
+		unsigned int l_id = FreeIds[i];
+		l_valid = l_id < l_num && Alive[l_id] == 0 && VisitStamp[l_id] == 0;
+		if (l_valid)
+		{
+			VisitStamp[l_id] = 1;
+		}
+	}
+	if (!l_valid)
+	{
+		MAD_LOG_ERR("Try to restore an entity index from a broken snapshot!");
+		Clear();
+		return false;
+	}
+	CellSize = l_cell_size;
+	InvCellSize = 1.0f / l_cell_size;
+	AliveNum = static_cast<size_t>(l_alive_num);
+	RebinCount = l_rebin_count;
+	MaxRadiusDirty = true;
+	VisitStamp.assign(Entities.size(), 0u);
+	CurrentStamp = 0;
+	return true;
+}
+
+/**
+ * (内部函数)
+ * 将坐标换算为格子坐标,超出范围或NaN的坐标被钳制到有效范围内。
+ */
+int MADEntityIndex::ToCell(float _value) const
+{
+	float l_cell = std::floor(_value * InvCellSize);
+	if (!(l_cell > -static_cast<float>(MAD_ENTITY_INDEX_MAX_CELL)))
+	{
+		return l_cell == l_cell ? -MAD_ENTITY_INDEX_MAX_CELL : 0;
+	}
+	if (l_cell > static_cast<float>(MAD_ENTITY_INDEX_MAX_CELL))
+	{
+		return MAD_ENTITY_INDEX_MAX_CELL;
+	}
+	return static_cast<int>(l_cell);
+}
+
+/**
+ * (内部函数)
+ * 计算格子所在的哈希桶,不同格子可能落在同一个桶中,遍历桶时需要再比较格子坐标。
+ */
+unsigned int MADEntityIndex::GetBucket(int _cell_x, int _cell_y) const
+{
+	unsigned int l_hash = (static_cast<unsigned int>(_cell_x) * 73856093u) ^ (static_cast<unsigned int>(_cell_y) * 19349663u);
+	return l_hash & (MAD_ENTITY_INDEX_BUCKETS - 1);
+}
+
+/**
+ * (内部函数)
+ * 将实体追加到其当前格子所在的桶中。
+ */
+void MADEntityIndex::Link(unsigned int _id)
+{
+	std::vector<unsigned int>& l_bucket = Buckets[GetBucket(Cell_X[_id], Cell_Y[_id])];
+	BucketSlot[_id] = static_cast<unsigned int>(l_bucket.size());
+	l_bucket.push_back(_id);
+}
+
+/**
+ * (内部函数)
+ * 将实体从其当前格子所在的桶中交换删除。
+ */
+void MADEntityIndex::Unlink(unsigned int _id)
+{
+	std::vector<unsigned int>& l_bucket = Buckets[GetBucket(Cell_X[_id], Cell_Y[_id])];
+	unsigned int l_slot = BucketSlot[_id];
+	unsigned int l_last = l_bucket.back();
+	l_bucket[l_slot] = l_last;
+	BucketSlot[l_last] = l_slot;
+	l_bucket.pop_back();
+}
+
+/**
+ * (内部函数)
+ * 获取存活实体中最大的检测半径,必要时重新统计。
+ */
+float MADEntityIndex::GetMaxRadius() const
+{
+	if (MaxRadiusDirty)
+	{
+		MaxRadius = 0.0f;
+		for (size_t i = 0; i < Entities.size(); ++i)
+		{
+			if (Alive[i] && Entities[i].TestRadius > MaxRadius)
+			{
+				MaxRadius = Entities[i].TestRadius;
+			}
+		}
+		MaxRadiusDirty = false;
+	}
+	return MaxRadius;
+}
+
+/**
+ * (内部函数)
+ * 获取一个新的访问标记,标记回绕时清空所有实体的标记。
+ */
+unsigned int MADEntityIndex::NextStamp() const
+{
+	if (++CurrentStamp == 0)
+	{
+		std::fill(VisitStamp.begin(), VisitStamp.end(), 0u);
+		CurrentStamp = 1;
+	}
+	return CurrentStamp;
+}
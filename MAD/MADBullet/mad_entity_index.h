@@ -0,0 +1,123 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "mad_bullet_pool.h"
+
+/*Invalid entity id*/
+#define MAD_ENTITY_INVALID_ID 0xFFFFFFFFu
+
+/*Tag written at the start of an entity index snapshot*/
+#define MAD_ENTITY_INDEX_SNAPSHOT_TAG 0x59544E45u
+
+/*Number of hash buckets,must be a power of two*/
+#define MAD_ENTITY_INDEX_BUCKETS 1024
+
+/**
+ * \brief MADEntityRayHit 是一次射线查询的结果。
+ *
+ * `Entity` 为命中实体的id,未命中时为MAD_ENTITY_INVALID_ID;`Distance` 为射线起点到命中点的距离。
+ */
+struct MADEntityRayHit {
+	unsigned int Entity;
+	float Distance;
+
+	MADEntityRayHit() {
+		Entity = MAD_ENTITY_INVALID_ID;
+		Distance = 0.0f;
+	}
+};
+
+/**
+ * MADEntityIndex 是MADEntity的增量空间哈希索引,用于碰撞检测与敌机索敌。
+ *
+ * 与每帧重建的子弹网格不同,实体数量少且移动缓慢,因此索引是常驻的:
+ * - 每个实体按圆心所在的格子放入哈希桶,移动时只有跨越格子边界才会从旧桶移到新桶,否则只更新坐标;
+ * - 桶内移除为交换删除,插入、移动与删除都是 O(1);
+ * - 查询时按所有实体中最大的检测半径扩大搜索范围,因此大实体不需要登记到多个格子。
+ *
+ * 支持的查询:
+ * - QueryRadius: 与给定圆相交的实体;
+ * - FindNearest: 圆心距离最近且TeamMask匹配的实体,由内向外逐圈搜索格子;
+ * - Raycast: 射线命中的第一个实体,沿射线按格子前进(DDA),找到命中后提前结束。
+ *
+ * 所有查询结果与桶内的排列顺序无关:列表按id递增输出,距离相同时取id较小者,因此结果是确定的。
+ * 搜索范围覆盖的格子多于实体数量时,查询自动退化为线性遍历。
+ *
+ * 实体id在Remove之后会被复用。也可以每帧调用Sync,让id与外部实体数组的下标一一对应。
+ *
+ * 注意:该类是线程不安全的!
+ */
+class MADEntityIndex
+{
+public:
+	MADEntityIndex(float _cell_size = 64.0f);
+	~MADEntityIndex();
+
+public:
+	/*Entity operator*/
+	unsigned int Insert(const MADEntity& _entity);
+	bool Remove(unsigned int _id);
+	bool Move(unsigned int _id, const MADVector2DF& _position);
+	bool SetEntity(unsigned int _id, const MADEntity& _entity);
+	void Sync(const MADEntity* _entities, size_t _num);
+	void Clear();
+
+	/*Get Data*/
+	size_t GetNum() const;
+	float GetCellSize() const;
+	bool IsValid(unsigned int _id) const;
+	const MADEntity& GetEntity(unsigned int _id) const;
+	unsigned long long GetRebinCount() const;
+
+	/*Query*/
+	size_t QueryRadius(const MADVector2DF& _center, float _radius, long long _team_mask,
+		std::vector<unsigned int>& out_ids) const;
+	unsigned int FindNearest(const MADVector2DF& _position, long long _team_mask, float _max_distance = -1.0f) const;
+	bool Raycast(const MADVector2DF& _origin, const MADVector2DF& _dir, float _max_distance, long long _team_mask,
+		MADEntityRayHit* out_hit) const;
+
+	/*Snapshot*/
+	size_t Snapshot(std::vector<unsigned char>& out_data) const;
+	bool Restore(MADBlobReader& io_reader);
+
+private:
+	/*Config*/
+	float CellSize;
+	float InvCellSize;
+
+	/*Entity Data,indexed by id*/
+	std::vector<MADEntity> Entities;
+	std::vector<int> Cell_X;
+	std::vector<int> Cell_Y;
+	std::vector<unsigned int> BucketSlot;
+	std::vector<unsigned char> Alive;
+	std::vector<unsigned int> FreeIds;
+	size_t AliveNum;
+
+	/*Largest TestRadius among alive entities,recomputed lazily after the largest one shrinks or leaves*/
+	mutable float MaxRadius;
+	mutable bool MaxRadiusDirty;
+
+	/*Hash buckets of entity ids*/
+	std::vector<std::vector<unsigned int>> Buckets;
+
+	/*Query scratch*/
+	mutable std::vector<unsigned int> VisitStamp;
+	mutable unsigned int CurrentStamp;
+	unsigned long long RebinCount;
+
+	/*Common function*/
+	int ToCell(float _value) const;
+	unsigned int GetBucket(int _cell_x, int _cell_y) const;
+	void Link(unsigned int _id);
+	void Unlink(unsigned int _id);
+	float GetMaxRadius() const;
+	unsigned int NextStamp() const;
+};
@@ -0,0 +1,548 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_fixed_pool.h"
+#include "mad_bullet_kernel.h"
+
+#include <cstring>
+
+/**
+ * (内部函数)
+ * 从数组中移除一组升序排列的索引,存活的元素保持原有顺序,
+ * 每段连续的存活元素只做一次memmove。
+ */
+template <typename T>
+static void CompactArray(std::vector<T>& io_array, const unsigned int* _sorted, size_t _num)
+{
+	if (_num == 0)
+	{
+		return;
+	}
+	T* l_data = io_array.data();
+	size_t l_write = _sorted[0];
+	for (size_t k = 0; k < _num; ++k)
+	{
+		size_t l_begin = static_cast<size_t>(_sorted[k]) + 1;
+		size_t l_end = k + 1 < _num ? _sorted[k + 1] : io_array.size();
+		if (l_end > l_begin)
+		{
+			memmove(l_data + l_write, l_data + l_begin, (l_end - l_begin) * sizeof(T));
+			l_write += l_end - l_begin;
+		}
+	}
+	io_array.resize(l_write);
+}
+
+/**
+ * 构造一个空的定点子弹池。
+ * 构造时不会分配任何内存,如果已知子弹规模,请调用Reserve预留容量以避免运行中扩容。
+ */
+MADFixedBulletPool::MADFixedBulletPool()
+{
+}
+
+/**
+ * MADFixedBulletPool析构函数。
+ */
+MADFixedBulletPool::~MADFixedBulletPool()
+{
+}
+
+/**
+ * 生成一颗子弹并返回其句柄,子弹被追加到密集数组末尾。
+ *
+ * @param _info 子弹的初始数据
+ * @return 新子弹的句柄
+ */
+MADBulletHandle MADFixedBulletPool::Spawn(const MADFixedBulletInfo& _info)
+{
+	unsigned int l_dense = static_cast<unsigned int>(AliveTick.size());
+	unsigned int l_slot;
+	if (!FreeSlots.empty())
+	{
+		l_slot = FreeSlots.back();
+		FreeSlots.pop_back();
+		SlotToDense[l_slot] = l_dense;
+	}
+	else
+	{
+		l_slot = static_cast<unsigned int>(SlotToDense.size());
+		SlotToDense.push_back(l_dense);
+		SlotGeneration.push_back(0);
+	}
+
+	AliveTick.push_back(_info.AliveTick);
+	OriginPos_X.push_back(_info.OriginPos_X);
+	OriginPos_Y.push_back(_info.OriginPos_Y);
+	Angle.push_back(_info.Angle);
+	Speed.push_back(_info.Speed);
+	TeamMask.push_back(_info.TeamMask);
+	DenseToSlot.push_back(l_slot);
+
+	return MADBulletHandle(l_slot, SlotGeneration[l_slot]);
+}
+
+/**
+ * 通过句柄销毁一颗子弹,旧句柄随即失效。
+ *
+ * @param _handle 子弹句柄
+ * @return 句柄有效时返回true
+ */
+bool MADFixedBulletPool::Kill(MADBulletHandle _handle)
+{
+	size_t l_index = GetIndex(_handle);
+	if (l_index == MAD_BULLET_INVALID_INDEX)
+	{
+		return false;
+	}
+	KillAt(l_index);
+	return true;
+}
+
+/**
+ * 通过密集索引销毁一颗子弹,末尾的子弹会被交换到该位置(swap-remove)。
+ *
+ * @param _index 要销毁的子弹的密集索引,必须小于GetNum()
+ */
+void MADFixedBulletPool::KillAt(size_t _index)
+{
+	size_t l_last = AliveTick.size() - 1;
+	unsigned int l_slot = DenseToSlot[_index];
+
+	if (_index != l_last)
+	{
+		AliveTick[_index] = AliveTick[l_last];
+		OriginPos_X[_index] = OriginPos_X[l_last];
+		OriginPos_Y[_index] = OriginPos_Y[l_last];
+		Angle[_index] = Angle[l_last];
+		Speed[_index] = Speed[l_last];
+		TeamMask[_index] = TeamMask[l_last];
+		DenseToSlot[_index] = DenseToSlot[l_last];
+		SlotToDense[DenseToSlot[_index]] = static_cast<unsigned int>(_index);
+	}
+
+	AliveTick.pop_back();
+	OriginPos_X.pop_back();
+	OriginPos_Y.pop_back();
+	Angle.pop_back();
+	Speed.pop_back();
+	TeamMask.pop_back();
+	DenseToSlot.pop_back();
+
+	SlotToDense[l_slot] = MAD_BULLET_INVALID_INDEX;
+	SlotGeneration[l_slot]++;
+	FreeSlots.push_back(l_slot);
+}
+
+/**
+ * 一次销毁一组子弹,存活的子弹保持原有的相对顺序,所有数组只做一遍分段memmove压缩。
+ *
+ * @param _indices 要销毁的子弹的密集索引,必须严格升序且小于GetNum()
+ * @param _num 索引数量
+ */
+void MADFixedBulletPool::KillBatch(const unsigned int* _indices, size_t _num)
+{
+	if (_num == 0)
+	{
+		return;
+	}
+	for (size_t k = 0; k < _num; ++k)
+	{
+		unsigned int l_slot = DenseToSlot[_indices[k]];
+		SlotToDense[l_slot] = MAD_BULLET_INVALID_INDEX;
+		SlotGeneration[l_slot]++;
+		FreeSlots.push_back(l_slot);
+	}
+	CompactArray(AliveTick, _indices, _num);
+	CompactArray(OriginPos_X, _indices, _num);
+	CompactArray(OriginPos_Y, _indices, _num);
+	CompactArray(Angle, _indices, _num);
+	CompactArray(Speed, _indices, _num);
+	CompactArray(TeamMask, _indices, _num);
+	CompactArray(DenseToSlot, _indices, _num);
+
+	for (size_t i = _indices[0]; i < DenseToSlot.size(); ++i)
+	{
+		SlotToDense[DenseToSlot[i]] = static_cast<unsigned int>(i);
+	}
+}
+
+/**
+ * 清空子弹池。
+ * 所有已发出的句柄都会失效,但已分配的容量会被保留。
+ */
+void MADFixedBulletPool::Clear()
+{
+	while (!AliveTick.empty())
+	{
+		KillAt(AliveTick.size() - 1);
+	}
+}
+
+/**
+ * 预留至少能容纳 _capacity 颗子弹的容量。
+ *
+ * @param _capacity 期望的子弹容量
+ */
+void MADFixedBulletPool::Reserve(size_t _capacity)
+{
+	AliveTick.reserve(_capacity);
+	OriginPos_X.reserve(_capacity);
+	OriginPos_Y.reserve(_capacity);
+	Angle.reserve(_capacity);
+	Speed.reserve(_capacity);
+	TeamMask.reserve(_capacity);
+	DenseToSlot.reserve(_capacity);
+	SlotToDense.reserve(_capacity);
+	SlotGeneration.reserve(_capacity);
+	FreeSlots.reserve(_capacity);
+}
+
+/**
+ * 获取存活子弹的数量。
+ *
+ * @return 存活子弹数量
+ */
+size_t MADFixedBulletPool::GetNum() const
+{
+	return AliveTick.size();
+}
+
+/**
+ * 获取当前无需扩容即可容纳的子弹数量。
+ *
+ * @return 子弹容量
+ */
+size_t MADFixedBulletPool::GetCapacity() const
+{
+	return AliveTick.capacity();
+}
+
+/**
+ * 查看子弹池是否为空。
+ *
+ * @return 子弹池是否为空
+ */
+bool MADFixedBulletPool::Is_Empty() const
+{
+	return AliveTick.empty();
+}
+
+/**
+ * 检查句柄是否仍指向一颗存活的子弹。
+ *
+ * @param _handle 要检查的子弹句柄
+ * @return 句柄有效时返回true
+ */
+bool MADFixedBulletPool::IsAlive(MADBulletHandle _handle) const
+{
+	return GetIndex(_handle) != MAD_BULLET_INVALID_INDEX;
+}
+
+/**
+ * 将句柄转换为当前的密集索引,仅可在下一次Spawn/Kill之前使用。
+ *
+ * @param _handle 子弹句柄
+ * @return 子弹的密集索引;句柄失效时返回MAD_BULLET_INVALID_INDEX。
+ */
+size_t MADFixedBulletPool::GetIndex(MADBulletHandle _handle) const
+{
+	if (_handle.Index >= SlotToDense.size() || SlotGeneration[_handle.Index] != _handle.Generation)
+	{
+		return MAD_BULLET_INVALID_INDEX;
+	}
+	return SlotToDense[_handle.Index];
+}
+
+/**
+ * 获取指定密集索引处子弹的句柄。
+ *
+ * @param _index 子弹的密集索引,必须小于GetNum()
+ * @return 该子弹的句柄
+ */
+MADBulletHandle MADFixedBulletPool::GetHandle(size_t _index) const
+{
+	unsigned int l_slot = DenseToSlot[_index];
+	return MADBulletHandle(l_slot, SlotGeneration[l_slot]);
+}
+
+/**
+ * 通过句柄读取子弹数据。
+ *
+ * @param _handle 子弹句柄
+ * @param[out] out_info 接收子弹数据的指针
+ * @return 句柄有效时返回true;句柄失效时返回false且不修改out_info。
+ */
+bool MADFixedBulletPool::GetInfo(MADBulletHandle _handle, MADFixedBulletInfo* out_info) const
+{
+	size_t l_index = GetIndex(_handle);
+	if (l_index == MAD_BULLET_INVALID_INDEX || out_info == nullptr)
+	{
+		return false;
+	}
+	*out_info = GetInfoAt(l_index);
+	return true;
+}
+
+/**
+ * 将指定密集索引处的子弹重新组装为MADFixedBulletInfo。
+ *
+ * @param _index 子弹的密集索引,必须小于GetNum()
+ * @return 子弹数据的副本
+ */
+MADFixedBulletInfo MADFixedBulletPool::GetInfoAt(size_t _index) const
+{
+	MADFixedBulletInfo l_info(OriginPos_X[_index], OriginPos_Y[_index], Angle[_index], Speed[_index], TeamMask[_index]);
+	l_info.AliveTick = AliveTick[_index];
+	return l_info;
+}
+
+/**
+ * 通过句柄覆盖子弹数据,例如转向或变速。
+ *
+ * @param _handle 子弹句柄
+ * @param _info 新的子弹数据
+ * @return 句柄有效时返回true
+ */
+bool MADFixedBulletPool::SetInfo(MADBulletHandle _handle, const MADFixedBulletInfo& _info)
+{
+	size_t l_index = GetIndex(_handle);
+	if (l_index == MAD_BULLET_INVALID_INDEX)
+	{
+		return false;
+	}
+	AliveTick[l_index] = _info.AliveTick;
+	OriginPos_X[l_index] = _info.OriginPos_X;
+	OriginPos_Y[l_index] = _info.OriginPos_Y;
+	Angle[l_index] = _info.Angle;
+	Speed[l_index] = _info.Speed;
+	TeamMask[l_index] = _info.TeamMask;
+	return true;
+}
+
+/*Raw arrays*/
+unsigned int* MADFixedBulletPool::GetAliveTickData() { return AliveTick.data(); }
+int* MADFixedBulletPool::GetPositionXData() { return OriginPos_X.data(); }
+int* MADFixedBulletPool::GetPositionYData() { return OriginPos_Y.data(); }
+unsigned short* MADFixedBulletPool::GetAngleData() { return Angle.data(); }
+short* MADFixedBulletPool::GetSpeedData() { return Speed.data(); }
+long long* MADFixedBulletPool::GetTeamMaskData() { return TeamMask.data(); }
+const unsigned int* MADFixedBulletPool::GetAliveTickData() const { return AliveTick.data(); }
+const int* MADFixedBulletPool::GetPositionXData() const { return OriginPos_X.data(); }
+const int* MADFixedBulletPool::GetPositionYData() const { return OriginPos_Y.data(); }
+const unsigned short* MADFixedBulletPool::GetAngleData() const { return Angle.data(); }
+const short* MADFixedBulletPool::GetSpeedData() const { return Speed.data(); }
+const long long* MADFixedBulletPool::GetTeamMaskData() const { return TeamMask.data(); }
+
+/**
+ * 将所有存活子弹前进一个tick,并可选地在同一次遍历中写出定点刷新数据。
+ * 计算由MADBulletKernel::IntegrateFixed完成,传入调度器时按MAD_BULLET_JOB_GRAIN切分到多个线程,结果与单线程逐位一致。
+ *
+ * @param[out] out_res 可选的刷新数据输出,至少能容纳GetNum()条记录;传入nullptr则不输出
+ * @param _jobs 可选的任务调度器,传入nullptr则在当前线程执行
+ */
+void MADFixedBulletPool::Step(MADFixedFlushResData* out_res, MADJobSystem* _jobs)
+{
+	int* l_px = OriginPos_X.data();
+	int* l_py = OriginPos_Y.data();
+	const unsigned short* l_angle = Angle.data();
+	const short* l_speed = Speed.data();
+	unsigned int* l_alive = AliveTick.data();
+	MADJobSystem::Dispatch(_jobs, AliveTick.size(), MAD_BULLET_JOB_GRAIN, [=](size_t _begin, size_t _end, size_t) {
+		MADBulletKernel::IntegrateFixed(l_px + _begin, l_py + _begin, l_angle + _begin, l_speed + _begin, l_alive + _begin,
+			_end - _begin, out_res != nullptr ? out_res + _begin : nullptr);
+	});
+}
+
+/**
+ * 将所有存活子弹前进一个tick,并把定点刷新数据写入 out_res。
+ *
+ * @param[out] out_res 接收输出的数组,原有内容会被覆盖
+ * @param _jobs 可选的任务调度器,传入nullptr则在当前线程执行
+ */
+void MADFixedBulletPool::Step(std::vector<MADFixedFlushResData>& out_res, MADJobSystem* _jobs)
+{
+	out_res.resize(AliveTick.size());
+	Step(out_res.data(), _jobs);
+}
+
+/**
+ * 销毁位于定点矩形 [_min, _max] 之外的子弹,存活的子弹保持原有顺序。
+ *
+ * @param _min_x 边界左侧(16.16)
+ * @param _min_y 边界下侧(16.16)
+ * @param _max_x 边界右侧(16.16)
+ * @param _max_y 边界上侧(16.16)
+ * @return 被销毁的子弹数量
+ */
+size_t MADFixedBulletPool::ApplyBoundary(int _min_x, int _min_y, int _max_x, int _max_y)
+{
+	size_t l_num = AliveTick.size();
+	if (l_num == 0)
+	{
+		return 0;
+	}
+	BatchIndex.resize(l_num);
+	size_t l_kill = MADBulletKernel::FindOutsideFixed(OriginPos_X.data(), OriginPos_Y.data(), l_num,
+		_min_x, _min_y, _max_x, _max_y, BatchIndex.data());
+	KillBatch(BatchIndex.data(), l_kill);
+	return l_kill;
+}
+
+/**
+ * 找出与圆心距离不超过 _radius 且TeamMask与 _mask 相交的子弹,例如判定玩家中弹。
+ * 距离按MADBulletKernel::OverlapCircleFixed的规则以整数比较,判定半径最大为127.99单位。
+ *
+ * @param _center_x 圆心X(16.16)
+ * @param _center_y 圆心Y(16.16)
+ * @param _radius 判定半径(16.16)
+ * @param _mask 实体的TeamMask
+ * @param[out] out_index 命中子弹的密集索引(升序),原有内容会被覆盖
+ * @return 命中子弹的数量
+ */
+size_t MADFixedBulletPool::QueryCircle(int _center_x, int _center_y, int _radius, long long _mask,
+	std::vector<unsigned int>& out_index) const
+{
+	out_index.resize(AliveTick.size());
+	size_t l_hit = MADBulletKernel::OverlapCircleFixed(OriginPos_X.data(), OriginPos_Y.data(), TeamMask.data(),
+		AliveTick.size(), _center_x, _center_y, _radius, _mask, out_index.data());
+	out_index.resize(l_hit);
+	return l_hit;
+}
+
+/**
+ * 将所有存活子弹按密集索引顺序输出为定点刷新数据。
+ *
+ * @param[out] out_res 接收输出的数组,原有内容会被覆盖
+ */
+void MADFixedBulletPool::Flush(std::vector<MADFixedFlushResData>& out_res) const
+{
+	size_t l_num = AliveTick.size();
+	out_res.resize(l_num);
+	for (size_t i = 0; i < l_num; ++i)
+	{
+		out_res[i].Position_X = OriginPos_X[i];
+		out_res[i].Position_Y = OriginPos_Y[i];
+		out_res[i].Angle = Angle[i];
+		out_res[i].Speed = Speed[i];
+	}
+}
+
+/**
+ * 将所有存活子弹转换为浮点的MADBulletFlushResData,供沿用浮点格式的渲染端使用。
+ *
+ * @param[out] out_res 接收输出的数组,原有内容会被覆盖
+ * @param _tick_rate 每秒的tick数,用于把每tick的位移换算为速度(单位/秒)
+ * @param _jobs 可选的任务调度器,传入nullptr则在当前线程执行
+ */
+void MADFixedBulletPool::Flush(std::vector<MADBulletFlushResData>& out_res, float _tick_rate, MADJobSystem* _jobs) const
+{
+	out_res.resize(AliveTick.size());
+	const int* l_px = OriginPos_X.data();
+	const int* l_py = OriginPos_Y.data();
+	const unsigned short* l_angle = Angle.data();
+	const short* l_speed = Speed.data();
+	MADBulletFlushResData* l_out = out_res.data();
+	MADJobSystem::Dispatch(_jobs, AliveTick.size(), MAD_BULLET_JOB_GRAIN, [=](size_t _begin, size_t _end, size_t) {
+		MADBulletKernel::UnpackFixed(l_px + _begin, l_py + _begin, l_angle + _begin, l_speed + _begin,
+			_end - _begin, _tick_rate, l_out + _begin);
+	});
+}
+
+/**
+ * 把子弹池的全部状态追加到 out_data 末尾,格式与MADBulletPool::Snapshot相同,按数组整体复制。
+ *
+ * @param out_data 输出缓冲区,数据追加在已有内容之后
+ * @return 写入的字节数
+ */
+size_t MADFixedBulletPool::Snapshot(std::vector<unsigned char>& out_data) const
+{
+	size_t l_begin = out_data.size();
+	MADBlobWriter l_writer(out_data);
+	size_t l_reserve = (AliveTick.size() / MAD_BULLET_SNAPSHOT_GRAIN + 1) * MAD_BULLET_SNAPSHOT_GRAIN;
+	size_t l_slot_reserve = (SlotToDense.size() / MAD_BULLET_SNAPSHOT_GRAIN + 1) * MAD_BULLET_SNAPSHOT_GRAIN;
+	l_writer.Write(MAD_FIXED_POOL_SNAPSHOT_TAG);
+	l_writer.Write(0u);
+	l_writer.WriteArray(AliveTick, l_reserve);
+	l_writer.WriteArray(OriginPos_X, l_reserve);
+	l_writer.WriteArray(OriginPos_Y, l_reserve);
+	l_writer.WriteArray(Angle, l_reserve);
+	l_writer.WriteArray(Speed, l_reserve);
+	l_writer.WriteArray(TeamMask, l_reserve);
+	l_writer.WriteArray(DenseToSlot, l_reserve);
+	l_writer.WriteArray(SlotToDense, l_slot_reserve);
+	l_writer.WriteArray(SlotGeneration, l_slot_reserve);
+	l_writer.WriteArray(FreeSlots, l_slot_reserve);
+	return out_data.size() - l_begin;
+}
+
+/**
+ * 从快照中恢复子弹池的全部状态,已有数组的容量会被复用。
+ * 快照数据损坏或不完整时子弹池被清空。
+ *
+ * @param io_reader 指向一份由Snapshot写入的数据,读取后前进到该数据之后
+ * @return 成功时返回true
+ */
+bool MADFixedBulletPool::Restore(MADBlobReader& io_reader)
+{
+	unsigned int l_tag = 0;
+	unsigned int l_reserved = 0;
+	io_reader.Read(&l_tag);
+	io_reader.Read(&l_reserved);
+	io_reader.ReadArray(AliveTick);
+	io_reader.ReadArray(OriginPos_X);
+	io_reader.ReadArray(OriginPos_Y);
+	io_reader.ReadArray(Angle);
+	io_reader.ReadArray(Speed);
+	io_reader.ReadArray(TeamMask);
+	io_reader.ReadArray(DenseToSlot);
+	io_reader.ReadArray(SlotToDense);
+	io_reader.ReadArray(SlotGeneration);
+	io_reader.ReadArray(FreeSlots);
+
+	/*Every per-bullet array must agree on the bullet count*/
+	size_t l_num = AliveTick.size();
+	bool l_valid = !io_reader.IsFailed() && l_tag == MAD_FIXED_POOL_SNAPSHOT_TAG &&
+		OriginPos_X.size() == l_num && OriginPos_Y.size() == l_num && Angle.size() == l_num && Speed.size() == l_num &&
+		TeamMask.size() == l_num && DenseToSlot.size() == l_num && SlotToDense.size() == SlotGeneration.size();
+	for (size_t i = 0; l_valid && i < l_num; ++i)
+	{
+		l_valid = DenseToSlot[i] < SlotToDense.size() && SlotToDense[DenseToSlot[i]] == i;
+	}
+
+	/*Every slot without a bullet is free exactly once*/
+	l_valid = l_valid && l_num + FreeSlots.size() == SlotToDense.size();
+	for (size_t i = 0; l_valid && i < FreeSlots.size(); ++i)
+	{
+		unsigned int l_slot = FreeSlots[i];
+		l_valid = l_slot < SlotToDense.size() && SlotToDense[l_slot] == MAD_BULLET_INVALID_INDEX;
+		if (l_valid)
+		{
+			/*Mark the slot so a repeated free slot fails the check above*/
+			SlotToDense[l_slot] = MAD_BULLET_INVALID_INDEX - 1;
+		}
+	}
+	for (size_t i = 0; l_valid && i < FreeSlots.size(); ++i)
+	{
+		SlotToDense[FreeSlots[i]] = MAD_BULLET_INVALID_INDEX;
+	}
+	if (!l_valid)
+	{
+		MAD_LOG_ERR("Try to restore a fixed-point bullet pool from a broken snapshot!");
+		AliveTick.clear();
+		OriginPos_X.clear();
+		OriginPos_Y.clear();
+		Angle.clear();
+		Speed.clear();
+		TeamMask.clear();
+		DenseToSlot.clear();
+		SlotToDense.clear();
+		SlotGeneration.clear();
+		FreeSlots.clear();
+		return false;
+	}
+	return true;
+}
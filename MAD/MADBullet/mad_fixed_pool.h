@@ -0,0 +1,102 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "mad_bullet_pool.h"
+
+/*Tag written at the start of a fixed-point pool snapshot*/
+#define MAD_FIXED_POOL_SNAPSHOT_TAG 0x44584946u
+
+/**
+ * MADFixedBulletPool 是以定点数储存子弹的SoA容器,是MADBulletPool的替代选择,用于需要逐位可复现的模式(录像校验、联机同步)。
+ *
+ * 与MADBulletPool的区别:
+ * - 位置为16.16定点数,方向为16位角度索引,速率为8.8定点数(单位/tick),存活时间以tick计;
+ * - 每颗子弹约占28字节(位置8、角度与速率4、存活tick 4、TeamMask 8、句柄映射4),约为MADBulletPool的一半;
+ * - 模拟、越界与碰撞只使用整数运算(见MADBulletKernel中以Fixed结尾的内核),
+ *   结果与编译器、优化等级和SIMD路径无关,不需要严格浮点设置就能在所有平台上逐位一致;
+ * - 以固定的tick推进,不支持可变 _dt,也不支持参数化运动与子弹组;转向、变速等通过SetInfo修改角度与速率。
+ *
+ * 句柄、swap-remove与批量销毁的语义与MADBulletPool相同,MADBulletHandle在两种子弹池之间通用(但不能混用)。
+ * 浮点只出现在输入(MADFixed::FromFloat等)与输出(Flush)处。
+ *
+ * 注意:该类是线程不安全的!
+ */
+class MADFixedBulletPool
+{
+public:
+	MADFixedBulletPool();
+	~MADFixedBulletPool();
+
+public:
+	/*Bullet operator*/
+	MADBulletHandle Spawn(const MADFixedBulletInfo& _info);
+	bool Kill(MADBulletHandle _handle);
+	void KillAt(size_t _index);
+	void KillBatch(const unsigned int* _indices, size_t _num);
+	void Clear();
+	void Reserve(size_t _capacity);
+
+	/*Get Data*/
+	size_t GetNum() const;
+	size_t GetCapacity() const;
+	bool Is_Empty() const;
+	bool IsAlive(MADBulletHandle _handle) const;
+	size_t GetIndex(MADBulletHandle _handle) const;
+	MADBulletHandle GetHandle(size_t _index) const;
+	bool GetInfo(MADBulletHandle _handle, MADFixedBulletInfo* out_info) const;
+	MADFixedBulletInfo GetInfoAt(size_t _index) const;
+	bool SetInfo(MADBulletHandle _handle, const MADFixedBulletInfo& _info);
+
+	/*Raw arrays,valid until the next Spawn/Kill/Clear*/
+	unsigned int* GetAliveTickData();
+	int* GetPositionXData();
+	int* GetPositionYData();
+	unsigned short* GetAngleData();
+	short* GetSpeedData();
+	long long* GetTeamMaskData();
+	const unsigned int* GetAliveTickData() const;
+	const int* GetPositionXData() const;
+	const int* GetPositionYData() const;
+	const unsigned short* GetAngleData() const;
+	const short* GetSpeedData() const;
+	const long long* GetTeamMaskData() const;
+
+	/*Simulate*/
+	void Step(MADFixedFlushResData* out_res = nullptr, MADJobSystem* _jobs = nullptr);
+	void Step(std::vector<MADFixedFlushResData>& out_res, MADJobSystem* _jobs = nullptr);
+	size_t ApplyBoundary(int _min_x, int _min_y, int _max_x, int _max_y);
+	size_t QueryCircle(int _center_x, int _center_y, int _radius, long long _mask, std::vector<unsigned int>& out_index) const;
+
+	/*Flush*/
+	void Flush(std::vector<MADFixedFlushResData>& out_res) const;
+	void Flush(std::vector<MADBulletFlushResData>& out_res, float _tick_rate, MADJobSystem* _jobs = nullptr) const;
+
+	/*Snapshot*/
+	size_t Snapshot(std::vector<unsigned char>& out_data) const;
+	bool Restore(MADBlobReader& io_reader);
+
+private:
+	/*Bullet Data (SoA)*/
+	std::vector<unsigned int> AliveTick;
+	std::vector<int> OriginPos_X;
+	std::vector<int> OriginPos_Y;
+	std::vector<unsigned short> Angle;
+	std::vector<short> Speed;
+	std::vector<long long> TeamMask;
+
+	/*Handle Data*/
+	std::vector<unsigned int> DenseToSlot;
+	std::vector<unsigned int> SlotToDense;
+	std::vector<unsigned int> SlotGeneration;
+	std::vector<unsigned int> FreeSlots;
+
+	/*Scratch indices for batch passes*/
+	std::vector<unsigned int> BatchIndex;
+};
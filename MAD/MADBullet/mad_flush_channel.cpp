@@ -0,0 +1,110 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_flush_channel.h"
+
+/**
+ * 构造一个空的刷新通道,缓冲区在第一次写入时才分配。
+ */
+MADFlushChannel::MADFlushChannel()
+{
+	WriteIndex = 0;
+	MiddleIndex.store(1, std::memory_order_relaxed);
+	ReadIndex = 2;
+}
+
+/**
+ * MADFlushChannel析构函数。
+ * 请保证销毁时读写两端都已停止使用本通道。
+ */
+MADFlushChannel::~MADFlushChannel()
+{
+}
+
+/**
+ * (写线程)
+ * 获取写端缓冲区,保证至少能容纳 _num 条记录。
+ * 容量不足时按倍数扩容,之后容量只增不减。
+ *
+ * @param _num 本帧要写入的记录数量
+ * @return 写端缓冲区首地址,在EndWrite之前一直有效
+ */
+MADBulletFlushResData* MADFlushChannel::BeginWrite(size_t _num)
+{
+	std::vector<MADBulletFlushResData>& l_data = Buffers[WriteIndex].Data;
+	if (_num > l_data.size())
+	{
+		size_t l_size = l_data.size() * 2;
+		l_data.resize(l_size > _num ? l_size : _num);
+	}
+	return l_data.data();
+}
+
+/**
+ * (写线程)
+ * 发布写端缓冲区中已写好的一帧,并换回一个空闲的缓冲区继续写入。
+ *
+ * @param _num 实际写入的记录数量,不能超过BeginWrite时请求的数量
+ * @param _tick 本帧的tick序号
+ */
+void MADFlushChannel::EndWrite(size_t _num, unsigned long long _tick)
+{
+	Buffers[WriteIndex].Num = _num;
+	Buffers[WriteIndex].Tick = _tick;
+	Buffers[WriteIndex].Published = true;
+	unsigned int l_old = MiddleIndex.exchange(WriteIndex | MAD_FLUSH_CHANNEL_FRESH, std::memory_order_acq_rel);
+	WriteIndex = l_old & ~MAD_FLUSH_CHANNEL_FRESH;
+}
+
+/**
+ * (写线程)
+ * 将子弹池的刷新数据写入通道并立即发布。
+ *
+ * @param _pool 子弹池
+ * @param _tick 本帧的tick序号
+ */
+void MADFlushChannel::Publish(const MADBulletPool& _pool, unsigned long long _tick)
+{
+	size_t l_num = _pool.GetNum();
+	MADBulletFlushResData* l_data = BeginWrite(l_num);
+	EndWrite(_pool.Flush(l_data, l_num), _tick);
+}
+
+/**
+ * (读线程)
+ * 取得最新的完整帧。若自上次调用以来没有新的帧,则返回与上次相同的帧。
+ *
+ * @return 最新一帧的只读视图,在下一次Acquire之前有效
+ */
+MADFlushFrame MADFlushChannel::Acquire()
+{
+	if ((MiddleIndex.load(std::memory_order_relaxed) & MAD_FLUSH_CHANNEL_FRESH) != 0)
+	{
+		unsigned int l_old = MiddleIndex.exchange(ReadIndex, std::memory_order_acq_rel);
+		ReadIndex = l_old & ~MAD_FLUSH_CHANNEL_FRESH;
+	}
+
+	MADFlushFrame l_frame;
+	const FlushBuffer& l_buffer = Buffers[ReadIndex];
+	if (l_buffer.Published)
+	{
+		l_frame.Data = l_buffer.Data.data();
+		l_frame.Num = l_buffer.Num;
+		l_frame.Tick = l_buffer.Tick;
+	}
+	return l_frame;
+}
+
+/**
+ * (读线程)
+ * 查看是否有尚未取走的新帧。
+ *
+ * @return 有新帧时返回true
+ */
+bool MADFlushChannel::HasNewFrame() const
+{
+	return (MiddleIndex.load(std::memory_order_acquire) & MAD_FLUSH_CHANNEL_FRESH) != 0;
+}
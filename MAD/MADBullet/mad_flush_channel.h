@@ -0,0 +1,90 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "mad_bullet_pool.h"
+
+/*Flag bit in the shared index,set while the middle buffer holds a frame the reader has not taken*/
+#define MAD_FLUSH_CHANNEL_FRESH 0x4u
+
+/**
+ * \brief MADFlushFrame 是渲染线程取得的一帧刷新数据的只读视图。
+ *
+ * Data 指向通道内部的缓冲区,在下一次Acquire之前一直有效,期间模拟线程不会写入它。
+ * Tick 为发布时传入的tick序号,Num 为0且Data为nullptr表示尚未发布过任何一帧。
+ */
+struct MADFlushFrame {
+	const MADBulletFlushResData* Data;
+	size_t Num;
+	unsigned long long Tick;
+
+	MADFlushFrame() {
+		Data = nullptr;
+		Num = 0;
+		Tick = 0;
+	}
+};
+
+/**
+ * MADFlushChannel 是模拟线程与渲染线程之间的无锁三缓冲刷新通道。
+ *
+ * 三个缓冲区分别由写端(模拟线程)、读端(渲染线程)与中间交换位持有:
+ * - 写端写满自己的缓冲区后调用EndWrite,用一次原子交换把它放到中间位,并取回中间位原来的缓冲区;
+ * - 读端调用Acquire时,若中间位有新的完整帧,则用一次原子交换取走它,否则继续使用当前帧;
+ * - 两端都不会等待对方,读端总是拿到最新的完整帧,没来得及读的旧帧会被直接覆盖。
+ *
+ * 缓冲区容量按倍数增长且从不收缩,子弹数量稳定后每帧不再分配内存。
+ *
+ * 注意:
+ * - 只支持一个写线程与一个读线程。
+ * - BeginWrite/EndWrite/Publish只能在写线程调用,Acquire只能在读线程调用。
+ */
+class MADFlushChannel
+{
+public:
+	MADFlushChannel();
+	~MADFlushChannel();
+
+	MADFlushChannel(const MADFlushChannel&) = delete;
+	MADFlushChannel& operator=(const MADFlushChannel&) = delete;
+
+private:
+	typedef struct FlushBuffer
+	{
+		std::vector<MADBulletFlushResData> Data;
+		size_t Num = 0;
+		unsigned long long Tick = 0;
+		bool Published = false;
+	}FlushBuffer;
+
+public:
+	/*Writer*/
+	MADBulletFlushResData* BeginWrite(size_t _num);
+	void EndWrite(size_t _num, unsigned long long _tick);
+	void Publish(const MADBulletPool& _pool, unsigned long long _tick);
+
+	/*Reader*/
+	MADFlushFrame Acquire();
+	bool HasNewFrame() const;
+
+private:
+	FlushBuffer Buffers[3];
+
+	/*Owned by the writer*/
+	unsigned int WriteIndex;
+	char WriterPadding[64];
+
+	/*Shared between both threads*/
+	std::atomic<unsigned int> MiddleIndex;
+	char SharedPadding[64];
+
+	/*Owned by the reader*/
+	unsigned int ReadIndex;
+};
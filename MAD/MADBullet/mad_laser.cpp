@@ -0,0 +1,707 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_laser.h"
+#include "../MADBase/mad_fp_strict.h"
+
+#include <cmath>
+
+/**
+ * (内部函数)
+ * 计算从 (_x0, _y0) 指向 (_x1, _y1) 的单位法向量(方向逆时针旋转90度),两点重合时取 (0, 1)。
+ */
+static void GetNormal(float _x0, float _y0, float _x1, float _y1, float* out_nx, float* out_ny)
+{
+	float l_dx = _x1 - _x0;
+	float l_dy = _y1 - _y0;
+	float l_length = std::sqrt(l_dx * l_dx + l_dy * l_dy);
+	if (!(l_length > 0.0f))
+	{
+		*out_nx = 0.0f;
+		*out_ny = 1.0f;
+		return;
+	}
+	*out_nx = -l_dy / l_length;
+	*out_ny = l_dx / l_length;
+}
+
+/**
+ * (内部函数)
+ * 向顶点数组追加一个条带顶点。
+ */
+static void PushVertex(std::vector<MADLaserVertex>& out_vertices, float _x, float _y, float _u, float _v)
+{
+	MADLaserVertex l_vertex;
+	l_vertex.X = _x;
+	l_vertex.Y = _y;
+	l_vertex.U = _u;
+	l_vertex.V = _v;
+	out_vertices.push_back(l_vertex);
+}
+
+/**
+ * 构造一个空的直线激光池。
+ */
+MADLaserPool::MADLaserPool()
+{
+}
+
+/**
+ * MADLaserPool析构函数。
+ */
+MADLaserPool::~MADLaserPool()
+{
+}
+
+/**
+ * 生成一条直线激光。
+ *
+ * @param _info 激光数据
+ * @return 新激光的句柄
+ */
+MADBulletHandle MADLaserPool::Spawn(const MADLaserInfo& _info)
+{
+	unsigned int l_dense = static_cast<unsigned int>(Start_X.size());
+	unsigned int l_slot;
+	if (!FreeSlots.empty())
+	{
+		l_slot = FreeSlots.back();
+		FreeSlots.pop_back();
+		SlotToDense[l_slot] = l_dense;
+	}
+	else
+	{
+		l_slot = static_cast<unsigned int>(SlotToDense.size());
+		SlotToDense.push_back(l_dense);
+		SlotGeneration.push_back(0);
+	}
+
+	Start_X.push_back(_info.Start.x);
+	Start_Y.push_back(_info.Start.y);
+	End_X.push_back(_info.End.x);
+	End_Y.push_back(_info.End.y);
+	Radius.push_back(_info.Radius);
+	TeamMask.push_back(_info.TeamMask);
+	DenseToSlot.push_back(l_slot);
+	return MADBulletHandle(l_slot, SlotGeneration[l_slot]);
+}
+
+/**
+ * 销毁一条激光,末尾的激光会被交换到空位。
+ *
+ * @param _handle 激光句柄
+ * @return 句柄有效时返回true
+ */
+bool MADLaserPool::Kill(MADBulletHandle _handle)
+{
+	size_t l_index = GetIndex(_handle);
+	if (l_index == MAD_BULLET_INVALID_INDEX)
+	{
+		return false;
+	}
+	unsigned int l_slot = DenseToSlot[l_index];
+	SlotToDense[l_slot] = MAD_BULLET_INVALID_INDEX;
+	SlotGeneration[l_slot]++;
+	FreeSlots.push_back(l_slot);
+
+	size_t l_last = Start_X.size() - 1;
+	if (l_index != l_last)
+	{
+		Start_X[l_index] = Start_X[l_last];
+		Start_Y[l_index] = Start_Y[l_last];
+		End_X[l_index] = End_X[l_last];
+		End_Y[l_index] = End_Y[l_last];
+		Radius[l_index] = Radius[l_last];
+		TeamMask[l_index] = TeamMask[l_last];
+		DenseToSlot[l_index] = DenseToSlot[l_last];
+		SlotToDense[DenseToSlot[l_index]] = static_cast<unsigned int>(l_index);
+	}
+	Start_X.pop_back();
+	Start_Y.pop_back();
+	End_X.pop_back();
+	End_Y.pop_back();
+	Radius.pop_back();
+	TeamMask.pop_back();
+	DenseToSlot.pop_back();
+	return true;
+}
+
+/**
+ * 销毁所有激光,已发出的句柄全部失效。
+ */
+void MADLaserPool::Clear()
+{
+	while (!DenseToSlot.empty())
+	{
+		Kill(GetHandle(DenseToSlot.size() - 1));
+	}
+}
+
+/**
+ * 获取存活激光的数量。
+ *
+ * @return 激光数量
+ */
+size_t MADLaserPool::GetNum() const
+{
+	return Start_X.size();
+}
+
+/**
+ * 检查句柄是否仍然有效。
+ *
+ * @param _handle 激光句柄
+ * @return 激光存活时返回true
+ */
+bool MADLaserPool::IsAlive(MADBulletHandle _handle) const
+{
+	return GetIndex(_handle) != MAD_BULLET_INVALID_INDEX;
+}
+
+/**
+ * 将句柄转换为当前的密集索引,仅可在下一次Spawn/Kill之前使用。
+ *
+ * @param _handle 激光句柄
+ * @return 密集索引;句柄失效时返回MAD_BULLET_INVALID_INDEX。
+ */
+size_t MADLaserPool::GetIndex(MADBulletHandle _handle) const
+{
+	if (_handle.Index >= SlotToDense.size() || SlotGeneration[_handle.Index] != _handle.Generation)
+	{
+		return MAD_BULLET_INVALID_INDEX;
+	}
+	return SlotToDense[_handle.Index];
+}
+
+/**
+ * 获取指定密集索引处激光的句柄。
+ *
+ * @param _index 密集索引,必须小于GetNum()
+ * @return 该激光的句柄
+ */
+MADBulletHandle MADLaserPool::GetHandle(size_t _index) const
+{
+	unsigned int l_slot = DenseToSlot[_index];
+	return MADBulletHandle(l_slot, SlotGeneration[l_slot]);
+}
+
+/**
+ * 通过句柄读取激光数据。
+ *
+ * @param _handle 激光句柄
+ * @param[out] out_info 接收激光数据的指针
+ * @return 句柄有效时返回true;句柄失效时返回false且不修改out_info。
+ */
+bool MADLaserPool::GetInfo(MADBulletHandle _handle, MADLaserInfo* out_info) const
+{
+	size_t l_index = GetIndex(_handle);
+	if (l_index == MAD_BULLET_INVALID_INDEX)
+	{
+		return false;
+	}
+	out_info->Start = MADVector2DF(Start_X[l_index], Start_Y[l_index]);
+	out_info->End = MADVector2DF(End_X[l_index], End_Y[l_index]);
+	out_info->Radius = Radius[l_index];
+	out_info->TeamMask = TeamMask[l_index];
+	return true;
+}
+
+/**
+ * 通过句柄修改激光数据,例如每帧更新激光的起点与朝向。
+ *
+ * @param _handle 激光句柄
+ * @param _info 新的激光数据
+ * @return 句柄有效时返回true
+ */
+bool MADLaserPool::SetInfo(MADBulletHandle _handle, const MADLaserInfo& _info)
+{
+	size_t l_index = GetIndex(_handle);
+	if (l_index == MAD_BULLET_INVALID_INDEX)
+	{
+		return false;
+	}
+	Start_X[l_index] = _info.Start.x;
+	Start_Y[l_index] = _info.Start.y;
+	End_X[l_index] = _info.End.x;
+	End_Y[l_index] = _info.End.y;
+	Radius[l_index] = _info.Radius;
+	TeamMask[l_index] = _info.TeamMask;
+	return true;
+}
+
+/**
+ * 查询一组实体与所有直线激光的命中情况。
+ * 每个实体对所有激光做一次批量胶囊检测,TeamMask按位与为0的激光在同一次检测中被过滤。
+ * 命中记录先按实体下标、再按激光密集索引排列。
+ *
+ * @param _entities 实体数组
+ * @param _num 实体数量
+ * @param[out] out_hits 接收命中记录的数组,原有内容会被保留
+ * @return 本次查询新增的命中数量
+ */
+size_t MADLaserPool::Query(const MADEntity* _entities, size_t _num, std::vector<MADLaserHit>& out_hits) const
+{
+	size_t l_before = out_hits.size();
+	size_t l_laser_num = Start_X.size();
+	if (l_laser_num == 0)
+	{
+		return 0;
+	}
+	HitIndex.resize(l_laser_num);
+	for (size_t e = 0; e < _num; ++e)
+	{
+		if (_entities[e].TeamMask == 0)
+		{
+			continue;
+		}
+		size_t l_hit = MADBulletKernel::OverlapCapsule(Start_X.data(), Start_Y.data(), End_X.data(), End_Y.data(),
+			Radius.data(), TeamMask.data(), l_laser_num, _entities[e].Position.x, _entities[e].Position.y,
+			_entities[e].TestRadius, _entities[e].TeamMask, HitIndex.data());
+		for (size_t k = 0; k < l_hit; ++k)
+		{
+			out_hits.push_back(MADLaserHit(HitIndex[k], static_cast<unsigned int>(e), 0));
+		}
+	}
+	return out_hits.size() - l_before;
+}
+
+/**
+ * 将所有激光输出为条带顶点,按密集索引顺序每条激光4个顶点:
+ * 起点左侧、起点右侧、终点左侧、终点右侧,条带宽度为判定半径的两倍。
+ *
+ * @param[out] out_vertices 接收顶点的数组,结果追加在末尾
+ * @return 追加的顶点数量
+ */
+size_t MADLaserPool::Flush(std::vector<MADLaserVertex>& out_vertices) const
+{
+	size_t l_num = Start_X.size();
+	out_vertices.reserve(out_vertices.size() + l_num * 4);
+	for (size_t i = 0; i < l_num; ++i)
+	{
+		float l_nx, l_ny;
+		GetNormal(Start_X[i], Start_Y[i], End_X[i], End_Y[i], &l_nx, &l_ny);
+		l_nx *= Radius[i];
+		l_ny *= Radius[i];
+		PushVertex(out_vertices, Start_X[i] + l_nx, Start_Y[i] + l_ny, 0.0f, 0.0f);
+		PushVertex(out_vertices, Start_X[i] - l_nx, Start_Y[i] - l_ny, 0.0f, 1.0f);
+		PushVertex(out_vertices, End_X[i] + l_nx, End_Y[i] + l_ny, 1.0f, 0.0f);
+		PushVertex(out_vertices, End_X[i] - l_nx, End_Y[i] - l_ny, 1.0f, 1.0f);
+	}
+	return l_num * 4;
+}
+
+/**
+ * 把激光池的全部状态追加到 out_data 末尾,每个连续数组按内存映像整体复制。
+ *
+ * @param out_data 输出缓冲区,数据追加在已有内容之后
+ * @return 写入的字节数
+ */
+size_t MADLaserPool::Snapshot(std::vector<unsigned char>& out_data) const
+{
+	size_t l_begin = out_data.size();
+	MADBlobWriter l_writer(out_data);
+	l_writer.Write(MAD_LASER_SNAPSHOT_TAG);
+	l_writer.WriteArray(Start_X);
+	l_writer.WriteArray(Start_Y);
+	l_writer.WriteArray(End_X);
+	l_writer.WriteArray(End_Y);
+	l_writer.WriteArray(Radius);
+	l_writer.WriteArray(TeamMask);
+	l_writer.WriteArray(DenseToSlot);
+	l_writer.WriteArray(SlotToDense);
+	l_writer.WriteArray(SlotGeneration);
+	l_writer.WriteArray(FreeSlots);
+	return out_data.size() - l_begin;
+}
+
+/**
+ * 从快照中恢复激光池,保存时发出的句柄在恢复后依然有效。
+ * 快照数据损坏或不完整时激光池被清空。
+ *
+ * @param io_reader 指向一份由Snapshot写入的数据,读取后前进到该数据之后
+ * @return 成功时返回true
+ */
+bool MADLaserPool::Restore(MADBlobReader& io_reader)
+{
+	unsigned int l_tag = 0;
+	io_reader.Read(&l_tag);
+	io_reader.ReadArray(Start_X);
+	io_reader.ReadArray(Start_Y);
+	io_reader.ReadArray(End_X);
+	io_reader.ReadArray(End_Y);
+	io_reader.ReadArray(Radius);
+	io_reader.ReadArray(TeamMask);
+	io_reader.ReadArray(DenseToSlot);
+	io_reader.ReadArray(SlotToDense);
+	io_reader.ReadArray(SlotGeneration);
+	io_reader.ReadArray(FreeSlots);
+
+	/*Alive slots link both ways,every other slot is free exactly once*/
+	size_t l_num = Start_X.size();
+	size_t l_slot_num = SlotToDense.size();
+	bool l_valid = !io_reader.IsFailed() && l_tag == MAD_LASER_SNAPSHOT_TAG &&
+		Start_Y.size() == l_num && End_X.size() == l_num && End_Y.size() == l_num &&
+		Radius.size() == l_num && TeamMask.size() == l_num && DenseToSlot.size() == l_num &&
+		SlotGeneration.size() == l_slot_num && l_num + FreeSlots.size() == l_slot_num;
+	for (size_t i = 0; l_valid && i < l_num; ++i)
+	{
+		l_valid = DenseToSlot[i] < l_slot_num && SlotToDense[DenseToSlot[i]] == i;
+	}
+	for (size_t i = 0; l_valid && i < FreeSlots.size(); ++i)
+	{
+		unsigned int l_slot = FreeSlots[i];
+		l_valid = l_slot < l_slot_num && SlotToDense[l_slot] == MAD_BULLET_INVALID_INDEX;
+		if (l_valid)
+		{
+			/*Mark the slot so a repeated free slot fails the check above*/
+			SlotToDense[l_slot] = MAD_BULLET_INVALID_INDEX - 1;
+		}
+	}
+	for (size_t i = 0; l_valid && i < FreeSlots.size(); ++i)
+	{
+		SlotToDense[FreeSlots[i]] = MAD_BULLET_INVALID_INDEX;
+	}
+	if (!l_valid)
+	{
+		MAD_LOG_ERR("Try to restore a laser pool from a broken snapshot!");
+		Start_X.clear();
+		Start_Y.clear();
+		End_X.clear();
+		End_Y.clear();
+		Radius.clear();
+		TeamMask.clear();
+		DenseToSlot.clear();
+		SlotToDense.clear();
+		SlotGeneration.clear();
+		FreeSlots.clear();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * 构造一条空的曲线激光。
+ *
+ * @param _capacity 最多保留的节点数量,超出后最旧的节点被覆盖
+ * @param _radius 判定半径,实际半径还会乘以宽度曲线
+ * @param _team_mask 激光的TeamMask
+ */
+MADCurvyLaser::MADCurvyLaser(size_t _capacity, float _radius, long long _team_mask)
+{
+	if (_capacity < 2)
+	{
+		MAD_LOG_ERR("Try to create a curvy laser with less than 2 nodes!");
+		_capacity = 2;
+	}
+	Capacity = _capacity;
+	Radius = _radius;
+	TeamMask = _team_mask;
+	Node_X.assign(Capacity * 2, 0.0f);
+	Node_Y.assign(Capacity * 2, 0.0f);
+	Write = 0;
+	Count = 0;
+	RadiusDirty = true;
+	for (size_t k = 0; k < 4; ++k)
+	{
+		Bounds[k] = 0.0f;
+	}
+	BoundsDirty = true;
+}
+
+/**
+ * MADCurvyLaser析构函数。
+ */
+MADCurvyLaser::~MADCurvyLaser()
+{
+}
+
+/**
+ * 在头部追加一个节点,节点数量达到容量后最旧的节点被覆盖,为 O(1)。
+ *
+ * @param _position 新节点的位置,通常为激光头部(例如引导子弹)当前的位置
+ */
+void MADCurvyLaser::PushNode(const MADVector2DF& _position)
+{
+	Node_X[Write] = _position.x;
+	Node_Y[Write] = _position.y;
+	Node_X[Write + Capacity] = _position.x;
+	Node_Y[Write + Capacity] = _position.y;
+	Write = Write + 1 == Capacity ? 0 : Write + 1;
+	if (Count < Capacity)
+	{
+		Count++;
+		RadiusDirty = true;
+	}
+	BoundsDirty = true;
+}
+
+/**
+ * 清除所有节点,容量与宽度曲线保持不变。
+ */
+void MADCurvyLaser::Clear()
+{
+	Write = 0;
+	Count = 0;
+	RadiusDirty = true;
+	BoundsDirty = true;
+}
+
+/**
+ * 设置判定半径。
+ *
+ * @param _radius 判定半径
+ */
+void MADCurvyLaser::SetRadius(float _radius)
+{
+	Radius = _radius;
+	RadiusDirty = true;
+	BoundsDirty = true;
+}
+
+/**
+ * 获取判定半径。
+ *
+ * @return 判定半径
+ */
+float MADCurvyLaser::GetRadius() const
+{
+	return Radius;
+}
+
+/**
+ * 设置激光的TeamMask。
+ *
+ * @param _team_mask 激光的TeamMask
+ */
+void MADCurvyLaser::SetTeamMask(long long _team_mask)
+{
+	TeamMask = _team_mask;
+}
+
+/**
+ * 获取激光的TeamMask。
+ *
+ * @return 激光的TeamMask
+ */
+long long MADCurvyLaser::GetTeamMask() const
+{
+	return TeamMask;
+}
+
+/**
+ * 设置宽度曲线:从尾部到头部等间距的半径倍率采样,采样之间线性插值。
+ * 传入0个采样时恢复为恒定的倍率1。
+ *
+ * @param _samples 倍率采样数组
+ * @param _num 采样数量
+ */
+void MADCurvyLaser::SetProfile(const float* _samples, size_t _num)
+{
+	Profile.assign(_samples, _samples + _num);
+	RadiusDirty = true;
+	BoundsDirty = true;
+}
+
+/**
+ * 获取最多保留的节点数量。
+ *
+ * @return 节点容量
+ */
+size_t MADCurvyLaser::GetCapacity() const
+{
+	return Capacity;
+}
+
+/**
+ * 获取当前的节点数量。
+ *
+ * @return 节点数量
+ */
+size_t MADCurvyLaser::GetNodeNum() const
+{
+	return Count;
+}
+
+/**
+ * 获取指定的节点,0为尾部(最旧)。
+ *
+ * @param _index 节点序号,必须小于GetNodeNum()
+ * @return 节点位置
+ */
+MADVector2DF MADCurvyLaser::GetNode(size_t _index) const
+{
+	size_t l_tail = GetTail();
+	return MADVector2DF(Node_X[l_tail + _index], Node_Y[l_tail + _index]);
+}
+
+/*Raw nodes from the tail,GetNodeNum() elements are contiguous,valid until the next PushNode/Clear*/
+const float* MADCurvyLaser::GetNodeXData() const { return Node_X.data() + GetTail(); }
+const float* MADCurvyLaser::GetNodeYData() const { return Node_Y.data() + GetTail(); }
+
+/**
+ * 查询一组实体与该曲线激光的命中情况。
+ * 实体先与整条激光的包围盒比较,通过后再对所有线段做一次批量胶囊检测;
+ * 每个实体最多产生一条命中记录,Segment为最靠近尾部的命中线段。
+ *
+ * @param _entities 实体数组
+ * @param _num 实体数量
+ * @param _laser_index 写入命中记录的激光编号,用于区分多条曲线激光
+ * @param[out] out_hits 接收命中记录的数组,原有内容会被保留
+ * @return 本次查询新增的命中数量
+ */
+size_t MADCurvyLaser::Query(const MADEntity* _entities, size_t _num, unsigned int _laser_index,
+	std::vector<MADLaserHit>& out_hits) const
+{
+	if (Count == 0 || TeamMask == 0)
+	{
+		return 0;
+	}
+	UpdateRadius();
+	UpdateBounds();
+
+	/*A single node is tested as a degenerate segment*/
+	const float* l_x = GetNodeXData();
+	const float* l_y = GetNodeYData();
+	size_t l_segment_num = Count > 1 ? Count - 1 : 1;
+	const float* l_next_x = Count > 1 ? l_x + 1 : l_x;
+	const float* l_next_y = Count > 1 ? l_y + 1 : l_y;
+	const float* l_radius = Count > 1 ? SegmentRadius.data() : NodeRadius.data();
+	HitIndex.resize(l_segment_num);
+
+	size_t l_before = out_hits.size();
+	for (size_t e = 0; e < _num; ++e)
+	{
+		const MADEntity& l_entity = _entities[e];
+		if ((l_entity.TeamMask & TeamMask) == 0)
+		{
+			continue;
+		}
+		float l_ex = l_entity.Position.x;
+		float l_ey = l_entity.Position.y;
+		float l_er = l_entity.TestRadius;
+		if (l_ex + l_er < Bounds[0] || l_ey + l_er < Bounds[1] || l_ex - l_er > Bounds[2] || l_ey - l_er > Bounds[3])
+		{
+			continue;
+		}
+		size_t l_hit = MADBulletKernel::OverlapCapsule(l_x, l_y, l_next_x, l_next_y, l_radius, nullptr, l_segment_num,
+			l_ex, l_ey, l_er, l_entity.TeamMask, HitIndex.data());
+		if (l_hit != 0)
+		{
+			out_hits.push_back(MADLaserHit(_laser_index, static_cast<unsigned int>(e), HitIndex[0]));
+		}
+	}
+	return out_hits.size() - l_before;
+}
+
+/**
+ * 将激光输出为条带顶点,从尾部到头部每个节点输出左侧、右侧两个顶点。
+ * 节点处的法向取前后相邻节点连线的法向,条带宽度为该节点判定半径的两倍。
+ *
+ * @param[out] out_vertices 接收顶点的数组,结果追加在末尾
+ * @return 追加的顶点数量
+ */
+size_t MADCurvyLaser::Flush(std::vector<MADLaserVertex>& out_vertices) const
+{
+	if (Count == 0)
+	{
+		return 0;
+	}
+	UpdateRadius();
+	const float* l_x = GetNodeXData();
+	const float* l_y = GetNodeYData();
+	float l_inv_last = Count > 1 ? 1.0f / static_cast<float>(Count - 1) : 0.0f;
+	out_vertices.reserve(out_vertices.size() + Count * 2);
+	for (size_t k = 0; k < Count; ++k)
+	{
+		size_t l_prev = k > 0 ? k - 1 : 0;
+		size_t l_next = k + 1 < Count ? k + 1 : k;
+		float l_nx, l_ny;
+		GetNormal(l_x[l_prev], l_y[l_prev], l_x[l_next], l_y[l_next], &l_nx, &l_ny);
+		l_nx *= NodeRadius[k];
+		l_ny *= NodeRadius[k];
+		float l_u = static_cast<float>(k) * l_inv_last;
+		PushVertex(out_vertices, l_x[k] + l_nx, l_y[k] + l_ny, l_u, 0.0f);
+		PushVertex(out_vertices, l_x[k] - l_nx, l_y[k] - l_ny, l_u, 1.0f);
+	}
+	return Count * 2;
+}
+
+/**
+ * (内部函数)
+ * 获取尾部节点在环形缓冲区中的位置,从该位置起的Count个元素即为从尾到头的所有节点。
+ */
+size_t MADCurvyLaser::GetTail() const
+{
+	return Write >= Count ? Write - Count : Write + Capacity - Count;
+}
+
+/**
+ * (内部函数)
+ * 按宽度曲线重新计算每个节点与每段线段的判定半径。
+ * 半径只取决于节点在激光上的相对位置,因此节点数量达到容量后不再需要重新计算。
+ */
+void MADCurvyLaser::UpdateRadius() const
+{
+	if (!RadiusDirty)
+	{
+		return;
+	}
+	RadiusDirty = false;
+	NodeRadius.resize(Count);
+	SegmentRadius.resize(Count > 1 ? Count - 1 : 0);
+	for (size_t k = 0; k < Count; ++k)
+	{
+		float l_scale = 1.0f;
+		if (Profile.size() == 1)
+		{
+			l_scale = Profile[0];
+		}
+		else if (Profile.size() > 1)
+		{
+			float l_u = Count > 1 ? static_cast<float>(k) / static_cast<float>(Count - 1) : 1.0f;
+			float l_pos = l_u * static_cast<float>(Profile.size() - 1);
+			size_t l_sample = static_cast<size_t>(l_pos);
+			l_sample = l_sample + 1 < Profile.size() ? l_sample : Profile.size() - 2;
+			float l_frac = l_pos - static_cast<float>(l_sample);
+			l_scale = Profile[l_sample] + (Profile[l_sample + 1] - Profile[l_sample]) * l_frac;
+		}
+		NodeRadius[k] = Radius * l_scale;
+	}
+	for (size_t k = 0; k + 1 < Count; ++k)
+	{
+		SegmentRadius[k] = 0.5f * (NodeRadius[k] + NodeRadius[k + 1]);
+	}
+}
+
+/**
+ * (内部函数)
+ * 重新计算所有节点的包围盒,并按最大判定半径向外扩展。
+ */
+void MADCurvyLaser::UpdateBounds() const
+{
+	if (!BoundsDirty)
+	{
+		return;
+	}
+	BoundsDirty = false;
+	const float* l_x = GetNodeXData();
+	const float* l_y = GetNodeYData();
+	float l_min_x = l_x[0], l_max_x = l_x[0];
+	float l_min_y = l_y[0], l_max_y = l_y[0];
+	float l_radius = 0.0f;
+	for (size_t k = 0; k < Count; ++k)
+	{
+		l_min_x = l_x[k] < l_min_x ? l_x[k] : l_min_x;
+		l_max_x = l_x[k] > l_max_x ? l_x[k] : l_max_x;
+		l_min_y = l_y[k] < l_min_y ? l_y[k] : l_min_y;
+		l_max_y = l_y[k] > l_max_y ? l_y[k] : l_max_y;
+		l_radius = NodeRadius[k] > l_radius ? NodeRadius[k] : l_radius;
+	}
+	Bounds[0] = l_min_x - l_radius;
+	Bounds[1] = l_min_y - l_radius;
+	Bounds[2] = l_max_x + l_radius;
+	Bounds[3] = l_max_y + l_radius;
+}
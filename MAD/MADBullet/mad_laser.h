@@ -0,0 +1,206 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "mad_bullet_pool.h"
+
+/*Tag written at the start of a laser pool snapshot*/
+#define MAD_LASER_SNAPSHOT_TAG 0x5253414Cu
+
+/**
+ * \brief MADLaserInfo 描述一条直线激光,即一个胶囊:从 `Start` 到 `End` 的线段,判定半径为 `Radius`。
+ */
+struct MADLaserInfo {
+	MADVector2DF Start;
+	MADVector2DF End;
+	float Radius;
+	long long TeamMask;
+
+	MADLaserInfo() {
+		Start = MADVector2DF();
+		End = MADVector2DF();
+		Radius = 0.0f;
+		TeamMask = 0;
+	}
+	MADLaserInfo(MADVector2DF _start, MADVector2DF _end, float _radius, long long _team_mask) {
+		Start = _start;
+		End = _end;
+		Radius = _radius;
+		TeamMask = _team_mask;
+	}
+};
+
+/**
+ * \brief MADLaserHit 是一次激光与实体的命中记录。
+ *
+ * `Laser` 为MADLaserPool中激光的密集索引,或查询MADCurvyLaser时传入的激光编号;
+ * `Entity` 为实体在查询时传入的数组中的下标;
+ * `Segment` 为曲线激光中命中的第一段线段(从尾部起计数),直线激光总为0。
+ */
+struct MADLaserHit {
+	unsigned int Laser;
+	unsigned int Entity;
+	unsigned int Segment;
+
+	MADLaserHit() {
+		Laser = MAD_BULLET_INVALID_INDEX;
+		Entity = MAD_BULLET_INVALID_INDEX;
+		Segment = 0;
+	}
+	MADLaserHit(unsigned int _laser, unsigned int _entity, unsigned int _segment) {
+		Laser = _laser;
+		Entity = _entity;
+		Segment = _segment;
+	}
+};
+
+/**
+ * \brief MADLaserVertex 是激光刷新输出的条带(triangle strip)顶点。
+ *
+ * `U` 为沿激光方向的参数,尾部为0、头部为1;`V` 为横向参数,左侧为0、右侧为1。
+ */
+struct MADLaserVertex {
+	float X, Y;
+	float U, V;
+};
+
+/**
+ * MADLaserPool 是直线激光的SoA容器,每条激光以一个胶囊储存,而不是用大量紧密排列的子弹拼接。
+ *
+ * - 生成与销毁均为 O(1),销毁时将末尾激光交换到空位,外部通过MADBulletHandle引用激光;
+ * - 碰撞检测由MADBulletKernel::OverlapCapsule对所有激光批量完成,同时按TeamMask过滤;
+ * - Flush为每条激光输出4个顶点组成的条带。
+ *
+ * 注意:该类是线程不安全的!
+ */
+class MADLaserPool
+{
+public:
+	MADLaserPool();
+	~MADLaserPool();
+
+public:
+	/*Laser operator*/
+	MADBulletHandle Spawn(const MADLaserInfo& _info);
+	bool Kill(MADBulletHandle _handle);
+	void Clear();
+
+	/*Get Data*/
+	size_t GetNum() const;
+	bool IsAlive(MADBulletHandle _handle) const;
+	size_t GetIndex(MADBulletHandle _handle) const;
+	MADBulletHandle GetHandle(size_t _index) const;
+	bool GetInfo(MADBulletHandle _handle, MADLaserInfo* out_info) const;
+	bool SetInfo(MADBulletHandle _handle, const MADLaserInfo& _info);
+
+	/*Query*/
+	size_t Query(const MADEntity* _entities, size_t _num, std::vector<MADLaserHit>& out_hits) const;
+
+	/*Flush*/
+	size_t Flush(std::vector<MADLaserVertex>& out_vertices) const;
+
+	/*Snapshot*/
+	size_t Snapshot(std::vector<unsigned char>& out_data) const;
+	bool Restore(MADBlobReader& io_reader);
+
+private:
+	/*Laser Data (SoA)*/
+	std::vector<float> Start_X;
+	std::vector<float> Start_Y;
+	std::vector<float> End_X;
+	std::vector<float> End_Y;
+	std::vector<float> Radius;
+	std::vector<long long> TeamMask;
+
+	/*Handle Data*/
+	std::vector<unsigned int> DenseToSlot;
+	std::vector<unsigned int> SlotToDense;
+	std::vector<unsigned int> SlotGeneration;
+	std::vector<unsigned int> FreeSlots;
+
+	/*Query scratch*/
+	mutable std::vector<unsigned int> HitIndex;
+};
+
+/**
+ * MADCurvyLaser 是一条曲线激光,以折线节点的环形缓冲区储存,头部不断追加新节点、尾部的旧节点依次被覆盖。
+ *
+ * - 每个节点写入两次(i 与 i + 容量),因此从尾到头的所有节点在内存中总是连续的,
+ *   相邻节点之间的线段可以直接交给MADBulletKernel::OverlapCapsule做SIMD检测,不需要处理回绕;
+ * - 判定半径为 Radius 乘以宽度曲线(Profile),宽度曲线在尾部(0)到头部(1)之间线性插值,
+ *   每段线段取两端节点半径的平均值,只在节点数量或宽度曲线变化时重新计算;
+ * - 查询前先用整条激光的包围盒排除远处的实体;
+ * - Flush为每个节点输出左右两个顶点组成的条带。
+ *
+ * 每个节点占用约 6 个float,远小于用子弹拼接时每个子弹的开销。
+ *
+ * 注意:该类是线程不安全的!
+ */
+class MADCurvyLaser
+{
+public:
+	MADCurvyLaser(size_t _capacity = 64, float _radius = 0.0f, long long _team_mask = 0);
+	~MADCurvyLaser();
+
+public:
+	/*Node operator*/
+	void PushNode(const MADVector2DF& _position);
+	void Clear();
+
+	/*Config*/
+	void SetRadius(float _radius);
+	float GetRadius() const;
+	void SetTeamMask(long long _team_mask);
+	long long GetTeamMask() const;
+	void SetProfile(const float* _samples, size_t _num);
+
+	/*Get Data*/
+	size_t GetCapacity() const;
+	size_t GetNodeNum() const;
+	MADVector2DF GetNode(size_t _index) const;
+	const float* GetNodeXData() const;
+	const float* GetNodeYData() const;
+
+	/*Query*/
+	size_t Query(const MADEntity* _entities, size_t _num, unsigned int _laser_index,
+		std::vector<MADLaserHit>& out_hits) const;
+
+	/*Flush*/
+	size_t Flush(std::vector<MADLaserVertex>& out_vertices) const;
+
+private:
+	/*Config*/
+	size_t Capacity;
+	float Radius;
+	long long TeamMask;
+	std::vector<float> Profile;
+
+	/*Ring buffer,every node is stored at i and i + Capacity*/
+	std::vector<float> Node_X;
+	std::vector<float> Node_Y;
+	size_t Write;
+	size_t Count;
+
+	/*Radius of each node and segment from the tail,rebuilt when Count or the profile changes*/
+	mutable std::vector<float> NodeRadius;
+	mutable std::vector<float> SegmentRadius;
+	mutable bool RadiusDirty;
+
+	/*Bounds of all nodes expanded by the largest radius*/
+	mutable float Bounds[4];
+	mutable bool BoundsDirty;
+
+	/*Query scratch*/
+	mutable std::vector<unsigned int> HitIndex;
+
+	/*Common function*/
+	size_t GetTail() const;
+	void UpdateRadius() const;
+	void UpdateBounds() const;
+};
@@ -0,0 +1,425 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_hit_queue.h"
+
+/**
+ * 构造一个未绑定脚本的空命中事件队列。
+ */
+MADHitQueue::MADHitQueue()
+{
+	Script = nullptr;
+	BoundState = nullptr;
+	Handler = MADString();
+	ViewRef = LUA_NOREF;
+	Delivering = false;
+}
+
+/**
+ * MADHitQueue析构函数,会解除与脚本的绑定。
+ */
+MADHitQueue::~MADHitQueue()
+{
+	Unbind();
+}
+
+/**
+ * 追加一条命中事件。
+ *
+ * @param _bullet 命中的子弹句柄
+ * @param _user_data 被命中实体的UserData
+ * @param _team 子弹的TeamMask
+ */
+void MADHitQueue::Push(MADBulletHandle _bullet, void** _user_data, long long _team)
+{
+	Events.emplace_back(_bullet, _user_data, _team);
+}
+
+/**
+ * 将一次碰撞查询的结果整体追加到队列中。
+ * 子弹的密集索引会在此时转换为句柄,因此之后子弹池发生Spawn/Kill也不影响队列中的记录。
+ *
+ * @param _pool 执行碰撞查询时的子弹池
+ * @param _entities 碰撞查询时传入的实体数组
+ * @param _hits 命中记录
+ * @param _num 命中记录数量
+ * @return 追加的事件数量
+ */
+size_t MADHitQueue::PushHits(const MADBulletPool& _pool, const MADEntity* _entities, const MADCollisionHit* _hits, size_t _num)
+{
+	if (_num == 0)
+	{
+		return 0;
+	}
+	size_t l_begin = Events.size();
+	Events.resize(l_begin + _num);
+	MADHitEvent* l_out = Events.data() + l_begin;
+	const long long* l_team = _pool.GetTeamMaskData();
+	for (size_t i = 0; i < _num; ++i)
+	{
+		l_out[i].Bullet = _pool.GetHandle(_hits[i].Bullet);
+		l_out[i].UserData = _entities[_hits[i].Entity].UserData;
+		l_out[i].Team = l_team[_hits[i].Bullet];
+	}
+	return _num;
+}
+
+/**
+ * 将一次碰撞查询的结果整体追加到队列中。
+ *
+ * @param _pool 执行碰撞查询时的子弹池
+ * @param _entities 碰撞查询时传入的实体数组
+ * @param _hits 命中记录
+ * @return 追加的事件数量
+ */
+size_t MADHitQueue::PushHits(const MADBulletPool& _pool, const MADEntity* _entities, const std::vector<MADCollisionHit>& _hits)
+{
+	return PushHits(_pool, _entities, _hits.data(), _hits.size());
+}
+
+/**
+ * 预留事件容量,避免弹幕密集的帧中途扩容。
+ *
+ * @param _capacity 事件数量
+ */
+void MADHitQueue::Reserve(size_t _capacity)
+{
+	Events.reserve(_capacity);
+}
+
+/**
+ * 丢弃队列中所有尚未交付的事件,已分配的容量会被保留。
+ */
+void MADHitQueue::Clear()
+{
+	Events.clear();
+}
+
+/**
+ * 获取队列中尚未交付的事件数量。
+ *
+ * @return 事件数量
+ */
+size_t MADHitQueue::GetNum() const
+{
+	return Events.size();
+}
+
+/**
+ * 查看队列是否为空。
+ *
+ * @return 队列是否为空
+ */
+bool MADHitQueue::Is_Empty() const
+{
+	return Events.empty();
+}
+
+/**
+ * 获取队列中事件的连续数组,按追加顺序排列。
+ *
+ * @return 事件数组,在下一次Push、PushHits、Clear或Deliver之前有效
+ */
+const MADHitEvent* MADHitQueue::GetData() const
+{
+	return Events.data();
+}
+
+/**
+ * 将本对象绑定到脚本,之后由Deliver调用脚本中名为 _handler 的全局函数。
+ * 绑定时会在脚本中创建一个事件视图并保存在注册表中,之后每帧交付都复用这个视图。
+ *
+ * @param _script 处理命中事件的脚本
+ * @param _handler 处理函数的全局名称,交付时才查找,因此可以在绑定之后再定义
+ * @return 绑定成功返回true
+ *
+ * 注意:
+ * - 重复绑定会先解除之前的绑定。
+ * - 脚本通过ReloadScript重新加载后,需要重新绑定。
+ */
+bool MADHitQueue::BindScript(MADScript* _script, const char* _handler)
+{
+	if (_script == nullptr || _handler == nullptr)
+	{
+		MAD_LOG_ERR("Try to bind hit queue to a null script or handler!");
+		return false;
+	}
+	Unbind();
+	if (_script->GetScriptState() == MADScriptState::Deleted)
+	{
+		MAD_LOG_ERR("Try to bind hit queue to a deleted script!");
+		return false;
+	}
+	lua_State* L = _script->GetLuaState();
+
+	/*The metatable is shared by every view in this VM*/
+	if (luaL_newmetatable(L, MAD_HIT_QUEUE_LUA_METATABLE))
+	{
+		/*Methods keep the metatable as an upvalue,checking a view is then one pointer compare*/
+		lua_newtable(L);
+		lua_pushvalue(L, -2);
+		lua_pushcclosure(L, GetFromLua, 1);
+		lua_setfield(L, -2, "Get");
+		lua_pushvalue(L, -2);
+		lua_pushcclosure(L, BulletFromLua, 1);
+		lua_setfield(L, -2, "Bullet");
+		lua_pushvalue(L, -2);
+		lua_pushcclosure(L, EntityFromLua, 1);
+		lua_setfield(L, -2, "Entity");
+		lua_pushvalue(L, -2);
+		lua_pushcclosure(L, TeamFromLua, 1);
+		lua_setfield(L, -2, "Team");
+		lua_setfield(L, -2, "__index");
+		lua_pushvalue(L, -1);
+		lua_pushcclosure(L, LenFromLua, 1);
+		lua_setfield(L, -2, "__len");
+	}
+	lua_pop(L, 1);
+
+	MADHitQueue** l_view = static_cast<MADHitQueue**>(lua_newuserdatauv(L, sizeof(MADHitQueue*), 0));
+	*l_view = this;
+	luaL_setmetatable(L, MAD_HIT_QUEUE_LUA_METATABLE);
+	ViewRef = luaL_ref(L, LUA_REGISTRYINDEX);
+
+	Script = _script;
+	BoundState = L;
+	Handler = _handler;
+	return true;
+}
+
+/**
+ * 解除与脚本的绑定,脚本中残留的视图之后只会返回nil。
+ * 队列中尚未交付的事件会被保留。
+ */
+void MADHitQueue::Unbind()
+{
+	if (Script == nullptr)
+	{
+		return;
+	}
+	if (Script->GetScriptState() != MADScriptState::Deleted && Script->GetLuaState() == BoundState)
+	{
+		lua_rawgeti(BoundState, LUA_REGISTRYINDEX, ViewRef);
+		*static_cast<MADHitQueue**>(lua_touserdata(BoundState, -1)) = nullptr;
+		lua_pop(BoundState, 1);
+		luaL_unref(BoundState, LUA_REGISTRYINDEX, ViewRef);
+	}
+	Script = nullptr;
+	BoundState = nullptr;
+	Handler = MADString();
+	ViewRef = LUA_NOREF;
+}
+
+/**
+ * 将队列中的所有事件一次性交给脚本的处理函数,即 handler(events, n),之后清空队列。
+ * 队列为空时不会进入Lua。
+ *
+ * @return 返回交付结果的状态码,MAD_RESCODE_OK表示成功(包括队列为空)。
+ *
+ * 注意:
+ * - 无论交付是否成功,队列都会被清空,出错的一帧事件不会累积到下一帧。
+ * - 处理函数中可以继续向本队列Push,新事件会在下一次Deliver时交付,不会出现在本次的视图中。
+ */
+MADDebuggerInfo_LIGHT MADHitQueue::Deliver()
+{
+	if (Events.empty())
+	{
+		return MAD_RESCODE_OK;
+	}
+	if (Script == nullptr || Script->GetScriptState() != MADScriptState::Ready || Script->GetLuaState() != BoundState)
+	{
+		MAD_LOG_ERR("Try to deliver hit events without a ready bound script!");
+		Events.clear();
+		return MAD_RESCODE_ILLEGAL_CALL;
+	}
+
+	lua_getglobal(BoundState, Handler.c_str());
+	if (!lua_isfunction(BoundState, -1))
+	{
+		MAD_LOG_ERR("Can't find hit event handler named: \"" + Handler + "\"");
+		lua_pop(BoundState, 1);
+		Events.clear();
+		return MAD_RESCODE_FUNC_NOT_FOUND;
+	}
+	lua_rawgeti(BoundState, LUA_REGISTRYINDEX, ViewRef);
+	lua_pushinteger(BoundState, static_cast<lua_Integer>(Events.size()));
+
+	/*Events pushed by the handler itself wait for the next delivery*/
+	Delivered.swap(Events);
+	Delivering = true;
+	int l_res = lua_pcall(BoundState, 2, 0, 0);
+	Delivering = false;
+	Delivered.clear();
+	if (Events.empty())
+	{
+		Events.swap(Delivered);
+	}
+
+	if (l_res != LUA_OK)
+	{
+		MAD_LOG_ERR("Call hit event handler: \"" + Handler + "\" failed!Lua error: \"" + MADString(lua_tostring(BoundState, -1)) + "\"");
+		lua_pop(BoundState, 1);
+		return MAD_RESCODE_FUNC_FAILED;
+	}
+	return MAD_RESCODE_OK;
+}
+
+/**
+ * 将子弹句柄打包为一个Lua整数,高32位为代数,低32位为槽位索引。
+ *
+ * @param _handle 子弹句柄
+ * @return 打包后的整数
+ */
+long long MADHitQueue::PackHandle(MADBulletHandle _handle)
+{
+	return static_cast<long long>((static_cast<unsigned long long>(_handle.Generation) << 32) | _handle.Index);
+}
+
+/**
+ * 将PackHandle得到的整数还原为子弹句柄,用于处理脚本传回的句柄。
+ *
+ * @param _value 打包后的整数
+ * @return 子弹句柄
+ */
+MADBulletHandle MADHitQueue::UnpackHandle(long long _value)
+{
+	unsigned long long l_value = static_cast<unsigned long long>(_value);
+	return MADBulletHandle(static_cast<unsigned int>(l_value & 0xFFFFFFFFull), static_cast<unsigned int>(l_value >> 32));
+}
+
+/**
+ * (内部回调函数,禁止主动调用)
+ * Lua: #events
+ *
+ * @param L 当前的Lua状态机指针。
+ * @return 返回1,向Lua返回本次交付的事件数量,不在交付期间时为0。
+ */
+int MADHitQueue::LenFromLua(lua_State* L)
+{
+	MADHitQueue* l_queue = GetQueueFromLua(L);
+	lua_Integer l_num = 0;
+	if (l_queue != nullptr && l_queue->Delivering)
+	{
+		l_num = static_cast<lua_Integer>(l_queue->Delivered.size());
+	}
+	lua_pushinteger(L, l_num);
+	return 1;
+}
+
+/**
+ * (内部回调函数,禁止主动调用)
+ * Lua: local bullet, entity, team = events:Get(i)
+ *
+ * @param L 当前的Lua状态机指针。
+ * @return 返回3,依次为子弹句柄、实体UserData与子弹队伍;下标无效时返回1个nil。
+ */
+int MADHitQueue::GetFromLua(lua_State* L)
+{
+	const MADHitEvent* l_event = GetEventFromLua(L);
+	if (l_event == nullptr)
+	{
+		lua_pushnil(L);
+		return 1;
+	}
+	lua_pushinteger(L, PackHandle(l_event->Bullet));
+	lua_pushlightuserdata(L, l_event->UserData);
+	lua_pushinteger(L, l_event->Team);
+	return 3;
+}
+
+/**
+ * (内部回调函数,禁止主动调用)
+ * Lua: events:Bullet(i)
+ *
+ * @param L 当前的Lua状态机指针。
+ * @return 返回1,向Lua返回子弹句柄,下标无效时为nil。
+ */
+int MADHitQueue::BulletFromLua(lua_State* L)
+{
+	const MADHitEvent* l_event = GetEventFromLua(L);
+	if (l_event == nullptr)
+	{
+		lua_pushnil(L);
+		return 1;
+	}
+	lua_pushinteger(L, PackHandle(l_event->Bullet));
+	return 1;
+}
+
+/**
+ * (内部回调函数,禁止主动调用)
+ * Lua: events:Entity(i)
+ *
+ * @param L 当前的Lua状态机指针。
+ * @return 返回1,向Lua返回实体UserData,下标无效时为nil。
+ */
+int MADHitQueue::EntityFromLua(lua_State* L)
+{
+	const MADHitEvent* l_event = GetEventFromLua(L);
+	if (l_event == nullptr)
+	{
+		lua_pushnil(L);
+		return 1;
+	}
+	lua_pushlightuserdata(L, l_event->UserData);
+	return 1;
+}
+
+/**
+ * (内部回调函数,禁止主动调用)
+ * Lua: events:Team(i)
+ *
+ * @param L 当前的Lua状态机指针。
+ * @return 返回1,向Lua返回子弹队伍,下标无效时为nil。
+ */
+int MADHitQueue::TeamFromLua(lua_State* L)
+{
+	const MADHitEvent* l_event = GetEventFromLua(L);
+	if (l_event == nullptr)
+	{
+		lua_pushnil(L);
+		return 1;
+	}
+	lua_pushinteger(L, l_event->Team);
+	return 1;
+}
+
+/**
+ * (内部函数)
+ * 读取视图方法的 (events, i) 参数,返回对应的事件。
+ * 视图已失效、不在交付期间或下标越界时返回nullptr。
+ */
+const MADHitEvent* MADHitQueue::GetEventFromLua(lua_State* L)
+{
+	MADHitQueue* l_queue = GetQueueFromLua(L);
+	lua_Integer l_index = luaL_checkinteger(L, 2);
+	if (l_queue == nullptr || !l_queue->Delivering || l_index < 1 || l_index > static_cast<lua_Integer>(l_queue->Delivered.size()))
+	{
+		return nullptr;
+	}
+	return l_queue->Delivered.data() + (l_index - 1);
+}
+
+/**
+ * (内部函数)
+ * 读取视图方法的第一个参数,与闭包上值中的元表比较来确认它是事件视图,不是视图时抛出Lua错误。
+ * 视图已解除绑定时返回nullptr。
+ */
+MADHitQueue* MADHitQueue::GetQueueFromLua(lua_State* L)
+{
+	MADHitQueue** l_view = static_cast<MADHitQueue**>(lua_touserdata(L, 1));
+	bool l_valid = l_view != nullptr && lua_getmetatable(L, 1);
+	if (l_valid)
+	{
+		l_valid = lua_rawequal(L, -1, lua_upvalueindex(1));
+		lua_pop(L, 1);
+	}
+	if (!l_valid)
+	{
+		luaL_typeerror(L, 1, MAD_HIT_QUEUE_LUA_METATABLE);
+	}
+	return *l_view;
+}
@@ -0,0 +1,112 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "mad_lua.h"
+#include "../MADBullet/mad_collision.h"
+
+/*Name of the metatable shared by all hit event views of a script*/
+#define MAD_HIT_QUEUE_LUA_METATABLE "MAD_HitEvents"
+
+/**
+ * \brief MADHitEvent 是一次交给脚本处理的命中事件。
+ *
+ * - Bullet: 命中的子弹句柄,在Lua中以整数 (Generation << 32) | Index 表示,见MADHitQueue::PackHandle
+ * - UserData: 被命中实体的MADEntity::UserData
+ * - Team: 子弹的TeamMask
+ */
+struct MADHitEvent {
+	MADBulletHandle Bullet;
+	void** UserData;
+	long long Team;
+
+	MADHitEvent() {
+		Bullet = MADBulletHandle();
+		UserData = nullptr;
+		Team = 0;
+	}
+	MADHitEvent(MADBulletHandle _bullet, void** _user_data, long long _team) {
+		Bullet = _bullet;
+		UserData = _user_data;
+		Team = _team;
+	}
+};
+
+/**
+ * MADHitQueue 收集一帧内的所有命中事件,并在帧末一次性交给脚本中的一个处理函数。
+ *
+ * 逐个命中调用MADScript::CallFunction时,每次命中都要构造参数流、分配装箱的参数并执行一次lua_pcall;
+ * 使用本队列后,每次命中只是向连续数组追加一条24字节的记录,每帧只进入一次Lua。
+ *
+ * BindScript之后,Deliver会以 handler(events, n) 的形式调用脚本中的全局函数,
+ * events 是直接读取本对象内存的视图,不会为每条记录创建表:
+ *     function OnHits(events, n)
+ *         for i = 1, n do
+ *             local bullet, entity, team = events:Get(i)
+ *         end
+ *     end
+ * 视图还支持 #events 以及 events:Bullet(i)、events:Entity(i)、events:Team(i),下标从1开始,越界时返回nil。
+ * 事件很多时可以先取出 local get = events.Get,再在循环中调用 get(events, i),省去每次的方法查找。
+ *
+ * 注意:
+ * - 视图只在处理函数执行期间有效,之后再访问会得到nil,请不要保存视图或在其他时机使用它。
+ * - 本对象持有绑定脚本的指针,请保证脚本的生命周期长于本对象,或在删除脚本前调用Unbind。
+ * - 该类是线程不安全的!
+ */
+class MADHitQueue
+{
+public:
+	MADHitQueue();
+	~MADHitQueue();
+
+public:
+	/*Event operator*/
+	void Push(MADBulletHandle _bullet, void** _user_data, long long _team);
+	size_t PushHits(const MADBulletPool& _pool, const MADEntity* _entities, const MADCollisionHit* _hits, size_t _num);
+	size_t PushHits(const MADBulletPool& _pool, const MADEntity* _entities, const std::vector<MADCollisionHit>& _hits);
+	void Reserve(size_t _capacity);
+	void Clear();
+
+	/*Get Data*/
+	size_t GetNum() const;
+	bool Is_Empty() const;
+	const MADHitEvent* GetData() const;
+
+	/*Lua binding*/
+	bool BindScript(MADScript* _script, const char* _handler);
+	void Unbind();
+	MADDebuggerInfo_LIGHT Deliver();
+
+	/*Handle packing*/
+	static long long PackHandle(MADBulletHandle _handle);
+	static MADBulletHandle UnpackHandle(long long _value);
+
+	/*Lua API Function*/
+	static int LenFromLua(lua_State* L);
+	static int GetFromLua(lua_State* L);
+	static int BulletFromLua(lua_State* L);
+	static int EntityFromLua(lua_State* L);
+	static int TeamFromLua(lua_State* L);
+
+private:
+	/*Event Data,Delivered holds the events the handler is reading*/
+	std::vector<MADHitEvent> Events;
+	std::vector<MADHitEvent> Delivered;
+
+	/*Binding*/
+	MADScript* Script;
+	lua_State* BoundState;
+	MADString Handler;
+	int ViewRef;
+	bool Delivering;
+
+	/*Common function*/
+	static MADHitQueue* GetQueueFromLua(lua_State* L);
+	static const MADHitEvent* GetEventFromLua(lua_State* L);
+};
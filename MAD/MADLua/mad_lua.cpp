@@ -270,6 +270,40 @@ MADDebuggerInfo_HEAVY MADScript::ReloadScript(const MADString& _script)
 	return MADDebuggerInfo_HEAVY();
 }
 
+/**
+ * 为脚本的math.random设置确定的随机数种子。
+ * 内部调用Lua的math.randomseed(_seed, _stream),相同的种子与流编号总是产生相同的随机序列,
+ * 不同的流编号产生互不相关的序列,因此可以用同一个主种子为多个脚本分配独立的随机流。
+ * 确定性模拟(如录像回放)中,请在脚本创建后、首次运行前调用此方法。
+ *
+ * @param _seed 主种子
+ * @param _stream 随机流编号,默认为0
+ */
+void MADScript::SetRandomSeed(long long _seed, long long _stream)
+{
+	if (ScriptState == MADScriptState::Deleted)
+	{
+		MAD_LOG_ERR("Try to set random seed on a deleted script!");
+		return;
+	}
+	lua_getglobal(L, "math");
+	if (!lua_istable(L, -1))
+	{
+		MAD_LOG_ERR("Can't find lua math library to set random seed!");
+		lua_pop(L, 1);
+		return;
+	}
+	lua_getfield(L, -1, "randomseed");
+	lua_pushinteger(L, _seed);
+	lua_pushinteger(L, _stream);
+	if (lua_pcall(L, 2, 0, 0) != LUA_OK)
+	{
+		MAD_LOG_ERR("Set random seed failed,lua error: " + MADString(lua_tostring(L, -1)));
+		lua_pop(L, 1);
+	}
+	lua_pop(L, 1);
+}
+
 /**
  * 从Lua环境中获取指定名称的全局整数值。
  * 在调用此方法前，确保脚本状态为Ready，否则会返回错误或无效结果。
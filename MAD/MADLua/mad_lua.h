@@ -95,6 +95,7 @@ public:
 	void CallMain();
 	void DeleteScript();
 	MADDebuggerInfo_HEAVY ReloadScript(const MADString& _script);
+	void SetRandomSeed(long long _seed, long long _stream = 0);
 
 	/*Get value*/
 	long long GetValueInteger(const char* _valueName);
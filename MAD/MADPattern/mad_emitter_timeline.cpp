@@ -0,0 +1,717 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_emitter_timeline.h"
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ * (内部函数)
+ * 比较两个堆节点的 (到期tick, 登记顺序),先到期的在前,同一tick先登记的在前。
+ */
+static bool KeyLess(unsigned long long _due_a, unsigned long long _order_a, unsigned long long _due_b, unsigned long long _order_b)
+{
+	return _due_a < _due_b || (_due_a == _due_b && _order_a < _order_b);
+}
+
+/**
+ * 构造一个空的发射时间线。
+ *
+ * @param _runner Pattern事件使用的模式解释器,可为nullptr
+ * @param _tick 当前tick,第一次Advance处理的是 _tick + 1
+ */
+MADEmitterTimeline::MADEmitterTimeline(MADPatternRunner* _runner, unsigned long long _tick)
+{
+	Runner = _runner;
+	Tick = _tick;
+	NextOrder = 0;
+	Script = nullptr;
+	BoundState = nullptr;
+	BindingRef = LUA_NOREF;
+}
+
+/**
+ * MADEmitterTimeline析构函数,释放未触发的Script事件持有的Lua函数引用,并解除与脚本的绑定。
+ */
+MADEmitterTimeline::~MADEmitterTimeline()
+{
+	Clear();
+	Unbind();
+}
+
+/**
+ * 登记一个在 _delay 个tick之后启动发射器的事件。
+ * _delay 为0时视为1,即在下一次Advance中处理。
+ *
+ * @param _delay 距离当前tick的延迟
+ * @param _pattern 模式序号
+ * @param _info 发射器的初始状态
+ * @return 事件句柄;没有模式解释器或模式不存在时返回0。
+ */
+MADTimelineHandle MADEmitterTimeline::SchedulePattern(unsigned long long _delay, unsigned int _pattern, const MADPatternStartInfo& _info)
+{
+	if (Runner == nullptr || Runner->GetProgram() == nullptr || _pattern >= Runner->GetProgram()->GetPatternNum())
+	{
+		MAD_LOG_ERR("Try to schedule a pattern which does not exist!");
+		return 0;
+	}
+	TimelineEvent l_event;
+	l_event.Type = MADTimelineEventType::Pattern;
+	l_event.Pattern = _pattern;
+	l_event.Info = _info;
+	return Push(_delay, l_event);
+}
+
+/**
+ * 按名称登记一个在 _delay 个tick之后启动发射器的事件,名称在登记时解析。
+ *
+ * @param _delay 距离当前tick的延迟
+ * @param _name 模式名称
+ * @param _info 发射器的初始状态
+ * @return 事件句柄;没有模式解释器或模式不存在时返回0。
+ */
+MADTimelineHandle MADEmitterTimeline::SchedulePattern(unsigned long long _delay, const MADString& _name, const MADPatternStartInfo& _info)
+{
+	if (Runner == nullptr || Runner->GetProgram() == nullptr || Runner->GetProgram()->FindPattern(_name) == MAD_PATTERN_INVALID_INDEX)
+	{
+		MAD_LOG_ERR("Try to schedule pattern \"" + _name + "\" which does not exist!");
+		return 0;
+	}
+	return SchedulePattern(_delay, Runner->GetProgram()->FindPattern(_name), _info);
+}
+
+/**
+ * 登记一个在 _delay 个tick之后交给调用者的User事件。
+ *
+ * @param _delay 距离当前tick的延迟
+ * @param _user_data 到期时原样交给调用者的数据
+ * @return 事件句柄
+ */
+MADTimelineHandle MADEmitterTimeline::ScheduleUser(unsigned long long _delay, unsigned long long _user_data)
+{
+	TimelineEvent l_event;
+	l_event.Type = MADTimelineEventType::User;
+	l_event.UserData = _user_data;
+	return Push(_delay, l_event);
+}
+
+/**
+ * 取消一个尚未触发的事件。
+ *
+ * @param _handle 事件句柄
+ * @return 事件尚未触发并被取消时返回true;句柄无效或事件已触发时返回false。
+ */
+bool MADEmitterTimeline::Cancel(MADTimelineHandle _handle)
+{
+	size_t l_slot = Find(_handle);
+	if (l_slot == MAD_PATTERN_INVALID_INDEX)
+	{
+		return false;
+	}
+	RemoveAt(Events[l_slot].HeapPos);
+	Release(l_slot);
+	return true;
+}
+
+/**
+ * 取消所有尚未触发的事件,当前tick保持不变。
+ * 所有已发出的句柄都会失效,但已分配的容量会被保留。
+ */
+void MADEmitterTimeline::Clear()
+{
+	for (size_t i = 0; i < Heap.size(); ++i)
+	{
+		Release(Heap[i].Slot);
+	}
+	Heap.clear();
+}
+
+/**
+ * 预留事件容量,避免大量登记时反复扩容。
+ *
+ * @param _capacity 事件数量
+ */
+void MADEmitterTimeline::Reserve(size_t _capacity)
+{
+	Events.reserve(_capacity);
+	FreeSlots.reserve(_capacity);
+	Heap.reserve(_capacity);
+}
+
+/**
+ * 前进一个tick,并按 (到期tick, 登记顺序) 依次触发所有到期的事件。
+ * 每个tick只比较堆顶,没有到期事件时的代价为常数。
+ *
+ * 触发过程中(例如Lua回调中)新登记的事件至少在下一个tick才会到期,不会在本次Advance中触发;
+ * 在回调中取消尚未触发的事件是安全的。
+ *
+ * @param out_user 接收到期User事件UserData的数组,可为nullptr;结果会追加在末尾
+ * @return 本tick触发的事件数量
+ */
+size_t MADEmitterTimeline::Advance(std::vector<unsigned long long>* out_user)
+{
+	Tick++;
+
+	size_t l_fired = 0;
+	while (!Heap.empty() && Heap[0].Due <= Tick)
+	{
+		size_t l_slot = Heap[0].Slot;
+		RemoveAt(0);
+
+		/*Copied out first,callbacks may schedule new events and move the slots*/
+		TimelineEvent l_event = Events[l_slot];
+		Events[l_slot].ScriptRef = LUA_NOREF;
+		Release(l_slot);
+
+		switch (l_event.Type)
+		{
+		case MADTimelineEventType::Pattern:
+			if (Runner != nullptr)
+			{
+				Runner->Start(l_event.Pattern, l_event.Info);
+			}
+			break;
+		case MADTimelineEventType::Script:
+			if (HasScript())
+			{
+				lua_rawgeti(BoundState, LUA_REGISTRYINDEX, l_event.ScriptRef);
+				luaL_unref(BoundState, LUA_REGISTRYINDEX, l_event.ScriptRef);
+				if (lua_pcall(BoundState, 0, 0, 0) != LUA_OK)
+				{
+					MAD_LOG_ERR("Scheduled call failed,lua error: " + MADString(lua_tostring(BoundState, -1)));
+					lua_pop(BoundState, 1);
+				}
+			}
+			break;
+		case MADTimelineEventType::User:
+			if (out_user != nullptr)
+			{
+				out_user->push_back(l_event.UserData);
+			}
+			break;
+		}
+		l_fired++;
+	}
+	return l_fired;
+}
+
+/**
+ * 获取当前tick,即最近一次Advance处理的tick。
+ *
+ * @return 当前tick
+ */
+unsigned long long MADEmitterTimeline::GetTick() const
+{
+	return Tick;
+}
+
+/**
+ * 获取等待触发的事件数量,已触发或被取消的事件不计入。
+ *
+ * @return 等待中的事件数量
+ */
+size_t MADEmitterTimeline::GetNum() const
+{
+	return Heap.size();
+}
+
+/**
+ * 检查事件是否仍在等待触发。
+ *
+ * @param _handle 事件句柄
+ * @return 事件尚未触发且未被取消时返回true。
+ */
+bool MADEmitterTimeline::IsPending(MADTimelineHandle _handle) const
+{
+	return Find(_handle) != MAD_PATTERN_INVALID_INDEX;
+}
+
+/**
+ * 获取事件的到期tick。
+ *
+ * @param _handle 事件句柄
+ * @return 到期tick;事件已触发、被取消或句柄无效时返回0。
+ */
+unsigned long long MADEmitterTimeline::GetDue(MADTimelineHandle _handle) const
+{
+	size_t l_slot = Find(_handle);
+	if (l_slot == MAD_PATTERN_INVALID_INDEX)
+	{
+		return 0;
+	}
+	return Heap[Events[l_slot].HeapPos].Due;
+}
+
+/**
+ * 把当前tick、登记顺序、槽位代数、空闲槽位与所有等待中的Pattern/User事件追加到 out_data 末尾。
+ * Script事件无法序列化,写入时按已取消处理:槽位记为空闲,代数加1,其句柄在恢复后失效。
+ *
+ * @param out_data 输出缓冲区,数据追加在已有内容之后
+ * @return 写入的字节数
+ */
+size_t MADEmitterTimeline::Snapshot(std::vector<unsigned char>& out_data) const
+{
+	size_t l_begin = out_data.size();
+	std::vector<unsigned int> l_generations(Events.size());
+	for (size_t i = 0; i < Events.size(); ++i)
+	{
+		l_generations[i] = Events[i].Generation;
+	}
+	std::vector<unsigned int> l_free_slots = FreeSlots;
+	std::vector<SnapshotEvent> l_events;
+	l_events.reserve(Heap.size());
+	for (size_t i = 0; i < Heap.size(); ++i)
+	{
+		const TimelineEvent& l_event = Events[Heap[i].Slot];
+		if (l_event.Type == MADTimelineEventType::Script)
+		{
+			unsigned int& l_generation = l_generations[Heap[i].Slot];
+			l_generation = l_generation + 1 == 0 ? 1 : l_generation + 1;
+			l_free_slots.push_back(Heap[i].Slot);
+			continue;
+		}
+		/*Copied field by field over zeroed padding,so snapshots of equal timelines are byte-identical*/
+		l_events.emplace_back();
+		SnapshotEvent& l_record = l_events.back();
+		std::memset(static_cast<void*>(&l_record), 0, sizeof(l_record));
+		l_record.Node.Due = Heap[i].Due;
+		l_record.Node.Order = Heap[i].Order;
+		l_record.Node.Slot = Heap[i].Slot;
+		l_record.Type = l_event.Type;
+		l_record.Pattern = l_event.Pattern;
+		l_record.Info.Position = l_event.Info.Position;
+		l_record.Info.Direction = l_event.Info.Direction;
+		l_record.Info.Speed = l_event.Info.Speed;
+		l_record.Info.TeamMask = l_event.Info.TeamMask;
+		l_record.Info.Target = l_event.Info.Target;
+		for (int k = 0; k < MAD_PATTERN_MAX_PARAM; ++k)
+		{
+			l_record.Info.Params[k] = l_event.Info.Params[k];
+		}
+		l_record.UserData = l_event.UserData;
+	}
+
+	MADBlobWriter l_writer(out_data);
+	l_writer.Write(MAD_TIMELINE_SNAPSHOT_TAG);
+	l_writer.Write(Tick);
+	l_writer.Write(NextOrder);
+	l_writer.WriteArray(l_generations);
+	l_writer.WriteArray(l_free_slots);
+	l_writer.WriteArray(l_events);
+	return out_data.size() - l_begin;
+}
+
+/**
+ * 从快照中恢复时间线,恢复前登记的所有事件(包括Script事件)都会被取消。
+ * 快照数据损坏、不完整,或Pattern事件引用的模式在当前模式解释器中不存在时,所有事件被取消。
+ *
+ * @param io_reader 指向一份由Snapshot写入的数据,读取后前进到该数据之后
+ * @return 成功时返回true
+ */
+bool MADEmitterTimeline::Restore(MADBlobReader& io_reader)
+{
+	unsigned int l_tag = 0;
+	unsigned long long l_tick = 0;
+	unsigned long long l_next_order = 0;
+	std::vector<unsigned int> l_generations;
+	std::vector<unsigned int> l_free_slots;
+	std::vector<SnapshotEvent> l_events;
+	io_reader.Read(&l_tag);
+	io_reader.Read(&l_tick);
+	io_reader.Read(&l_next_order);
+	io_reader.ReadArray(l_generations);
+	io_reader.ReadArray(l_free_slots);
+	io_reader.ReadArray(l_events);
+
+	/*Every slot is either free or holds exactly one pending event,and events are due after the saved tick*/
+	bool l_valid = !io_reader.IsFailed() && l_tag == MAD_TIMELINE_SNAPSHOT_TAG &&
+		l_generations.size() < MAD_PATTERN_INVALID_INDEX && l_free_slots.size() <= l_generations.size() &&
+		l_events.size() == l_generations.size() - l_free_slots.size();
+	std::sort(l_events.begin(), l_events.end(), [](const SnapshotEvent& _a, const SnapshotEvent& _b) {
+		return KeyLess(_a.Node.Due, _a.Node.Order, _b.Node.Due, _b.Node.Order);
+	});
+	std::vector<unsigned char> l_used(l_valid ? l_generations.size() : 0, 0);
+	for (size_t i = 0; l_valid && i < l_generations.size(); ++i)
+	{
+		l_valid = l_generations[i] != 0;
+	}
+	for (size_t i = 0; l_valid && i < l_free_slots.size(); ++i)
+	{
+		l_valid = l_free_slots[i] < l_used.size() && l_used[l_free_slots[i]] == 0;
+		if (l_valid)
+		{
+			l_used[l_free_slots[i]] = 1;
+		}
+	}
+	const MADPatternProgram* l_program = Runner != nullptr ? Runner->GetProgram() : nullptr;
+	for (size_t i = 0; l_valid && i < l_events.size(); ++i)
+	{
+		const SnapshotEvent& l_record = l_events[i];
+		l_valid = l_record.Node.Slot < l_used.size() && l_used[l_record.Node.Slot] == 0 &&
+			l_record.Node.Due > l_tick && l_record.Node.Order < l_next_order &&
+			(i == 0 || KeyLess(l_events[i - 1].Node.Due, l_events[i - 1].Node.Order, l_record.Node.Due, l_record.Node.Order)) &&
+			(l_record.Type == MADTimelineEventType::User ||
+				(l_record.Type == MADTimelineEventType::Pattern && l_program != nullptr && l_record.Pattern < l_program->GetPatternNum()));
+		if (l_valid)
+		{
+			l_used[l_record.Node.Slot] = 1;
+		}
+	}
+
+	Clear();
+	if (!l_valid)
+	{
+		MAD_LOG_ERR("Try to restore an emitter timeline from a broken snapshot!");
+		return false;
+	}
+
+	/*A sorted array is already a valid min-heap*/
+	Events.assign(l_generations.size(), TimelineEvent());
+	for (size_t i = 0; i < l_generations.size(); ++i)
+	{
+		Events[i].Generation = l_generations[i];
+	}
+	FreeSlots = l_free_slots;
+	Heap.resize(l_events.size());
+	for (size_t i = 0; i < l_events.size(); ++i)
+	{
+		const SnapshotEvent& l_record = l_events[i];
+		TimelineEvent& l_event = Events[l_record.Node.Slot];
+		l_event.Type = l_record.Type;
+		l_event.Pattern = l_record.Pattern;
+		l_event.Info = l_record.Info;
+		l_event.UserData = l_record.UserData;
+		Place(i, l_record.Node);
+	}
+	Tick = l_tick;
+	NextOrder = l_next_order;
+	return true;
+}
+
+/**
+ * 将本对象绑定到脚本,并向脚本注册SchedulePattern、ScheduleCall与CancelScheduled三个函数。
+ * 本对象的指针装在一个由注册表持有的userdata中,作为三个函数的upvalue,脚本中没有可以改写它的全局变量;
+ * 取出指针前会检查userdata的元表,本对象析构或解除绑定时指针会被清空。
+ *
+ * @param _script 登记发射计划的脚本
+ *
+ * 注意:
+ * - 一个脚本同时只能绑定一个MADEmitterTimeline,重复绑定会覆盖之前的绑定。
+ * - 改为绑定另一个脚本时,会先解除之前的绑定,之前脚本登记的Script事件会被取消。
+ */
+void MADEmitterTimeline::BindScript(MADScript* _script)
+{
+	if (_script == nullptr)
+	{
+		MAD_LOG_ERR("Try to bind emitter timeline to a null script!");
+		return;
+	}
+	if (Script != _script || !HasScript())
+	{
+		Unbind();
+	}
+	if (_script->GetScriptState() == MADScriptState::Deleted)
+	{
+		MAD_LOG_ERR("Try to bind emitter timeline to a deleted script!");
+		return;
+	}
+	lua_State* L = _script->GetLuaState();
+	luaL_newmetatable(L, MAD_TIMELINE_LUA_TIMELINE);
+	lua_pop(L, 1);
+
+	/*Binding the same script again reuses the box,so the functions of both bindings stay valid*/
+	if (BindingRef == LUA_NOREF)
+	{
+		MADEmitterTimeline** l_binding = static_cast<MADEmitterTimeline**>(lua_newuserdatauv(L, sizeof(MADEmitterTimeline*), 0));
+		*l_binding = this;
+		luaL_setmetatable(L, MAD_TIMELINE_LUA_TIMELINE);
+		BindingRef = luaL_ref(L, LUA_REGISTRYINDEX);
+	}
+	lua_rawgeti(L, LUA_REGISTRYINDEX, BindingRef);
+	lua_pushvalue(L, -1);
+	lua_pushcclosure(L, SchedulePatternFromLua, 1);
+	lua_setglobal(L, "SchedulePattern");
+	lua_pushvalue(L, -1);
+	lua_pushcclosure(L, ScheduleCallFromLua, 1);
+	lua_setglobal(L, "ScheduleCall");
+	lua_pushcclosure(L, CancelScheduledFromLua, 1);
+	lua_setglobal(L, "CancelScheduled");
+
+	Script = _script;
+	BoundState = L;
+}
+
+/**
+ * 解除与脚本的绑定,取消所有等待中的Script事件,Pattern与User事件不受影响。
+ * 脚本中的SchedulePattern、ScheduleCall与CancelScheduled之后只会返回失败。
+ */
+void MADEmitterTimeline::Unbind()
+{
+	if (Script == nullptr)
+	{
+		return;
+	}
+	std::vector<MADTimelineHandle> l_stale;
+	for (size_t i = 0; i < Heap.size(); ++i)
+	{
+		const TimelineEvent& l_event = Events[Heap[i].Slot];
+		if (l_event.Type == MADTimelineEventType::Script)
+		{
+			l_stale.push_back((static_cast<unsigned long long>(l_event.Generation) << 32) | Heap[i].Slot);
+		}
+	}
+	for (size_t i = 0; i < l_stale.size(); ++i)
+	{
+		Cancel(l_stale[i]);
+	}
+	if (HasScript())
+	{
+		lua_rawgeti(BoundState, LUA_REGISTRYINDEX, BindingRef);
+		*static_cast<MADEmitterTimeline**>(lua_touserdata(BoundState, -1)) = nullptr;
+		lua_pop(BoundState, 1);
+		luaL_unref(BoundState, LUA_REGISTRYINDEX, BindingRef);
+	}
+	Script = nullptr;
+	BoundState = nullptr;
+	BindingRef = LUA_NOREF;
+}
+
+/**
+ * (内部回调函数,禁止主动调用)
+ * Lua: SchedulePattern(delay, name, x, y, dir, speed, team, target, ...)
+ * delay之后的参数与StartPattern相同。
+ *
+ * @param L 当前的Lua状态机指针。
+ * @return 返回1,向Lua返回事件句柄(失败时为0)。
+ */
+int MADEmitterTimeline::SchedulePatternFromLua(lua_State* L)
+{
+	MADEmitterTimeline* l_timeline = GetTimelineFromLua(L);
+	if (l_timeline == nullptr || !lua_isnumber(L, 1) || lua_type(L, 2) != LUA_TSTRING)
+	{
+		MAD_LOG_ERR("[LuaScript]Illegal call for SchedulePattern.A delay and a pattern name are needed and the script must be bound to a timeline.");
+		lua_pushinteger(L, 0);
+		return 1;
+	}
+
+	MADPatternStartInfo l_info;
+	MADPatternRunner::ReadStartInfo(L, 3, &l_info);
+	lua_Integer l_delay = std::max<lua_Integer>(lua_tointeger(L, 1), 0);
+	MADTimelineHandle l_handle = l_timeline->SchedulePattern(static_cast<unsigned long long>(l_delay), MADString(lua_tostring(L, 2)), l_info);
+	lua_pushinteger(L, static_cast<lua_Integer>(l_handle));
+	return 1;
+}
+
+/**
+ * (内部回调函数,禁止主动调用)
+ * Lua: ScheduleCall(delay, func)
+ * func会在到期时以无参数的形式调用,需要的数据请通过闭包捕获。
+ *
+ * @param L 当前的Lua状态机指针。
+ * @return 返回1,向Lua返回事件句柄(失败时为0)。
+ */
+int MADEmitterTimeline::ScheduleCallFromLua(lua_State* L)
+{
+	MADEmitterTimeline* l_timeline = GetTimelineFromLua(L);
+	if (l_timeline == nullptr || !lua_isnumber(L, 1) || !lua_isfunction(L, 2))
+	{
+		MAD_LOG_ERR("[LuaScript]Illegal call for ScheduleCall.A delay and a function are needed and the script must be bound to a timeline.");
+		lua_pushinteger(L, 0);
+		return 1;
+	}
+
+	TimelineEvent l_event;
+	l_event.Type = MADTimelineEventType::Script;
+	lua_pushvalue(L, 2);
+	l_event.ScriptRef = luaL_ref(L, LUA_REGISTRYINDEX);
+	lua_Integer l_delay = std::max<lua_Integer>(lua_tointeger(L, 1), 0);
+	lua_pushinteger(L, static_cast<lua_Integer>(l_timeline->Push(static_cast<unsigned long long>(l_delay), l_event)));
+	return 1;
+}
+
+/**
+ * (内部回调函数,禁止主动调用)
+ * Lua: CancelScheduled(handle)
+ *
+ * @param L 当前的Lua状态机指针。
+ * @return 返回1,向Lua返回事件是否被取消。
+ */
+int MADEmitterTimeline::CancelScheduledFromLua(lua_State* L)
+{
+	MADEmitterTimeline* l_timeline = GetTimelineFromLua(L);
+	if (l_timeline == nullptr || !lua_isinteger(L, 1))
+	{
+		MAD_LOG_ERR("[LuaScript]Illegal call for CancelScheduled.An event handle is needed.");
+		lua_pushboolean(L, 0);
+		return 1;
+	}
+	lua_pushboolean(L, l_timeline->Cancel(static_cast<MADTimelineHandle>(lua_tointeger(L, 1))));
+	return 1;
+}
+
+/**
+ * (内部函数)
+ * 从Lua函数的upvalue中取出绑定的时间线。
+ *
+ * @param L 当前的Lua状态机指针。
+ * @return 时间线;函数不是由BindScript注册的,或时间线已经析构、解除绑定时返回nullptr。
+ */
+MADEmitterTimeline* MADEmitterTimeline::GetTimelineFromLua(lua_State* L)
+{
+	MADEmitterTimeline** l_binding = static_cast<MADEmitterTimeline**>(luaL_testudata(L, lua_upvalueindex(1), MAD_TIMELINE_LUA_TIMELINE));
+	return l_binding != nullptr ? *l_binding : nullptr;
+}
+
+/**
+ * (内部函数)
+ * 将事件放入一个空闲槽位并加入堆中。
+ *
+ * @return 事件句柄
+ */
+MADTimelineHandle MADEmitterTimeline::Push(unsigned long long _delay, const TimelineEvent& _event)
+{
+	size_t l_slot;
+	if (!FreeSlots.empty())
+	{
+		l_slot = FreeSlots.back();
+		FreeSlots.pop_back();
+	}
+	else
+	{
+		l_slot = Events.size();
+		Events.push_back(TimelineEvent());
+	}
+	unsigned int l_generation = Events[l_slot].Generation;
+	Events[l_slot] = _event;
+	Events[l_slot].Generation = l_generation;
+
+	HeapNode l_node;
+	l_node.Due = Tick + std::max<unsigned long long>(_delay, 1);
+	l_node.Order = NextOrder++;
+	l_node.Slot = static_cast<unsigned int>(l_slot);
+	Heap.push_back(l_node);
+	Events[l_slot].HeapPos = static_cast<unsigned int>(Heap.size() - 1);
+	SiftUp(Heap.size() - 1);
+	return (static_cast<unsigned long long>(l_generation) << 32) | l_slot;
+}
+
+/**
+ * (内部函数)
+ * 将句柄解析为等待中的事件槽位,句柄无效或事件已不在堆中时返回MAD_PATTERN_INVALID_INDEX。
+ */
+size_t MADEmitterTimeline::Find(MADTimelineHandle _handle) const
+{
+	size_t l_slot = static_cast<size_t>(_handle & 0xFFFFFFFFull);
+	unsigned int l_generation = static_cast<unsigned int>(_handle >> 32);
+	if (l_slot >= Events.size() || Events[l_slot].Generation != l_generation ||
+		Events[l_slot].HeapPos == MAD_PATTERN_INVALID_INDEX)
+	{
+		return MAD_PATTERN_INVALID_INDEX;
+	}
+	return l_slot;
+}
+
+/**
+ * (内部函数)
+ * 检查绑定的脚本是否仍可用于释放与调用Lua函数引用。
+ */
+bool MADEmitterTimeline::HasScript()
+{
+	return Script != nullptr && Script->GetScriptState() != MADScriptState::Deleted && Script->GetLuaState() == BoundState;
+}
+
+/**
+ * (内部函数)
+ * 释放一个已移出堆的槽位:释放其Lua函数引用并递增代数,使旧句柄失效。
+ */
+void MADEmitterTimeline::Release(size_t _slot)
+{
+	TimelineEvent& l_event = Events[_slot];
+	if (l_event.ScriptRef != LUA_NOREF && HasScript())
+	{
+		luaL_unref(BoundState, LUA_REGISTRYINDEX, l_event.ScriptRef);
+	}
+	l_event.ScriptRef = LUA_NOREF;
+	l_event.HeapPos = MAD_PATTERN_INVALID_INDEX;
+	l_event.Generation = l_event.Generation + 1 == 0 ? 1 : l_event.Generation + 1;
+	FreeSlots.push_back(static_cast<unsigned int>(_slot));
+}
+
+/**
+ * (内部函数)
+ * 从堆中移除指定位置的节点,用堆尾节点填补并恢复堆序。
+ */
+void MADEmitterTimeline::RemoveAt(size_t _pos)
+{
+	HeapNode l_last = Heap.back();
+	Heap.pop_back();
+	if (_pos < Heap.size())
+	{
+		Place(_pos, l_last);
+		SiftDown(_pos);
+		SiftUp(Events[l_last.Slot].HeapPos);
+	}
+}
+
+/**
+ * (内部函数)
+ * 将节点向堆顶方向移动到合适的位置。
+ */
+void MADEmitterTimeline::SiftUp(size_t _pos)
+{
+	HeapNode l_node = Heap[_pos];
+	while (_pos > 0)
+	{
+		size_t l_parent = (_pos - 1) / 2;
+		if (!KeyLess(l_node.Due, l_node.Order, Heap[l_parent].Due, Heap[l_parent].Order))
+		{
+			break;
+		}
+		Place(_pos, Heap[l_parent]);
+		_pos = l_parent;
+	}
+	Place(_pos, l_node);
+}
+
+/**
+ * (内部函数)
+ * 将节点向堆底方向移动到合适的位置。
+ */
+void MADEmitterTimeline::SiftDown(size_t _pos)
+{
+	HeapNode l_node = Heap[_pos];
+	size_t l_num = Heap.size();
+	while (true)
+	{
+		size_t l_child = _pos * 2 + 1;
+		if (l_child >= l_num)
+		{
+			break;
+		}
+		if (l_child + 1 < l_num && KeyLess(Heap[l_child + 1].Due, Heap[l_child + 1].Order, Heap[l_child].Due, Heap[l_child].Order))
+		{
+			l_child++;
+		}
+		if (!KeyLess(Heap[l_child].Due, Heap[l_child].Order, l_node.Due, l_node.Order))
+		{
+			break;
+		}
+		Place(_pos, Heap[l_child]);
+		_pos = l_child;
+	}
+	Place(_pos, l_node);
+}
+
+/**
+ * (内部函数)
+ * 将节点写入堆中的指定位置,并同步其槽位记录的堆位置。
+ */
+void MADEmitterTimeline::Place(size_t _pos, const HeapNode& _node)
+{
+	Heap[_pos] = _node;
+	Events[_node.Slot].HeapPos = static_cast<unsigned int>(_pos);
+}
@@ -0,0 +1,148 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "mad_pattern_runner.h"
+
+/*Tag written at the start of an emitter timeline snapshot*/
+#define MAD_TIMELINE_SNAPSHOT_TAG 0x4E4C4D54u
+
+/*Name of the metatable of the boxed timeline pointer used by the Lua binding*/
+#define MAD_TIMELINE_LUA_TIMELINE "MAD_EmitterTimeline"
+
+/**
+ * \brief MADTimelineHandle 是时间线上一个待触发事件的句柄,0 表示无效句柄。
+ *
+ * 高32位为槽位代数,低32位为槽位索引,事件触发或取消后旧句柄自动失效。
+ */
+typedef unsigned long long MADTimelineHandle;
+
+/**
+ * \brief MADTimelineEventType 枚举定义了时间线事件到期时的动作。
+ *
+ * - Pattern: 通过MADPatternRunner启动一个发射器
+ * - Script: 调用绑定脚本中登记的Lua函数
+ * - User: 不执行任何动作,将UserData原样交给调用者处理
+ */
+enum class MADTimelineEventType : unsigned char { Pattern = 0, Script, User };
+
+/**
+ * MADEmitterTimeline 是按tick排序的发射计划表,用于关卡脚本中大量"N帧之后在某处发射某种弹幕"的延迟事件。
+ *
+ * 在Lua中用计时表实现时,每帧都要经过CallMain轮询所有未到期的计时器;
+ * 本类把所有事件放在以 (到期tick, 登记顺序) 为键的二叉堆中,每个tick只检查堆顶,
+ * 只有到期的事件才会被取出执行,代价与到期事件数量成正比,与等待中的事件数量无关:
+ * - 登记与取消都为 O(log n),取消通过句柄直接定位堆中的位置,不会留下空事件;
+ * - 同一tick到期的事件严格按登记顺序触发,结果是确定的。
+ *
+ * Lua只需在事件登记时调用一次,BindScript之后,脚本中可以调用
+ *     local h = SchedulePattern(delay, name, x, y, dir, speed, team, target, $1, $2, ...)
+ *     local h = ScheduleCall(delay, function() ... end)
+ *     CancelScheduled(h)
+ * SchedulePattern的参数与StartPattern相同,只是多了最前面的延迟。
+ *
+ * 注意:
+ * - 本对象持有MADPatternRunner的指针,请保证其生命周期长于本对象;不需要发射器时可以传入nullptr,此时只能登记Script与User事件。
+ * - Script事件持有Lua函数的引用,请保证绑定的脚本生命周期长于本对象,或在删除脚本前调用Unbind;
+ *   本对象析构或解除绑定后,脚本中的SchedulePattern、ScheduleCall与CancelScheduled只会报错并返回失败。
+ * - Snapshot保存当前tick、登记顺序、所有槽位的代数与等待中的Pattern/User事件,恢复后旧句柄仍然有效,触发顺序与保存时一致;
+ *   Script事件中的Lua函数无法序列化,不会写入快照,恢复时会被取消,需要由脚本重新登记。
+ * - 该类是线程不安全的!
+ */
+class MADEmitterTimeline
+{
+public:
+	MADEmitterTimeline(MADPatternRunner* _runner, unsigned long long _tick = 0);
+	~MADEmitterTimeline();
+
+private:
+	typedef struct TimelineEvent
+	{
+		unsigned int Generation = 1;
+		unsigned int HeapPos = MAD_PATTERN_INVALID_INDEX;
+		MADTimelineEventType Type = MADTimelineEventType::User;
+		unsigned int Pattern = 0;
+		MADPatternStartInfo Info = MADPatternStartInfo();
+		int ScriptRef = LUA_NOREF;
+		unsigned long long UserData = 0;
+	}TimelineEvent;
+
+	typedef struct HeapNode
+	{
+		unsigned long long Due = 0;
+		unsigned long long Order = 0;
+		unsigned int Slot = 0;
+	}HeapNode;
+
+	typedef struct SnapshotEvent
+	{
+		HeapNode Node = HeapNode();
+		MADTimelineEventType Type = MADTimelineEventType::User;
+		unsigned int Pattern = 0;
+		MADPatternStartInfo Info = MADPatternStartInfo();
+		unsigned long long UserData = 0;
+	}SnapshotEvent;
+
+public:
+	/*Schedule*/
+	MADTimelineHandle SchedulePattern(unsigned long long _delay, unsigned int _pattern, const MADPatternStartInfo& _info);
+	MADTimelineHandle SchedulePattern(unsigned long long _delay, const MADString& _name, const MADPatternStartInfo& _info);
+	MADTimelineHandle ScheduleUser(unsigned long long _delay, unsigned long long _user_data);
+	bool Cancel(MADTimelineHandle _handle);
+	void Clear();
+	void Reserve(size_t _capacity);
+
+	/*Advance*/
+	size_t Advance(std::vector<unsigned long long>* out_user = nullptr);
+
+	/*Get Data*/
+	unsigned long long GetTick() const;
+	size_t GetNum() const;
+	bool IsPending(MADTimelineHandle _handle) const;
+	unsigned long long GetDue(MADTimelineHandle _handle) const;
+
+	/*Snapshot*/
+	size_t Snapshot(std::vector<unsigned char>& out_data) const;
+	bool Restore(MADBlobReader& io_reader);
+
+	/*Lua binding*/
+	void BindScript(MADScript* _script);
+	void Unbind();
+
+	/*Lua API Function*/
+	static int SchedulePatternFromLua(lua_State* L);
+	static int ScheduleCallFromLua(lua_State* L);
+	static int CancelScheduledFromLua(lua_State* L);
+
+private:
+	MADPatternRunner* Runner;
+	unsigned long long Tick;
+	unsigned long long NextOrder;
+
+	/*Event slots and the (due, order) min-heap over them*/
+	std::vector<TimelineEvent> Events;
+	std::vector<unsigned int> FreeSlots;
+	std::vector<HeapNode> Heap;
+
+	/*Binding,the Lua functions reach this object through a boxed pointer held in BindingRef*/
+	MADScript* Script;
+	lua_State* BoundState;
+	int BindingRef;
+
+	/*Common function*/
+	MADTimelineHandle Push(unsigned long long _delay, const TimelineEvent& _event);
+	size_t Find(MADTimelineHandle _handle) const;
+	bool HasScript();
+	void Release(size_t _slot);
+	void RemoveAt(size_t _pos);
+	void SiftUp(size_t _pos);
+	void SiftDown(size_t _pos);
+	void Place(size_t _pos, const HeapNode& _node);
+	static MADEmitterTimeline* GetTimelineFromLua(lua_State* L);
+};
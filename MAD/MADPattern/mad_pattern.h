@@ -0,0 +1,12 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+/*MAD APIs*/
+#include "mad_pattern_program.h"
+#include "mad_pattern_runner.h"
+#include "mad_emitter_timeline.h"
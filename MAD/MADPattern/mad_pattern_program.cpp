@@ -0,0 +1,780 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_pattern_program.h"
+
+#include <cstdlib>
+#include <cstring>
+
+enum class PatternTokenType { Identifier, Number, Variable, Symbol, Newline, Eof };
+
+struct PatternToken {
+	PatternTokenType Type;
+	MADString Text;
+	float Value;
+	int Line;
+};
+
+struct PatternExprInfo {
+	bool IsConst;
+	float Value;
+	size_t Start;
+};
+
+/**
+ * (内部类)
+ * 模式文本的单遍编译器:逐个读取记号,递归下降解析语句与表达式,直接生成字节码。
+ * 出错时记录第一条错误信息并停止解析。
+ */
+class PatternCompiler
+{
+public:
+	/**
+	 * 构造编译器并读入第一个记号,生成的字节码与模式表直接写入传入的数组。
+	 *
+	 * @param _text 模式文本
+	 * @param _code 字节码输出
+	 * @param _names 模式名称输出
+	 * @param _entries 模式入口地址输出
+	 */
+	PatternCompiler(const MADString& _text, std::vector<unsigned int>& _code,
+		std::vector<MADString>& _names, std::vector<unsigned int>& _entries)
+		: Text(_text), Code(_code), PatternNames(_names), PatternEntries(_entries)
+	{
+		Pos = 0;
+		Line = 1;
+		LoopDepth = 0;
+		Next();
+	}
+
+	/**
+	 * 编译全部文本,每个 pattern ... end 生成一个以End结尾的模式。
+	 *
+	 * @return 成功时返回true;失败时可通过GetError获取错误信息
+	 */
+	bool Run()
+	{
+		while (Error.empty())
+		{
+			SkipNewlines();
+			if (Token.Type == PatternTokenType::Eof)
+			{
+				break;
+			}
+			if (!IsKeyword("pattern"))
+			{
+				Fail("Expect 'pattern' but got '" + Token.Text + "'.");
+				break;
+			}
+			Next();
+			if (Token.Type != PatternTokenType::Identifier)
+			{
+				Fail("Expect a pattern name.");
+				break;
+			}
+			for (const MADString& l_name : PatternNames)
+			{
+				if (l_name == Token.Text)
+				{
+					Fail("Pattern '" + Token.Text + "' is defined twice.");
+					return false;
+				}
+			}
+			PatternNames.push_back(Token.Text);
+			PatternEntries.push_back(static_cast<unsigned int>(Code.size()));
+			Next();
+			ExpectEndOfLine();
+			ParseBlock();
+			Emit(MADPatternOp::End);
+		}
+		return Error.empty();
+	}
+
+	/**
+	 * 获取第一条错误信息。
+	 *
+	 * @return 错误信息,没有错误时为空
+	 */
+	const MADString& GetError() const
+	{
+		return Error;
+	}
+
+private:
+	const MADString& Text;
+	std::vector<unsigned int>& Code;
+	std::vector<MADString>& PatternNames;
+	std::vector<unsigned int>& PatternEntries;
+
+	size_t Pos;
+	int Line;
+	int LoopDepth;
+	PatternToken Token;
+	MADString Error;
+
+	/*Lexer*/
+	/**
+	 * 读取下一个记号到Token,跳过空白与注释,换行本身也是一个记号。
+	 */
+	void Next()
+	{
+		while (Pos < Text.size())
+		{
+			char l_char = Text[Pos];
+			if (l_char == '#')
+			{
+				while (Pos < Text.size() && Text[Pos] != '\n')
+				{
+					Pos++;
+				}
+			}
+			else if (l_char == ' ' || l_char == '\t' || l_char == '\r')
+			{
+				Pos++;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		Token.Line = Line;
+		Token.Value = 0.0f;
+		Token.Text.clear();
+		if (Pos >= Text.size())
+		{
+			Token.Type = PatternTokenType::Eof;
+			return;
+		}
+
+		char l_char = Text[Pos];
+		if (l_char == '\n')
+		{
+			Token.Type = PatternTokenType::Newline;
+			Token.Text = "\\n";
+			Pos++;
+			Line++;
+		}
+		else if (IsIdentChar(l_char) && !IsDigit(l_char))
+		{
+			Token.Type = PatternTokenType::Identifier;
+			size_t l_start = Pos;
+			while (Pos < Text.size() && IsIdentChar(Text[Pos]))
+			{
+				Pos++;
+			}
+			Token.Text = Text.substr(l_start, Pos - l_start);
+		}
+		else if (l_char == '$')
+		{
+			Token.Type = PatternTokenType::Variable;
+			size_t l_start = ++Pos;
+			while (Pos < Text.size() && IsIdentChar(Text[Pos]))
+			{
+				Pos++;
+			}
+			Token.Text = Text.substr(l_start, Pos - l_start);
+		}
+		else if (IsDigit(l_char) || (l_char == '.' && Pos + 1 < Text.size() && IsDigit(Text[Pos + 1])))
+		{
+			Token.Type = PatternTokenType::Number;
+			const char* l_begin = Text.c_str() + Pos;
+			char* l_end = nullptr;
+			Token.Value = static_cast<float>(strtod(l_begin, &l_end));
+			if (l_end == l_begin)
+			{
+				l_end++;
+			}
+			Token.Text = Text.substr(Pos, l_end - l_begin);
+			Pos += l_end - l_begin;
+		}
+		else
+		{
+			Token.Type = PatternTokenType::Symbol;
+			Token.Text = MADString(1, l_char);
+			Pos++;
+		}
+	}
+
+	/**
+	 * 判断字符是否为十进制数字。
+	 */
+	static bool IsDigit(char _char)
+	{
+		return _char >= '0' && _char <= '9';
+	}
+
+	/**
+	 * 判断字符能否出现在标识符或变量名中。
+	 */
+	static bool IsIdentChar(char _char)
+	{
+		return IsDigit(_char) || _char == '_' || (_char >= 'a' && _char <= 'z') || (_char >= 'A' && _char <= 'Z');
+	}
+
+	/**
+	 * 判断当前记号是否为指定的关键字。
+	 */
+	bool IsKeyword(const char* _keyword) const
+	{
+		return Token.Type == PatternTokenType::Identifier && Token.Text == _keyword;
+	}
+
+	/**
+	 * 判断当前记号是否为指定的符号。
+	 */
+	bool IsSymbol(char _symbol) const
+	{
+		return Token.Type == PatternTokenType::Symbol && Token.Text[0] == _symbol;
+	}
+
+	/**
+	 * 跳过连续的换行记号,用于空行与注释行。
+	 */
+	void SkipNewlines()
+	{
+		while (Token.Type == PatternTokenType::Newline)
+		{
+			Next();
+		}
+	}
+
+	/**
+	 * 记录一条带行号的错误信息,只保留第一条。
+	 *
+	 * @param _reason 错误描述
+	 */
+	void Fail(const MADString& _reason)
+	{
+		if (Error.empty())
+		{
+			Error = "Line " + std::to_string(Token.Line) + ": " + _reason;
+		}
+	}
+
+	/**
+	 * 要求语句在此结束:消耗换行记号,文本结尾同样视为行尾,否则报错。
+	 */
+	void ExpectEndOfLine()
+	{
+		if (Token.Type == PatternTokenType::Newline)
+		{
+			Next();
+		}
+		else if (Token.Type != PatternTokenType::Eof)
+		{
+			Fail("Unexpected '" + Token.Text + "' at the end of statement.");
+		}
+	}
+
+	/*Emitter*/
+	/**
+	 * 写入一条语句指令。
+	 */
+	void Emit(MADPatternOp _op)
+	{
+		Code.push_back(static_cast<unsigned int>(_op));
+	}
+
+	/**
+	 * 写入一条表达式指令。
+	 */
+	void Emit(MADPatternExprOp _op)
+	{
+		Code.push_back(static_cast<unsigned int>(_op));
+	}
+
+	/**
+	 * 写入一条常量指令,常量以float的位模式储存在下一个字中。
+	 */
+	void EmitConst(float _value)
+	{
+		unsigned int l_bits;
+		memcpy(&l_bits, &_value, sizeof(l_bits));
+		Emit(MADPatternExprOp::Const);
+		Code.push_back(l_bits);
+	}
+
+	/*Statements*/
+	/**
+	 * 解析语句直到与之配对的end,end之后的换行也会被消耗。
+	 */
+	void ParseBlock()
+	{
+		while (Error.empty())
+		{
+			SkipNewlines();
+			if (Token.Type == PatternTokenType::Eof)
+			{
+				Fail("Missing 'end'.");
+				return;
+			}
+			if (IsKeyword("end"))
+			{
+				Next();
+				ExpectEndOfLine();
+				return;
+			}
+			ParseStatement();
+		}
+	}
+
+	/**
+	 * 解析一条语句并生成对应的指令。
+	 * repeat在循环体之后回填跳出地址,并限制嵌套深度不超过MAD_PATTERN_MAX_DEPTH。
+	 */
+	void ParseStatement()
+	{
+		if (IsKeyword("fire"))
+		{
+			Next();
+			Emit(MADPatternOp::Fire);
+			size_t l_modes = Code.size();
+			Code.push_back(0);
+			Code.push_back(0);
+			Code[l_modes] = ParseDirMode();
+			ParseExpression();
+			Code[l_modes + 1] = ParseSpeedMode();
+			ParseExpression();
+		}
+		else if (IsKeyword("repeat"))
+		{
+			Next();
+			if (LoopDepth >= MAD_PATTERN_MAX_DEPTH)
+			{
+				Fail("Repeat is nested too deeply,the limit is " + std::to_string(MAD_PATTERN_MAX_DEPTH) + ".");
+				return;
+			}
+			Emit(MADPatternOp::Repeat);
+			size_t l_skip = Code.size();
+			Code.push_back(0);
+			ParseExpression();
+			ExpectEndOfLine();
+			unsigned int l_body = static_cast<unsigned int>(Code.size());
+			LoopDepth++;
+			ParseBlock();
+			LoopDepth--;
+			Emit(MADPatternOp::RepeatEnd);
+			Code.push_back(l_body);
+			Code[l_skip] = static_cast<unsigned int>(Code.size());
+			return;
+		}
+		else if (IsKeyword("wait"))
+		{
+			Next();
+			Emit(MADPatternOp::Wait);
+			ParseExpression();
+		}
+		else if (IsKeyword("changeDirection"))
+		{
+			Next();
+			Emit(MADPatternOp::ChangeDirection);
+			size_t l_mode = Code.size();
+			Code.push_back(0);
+			Code[l_mode] = ParseDirMode();
+			ParseExpression();
+			ParseExpression();
+		}
+		else if (IsKeyword("changeSpeed"))
+		{
+			Next();
+			Emit(MADPatternOp::ChangeSpeed);
+			size_t l_mode = Code.size();
+			Code.push_back(0);
+			Code[l_mode] = ParseSpeedMode();
+			ParseExpression();
+			ParseExpression();
+		}
+		else if (IsKeyword("vanish"))
+		{
+			Next();
+			Emit(MADPatternOp::End);
+		}
+		else
+		{
+			Fail("Unknown statement '" + Token.Text + "'.");
+			return;
+		}
+		ExpectEndOfLine();
+	}
+
+	/**
+	 * 解析方向模式关键字。
+	 *
+	 * @return MADPatternDirMode的数值,出错时为0
+	 */
+	unsigned int ParseDirMode()
+	{
+		MADPatternDirMode l_mode = MADPatternDirMode::Aim;
+		if (IsKeyword("aim"))
+			l_mode = MADPatternDirMode::Aim;
+		else if (IsKeyword("abs"))
+			l_mode = MADPatternDirMode::Absolute;
+		else if (IsKeyword("rel"))
+			l_mode = MADPatternDirMode::Relative;
+		else if (IsKeyword("seq"))
+			l_mode = MADPatternDirMode::Sequence;
+		else
+		{
+			Fail("Expect direction mode 'aim','abs','rel' or 'seq' but got '" + Token.Text + "'.");
+			return 0;
+		}
+		Next();
+		return static_cast<unsigned int>(l_mode);
+	}
+
+	/**
+	 * 解析速度模式关键字。
+	 *
+	 * @return MADPatternSpeedMode的数值,出错时为0
+	 */
+	unsigned int ParseSpeedMode()
+	{
+		MADPatternSpeedMode l_mode = MADPatternSpeedMode::Absolute;
+		if (IsKeyword("abs"))
+			l_mode = MADPatternSpeedMode::Absolute;
+		else if (IsKeyword("rel"))
+			l_mode = MADPatternSpeedMode::Relative;
+		else if (IsKeyword("seq"))
+			l_mode = MADPatternSpeedMode::Sequence;
+		else
+		{
+			Fail("Expect speed mode 'abs','rel' or 'seq' but got '" + Token.Text + "'.");
+			return 0;
+		}
+		Next();
+		return static_cast<unsigned int>(l_mode);
+	}
+
+	/*Expressions*/
+	/**
+	 * 解析一个完整的表达式并写入End,求值所需的栈深度不得超过MAD_PATTERN_MAX_EXPR_STACK。
+	 */
+	void ParseExpression()
+	{
+		size_t l_start = Code.size();
+		ParseSum();
+		Emit(MADPatternExprOp::End);
+		if (Error.empty() && GetStackDepth(l_start) > MAD_PATTERN_MAX_EXPR_STACK)
+		{
+			Fail("Expression is too complex.");
+		}
+	}
+
+	/**
+	 * 解析加减法,左结合。
+	 *
+	 * @return 表达式的常量信息
+	 */
+	PatternExprInfo ParseSum()
+	{
+		PatternExprInfo l_left = ParseProduct();
+		while (Error.empty() && (IsSymbol('+') || IsSymbol('-')))
+		{
+			char l_op = Token.Text[0];
+			Next();
+			PatternExprInfo l_right = ParseProduct();
+			l_left = Fold(l_left, l_right, l_op == '+' ? MADPatternExprOp::Add : MADPatternExprOp::Sub);
+		}
+		return l_left;
+	}
+
+	/**
+	 * 解析乘除法,左结合。
+	 *
+	 * @return 表达式的常量信息
+	 */
+	PatternExprInfo ParseProduct()
+	{
+		PatternExprInfo l_left = ParseUnary();
+		while (Error.empty() && (IsSymbol('*') || IsSymbol('/')))
+		{
+			char l_op = Token.Text[0];
+			Next();
+			PatternExprInfo l_right = ParseUnary();
+			l_left = Fold(l_left, l_right, l_op == '*' ? MADPatternExprOp::Mul : MADPatternExprOp::Div);
+		}
+		return l_left;
+	}
+
+	/**
+	 * 解析取负,常量直接折叠为相反数。
+	 *
+	 * @return 表达式的常量信息
+	 */
+	PatternExprInfo ParseUnary()
+	{
+		if (IsSymbol('-'))
+		{
+			Next();
+			PatternExprInfo l_value = ParseUnary();
+			if (l_value.IsConst)
+			{
+				Code.resize(l_value.Start);
+				l_value.Value = -l_value.Value;
+				EmitConst(l_value.Value);
+			}
+			else
+			{
+				Emit(MADPatternExprOp::Neg);
+			}
+			return l_value;
+		}
+		return ParsePrimary();
+	}
+
+	/**
+	 * 解析数字、变量或括号中的表达式。
+	 * $loop只能在repeat之内使用,$1~$8对应启动参数。
+	 *
+	 * @return 表达式的常量信息
+	 */
+	PatternExprInfo ParsePrimary()
+	{
+		PatternExprInfo l_info;
+		l_info.IsConst = false;
+		l_info.Value = 0.0f;
+		l_info.Start = Code.size();
+
+		if (Token.Type == PatternTokenType::Number)
+		{
+			l_info.IsConst = true;
+			l_info.Value = Token.Value;
+			EmitConst(Token.Value);
+			Next();
+		}
+		else if (Token.Type == PatternTokenType::Variable)
+		{
+			const MADString& l_name = Token.Text;
+			if (l_name == "rand")
+				Emit(MADPatternExprOp::Rand);
+			else if (l_name == "rank")
+				Emit(MADPatternExprOp::Rank);
+			else if (l_name == "loop")
+			{
+				if (LoopDepth == 0)
+				{
+					Fail("$loop is used outside of repeat.");
+					return l_info;
+				}
+				Emit(MADPatternExprOp::Loop);
+			}
+			else if (l_name.size() == 1 && l_name[0] >= '1' && l_name[0] < '1' + MAD_PATTERN_MAX_PARAM)
+			{
+				Emit(MADPatternExprOp::Param);
+				Code.push_back(static_cast<unsigned int>(l_name[0] - '1'));
+			}
+			else
+			{
+				Fail("Unknown variable '$" + l_name + "'.");
+				return l_info;
+			}
+			Next();
+		}
+		else if (IsSymbol('('))
+		{
+			Next();
+			l_info = ParseSum();
+			if (!IsSymbol(')'))
+			{
+				Fail("Missing ')'.");
+				return l_info;
+			}
+			Next();
+		}
+		else
+		{
+			Fail("Expect an expression but got '" + Token.Text + "'.");
+		}
+		return l_info;
+	}
+
+	/**
+	 * 生成一个二元运算;两侧都是常量时撤销已写入的两个常量,改为写入折叠后的结果。
+	 * 除数为0时结果为0,与运行时的规则一致。
+	 *
+	 * @param _left 左操作数
+	 * @param _right 右操作数
+	 * @param _op 运算
+	 * @return 运算结果的常量信息
+	 */
+	PatternExprInfo Fold(const PatternExprInfo& _left, const PatternExprInfo& _right, MADPatternExprOp _op)
+	{
+		PatternExprInfo l_info = _left;
+		if (!_left.IsConst || !_right.IsConst)
+		{
+			l_info.IsConst = false;
+			Emit(_op);
+			return l_info;
+		}
+		switch (_op)
+		{
+		case MADPatternExprOp::Add: l_info.Value = _left.Value + _right.Value; break;
+		case MADPatternExprOp::Sub: l_info.Value = _left.Value - _right.Value; break;
+		case MADPatternExprOp::Mul: l_info.Value = _left.Value * _right.Value; break;
+		default: l_info.Value = _right.Value != 0.0f ? _left.Value / _right.Value : 0.0f; break;
+		}
+		Code.resize(_left.Start);
+		EmitConst(l_info.Value);
+		return l_info;
+	}
+
+	/**
+	 * 计算从 _start 开始的表达式求值时的最大栈深度。
+	 *
+	 * @param _start 表达式的起始地址
+	 * @return 最大栈深度
+	 */
+	size_t GetStackDepth(size_t _start) const
+	{
+		size_t l_depth = 0, l_max = 0;
+		for (size_t i = _start; i < Code.size(); ++i)
+		{
+			switch (static_cast<MADPatternExprOp>(Code[i]))
+			{
+			case MADPatternExprOp::Const:
+			case MADPatternExprOp::Param:
+				i++;
+				l_depth++;
+				break;
+			case MADPatternExprOp::Rand:
+			case MADPatternExprOp::Rank:
+			case MADPatternExprOp::Loop:
+				l_depth++;
+				break;
+			case MADPatternExprOp::Add:
+			case MADPatternExprOp::Sub:
+			case MADPatternExprOp::Mul:
+			case MADPatternExprOp::Div:
+				l_depth--;
+				break;
+			default:
+				break;
+			}
+			l_max = l_depth > l_max ? l_depth : l_max;
+		}
+		return l_max;
+	}
+};
+
+/**
+ * 构造一个空的模式库。
+ */
+MADPatternProgram::MADPatternProgram()
+{
+}
+
+/**
+ * MADPatternProgram析构函数。
+ */
+MADPatternProgram::~MADPatternProgram()
+{
+}
+
+/**
+ * 编译模式文本,替换当前的全部模式。
+ * 编译失败时模式库会被清空,错误信息中包含出错的行号。
+ *
+ * @param _text 模式文本,格式见类说明
+ * @return 成功时返回MAD_RESCODE_OK;文本有误时返回MAD_RESCODE_SYNTAX_ERROR及错误描述。
+ *
+ * 注意:
+ * - 正在运行的MADPatternRunner持有指向本对象的指针,请勿在其仍有发射器时重新编译。
+ */
+MADDebuggerInfo_HEAVY MADPatternProgram::Compile(const MADString& _text)
+{
+	Clear();
+	PatternCompiler l_compiler(_text, Code, PatternNames, PatternEntries);
+	if (l_compiler.Run())
+	{
+		return MADDebuggerInfo_HEAVY(MAD_RESCODE_OK);
+	}
+
+	MADString l_error_info = "Pattern compiled failed.Error detail: " + l_compiler.GetError();
+	MAD_LOG_ERR(l_error_info);
+	Clear();
+	return MADDebuggerInfo_HEAVY(MAD_RESCODE_SYNTAX_ERROR, l_error_info);
+}
+
+/**
+ * 清空模式库。
+ */
+void MADPatternProgram::Clear()
+{
+	Code.clear();
+	PatternNames.clear();
+	PatternEntries.clear();
+}
+
+/**
+ * 获取模式数量。
+ *
+ * @return 模式数量
+ */
+size_t MADPatternProgram::GetPatternNum() const
+{
+	return PatternNames.size();
+}
+
+/**
+ * 按名称查找模式。
+ *
+ * @param _name 模式名称
+ * @return 模式序号;找不到时返回MAD_PATTERN_INVALID_INDEX。
+ */
+unsigned int MADPatternProgram::FindPattern(const MADString& _name) const
+{
+	for (size_t i = 0; i < PatternNames.size(); ++i)
+	{
+		if (PatternNames[i] == _name)
+		{
+			return static_cast<unsigned int>(i);
+		}
+	}
+	return MAD_PATTERN_INVALID_INDEX;
+}
+
+/**
+ * 获取模式名称。
+ *
+ * @param _pattern 模式序号,必须小于GetPatternNum()
+ * @return 模式名称
+ */
+const MADString& MADPatternProgram::GetPatternName(unsigned int _pattern) const
+{
+	return PatternNames[_pattern];
+}
+
+/**
+ * 获取模式在字节码中的入口地址。
+ *
+ * @param _pattern 模式序号,必须小于GetPatternNum()
+ * @return 入口地址
+ */
+unsigned int MADPatternProgram::GetEntry(unsigned int _pattern) const
+{
+	return PatternEntries[_pattern];
+}
+
+/**
+ * 获取字节码。
+ *
+ * @return 字节码首地址
+ */
+const unsigned int* MADPatternProgram::GetCode() const
+{
+	return Code.data();
+}
+
+/**
+ * 获取字节码长度。
+ *
+ * @return 字节码的字数(32位)
+ */
+size_t MADPatternProgram::GetCodeSize() const
+{
+	return Code.size();
+}
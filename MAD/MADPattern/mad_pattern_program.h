@@ -0,0 +1,105 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "../MADBase/mad_base.h"
+
+/*Invalid pattern index*/
+#define MAD_PATTERN_INVALID_INDEX 0xFFFFFFFFu
+
+/*Interpreter limits, checked by the compiler*/
+#define MAD_PATTERN_MAX_PARAM 8
+#define MAD_PATTERN_MAX_DEPTH 8
+#define MAD_PATTERN_MAX_EXPR_STACK 16
+
+/**
+ * \brief MADPatternOp 枚举定义了弹幕模式字节码的指令。
+ *
+ * 指令布局(每格为一个32位字,<expr>为以Expr::End结尾的表达式):
+ * - End: [End] 模式结束,发射器被销毁
+ * - Fire: [Fire][方向模式][速度模式]<方向><速度> 在发射器位置生成一颗子弹
+ * - Repeat: [Repeat][跳出地址]<次数> 次数不大于0时跳到跳出地址,否则进入循环体
+ * - RepeatEnd: [RepeatEnd][循环体地址] 剩余次数大于0时跳回循环体
+ * - Wait: [Wait]<tick数> 暂停执行指定的tick数
+ * - ChangeDirection: [ChangeDirection][方向模式]<角度><tick数> 在若干tick内改变发射器方向
+ * - ChangeSpeed: [ChangeSpeed][速度模式]<速度><tick数> 在若干tick内改变发射器速度
+ */
+enum class MADPatternOp : unsigned int { End = 0, Fire, Repeat, RepeatEnd, Wait, ChangeDirection, ChangeSpeed };
+
+/**
+ * \brief MADPatternExprOp 枚举定义了表达式字节码的指令,表达式按逆波兰顺序求值。
+ *
+ * - Const: [Const][float位] 压入常量
+ * - Param: [Param][序号] 压入启动参数 $1~$8
+ * - Rand: 压入 [0, 1) 之间的随机数 $rand
+ * - Rank: 压入难度系数 $rank
+ * - Loop: 压入最内层循环的当前次数(从0开始) $loop
+ * - Add/Sub/Mul/Div/Neg: 四则运算与取负
+ */
+enum class MADPatternExprOp : unsigned int { End = 0, Const, Param, Rand, Rank, Loop, Add, Sub, Mul, Div, Neg };
+
+/**
+ * \brief 方向模式:aim(相对于瞄准目标的方向)、abs(绝对角度)、rel(相对于发射器方向)、seq(相对于上一发子弹的方向)。
+ */
+enum class MADPatternDirMode : unsigned int { Aim = 0, Absolute, Relative, Sequence };
+
+/**
+ * \brief 速度模式:abs(绝对速度)、rel(相对于发射器速度)、seq(相对于上一发子弹的速度)。
+ */
+enum class MADPatternSpeedMode : unsigned int { Absolute = 0, Relative, Sequence };
+
+/**
+ * MADPatternProgram 是编译后的弹幕模式库,一个程序中可以包含多个具名模式。
+ *
+ * 模式文本只需编译一次,之后由 MADPatternRunner 直接解释执行,发射子弹的过程中不再经过Lua。
+ * 文本格式为类BulletML的逐行语句,'#'之后为注释:
+ *
+ *     pattern ring
+ *         repeat $1
+ *             fire seq 360 / $1 abs $2
+ *         end
+ *         wait 30
+ *     end
+ *
+ * 语句:
+ * - pattern <名称> ... end: 定义一个模式
+ * - fire <aim|abs|rel|seq> <角度> <abs|rel|seq> <速度>
+ * - repeat <次数> ... end
+ * - wait <tick数>
+ * - changeDirection <aim|abs|rel|seq> <角度> <tick数>
+ * - changeSpeed <abs|rel|seq> <速度> <tick数>
+ * - vanish: 立即结束模式
+ *
+ * 表达式支持数字、+ - * / 、括号以及变量 $1~$8、$rand、$rank、$loop,常量子表达式在编译期折叠。
+ * 角度单位为度,0度指向+X方向,逆时针为正;速度单位为 单位/秒;时间单位为tick。
+ */
+class MADPatternProgram
+{
+public:
+	MADPatternProgram();
+	~MADPatternProgram();
+
+public:
+	/*Program operator*/
+	MADDebuggerInfo_HEAVY Compile(const MADString& _text);
+	void Clear();
+
+	/*Get Data*/
+	size_t GetPatternNum() const;
+	unsigned int FindPattern(const MADString& _name) const;
+	const MADString& GetPatternName(unsigned int _pattern) const;
+	unsigned int GetEntry(unsigned int _pattern) const;
+	const unsigned int* GetCode() const;
+	size_t GetCodeSize() const;
+
+private:
+	std::vector<unsigned int> Code;
+	std::vector<MADString> PatternNames;
+	std::vector<unsigned int> PatternEntries;
+};
@@ -0,0 +1,788 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_pattern_runner.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "../MADBase/mad_fp_strict.h"
+
+#define MAD_PATTERN_DEG_TO_RAD 0.017453292519943295f
+#define MAD_PATTERN_RAD_TO_DEG 57.29577951308232f
+
+static float WrapAngle(float _degree)
+{
+	_degree = MADStrictMath::Fmod(_degree, 360.0f);
+	if (_degree > 180.0f)
+	{
+		_degree -= 360.0f;
+	}
+	else if (_degree < -180.0f)
+	{
+		_degree += 360.0f;
+	}
+	return _degree;
+}
+
+static bool StopBroken()
+{
+	MAD_LOG_ERR("Pattern emitter met a broken instruction,it is stopped.");
+	return false;
+}
+
+static unsigned int ToTicks(float _value)
+{
+	if (!(_value >= 1.0f))
+	{
+		return 0;
+	}
+	return _value >= 4294967295.0f ? 0xFFFFFFFFu : static_cast<unsigned int>(_value);
+}
+
+/**
+ * 构造一个模式解释器。
+ *
+ * @param _program 编译好的模式库
+ * @param _seed $rand 使用的随机数种子
+ */
+MADPatternRunner::MADPatternRunner(const MADPatternProgram* _program, unsigned long long _seed)
+{
+	Program = _program;
+	NextHandle = 1;
+	Rank = 0.0f;
+	Script = nullptr;
+	BoundState = nullptr;
+	BindingRef = LUA_NOREF;
+	SetSeed(_seed);
+}
+
+/**
+ * MADPatternRunner析构函数,会解除与脚本的绑定。
+ */
+MADPatternRunner::~MADPatternRunner()
+{
+	Unbind();
+}
+
+/**
+ * 启动一个发射器,发射器会在下一次Step时开始执行。
+ *
+ * @param _pattern 模式序号
+ * @param _info 发射器的初始状态
+ * @return 发射器句柄;模式不存在时返回0。
+ */
+MADPatternHandle MADPatternRunner::Start(unsigned int _pattern, const MADPatternStartInfo& _info)
+{
+	if (Program == nullptr || _pattern >= Program->GetPatternNum())
+	{
+		MAD_LOG_ERR("Try to start a pattern which does not exist!");
+		return 0;
+	}
+
+	Emitter l_emitter;
+	l_emitter.Handle = NextHandle++;
+	l_emitter.Pc = Program->GetEntry(_pattern);
+	l_emitter.Position = _info.Position;
+	l_emitter.Direction = _info.Direction;
+	l_emitter.Speed = _info.Speed;
+	l_emitter.LastDirection = _info.Direction;
+	l_emitter.LastSpeed = _info.Speed;
+	l_emitter.TeamMask = _info.TeamMask;
+	l_emitter.Target = _info.Target;
+	memcpy(l_emitter.Params, _info.Params, sizeof(l_emitter.Params));
+	Emitters.push_back(l_emitter);
+	return l_emitter.Handle;
+}
+
+/**
+ * 按名称启动一个发射器。
+ *
+ * @param _name 模式名称
+ * @param _info 发射器的初始状态
+ * @return 发射器句柄;模式不存在时返回0。
+ */
+MADPatternHandle MADPatternRunner::Start(const MADString& _name, const MADPatternStartInfo& _info)
+{
+	if (Program == nullptr || Program->FindPattern(_name) == MAD_PATTERN_INVALID_INDEX)
+	{
+		MAD_LOG_ERR("Try to start pattern \"" + _name + "\" which does not exist!");
+		return 0;
+	}
+	return Start(Program->FindPattern(_name), _info);
+}
+
+/**
+ * 停止一个发射器,已经发射的子弹不受影响。
+ *
+ * @param _handle 发射器句柄
+ * @return 发射器存在并被停止时返回true。
+ */
+bool MADPatternRunner::Stop(MADPatternHandle _handle)
+{
+	for (size_t i = 0; i < Emitters.size(); ++i)
+	{
+		if (Emitters[i].Handle == _handle)
+		{
+			Emitters.erase(Emitters.begin() + i);
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * 停止所有发射器。
+ */
+void MADPatternRunner::Clear()
+{
+	Emitters.clear();
+}
+
+/**
+ * 推进一个tick:执行每个发射器直到其等待或结束,然后应用方向/速度变化并移动发射器。
+ * 执行结束(End/vanish)的发射器会被移除。
+ *
+ * @param _pool 接收子弹的子弹池
+ * @param _dt tick步长(秒),用于移动发射器
+ * @param _entities 瞄准目标所在的实体数组,可以为nullptr
+ * @param _num 实体数量
+ */
+void MADPatternRunner::Step(MADBulletPool& _pool, float _dt, const MADEntity* _entities, size_t _num)
+{
+	if (_entities == nullptr)
+	{
+		_num = 0;
+	}
+
+	size_t i = 0;
+	while (i < Emitters.size())
+	{
+		Emitter& l_emitter = Emitters[i];
+		if (l_emitter.Wait > 0)
+		{
+			l_emitter.Wait--;
+		}
+		if (l_emitter.Wait == 0 && !Execute(l_emitter, _pool, _entities, _num))
+		{
+			Emitters.erase(Emitters.begin() + i);
+			continue;
+		}
+
+		if (l_emitter.DirectionTicks > 0)
+		{
+			l_emitter.Direction += l_emitter.DirectionStep;
+			l_emitter.DirectionTicks--;
+		}
+		if (l_emitter.SpeedTicks > 0)
+		{
+			l_emitter.Speed += l_emitter.SpeedStep;
+			l_emitter.SpeedTicks--;
+		}
+		float l_sin, l_cos;
+		MADStrictMath::SinCos(l_emitter.Direction * MAD_PATTERN_DEG_TO_RAD, &l_sin, &l_cos);
+		l_emitter.Position.x += l_cos * l_emitter.Speed * _dt;
+		l_emitter.Position.y += l_sin * l_emitter.Speed * _dt;
+		i++;
+	}
+}
+
+/**
+ * 获取正在运行的发射器数量。
+ *
+ * @return 发射器数量
+ */
+size_t MADPatternRunner::GetNum() const
+{
+	return Emitters.size();
+}
+
+/**
+ * 检查发射器是否仍在运行。
+ *
+ * @param _handle 发射器句柄
+ * @return 仍在运行时返回true。
+ */
+bool MADPatternRunner::IsRunning(MADPatternHandle _handle) const
+{
+	for (const Emitter& l_emitter : Emitters)
+	{
+		if (l_emitter.Handle == _handle)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * 获取模式库。
+ *
+ * @return 模式库指针
+ */
+const MADPatternProgram* MADPatternRunner::GetProgram() const
+{
+	return Program;
+}
+
+/**
+ * 重置 $rand 的随机数序列。
+ *
+ * @param _seed 随机数种子
+ */
+void MADPatternRunner::SetSeed(unsigned long long _seed)
+{
+	RandomState = _seed * 0x9E3779B97F4A7C15ull + 0x2545F4914F6CDD1Dull;
+	if (RandomState == 0)
+	{
+		RandomState = 0x2545F4914F6CDD1Dull;
+	}
+}
+
+/**
+ * 设置模式中 $rank 的值,通常用于表示难度。
+ *
+ * @param _rank 难度系数
+ */
+void MADPatternRunner::SetRank(float _rank)
+{
+	Rank = _rank;
+}
+
+/**
+ * 把所有发射器、句柄计数、$rank 与 $rand 的随机数状态追加到 out_data 末尾,发射器数组整体复制。
+ *
+ * @param out_data 输出缓冲区,数据追加在已有内容之后
+ * @return 写入的字节数
+ */
+size_t MADPatternRunner::Snapshot(std::vector<unsigned char>& out_data) const
+{
+	size_t l_begin = out_data.size();
+	MADBlobWriter l_writer(out_data);
+	l_writer.Write(MAD_PATTERN_SNAPSHOT_TAG);
+	l_writer.Write(static_cast<unsigned long long>(Program != nullptr ? Program->GetCodeSize() : 0));
+	l_writer.Write(NextHandle);
+	l_writer.Write(RandomState);
+	l_writer.Write(Rank);
+	l_writer.WriteArray(Emitters);
+	return out_data.size() - l_begin;
+}
+
+/**
+ * 从快照中恢复所有发射器与随机数状态。
+ * 快照数据损坏、不完整或来自另一个模式库时所有发射器被停止。
+ *
+ * @param io_reader 指向一份由Snapshot写入的数据,读取后前进到该数据之后
+ * @return 成功时返回true
+ */
+bool MADPatternRunner::Restore(MADBlobReader& io_reader)
+{
+	unsigned int l_tag = 0;
+	unsigned long long l_code_size = 0;
+	MADPatternHandle l_next_handle = 0;
+	unsigned long long l_random_state = 0;
+	float l_rank = 0.0f;
+	io_reader.Read(&l_tag);
+	io_reader.Read(&l_code_size);
+	io_reader.Read(&l_next_handle);
+	io_reader.Read(&l_random_state);
+	io_reader.Read(&l_rank);
+	io_reader.ReadArray(Emitters);
+
+	/*Emitters keep their start order,and every address must lie inside the same program*/
+	bool l_valid = !io_reader.IsFailed() && l_tag == MAD_PATTERN_SNAPSHOT_TAG && Program != nullptr &&
+		l_code_size == Program->GetCodeSize() && l_random_state != 0;
+	MADPatternHandle l_last_handle = 0;
+	for (size_t i = 0; l_valid && i < Emitters.size(); ++i)
+	{
+		const Emitter& l_emitter = Emitters[i];
+		l_valid = l_emitter.Handle > l_last_handle && l_emitter.Handle < l_next_handle &&
+			l_emitter.Pc < l_code_size && l_emitter.LoopDepth >= 0 && l_emitter.LoopDepth <= MAD_PATTERN_MAX_DEPTH;
+		for (int d = 0; l_valid && d < l_emitter.LoopDepth; ++d)
+		{
+			l_valid = l_emitter.Loops[d].BodyPc < l_code_size;
+		}
+		l_last_handle = l_emitter.Handle;
+	}
+	if (!l_valid)
+	{
+		MAD_LOG_ERR("Try to restore a pattern runner from a broken snapshot!");
+		Emitters.clear();
+		return false;
+	}
+	NextHandle = l_next_handle;
+	RandomState = l_random_state;
+	Rank = l_rank;
+	return true;
+}
+
+/**
+ * 将本对象绑定到脚本,并向脚本注册StartPattern与StopPattern两个函数。
+ * 本对象的指针装在一个由注册表持有的userdata中,作为两个函数的upvalue,脚本中没有可以改写它的全局变量;
+ * 取出指针前会检查userdata的元表,本对象析构或解除绑定时指针会被清空。
+ *
+ * @param _script 需要发射弹幕的脚本
+ *
+ * 注意:
+ * - 一个脚本同时只能绑定一个MADPatternRunner,重复绑定会覆盖之前的绑定。
+ * - 重复绑定本对象会先解除之前的绑定。
+ */
+void MADPatternRunner::BindScript(MADScript* _script)
+{
+	if (_script == nullptr)
+	{
+		MAD_LOG_ERR("Try to bind pattern runner to a null script!");
+		return;
+	}
+	Unbind();
+	if (_script->GetScriptState() == MADScriptState::Deleted)
+	{
+		MAD_LOG_ERR("Try to bind pattern runner to a deleted script!");
+		return;
+	}
+	lua_State* L = _script->GetLuaState();
+	luaL_newmetatable(L, MAD_PATTERN_LUA_RUNNER);
+	lua_pop(L, 1);
+
+	MADPatternRunner** l_binding = static_cast<MADPatternRunner**>(lua_newuserdatauv(L, sizeof(MADPatternRunner*), 0));
+	*l_binding = this;
+	luaL_setmetatable(L, MAD_PATTERN_LUA_RUNNER);
+	lua_pushvalue(L, -1);
+	lua_pushcclosure(L, StartPatternFromLua, 1);
+	lua_setglobal(L, "StartPattern");
+	lua_pushvalue(L, -1);
+	lua_pushcclosure(L, StopPatternFromLua, 1);
+	lua_setglobal(L, "StopPattern");
+	BindingRef = luaL_ref(L, LUA_REGISTRYINDEX);
+
+	Script = _script;
+	BoundState = L;
+}
+
+/**
+ * 解除与脚本的绑定,脚本中的StartPattern与StopPattern之后只会返回失败。
+ * 正在运行的发射器不受影响。
+ */
+void MADPatternRunner::Unbind()
+{
+	if (Script == nullptr)
+	{
+		return;
+	}
+	if (Script->GetScriptState() != MADScriptState::Deleted && Script->GetLuaState() == BoundState)
+	{
+		lua_rawgeti(BoundState, LUA_REGISTRYINDEX, BindingRef);
+		*static_cast<MADPatternRunner**>(lua_touserdata(BoundState, -1)) = nullptr;
+		lua_pop(BoundState, 1);
+		luaL_unref(BoundState, LUA_REGISTRYINDEX, BindingRef);
+	}
+	Script = nullptr;
+	BoundState = nullptr;
+	BindingRef = LUA_NOREF;
+}
+
+/**
+ * (内部回调函数,禁止主动调用)
+ * Lua: StartPattern(name, x, y, dir, speed, team, target, ...)
+ * name为模式名称,target为实体序号(小于0或nil表示不瞄准),之后的参数依次作为 $1~$8。
+ *
+ * @param L 当前的Lua状态机指针。
+ * @return 返回1,向Lua返回发射器句柄(失败时为0)。
+ */
+int MADPatternRunner::StartPatternFromLua(lua_State* L)
+{
+	int l_arg_num = lua_gettop(L);
+	MADPatternRunner* l_runner = GetRunnerFromLua(L);
+	if (l_runner == nullptr || l_arg_num < 1 || lua_type(L, 1) != LUA_TSTRING)
+	{
+		MAD_LOG_ERR("[LuaScript]Illegal call for StartPattern.Pattern name is needed and the script must be bound to a runner.");
+		lua_pushinteger(L, 0);
+		return 1;
+	}
+
+	MADPatternStartInfo l_info;
+	ReadStartInfo(L, 2, &l_info);
+	lua_pushinteger(L, static_cast<lua_Integer>(l_runner->Start(MADString(lua_tostring(L, 1)), l_info)));
+	return 1;
+}
+
+/**
+ * 从Lua栈中读取 (x, y, dir, speed, team, target, $1, $2, ...) 形式的发射器初始状态,
+ * 供StartPattern以及其他按同样参数启动发射器的Lua函数使用。
+ * team不是整数时保持默认队伍,target小于0或为nil时不瞄准,缺少的参数按0处理。
+ *
+ * @param L 当前的Lua状态机指针。
+ * @param _first x所在的栈下标
+ * @param out_info 接收初始状态的指针
+ */
+void MADPatternRunner::ReadStartInfo(lua_State* L, int _first, MADPatternStartInfo* out_info)
+{
+	int l_arg_num = lua_gettop(L);
+	out_info->Position = MADVector2DF(static_cast<float>(lua_tonumber(L, _first)), static_cast<float>(lua_tonumber(L, _first + 1)));
+	out_info->Direction = static_cast<float>(lua_tonumber(L, _first + 2));
+	out_info->Speed = static_cast<float>(lua_tonumber(L, _first + 3));
+	if (lua_isinteger(L, _first + 4))
+	{
+		out_info->TeamMask = lua_tointeger(L, _first + 4);
+	}
+	if (lua_isnumber(L, _first + 5) && lua_tointeger(L, _first + 5) >= 0)
+	{
+		out_info->Target = static_cast<unsigned int>(lua_tointeger(L, _first + 5));
+	}
+	for (int i = 0; i < MAD_PATTERN_MAX_PARAM && i + _first + 6 <= l_arg_num; ++i)
+	{
+		out_info->Params[i] = static_cast<float>(lua_tonumber(L, i + _first + 6));
+	}
+}
+
+/**
+ * (内部回调函数,禁止主动调用)
+ * Lua: StopPattern(handle)
+ *
+ * @param L 当前的Lua状态机指针。
+ * @return 返回1,向Lua返回发射器是否被停止。
+ */
+int MADPatternRunner::StopPatternFromLua(lua_State* L)
+{
+	MADPatternRunner* l_runner = GetRunnerFromLua(L);
+	if (l_runner == nullptr || !lua_isinteger(L, 1))
+	{
+		MAD_LOG_ERR("[LuaScript]Illegal call for StopPattern.A pattern handle is needed.");
+		lua_pushboolean(L, 0);
+		return 1;
+	}
+	lua_pushboolean(L, l_runner->Stop(static_cast<MADPatternHandle>(lua_tointeger(L, 1))));
+	return 1;
+}
+
+/**
+ * (内部函数)
+ * 从Lua函数的upvalue中取出绑定的模式解释器。
+ *
+ * @param L 当前的Lua状态机指针。
+ * @return 模式解释器;函数不是由BindScript注册的,或解释器已经析构、解除绑定时返回nullptr。
+ */
+MADPatternRunner* MADPatternRunner::GetRunnerFromLua(lua_State* L)
+{
+	MADPatternRunner** l_binding = static_cast<MADPatternRunner**>(luaL_testudata(L, lua_upvalueindex(1), MAD_PATTERN_LUA_RUNNER));
+	return l_binding != nullptr ? *l_binding : nullptr;
+}
+
+/**
+ * (内部函数)
+ * 从发射器当前地址开始执行字节码,直到遇到等待或模式结束。
+ * 模式中没有无限循环,但很大的repeat可能在一个tick内执行过多指令,
+ * 执行满MAD_PATTERN_MAX_STEPS条指令后会停在下一条指令处,等到下一个tick继续执行。
+ * 地址、循环层数与参数序号都会被检查,从损坏的快照恢复的发射器只会被停止,不会越界访问。
+ *
+ * @return 发射器仍然存活时返回true;模式结束或字节码异常时返回false。
+ */
+bool MADPatternRunner::Execute(Emitter& _emitter, MADBulletPool& _pool, const MADEntity* _entities, size_t _num)
+{
+	const unsigned int* l_code = Program->GetCode();
+	const size_t l_code_size = Program->GetCodeSize();
+	for (int l_steps = 0; l_steps < MAD_PATTERN_MAX_STEPS; ++l_steps)
+	{
+		if (_emitter.Pc >= l_code_size)
+		{
+			return StopBroken();
+		}
+		switch (static_cast<MADPatternOp>(l_code[_emitter.Pc++]))
+		{
+		case MADPatternOp::End:
+			return false;
+
+		case MADPatternOp::Fire:
+		{
+			if (l_code_size - _emitter.Pc < 2)
+			{
+				return StopBroken();
+			}
+			MADPatternDirMode l_dir_mode = static_cast<MADPatternDirMode>(l_code[_emitter.Pc++]);
+			MADPatternSpeedMode l_speed_mode = static_cast<MADPatternSpeedMode>(l_code[_emitter.Pc++]);
+			float l_dir, l_speed;
+			if (!Evaluate(_emitter, &_emitter.Pc, &l_dir) || !Evaluate(_emitter, &_emitter.Pc, &l_speed))
+			{
+				return StopBroken();
+			}
+			switch (l_dir_mode)
+			{
+			case MADPatternDirMode::Aim: l_dir += GetAimDirection(_emitter, _entities, _num); break;
+			case MADPatternDirMode::Relative: l_dir += _emitter.Direction; break;
+			case MADPatternDirMode::Sequence: l_dir += _emitter.LastDirection; break;
+			default: break;
+			}
+			switch (l_speed_mode)
+			{
+			case MADPatternSpeedMode::Relative: l_speed += _emitter.Speed; break;
+			case MADPatternSpeedMode::Sequence: l_speed += _emitter.LastSpeed; break;
+			default: break;
+			}
+			_emitter.LastDirection = l_dir;
+			_emitter.LastSpeed = l_speed;
+
+			float l_sin, l_cos;
+			MADStrictMath::SinCos(l_dir * MAD_PATTERN_DEG_TO_RAD, &l_sin, &l_cos);
+			_pool.Spawn(BulletInfo(_emitter.Position,
+				MADVector2DF(l_cos * l_speed, l_sin * l_speed), _emitter.TeamMask));
+			break;
+		}
+
+		case MADPatternOp::Repeat:
+		{
+			float l_value;
+			if (_emitter.Pc >= l_code_size || _emitter.LoopDepth >= MAD_PATTERN_MAX_DEPTH)
+			{
+				return StopBroken();
+			}
+			unsigned int l_skip = l_code[_emitter.Pc++];
+			if (!Evaluate(_emitter, &_emitter.Pc, &l_value))
+			{
+				return StopBroken();
+			}
+			unsigned int l_count = ToTicks(l_value);
+			if (l_count == 0)
+			{
+				_emitter.Pc = l_skip;
+				break;
+			}
+			LoopFrame& l_frame = _emitter.Loops[_emitter.LoopDepth++];
+			l_frame.BodyPc = _emitter.Pc;
+			l_frame.Remaining = l_count > 0x7FFFFFFFu ? 0x7FFFFFFF : static_cast<int>(l_count);
+			l_frame.Index = 0;
+			break;
+		}
+
+		case MADPatternOp::RepeatEnd:
+		{
+			if (_emitter.Pc >= l_code_size || _emitter.LoopDepth <= 0)
+			{
+				return StopBroken();
+			}
+			_emitter.Pc++;
+			LoopFrame& l_frame = _emitter.Loops[_emitter.LoopDepth - 1];
+			l_frame.Index++;
+			if (--l_frame.Remaining > 0)
+			{
+				_emitter.Pc = l_frame.BodyPc;
+			}
+			else
+			{
+				_emitter.LoopDepth--;
+			}
+			break;
+		}
+
+		case MADPatternOp::Wait:
+		{
+			float l_value;
+			if (!Evaluate(_emitter, &_emitter.Pc, &l_value))
+			{
+				return StopBroken();
+			}
+			unsigned int l_ticks = ToTicks(l_value);
+			if (l_ticks > 0)
+			{
+				_emitter.Wait = l_ticks;
+				return true;
+			}
+			break;
+		}
+
+		case MADPatternOp::ChangeDirection:
+		{
+			float l_value, l_ticks_value;
+			if (_emitter.Pc >= l_code_size)
+			{
+				return StopBroken();
+			}
+			MADPatternDirMode l_mode = static_cast<MADPatternDirMode>(l_code[_emitter.Pc++]);
+			if (!Evaluate(_emitter, &_emitter.Pc, &l_value) || !Evaluate(_emitter, &_emitter.Pc, &l_ticks_value))
+			{
+				return StopBroken();
+			}
+			unsigned int l_ticks = ToTicks(l_ticks_value);
+			float l_delta = 0.0f;
+			switch (l_mode)
+			{
+			case MADPatternDirMode::Aim: l_delta = WrapAngle(GetAimDirection(_emitter, _entities, _num) + l_value - _emitter.Direction); break;
+			case MADPatternDirMode::Absolute: l_delta = WrapAngle(l_value - _emitter.Direction); break;
+			case MADPatternDirMode::Relative: l_delta = l_value; break;
+			default: l_delta = l_value * static_cast<float>(l_ticks); break;
+			}
+			if (l_ticks == 0)
+			{
+				_emitter.Direction += l_mode == MADPatternDirMode::Sequence ? 0.0f : l_delta;
+				_emitter.DirectionTicks = 0;
+			}
+			else
+			{
+				_emitter.DirectionStep = l_mode == MADPatternDirMode::Sequence ? l_value : l_delta / static_cast<float>(l_ticks);
+				_emitter.DirectionTicks = l_ticks;
+			}
+			break;
+		}
+
+		case MADPatternOp::ChangeSpeed:
+		{
+			float l_value, l_ticks_value;
+			if (_emitter.Pc >= l_code_size)
+			{
+				return StopBroken();
+			}
+			MADPatternSpeedMode l_mode = static_cast<MADPatternSpeedMode>(l_code[_emitter.Pc++]);
+			if (!Evaluate(_emitter, &_emitter.Pc, &l_value) || !Evaluate(_emitter, &_emitter.Pc, &l_ticks_value))
+			{
+				return StopBroken();
+			}
+			unsigned int l_ticks = ToTicks(l_ticks_value);
+			float l_delta = 0.0f;
+			switch (l_mode)
+			{
+			case MADPatternSpeedMode::Absolute: l_delta = l_value - _emitter.Speed; break;
+			case MADPatternSpeedMode::Relative: l_delta = l_value; break;
+			default: l_delta = 0.0f; break;
+			}
+			if (l_ticks == 0)
+			{
+				_emitter.Speed += l_delta;
+				_emitter.SpeedTicks = 0;
+			}
+			else
+			{
+				_emitter.SpeedStep = l_mode == MADPatternSpeedMode::Sequence ? l_value : l_delta / static_cast<float>(l_ticks);
+				_emitter.SpeedTicks = l_ticks;
+			}
+			break;
+		}
+
+		default:
+			return StopBroken();
+		}
+	}
+	/*Yield at an instruction boundary,Step counts the wait down to 0 on the next tick*/
+	_emitter.Wait = 1;
+	return true;
+}
+
+/**
+ * (内部函数)
+ * 计算一个表达式,并把地址移动到表达式之后。
+ *
+ * @param io_pc 表达式的起始地址,返回时指向表达式之后
+ * @param out_value 接收表达式的值
+ * @return 表达式完整且没有越界时返回true
+ */
+bool MADPatternRunner::Evaluate(const Emitter& _emitter, unsigned int* io_pc, float* out_value)
+{
+	const unsigned int* l_code = Program->GetCode();
+	const size_t l_code_size = Program->GetCodeSize();
+	float l_stack[MAD_PATTERN_MAX_EXPR_STACK];
+	int l_top = 0;
+	while (*io_pc < l_code_size)
+	{
+		MADPatternExprOp l_op = static_cast<MADPatternExprOp>(l_code[(*io_pc)++]);
+		/*Operators pop one or two values,every push needs a free slot*/
+		int l_pop = 0;
+		switch (l_op)
+		{
+		case MADPatternExprOp::Add: case MADPatternExprOp::Sub: case MADPatternExprOp::Mul: case MADPatternExprOp::Div: l_pop = 2; break;
+		case MADPatternExprOp::Neg: l_pop = 1; break;
+		case MADPatternExprOp::End: break;
+		default:
+			if (l_top >= MAD_PATTERN_MAX_EXPR_STACK)
+			{
+				return false;
+			}
+			break;
+		}
+		if (l_top < l_pop)
+		{
+			return false;
+		}
+		switch (l_op)
+		{
+		case MADPatternExprOp::End:
+			*out_value = l_top > 0 ? l_stack[l_top - 1] : 0.0f;
+			return true;
+		case MADPatternExprOp::Const:
+			if (*io_pc >= l_code_size)
+			{
+				return false;
+			}
+			memcpy(&l_stack[l_top++], &l_code[(*io_pc)++], sizeof(float));
+			break;
+		case MADPatternExprOp::Param:
+			if (*io_pc >= l_code_size || l_code[*io_pc] >= MAD_PATTERN_MAX_PARAM)
+			{
+				return false;
+			}
+			l_stack[l_top++] = _emitter.Params[l_code[(*io_pc)++]];
+			break;
+		case MADPatternExprOp::Rand:
+			l_stack[l_top++] = NextRandom();
+			break;
+		case MADPatternExprOp::Rank:
+			l_stack[l_top++] = Rank;
+			break;
+		case MADPatternExprOp::Loop:
+			l_stack[l_top++] = _emitter.LoopDepth > 0 ? static_cast<float>(_emitter.Loops[_emitter.LoopDepth - 1].Index) : 0.0f;
+			break;
+		case MADPatternExprOp::Add:
+			l_top--;
+			l_stack[l_top - 1] += l_stack[l_top];
+			break;
+		case MADPatternExprOp::Sub:
+			l_top--;
+			l_stack[l_top - 1] -= l_stack[l_top];
+			break;
+		case MADPatternExprOp::Mul:
+			l_top--;
+			l_stack[l_top - 1] *= l_stack[l_top];
+			break;
+		case MADPatternExprOp::Div:
+			l_top--;
+			l_stack[l_top - 1] = l_stack[l_top] != 0.0f ? l_stack[l_top - 1] / l_stack[l_top] : 0.0f;
+			break;
+		case MADPatternExprOp::Neg:
+			l_stack[l_top - 1] = -l_stack[l_top - 1];
+			break;
+		default:
+			return false;
+		}
+	}
+	return false;
+}
+
+/**
+ * (内部函数)
+ * 计算发射器指向瞄准目标的角度,没有目标时返回发射器自身的方向。
+ *
+ * @return 角度(度)
+ */
+float MADPatternRunner::GetAimDirection(const Emitter& _emitter, const MADEntity* _entities, size_t _num) const
+{
+	if (_emitter.Target >= _num)
+	{
+		return _emitter.Direction;
+	}
+	const MADEntity& l_target = _entities[_emitter.Target];
+	return MADStrictMath::Atan2(l_target.Position.y - _emitter.Position.y, l_target.Position.x - _emitter.Position.x) * MAD_PATTERN_RAD_TO_DEG;
+}
+
+/**
+ * (内部函数)
+ * xorshift64* 随机数,返回 [0, 1) 之间的浮点数。
+ *
+ * @return 随机数
+ */
+float MADPatternRunner::NextRandom()
+{
+	RandomState ^= RandomState >> 12;
+	RandomState ^= RandomState << 25;
+	RandomState ^= RandomState >> 27;
+	return static_cast<float>((RandomState * 0x2545F4914F6CDD1Dull) >> 40) * (1.0f / 16777216.0f);
+}
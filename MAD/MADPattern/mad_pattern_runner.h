@@ -0,0 +1,166 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "mad_pattern_program.h"
+#include "../MADBullet/mad_bullet_pool.h"
+#include "../MADLua/mad_lua.h"
+
+/*Target index meaning "no aim target"*/
+#define MAD_PATTERN_NO_TARGET 0xFFFFFFFFu
+
+/*Instructions one emitter may run in a single tick,the rest of a long burst continues on the next tick*/
+#define MAD_PATTERN_MAX_STEPS 65536
+
+/*Tag written at the start of a pattern runner snapshot*/
+#define MAD_PATTERN_SNAPSHOT_TAG 0x4E525450u
+
+/*Name of the metatable of the boxed runner pointer used by the Lua binding*/
+#define MAD_PATTERN_LUA_RUNNER "MAD_PatternRunner"
+
+/**
+ * \brief MADPatternHandle 是发射器的句柄,0 表示无效句柄。
+ */
+typedef unsigned long long MADPatternHandle;
+
+/**
+ * \brief MADPatternStartInfo 描述启动一个发射器时的初始状态。
+ *
+ * - Position/Direction/Speed: 发射器的初始位置、方向(度)与速度(单位/秒),发射器会按方向与速度移动
+ * - TeamMask: 发射出的子弹所属的队伍
+ * - Target: 瞄准目标在Step传入的实体数组中的序号,MAD_PATTERN_NO_TARGET表示不瞄准
+ * - Params: 模式中的参数 $1~$8
+ */
+struct MADPatternStartInfo {
+	MADVector2DF Position;
+	float Direction;
+	float Speed;
+	long long TeamMask;
+	unsigned int Target;
+	float Params[MAD_PATTERN_MAX_PARAM];
+
+	MADPatternStartInfo() {
+		Position = MADVector2DF();
+		Direction = 0.0f;
+		Speed = 0.0f;
+		TeamMask = 1;
+		Target = MAD_PATTERN_NO_TARGET;
+		for (int i = 0; i < MAD_PATTERN_MAX_PARAM; ++i)
+		{
+			Params[i] = 0.0f;
+		}
+	}
+};
+
+/**
+ * MADPatternRunner 是弹幕模式的原生解释器,每个tick推进所有发射器并把子弹直接生成到子弹池中。
+ *
+ * 每个发射器独立执行MADPatternProgram中的一个模式,拥有自己的位置、方向、速度、循环栈与等待计数。
+ * 发射器按启动顺序执行,$rand 取自本对象内部以种子初始化的随机数序列,因此结果完全确定。
+ *
+ * Lua只需要挑选模式与参数:BindScript之后,脚本中可以调用
+ *     local h = StartPattern(name, x, y, dir, speed, team, target, $1, $2, ...)
+ *     StopPattern(h)
+ * 之后的每一颗子弹都不再经过Lua。
+ *
+ * Snapshot保存所有发射器(包括执行位置、等待计数与循环栈)与 $rand 的随机数状态,恢复后的弹幕与保存时逐位一致。
+ *
+ * 注意:
+ * - 本对象持有MADPatternProgram的指针,请保证其生命周期长于本对象;快照不包含模式库,只能恢复到使用同一模式库的对象。
+ * - 本对象持有绑定脚本的指针,请保证脚本的生命周期长于本对象,或在删除脚本前调用Unbind;
+ *   本对象析构或解除绑定后,脚本中的StartPattern与StopPattern只会报错并返回失败。
+ * - 该类是线程不安全的!
+ */
+class MADPatternRunner
+{
+public:
+	MADPatternRunner(const MADPatternProgram* _program, unsigned long long _seed = 0);
+	~MADPatternRunner();
+
+private:
+	typedef struct LoopFrame
+	{
+		unsigned int BodyPc = 0;
+		int Remaining = 0;
+		int Index = 0;
+	}LoopFrame;
+
+	typedef struct Emitter
+	{
+		MADPatternHandle Handle = 0;
+		unsigned int Pc = 0;
+		unsigned int Wait = 0;
+
+		MADVector2DF Position = MADVector2DF();
+		float Direction = 0.0f;
+		float Speed = 0.0f;
+		float LastDirection = 0.0f;
+		float LastSpeed = 0.0f;
+		long long TeamMask = 1;
+		unsigned int Target = MAD_PATTERN_NO_TARGET;
+		float Params[MAD_PATTERN_MAX_PARAM] = {};
+
+		float DirectionStep = 0.0f;
+		unsigned int DirectionTicks = 0;
+		float SpeedStep = 0.0f;
+		unsigned int SpeedTicks = 0;
+
+		LoopFrame Loops[MAD_PATTERN_MAX_DEPTH];
+		int LoopDepth = 0;
+	}Emitter;
+
+public:
+	/*Emitter operator*/
+	MADPatternHandle Start(unsigned int _pattern, const MADPatternStartInfo& _info);
+	MADPatternHandle Start(const MADString& _name, const MADPatternStartInfo& _info);
+	bool Stop(MADPatternHandle _handle);
+	void Clear();
+	void Step(MADBulletPool& _pool, float _dt, const MADEntity* _entities = nullptr, size_t _num = 0);
+
+	/*Get Data*/
+	size_t GetNum() const;
+	bool IsRunning(MADPatternHandle _handle) const;
+	const MADPatternProgram* GetProgram() const;
+
+	/*Set Data*/
+	void SetSeed(unsigned long long _seed);
+	void SetRank(float _rank);
+
+	/*Snapshot*/
+	size_t Snapshot(std::vector<unsigned char>& out_data) const;
+	bool Restore(MADBlobReader& io_reader);
+
+	/*Lua binding*/
+	void BindScript(MADScript* _script);
+	void Unbind();
+	static void ReadStartInfo(lua_State* L, int _first, MADPatternStartInfo* out_info);
+
+	/*Lua API Function*/
+	static int StartPatternFromLua(lua_State* L);
+	static int StopPatternFromLua(lua_State* L);
+
+private:
+	const MADPatternProgram* Program;
+	std::vector<Emitter> Emitters;
+	MADPatternHandle NextHandle;
+	unsigned long long RandomState;
+	float Rank;
+
+	/*Binding,the Lua functions reach this object through a boxed pointer held in BindingRef*/
+	MADScript* Script;
+	lua_State* BoundState;
+	int BindingRef;
+
+	/*Interpreter*/
+	bool Execute(Emitter& _emitter, MADBulletPool& _pool, const MADEntity* _entities, size_t _num);
+	bool Evaluate(const Emitter& _emitter, unsigned int* io_pc, float* out_value);
+	float GetAimDirection(const Emitter& _emitter, const MADEntity* _entities, size_t _num) const;
+	float NextRandom();
+	static MADPatternRunner* GetRunnerFromLua(lua_State* L);
+};
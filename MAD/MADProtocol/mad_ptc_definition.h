@@ -37,10 +37,35 @@ struct BulletInfo {
 	}
 };
 
+enum class MADBulletMotionType : unsigned char { Integrated = 0, Linear, Accelerating, Sine, Spiral };
+
+struct MADBulletMotion {
+	MADBulletMotionType Type;
+	float Param[4];
+
+	MADBulletMotion() {
+		Type = MADBulletMotionType::Integrated;
+		Param[0] = Param[1] = Param[2] = Param[3] = 0.0f;
+	}
+	MADBulletMotion(MADBulletMotionType _type, float _p0 = 0.0f, float _p1 = 0.0f, float _p2 = 0.0f, float _p3 = 0.0f) {
+		Type = _type;
+		Param[0] = _p0;
+		Param[1] = _p1;
+		Param[2] = _p2;
+		Param[3] = _p3;
+	}
+};
+
 struct MADBulletFlushResData {
 	float Position_X, Position_Y;
 	float Dir_X, Dir_Y;
 
+	MADBulletFlushResData() {
+		Position_X = 0.0f;
+		Position_Y = 0.0f;
+		Dir_X = 0.0f;
+		Dir_Y = 0.0f;
+	}
 	MADBulletFlushResData(float _p_x, float _p_y, float _d_x, float _d_y) {
 		Position_X = _p_x;
 		Position_Y = _p_y;
@@ -55,6 +80,71 @@ struct MADBulletFlushResData {
 	}
 };
 
+struct MADFixedBulletInfo {
+	unsigned int AliveTick;
+
+	int OriginPos_X, OriginPos_Y;
+	unsigned short Angle;
+	short Speed;
+
+	long long TeamMask;
+
+	MADFixedBulletInfo() {
+		TeamMask = 1;
+		AliveTick = 0;
+		OriginPos_X = 0;
+		OriginPos_Y = 0;
+		Angle = 0;
+		Speed = 0;
+	}
+	MADFixedBulletInfo(int _pos_x, int _pos_y, unsigned short _angle, short _speed, const long long& _team_mask) {
+		TeamMask = _team_mask;
+		AliveTick = 0;
+		OriginPos_X = _pos_x;
+		OriginPos_Y = _pos_y;
+		Angle = _angle;
+		Speed = _speed;
+	}
+};
+
+struct MADFixedFlushResData {
+	int Position_X, Position_Y;
+	unsigned short Angle;
+	short Speed;
+
+	MADFixedFlushResData() {
+		Position_X = 0;
+		Position_Y = 0;
+		Angle = 0;
+		Speed = 0;
+	}
+	MADFixedFlushResData(int _p_x, int _p_y, unsigned short _angle, short _speed) {
+		Position_X = _p_x;
+		Position_Y = _p_y;
+		Angle = _angle;
+		Speed = _speed;
+	}
+};
+
+enum class MADFlushFormat : unsigned char { Float4 = 0, Half4, PosAngle };
+
+struct MADFlushLayout {
+	MADFlushFormat Format;
+	size_t Stride;
+	bool WriteIndices;
+
+	MADFlushLayout() {
+		Format = MADFlushFormat::Float4;
+		Stride = 0;
+		WriteIndices = false;
+	}
+	MADFlushLayout(MADFlushFormat _format, size_t _stride = 0, bool _write_indices = false) {
+		Format = _format;
+		Stride = _stride;
+		WriteIndices = _write_indices;
+	}
+};
+
 struct MADEntity {
 	MADVector2DF Position;
 	float TestRadius;
@@ -76,7 +166,7 @@ struct MADEntity {
 	MADEntity(const MADEntity& _parent) {
 		Position = _parent.Position;
 		TestRadius = _parent.TestRadius;
-		TeamMask = 0;
+		TeamMask = _parent.TeamMask;
 		UserData = _parent.UserData;
 	}
 };
@@ -0,0 +1,1091 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_replay.h"
+#include "mad_snapshot.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*Fixed sizes of the replay file parts*/
+#define MAD_REPLAY_FILE_HEADER_SIZE 32
+#define MAD_REPLAY_FILE_ENTRY_SIZE 48
+#define MAD_REPLAY_FILE_TAIL_SIZE 32
+
+/*Little endian writers*/
+static void WriteU16(std::vector<unsigned char>& out_data, unsigned int _value)
+{
+	out_data.push_back(static_cast<unsigned char>(_value & 0xFF));
+	out_data.push_back(static_cast<unsigned char>((_value >> 8) & 0xFF));
+}
+
+static void WriteU32(std::vector<unsigned char>& out_data, unsigned int _value)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		out_data.push_back(static_cast<unsigned char>((_value >> (i * 8)) & 0xFF));
+	}
+}
+
+static void WriteU64(std::vector<unsigned char>& out_data, unsigned long long _value)
+{
+	for (int i = 0; i < 8; ++i)
+	{
+		out_data.push_back(static_cast<unsigned char>((_value >> (i * 8)) & 0xFF));
+	}
+}
+
+static void WriteVarint(std::vector<unsigned char>& out_data, unsigned long long _value)
+{
+	while (_value >= 0x80)
+	{
+		out_data.push_back(static_cast<unsigned char>((_value & 0x7F) | 0x80));
+		_value >>= 7;
+	}
+	out_data.push_back(static_cast<unsigned char>(_value));
+}
+
+/*Little endian readers, return false when the data runs out*/
+static bool ReadU64(const unsigned char* _data, size_t _size, size_t* io_offset, unsigned long long* out_value)
+{
+	if (*io_offset + 8 > _size)
+	{
+		return false;
+	}
+	unsigned long long l_value = 0;
+	for (int i = 0; i < 8; ++i)
+	{
+		l_value |= static_cast<unsigned long long>(_data[*io_offset + i]) << (i * 8);
+	}
+	*io_offset += 8;
+	*out_value = l_value;
+	return true;
+}
+
+static bool ReadU32(const unsigned char* _data, size_t _size, size_t* io_offset, unsigned int* out_value)
+{
+	if (*io_offset + 4 > _size)
+	{
+		return false;
+	}
+	unsigned int l_value = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		l_value |= static_cast<unsigned int>(_data[*io_offset + i]) << (i * 8);
+	}
+	*io_offset += 4;
+	*out_value = l_value;
+	return true;
+}
+
+static bool ReadU16(const unsigned char* _data, size_t _size, size_t* io_offset, unsigned int* out_value)
+{
+	if (*io_offset + 2 > _size)
+	{
+		return false;
+	}
+	*out_value = static_cast<unsigned int>(_data[*io_offset]) | (static_cast<unsigned int>(_data[*io_offset + 1]) << 8);
+	*io_offset += 2;
+	return true;
+}
+
+static bool ReadVarint(const unsigned char* _data, size_t _size, size_t* io_offset, unsigned long long* out_value)
+{
+	unsigned long long l_value = 0;
+	for (int l_shift = 0; l_shift < 64; l_shift += 7)
+	{
+		if (*io_offset >= _size)
+		{
+			return false;
+		}
+		unsigned char l_byte = _data[(*io_offset)++];
+		l_value |= static_cast<unsigned long long>(l_byte & 0x7F) << l_shift;
+		if ((l_byte & 0x80) == 0)
+		{
+			*out_value = l_value;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * 构造一个空的录像记录器,使用前请调用Begin。
+ */
+MADReplayRecorder::MADReplayRecorder()
+{
+	Begin(0, 60, 0);
+}
+
+/**
+ * MADReplayRecorder析构函数。
+ */
+MADReplayRecorder::~MADReplayRecorder()
+{
+}
+
+/**
+ * 开始一段新的录像,之前记录的内容会被丢弃。
+ *
+ * @param _seed 本局模拟使用的主种子(例如传给MADScript::SetRandomSeed的值)
+ * @param _tick_rate 每秒的tick数
+ * @param _hash_interval 每隔多少个tick记录一次状态哈希,为0则不记录
+ */
+void MADReplayRecorder::Begin(unsigned long long _seed, unsigned int _tick_rate, unsigned int _hash_interval)
+{
+	Seed = _seed;
+	TickRate = _tick_rate;
+	HashInterval = _hash_interval;
+	TickNum = 0;
+	RunInput = 0;
+	RunLength = 0;
+	InputStream.clear();
+	Hashes.clear();
+}
+
+/**
+ * 记录一个tick的玩家输入,每个tick必须且只能调用一次。
+ * 与上一tick相同的输入只会增加重复计数,不占用额外空间。
+ *
+ * @param _input 本tick的玩家输入
+ */
+void MADReplayRecorder::Record(MADReplayInput _input)
+{
+	if (RunLength > 0 && _input != RunInput)
+	{
+		WriteVarint(InputStream, RunInput);
+		WriteVarint(InputStream, RunLength);
+		RunLength = 0;
+	}
+	RunInput = _input;
+	RunLength++;
+	TickNum++;
+}
+
+/**
+ * 记录当前tick模拟结束后的状态哈希。
+ * 只有当已记录的tick数是HashInterval的整数倍时才会保存,其余调用会被忽略。
+ *
+ * @param _hash 状态哈希,通常由MADStateHash::HashWorld计算
+ */
+void MADReplayRecorder::RecordHash(unsigned long long _hash)
+{
+	if (HashInterval == 0 || TickNum == 0 || TickNum % HashInterval != 0)
+	{
+		return;
+	}
+	if (Hashes.size() < TickNum / HashInterval)
+	{
+		Hashes.push_back(_hash);
+	}
+}
+
+/**
+ * 生成录像数据。记录器的状态不会改变,可以在录制过程中随时导出。
+ *
+ * 数据布局(小端序):
+ * u32 魔数, u16 版本, u16 保留, u64 种子, u32 tick频率, u32 哈希间隔, u64 tick数,
+ * u32 输入流字节数, 输入流(若干对varint: 输入值, 重复次数), u32 哈希数量, u64 哈希...
+ *
+ * @param[out] out_data 接收录像数据的数组,原有内容会被覆盖
+ */
+void MADReplayRecorder::Finish(std::vector<unsigned char>& out_data) const
+{
+	std::vector<unsigned char> l_stream = InputStream;
+	if (RunLength > 0)
+	{
+		WriteVarint(l_stream, RunInput);
+		WriteVarint(l_stream, RunLength);
+	}
+
+	out_data.clear();
+	out_data.reserve(44 + l_stream.size() + Hashes.size() * 8);
+	WriteU32(out_data, MAD_REPLAY_MAGIC);
+	WriteU16(out_data, MAD_REPLAY_VERSION);
+	WriteU16(out_data, 0);
+	WriteU64(out_data, Seed);
+	WriteU32(out_data, TickRate);
+	WriteU32(out_data, HashInterval);
+	WriteU64(out_data, TickNum);
+	WriteU32(out_data, static_cast<unsigned int>(l_stream.size()));
+	out_data.insert(out_data.end(), l_stream.begin(), l_stream.end());
+	WriteU32(out_data, static_cast<unsigned int>(Hashes.size()));
+	for (unsigned long long l_hash : Hashes)
+	{
+		WriteU64(out_data, l_hash);
+	}
+}
+
+/**
+ * 获取已记录的tick数。
+ *
+ * @return tick数
+ */
+unsigned long long MADReplayRecorder::GetTickNum() const
+{
+	return TickNum;
+}
+
+/**
+ * 构造一个空的录像播放器,使用前请调用Open。
+ */
+MADReplayPlayer::MADReplayPlayer()
+{
+	Seed = 0;
+	TickRate = 60;
+	HashInterval = 0;
+	TickNum = 0;
+	Rewind();
+}
+
+/**
+ * MADReplayPlayer析构函数。
+ */
+MADReplayPlayer::~MADReplayPlayer()
+{
+}
+
+/**
+ * 解析录像数据并回到第一个tick,数据会被复制,调用后可以释放 _data。
+ *
+ * @param _data 录像数据
+ * @param _size 录像数据字节数
+ * @return MAD_RESCODE_OK表示成功;数据格式或版本不正确时返回MAD_RESCODE_BAD_DATA。
+ */
+MADDebuggerInfo_LIGHT MADReplayPlayer::Open(const unsigned char* _data, size_t _size)
+{
+	size_t l_offset = 0;
+	unsigned int l_magic = 0, l_version = 0, l_reserved = 0, l_stream_size = 0, l_hash_num = 0;
+	bool l_ok = ReadU32(_data, _size, &l_offset, &l_magic) &&
+		ReadU16(_data, _size, &l_offset, &l_version) &&
+		ReadU16(_data, _size, &l_offset, &l_reserved) &&
+		ReadU64(_data, _size, &l_offset, &Seed) &&
+		ReadU32(_data, _size, &l_offset, &TickRate) &&
+		ReadU32(_data, _size, &l_offset, &HashInterval) &&
+		ReadU64(_data, _size, &l_offset, &TickNum) &&
+		ReadU32(_data, _size, &l_offset, &l_stream_size);
+	if (!l_ok || l_magic != MAD_REPLAY_MAGIC || l_version != MAD_REPLAY_VERSION || l_offset + l_stream_size > _size)
+	{
+		MAD_LOG_ERR("Try to open an invalid replay stream!");
+		InputStream.clear();
+		Hashes.clear();
+		TickNum = 0;
+		Rewind();
+		return MAD_RESCODE_BAD_DATA;
+	}
+	InputStream.assign(_data + l_offset, _data + l_offset + l_stream_size);
+	l_offset += l_stream_size;
+
+	Hashes.clear();
+	if (ReadU32(_data, _size, &l_offset, &l_hash_num))
+	{
+		/*The count comes from the stream,never reserve more than the bytes left can hold*/
+		size_t l_hash_left = (_size - l_offset) / sizeof(unsigned long long);
+		Hashes.reserve(l_hash_num < l_hash_left ? l_hash_num : l_hash_left);
+		unsigned long long l_hash = 0;
+		for (unsigned int i = 0; i < l_hash_num && ReadU64(_data, _size, &l_offset, &l_hash); ++i)
+		{
+			Hashes.push_back(l_hash);
+		}
+	}
+	if (Hashes.size() != l_hash_num)
+	{
+		MAD_LOG_WARN("Replay stream is truncated,some state hashes are lost.");
+	}
+
+	Rewind();
+	return MAD_RESCODE_OK;
+}
+
+/**
+ * 读取下一个tick的玩家输入。
+ *
+ * @param[out] out_input 接收输入的指针
+ * @return 成功读取时返回true;录像已结束或数据损坏时返回false。
+ */
+bool MADReplayPlayer::Next(MADReplayInput* out_input)
+{
+	if (Tick >= TickNum)
+	{
+		return false;
+	}
+	if (RunLeft == 0)
+	{
+		unsigned long long l_input = 0, l_run = 0;
+		if (!ReadVarint(InputStream.data(), InputStream.size(), &StreamOffset, &l_input) ||
+			!ReadVarint(InputStream.data(), InputStream.size(), &StreamOffset, &l_run) || l_run == 0)
+		{
+			MAD_LOG_ERR("Replay input stream is broken at tick " + std::to_string(Tick) + ".");
+			TickNum = Tick;
+			return false;
+		}
+		RunInput = static_cast<MADReplayInput>(l_input);
+		RunLeft = l_run;
+	}
+	RunLeft--;
+	Tick++;
+	*out_input = RunInput;
+	return true;
+}
+
+/**
+ * 用当前tick模拟结束后的状态哈希与录像中的记录比较。
+ * 当前tick没有记录哈希时视为通过。
+ *
+ * @param _hash 状态哈希,必须与录制时以相同方式计算
+ * @return 一致或无需校验时返回true;不一致时记录错误并返回false。
+ */
+bool MADReplayPlayer::CheckHash(unsigned long long _hash)
+{
+	if (HashInterval == 0 || Tick == 0 || Tick % HashInterval != 0)
+	{
+		return true;
+	}
+	size_t l_index = static_cast<size_t>(Tick / HashInterval - 1);
+	if (l_index >= Hashes.size())
+	{
+		return true;
+	}
+	if (Hashes[l_index] != _hash)
+	{
+		MAD_LOG_ERR("Replay desync detected at tick " + std::to_string(Tick) + "!");
+		return false;
+	}
+	return true;
+}
+
+/**
+ * 回到录像的第一个tick。
+ */
+void MADReplayPlayer::Rewind()
+{
+	Tick = 0;
+	StreamOffset = 0;
+	RunInput = 0;
+	RunLeft = 0;
+}
+
+/**
+ * 获取录像的主种子。
+ *
+ * @return 主种子
+ */
+unsigned long long MADReplayPlayer::GetSeed() const
+{
+	return Seed;
+}
+
+/**
+ * 获取录像的tick频率。
+ *
+ * @return 每秒tick数
+ */
+unsigned int MADReplayPlayer::GetTickRate() const
+{
+	return TickRate;
+}
+
+/**
+ * 获取录像的哈希间隔。
+ *
+ * @return 哈希间隔,0表示没有记录哈希
+ */
+unsigned int MADReplayPlayer::GetHashInterval() const
+{
+	return HashInterval;
+}
+
+/**
+ * 获取录像的总tick数。
+ *
+ * @return 总tick数
+ */
+unsigned long long MADReplayPlayer::GetTickNum() const
+{
+	return TickNum;
+}
+
+/**
+ * 获取已回放的tick数。
+ *
+ * @return 已回放的tick数
+ */
+unsigned long long MADReplayPlayer::GetTick() const
+{
+	return Tick;
+}
+
+/**
+ * 构造一个未打开文件的录像写入器。
+ */
+MADReplayFileWriter::MADReplayFileWriter()
+{
+	File = nullptr;
+	Offset = 0;
+	Failed = false;
+	KeyframeInterval = MAD_REPLAY_DEFAULT_KEYFRAME_INTERVAL;
+	TickNum = 0;
+	RunInput = 0;
+	RunLength = 0;
+}
+
+/**
+ * MADReplayFileWriter析构函数,未关闭的文件会被写完索引后关闭。
+ */
+MADReplayFileWriter::~MADReplayFileWriter()
+{
+	if (File != nullptr)
+	{
+		Close();
+	}
+}
+
+/**
+ * 创建录像文件并写入文件头,已存在的文件会被覆盖。之前打开的文件会先被关闭。
+ *
+ * @param _path 文件路径
+ * @param _seed 本局模拟使用的主种子
+ * @param _tick_rate 每秒的tick数
+ * @param _keyframe_interval 每隔多少个tick写入一个关键帧,决定Seek之后最多需要快进的tick数
+ * @return MAD_RESCODE_OK表示成功;无法创建文件时返回MAD_RESCODE_FILE_ERROR。
+ */
+MADDebuggerInfo_LIGHT MADReplayFileWriter::Open(const std::string& _path, unsigned long long _seed, unsigned int _tick_rate,
+	unsigned int _keyframe_interval)
+{
+	if (File != nullptr)
+	{
+		Close();
+	}
+#if defined(_MSC_VER)
+	if (fopen_s(&File, _path.c_str(), "wb") != 0)
+	{
+		File = nullptr;
+	}
+#else
+	File = std::fopen(_path.c_str(), "wb");
+#endif
+	if (File == nullptr)
+	{
+		MAD_LOG_ERR("Try to create a replay file which can not be written: " + _path);
+		return MAD_RESCODE_FILE_ERROR;
+	}
+	Offset = 0;
+	Failed = false;
+	KeyframeInterval = _keyframe_interval > 0 ? _keyframe_interval : 1;
+	TickNum = 0;
+	Keyframes.clear();
+	RunInput = 0;
+	RunLength = 0;
+	Segment.clear();
+
+	std::vector<unsigned char> l_header;
+	WriteU32(l_header, MAD_REPLAY_FILE_MAGIC);
+	WriteU16(l_header, MAD_REPLAY_FILE_VERSION);
+	WriteU16(l_header, 0);
+	WriteU64(l_header, _seed);
+	WriteU32(l_header, _tick_rate);
+	WriteU32(l_header, KeyframeInterval);
+	WriteU64(l_header, 0);
+	return WriteBytes(l_header.data(), l_header.size()) ? MAD_RESCODE_OK : MAD_RESCODE_FILE_ERROR;
+}
+
+/**
+ * 检查当前tick是否应当写入关键帧:tick 0与关键帧间隔的整数倍,且该tick尚未写入关键帧。
+ *
+ * @return 应当写入时返回true
+ */
+bool MADReplayFileWriter::NeedKeyframe() const
+{
+	if (File == nullptr || TickNum % KeyframeInterval != 0)
+	{
+		return false;
+	}
+	return Keyframes.empty() || Keyframes.back().Tick != TickNum;
+}
+
+/**
+ * 写入当前tick的世界快照作为关键帧,并开始新的输入段。
+ * 也可以在间隔之外额外写入关键帧(例如关卡切换时),每个tick最多一个。
+ *
+ * @param _world 世界快照,通常由MADSnapshotRing::CaptureWorld生成
+ * @param _size 快照字节数
+ * @return 成功时返回true
+ */
+bool MADReplayFileWriter::WriteKeyframe(const unsigned char* _world, size_t _size)
+{
+	if (File == nullptr || Failed)
+	{
+		MAD_LOG_ERR("Try to write a keyframe without an open replay file!");
+		return false;
+	}
+	if (!Keyframes.empty() && Keyframes.back().Tick == TickNum)
+	{
+		MAD_LOG_ERR("Try to write two keyframes at the same tick!");
+		return false;
+	}
+	if (_size > MAD_REPLAY_FILE_MAX_WORLD_SIZE)
+	{
+		MAD_LOG_ERR("Try to write a keyframe larger than MAD_REPLAY_FILE_MAX_WORLD_SIZE!");
+		return false;
+	}
+	if (!FlushSegment())
+	{
+		return false;
+	}
+	MADSnapshotRing::EncodeDelta(nullptr, 0, _world, _size, Planar, Encoded);
+	MADReplayKeyframe l_keyframe;
+	l_keyframe.Tick = TickNum;
+	l_keyframe.KeyOffset = Offset;
+	l_keyframe.KeySize = Encoded.size();
+	l_keyframe.RawSize = _size;
+	if (!WriteBytes(Encoded.data(), Encoded.size()))
+	{
+		return false;
+	}
+	l_keyframe.InputOffset = Offset;
+	Keyframes.push_back(l_keyframe);
+	return true;
+}
+
+/**
+ * 记录一个tick的玩家输入,每个tick必须且只能调用一次。
+ *
+ * @param _input 本tick的玩家输入
+ * @return 成功时返回true;tick 0的关键帧尚未写入时返回false
+ */
+bool MADReplayFileWriter::Record(MADReplayInput _input)
+{
+	if (File == nullptr || Keyframes.empty())
+	{
+		MAD_LOG_ERR("Try to record replay input before the first keyframe!");
+		return false;
+	}
+	if (RunLength > 0 && _input != RunInput)
+	{
+		WriteVarint(Segment, RunInput);
+		WriteVarint(Segment, RunLength);
+		RunLength = 0;
+	}
+	RunInput = _input;
+	RunLength++;
+	TickNum++;
+	return true;
+}
+
+/**
+ * 写出最后的输入段、索引与文件尾,并关闭文件。
+ *
+ * 一个关键帧都没有写入时文件无法被读取,此时只关闭文件并返回错误。
+ *
+ * @return MAD_RESCODE_OK表示成功;没有关键帧时返回MAD_RESCODE_ILLEGAL_CALL;写入失败时返回MAD_RESCODE_FILE_ERROR。
+ */
+MADDebuggerInfo_LIGHT MADReplayFileWriter::Close()
+{
+	if (File == nullptr)
+	{
+		return MAD_RESCODE_ILLEGAL_CALL;
+	}
+	if (Keyframes.empty())
+	{
+		MAD_LOG_ERR("Try to close a replay file without the keyframe at tick 0!");
+		std::fclose(File);
+		File = nullptr;
+		return MAD_RESCODE_ILLEGAL_CALL;
+	}
+	FlushSegment();
+	unsigned long long l_index_offset = Offset;
+	std::vector<unsigned char> l_tail;
+	l_tail.reserve(Keyframes.size() * MAD_REPLAY_FILE_ENTRY_SIZE + MAD_REPLAY_FILE_TAIL_SIZE);
+	for (const MADReplayKeyframe& l_keyframe : Keyframes)
+	{
+		WriteU64(l_tail, l_keyframe.Tick);
+		WriteU64(l_tail, l_keyframe.KeyOffset);
+		WriteU64(l_tail, l_keyframe.KeySize);
+		WriteU64(l_tail, l_keyframe.RawSize);
+		WriteU64(l_tail, l_keyframe.InputOffset);
+		WriteU64(l_tail, l_keyframe.InputSize);
+	}
+	WriteU64(l_tail, l_index_offset);
+	WriteU64(l_tail, Keyframes.size());
+	WriteU64(l_tail, TickNum);
+	WriteU32(l_tail, MAD_REPLAY_FILE_INDEX_MAGIC);
+	WriteU32(l_tail, 0);
+	WriteBytes(l_tail.data(), l_tail.size());
+	bool l_ok = std::fclose(File) == 0 && !Failed;
+	File = nullptr;
+	if (!l_ok)
+	{
+		MAD_LOG_ERR("Replay file is not completely written!");
+		return MAD_RESCODE_FILE_ERROR;
+	}
+	return MAD_RESCODE_OK;
+}
+
+/**
+ * 检查是否有打开的录像文件。
+ *
+ * @return 已打开时返回true
+ */
+bool MADReplayFileWriter::IsOpen() const
+{
+	return File != nullptr;
+}
+
+/**
+ * 获取已记录的tick数。
+ *
+ * @return tick数
+ */
+unsigned long long MADReplayFileWriter::GetTickNum() const
+{
+	return TickNum;
+}
+
+/**
+ * 获取已写入的关键帧数量。
+ *
+ * @return 关键帧数量
+ */
+size_t MADReplayFileWriter::GetKeyframeNum() const
+{
+	return Keyframes.size();
+}
+
+/**
+ * (内部函数)
+ * 写入文件并累计偏移,失败后不再写入。
+ */
+bool MADReplayFileWriter::WriteBytes(const unsigned char* _data, size_t _size)
+{
+	if (Failed)
+	{
+		return false;
+	}
+	if (_size != 0 && std::fwrite(_data, 1, _size, File) != _size)
+	{
+		MAD_LOG_ERR("Failed to write the replay file!");
+		Failed = true;
+		return false;
+	}
+	Offset += _size;
+	return true;
+}
+
+/**
+ * (内部函数)
+ * 把最新关键帧之后的输入写入文件,并记录该输入段的长度。
+ */
+bool MADReplayFileWriter::FlushSegment()
+{
+	if (Keyframes.empty())
+	{
+		return true;
+	}
+	if (RunLength > 0)
+	{
+		WriteVarint(Segment, RunInput);
+		WriteVarint(Segment, RunLength);
+		RunLength = 0;
+	}
+	Keyframes.back().InputSize = Segment.size();
+	bool l_ok = WriteBytes(Segment.data(), Segment.size());
+	Segment.clear();
+	return l_ok;
+}
+
+/**
+ * 构造一个未打开文件的录像读取器。
+ */
+MADReplayFile::MADReplayFile()
+{
+	Data = nullptr;
+	Size = 0;
+	Mapped = false;
+	Close();
+}
+
+/**
+ * MADReplayFile析构函数,解除文件映射。
+ */
+MADReplayFile::~MADReplayFile()
+{
+	Close();
+}
+
+/**
+ * 以只读方式映射录像文件并读取文件头与文件尾。之前打开的文件会先被关闭。
+ *
+ * @param _path 文件路径
+ * @return MAD_RESCODE_OK表示成功;无法打开文件时返回MAD_RESCODE_FILE_ERROR,格式不正确时返回MAD_RESCODE_BAD_DATA。
+ */
+MADDebuggerInfo_LIGHT MADReplayFile::Open(const std::string& _path)
+{
+	Close();
+	const unsigned char* l_data = nullptr;
+	size_t l_size = 0;
+#if defined(_WIN32)
+	HANDLE l_file = CreateFileA(_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (l_file != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER l_file_size;
+		if (GetFileSizeEx(l_file, &l_file_size) && l_file_size.QuadPart > 0)
+		{
+			/*The view keeps the mapping alive after both handles are closed*/
+			HANDLE l_mapping = CreateFileMappingA(l_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (l_mapping != nullptr)
+			{
+				l_data = static_cast<const unsigned char*>(MapViewOfFile(l_mapping, FILE_MAP_READ, 0, 0, 0));
+				l_size = static_cast<size_t>(l_file_size.QuadPart);
+				CloseHandle(l_mapping);
+			}
+		}
+		CloseHandle(l_file);
+	}
+#else
+	int l_file = ::open(_path.c_str(), O_RDONLY);
+	if (l_file >= 0)
+	{
+		struct stat l_stat;
+		if (fstat(l_file, &l_stat) == 0 && l_stat.st_size > 0)
+		{
+			/*The mapping stays valid after the descriptor is closed*/
+			void* l_map = mmap(nullptr, static_cast<size_t>(l_stat.st_size), PROT_READ, MAP_PRIVATE, l_file, 0);
+			if (l_map != MAP_FAILED)
+			{
+				l_data = static_cast<const unsigned char*>(l_map);
+				l_size = static_cast<size_t>(l_stat.st_size);
+			}
+		}
+		::close(l_file);
+	}
+#endif
+	if (l_data == nullptr)
+	{
+		MAD_LOG_ERR("Try to open a replay file which can not be mapped: " + _path);
+		return MAD_RESCODE_FILE_ERROR;
+	}
+	Data = l_data;
+	Size = l_size;
+	Mapped = true;
+	return Parse();
+}
+
+/**
+ * 读取内存中的录像文件数据。数据不会被复制,在Close之前必须保持有效。
+ *
+ * @param _data 录像文件数据
+ * @param _size 数据字节数
+ * @return MAD_RESCODE_OK表示成功;格式不正确时返回MAD_RESCODE_BAD_DATA。
+ */
+MADDebuggerInfo_LIGHT MADReplayFile::Open(const unsigned char* _data, size_t _size)
+{
+	Close();
+	Data = _data;
+	Size = _data != nullptr ? _size : 0;
+	Mapped = false;
+	return Parse();
+}
+
+/**
+ * 关闭录像文件,解除文件映射。
+ */
+void MADReplayFile::Close()
+{
+	if (Mapped && Data != nullptr)
+	{
+#if defined(_WIN32)
+		UnmapViewOfFile(Data);
+#else
+		munmap(const_cast<unsigned char*>(Data), Size);
+#endif
+	}
+	Data = nullptr;
+	Size = 0;
+	Mapped = false;
+	Seed = 0;
+	TickRate = 60;
+	KeyframeInterval = MAD_REPLAY_DEFAULT_KEYFRAME_INTERVAL;
+	TickNum = 0;
+	IndexOffset = 0;
+	KeyframeNum = 0;
+	Tick = 0;
+	Keyframe = 0;
+	SegmentOffset = 0;
+	SegmentEnd = 0;
+	RunInput = 0;
+	RunLeft = 0;
+}
+
+/**
+ * 跳转到不晚于 _tick 的最近关键帧,解压该关键帧,并把输入读取位置移到该关键帧之后。
+ * 之后由调用者恢复世界,再调用 Next 并执行模拟,直到GetTick()到达 _tick。
+ *
+ * @param _tick 目标tick,超过录像长度时视为录像末尾
+ * @param out_world 输出的世界快照,可交给MADSnapshotRing::RestoreWorld
+ * @param out_tick 输出关键帧对应的tick,可为nullptr
+ * @return 成功时返回true
+ */
+bool MADReplayFile::Seek(unsigned long long _tick, std::vector<unsigned char>& out_world, unsigned long long* out_tick)
+{
+	if (KeyframeNum == 0)
+	{
+		MAD_LOG_ERR("Try to seek in a replay file which is not open!");
+		return false;
+	}
+	_tick = _tick < TickNum ? _tick : TickNum;
+
+	/*Last keyframe not after the target,the index is untrusted so ticks must increase along the search*/
+	size_t l_low = 0;
+	size_t l_high = KeyframeNum;
+	MADReplayKeyframe l_keyframe;
+	bool l_ok = GetKeyframe(0, &l_keyframe);
+	unsigned long long l_low_tick = l_keyframe.Tick;
+	unsigned long long l_high_tick = ~0ull;
+	while (l_ok && l_high - l_low > 1)
+	{
+		size_t l_mid = l_low + (l_high - l_low) / 2;
+		l_ok = GetKeyframe(l_mid, &l_keyframe) && l_keyframe.Tick > l_low_tick && l_keyframe.Tick < l_high_tick;
+		if (l_keyframe.Tick <= _tick)
+		{
+			l_low = l_mid;
+			l_low_tick = l_keyframe.Tick;
+		}
+		else
+		{
+			l_high = l_mid;
+			l_high_tick = l_keyframe.Tick;
+		}
+	}
+
+	/*Only the keyframe actually used is checked against the data area*/
+	l_ok = l_ok && GetKeyframe(l_low, &l_keyframe) && l_keyframe.KeyOffset <= IndexOffset &&
+		l_keyframe.KeySize <= IndexOffset - l_keyframe.KeyOffset &&
+		l_keyframe.RawSize <= MAD_REPLAY_FILE_MAX_WORLD_SIZE && EnterSegment(l_low);
+	if (!l_ok)
+	{
+		MAD_LOG_ERR("Replay file keyframe at tick " + std::to_string(l_keyframe.Tick) + " is out of range!");
+		return false;
+	}
+	out_world.clear();
+	if (!MADSnapshotRing::ApplyDelta(Data + l_keyframe.KeyOffset, static_cast<size_t>(l_keyframe.KeySize),
+		static_cast<size_t>(l_keyframe.RawSize), out_world))
+	{
+		MAD_LOG_ERR("Replay file keyframe at tick " + std::to_string(l_keyframe.Tick) + " is broken!");
+		return false;
+	}
+	Tick = l_keyframe.Tick;
+	if (out_tick != nullptr)
+	{
+		*out_tick = l_keyframe.Tick;
+	}
+	return true;
+}
+
+/**
+ * 读取下一个tick的玩家输入,输入段结束时自动进入下一个关键帧之后的输入段。
+ *
+ * @param[out] out_input 接收输入的指针
+ * @return 成功读取时返回true;录像已结束、尚未Seek或数据损坏时返回false。
+ */
+bool MADReplayFile::Next(MADReplayInput* out_input)
+{
+	if (Data == nullptr || Tick >= TickNum || SegmentEnd == 0)
+	{
+		return false;
+	}
+	while (RunLeft == 0)
+	{
+		if (SegmentOffset >= SegmentEnd)
+		{
+			if (Keyframe + 1 >= KeyframeNum || !EnterSegment(Keyframe + 1))
+			{
+				MAD_LOG_ERR("Replay file input ends early at tick " + std::to_string(Tick) + ".");
+				TickNum = Tick;
+				return false;
+			}
+			continue;
+		}
+		unsigned long long l_input = 0, l_run = 0;
+		if (!ReadVarint(Data, SegmentEnd, &SegmentOffset, &l_input) ||
+			!ReadVarint(Data, SegmentEnd, &SegmentOffset, &l_run) || l_run == 0)
+		{
+			MAD_LOG_ERR("Replay file input is broken at tick " + std::to_string(Tick) + ".");
+			TickNum = Tick;
+			return false;
+		}
+		RunInput = static_cast<MADReplayInput>(l_input);
+		RunLeft = l_run;
+	}
+	RunLeft--;
+	Tick++;
+	*out_input = RunInput;
+	return true;
+}
+
+/**
+ * 检查是否有打开的录像文件。
+ *
+ * @return 已打开时返回true
+ */
+bool MADReplayFile::IsOpen() const
+{
+	return KeyframeNum != 0;
+}
+
+/**
+ * 获取录像的主种子。
+ *
+ * @return 主种子
+ */
+unsigned long long MADReplayFile::GetSeed() const
+{
+	return Seed;
+}
+
+/**
+ * 获取录像的tick频率。
+ *
+ * @return 每秒tick数
+ */
+unsigned int MADReplayFile::GetTickRate() const
+{
+	return TickRate;
+}
+
+/**
+ * 获取录像的关键帧间隔。
+ *
+ * @return 关键帧间隔(tick)
+ */
+unsigned int MADReplayFile::GetKeyframeInterval() const
+{
+	return KeyframeInterval;
+}
+
+/**
+ * 获取录像的总tick数。
+ *
+ * @return 总tick数
+ */
+unsigned long long MADReplayFile::GetTickNum() const
+{
+	return TickNum;
+}
+
+/**
+ * 获取录像中的关键帧数量。
+ *
+ * @return 关键帧数量
+ */
+size_t MADReplayFile::GetKeyframeNum() const
+{
+	return KeyframeNum;
+}
+
+/**
+ * 从尾部索引中读取一个关键帧的信息。
+ *
+ * @param _index 关键帧序号
+ * @param out_keyframe 接收关键帧信息的指针
+ * @return 序号有效时返回true
+ */
+bool MADReplayFile::GetKeyframe(size_t _index, MADReplayKeyframe* out_keyframe) const
+{
+	if (_index >= KeyframeNum)
+	{
+		return false;
+	}
+	size_t l_offset = static_cast<size_t>(IndexOffset) + _index * MAD_REPLAY_FILE_ENTRY_SIZE;
+	return ReadU64(Data, Size, &l_offset, &out_keyframe->Tick) &&
+		ReadU64(Data, Size, &l_offset, &out_keyframe->KeyOffset) &&
+		ReadU64(Data, Size, &l_offset, &out_keyframe->KeySize) &&
+		ReadU64(Data, Size, &l_offset, &out_keyframe->RawSize) &&
+		ReadU64(Data, Size, &l_offset, &out_keyframe->InputOffset) &&
+		ReadU64(Data, Size, &l_offset, &out_keyframe->InputSize);
+}
+
+/**
+ * 获取已读取输入的tick,即当前世界应处于的tick。
+ *
+ * @return tick
+ */
+unsigned long long MADReplayFile::GetTick() const
+{
+	return Tick;
+}
+
+/**
+ * (内部函数)
+ * 读取文件头与文件尾并校验,之后定位到第一个关键帧。
+ */
+MADDebuggerInfo_LIGHT MADReplayFile::Parse()
+{
+	size_t l_offset = 0;
+	unsigned int l_magic = 0, l_version = 0, l_reserved = 0, l_index_magic = 0;
+	unsigned long long l_reserved64 = 0, l_keyframe_num = 0;
+	bool l_ok = Size >= MAD_REPLAY_FILE_HEADER_SIZE + MAD_REPLAY_FILE_TAIL_SIZE &&
+		ReadU32(Data, Size, &l_offset, &l_magic) &&
+		ReadU16(Data, Size, &l_offset, &l_version) &&
+		ReadU16(Data, Size, &l_offset, &l_reserved) &&
+		ReadU64(Data, Size, &l_offset, &Seed) &&
+		ReadU32(Data, Size, &l_offset, &TickRate) &&
+		ReadU32(Data, Size, &l_offset, &KeyframeInterval) &&
+		ReadU64(Data, Size, &l_offset, &l_reserved64);
+	l_offset = Size - MAD_REPLAY_FILE_TAIL_SIZE;
+	l_ok = l_ok &&
+		ReadU64(Data, Size, &l_offset, &IndexOffset) &&
+		ReadU64(Data, Size, &l_offset, &l_keyframe_num) &&
+		ReadU64(Data, Size, &l_offset, &TickNum) &&
+		ReadU32(Data, Size, &l_offset, &l_index_magic);
+	l_ok = l_ok && l_magic == MAD_REPLAY_FILE_MAGIC && l_version == MAD_REPLAY_FILE_VERSION &&
+		l_index_magic == MAD_REPLAY_FILE_INDEX_MAGIC && l_keyframe_num > 0 &&
+		IndexOffset >= MAD_REPLAY_FILE_HEADER_SIZE &&
+		l_keyframe_num <= (Size - MAD_REPLAY_FILE_TAIL_SIZE) / MAD_REPLAY_FILE_ENTRY_SIZE &&
+		IndexOffset == Size - MAD_REPLAY_FILE_TAIL_SIZE - l_keyframe_num * MAD_REPLAY_FILE_ENTRY_SIZE;
+	if (!l_ok)
+	{
+		MAD_LOG_ERR("Try to open an invalid replay file!");
+		Close();
+		return MAD_RESCODE_BAD_DATA;
+	}
+	KeyframeNum = static_cast<size_t>(l_keyframe_num);
+	Tick = 0;
+	if (!EnterSegment(0))
+	{
+		MAD_LOG_ERR("Try to open an invalid replay file!");
+		Close();
+		return MAD_RESCODE_BAD_DATA;
+	}
+	return MAD_RESCODE_OK;
+}
+
+/**
+ * (内部函数)
+ * 把输入读取位置移到第 _keyframe 个关键帧之后的输入段开头。
+ */
+bool MADReplayFile::EnterSegment(size_t _keyframe)
+{
+	MADReplayKeyframe l_keyframe;
+	if (!GetKeyframe(_keyframe, &l_keyframe) || l_keyframe.InputOffset > IndexOffset ||
+		l_keyframe.InputSize > IndexOffset - l_keyframe.InputOffset)
+	{
+		return false;
+	}
+	Keyframe = _keyframe;
+	SegmentOffset = static_cast<size_t>(l_keyframe.InputOffset);
+	SegmentEnd = static_cast<size_t>(l_keyframe.InputOffset + l_keyframe.InputSize);
+	RunInput = 0;
+	RunLeft = 0;
+	return true;
+}
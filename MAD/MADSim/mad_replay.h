@@ -0,0 +1,264 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../MADBase/mad_base.h"
+
+/*Replay stream header*/
+#define MAD_REPLAY_MAGIC 0x5244414Du
+#define MAD_REPLAY_VERSION 1
+
+/*Replay file header and tail index*/
+#define MAD_REPLAY_FILE_MAGIC 0x4652414Du
+#define MAD_REPLAY_FILE_VERSION 1
+#define MAD_REPLAY_FILE_INDEX_MAGIC 0x58444E49u
+
+/*Largest uncompressed keyframe a replay file may hold,bounds the allocation made when a keyframe is decoded*/
+#define MAD_REPLAY_FILE_MAX_WORLD_SIZE (256ull << 20)
+
+/*Default ticks between two keyframes of a replay file,10 seconds at 60 ticks per second*/
+#define MAD_REPLAY_DEFAULT_KEYFRAME_INTERVAL 600
+
+/**
+ * \brief 一个tick的玩家输入,按位表示各个按键,具体含义由宿主定义。
+ */
+typedef unsigned int MADReplayInput;
+
+/**
+ * MADReplayRecorder 只记录每个tick的玩家输入,生成紧凑的录像数据流。
+ *
+ * 录像的前提是模拟完全确定:相同的种子、相同的固定步长与相同的输入序列必然得到相同的状态。
+ * 因此录像中只保存种子、tick频率与输入序列,连续相同的输入被压缩为(输入,重复次数)对。
+ * 另外每隔HashInterval个tick保存一次世界状态哈希,供回放时校验。
+ *
+ * 每个tick的调用顺序:Record(输入) -> 执行模拟 -> RecordHash(MADStateHash::HashWorld(...))。
+ */
+class MADReplayRecorder
+{
+public:
+	MADReplayRecorder();
+	~MADReplayRecorder();
+
+public:
+	/*Record operator*/
+	void Begin(unsigned long long _seed, unsigned int _tick_rate, unsigned int _hash_interval = 60);
+	void Record(MADReplayInput _input);
+	void RecordHash(unsigned long long _hash);
+	void Finish(std::vector<unsigned char>& out_data) const;
+
+	/*Get Data*/
+	unsigned long long GetTickNum() const;
+
+private:
+	unsigned long long Seed;
+	unsigned int TickRate;
+	unsigned int HashInterval;
+	unsigned long long TickNum;
+
+	/*Run length state*/
+	MADReplayInput RunInput;
+	unsigned long long RunLength;
+	std::vector<unsigned char> InputStream;
+	std::vector<unsigned long long> Hashes;
+};
+
+/**
+ * MADReplayPlayer 读取MADReplayRecorder生成的录像,逐tick还原玩家输入并校验状态哈希。
+ *
+ * 每个tick的调用顺序:Next(&输入) -> 执行模拟 -> CheckHash(MADStateHash::HashWorld(...))。
+ */
+class MADReplayPlayer
+{
+public:
+	MADReplayPlayer();
+	~MADReplayPlayer();
+
+public:
+	/*Play operator*/
+	MADDebuggerInfo_LIGHT Open(const unsigned char* _data, size_t _size);
+	bool Next(MADReplayInput* out_input);
+	bool CheckHash(unsigned long long _hash);
+	void Rewind();
+
+	/*Get Data*/
+	unsigned long long GetSeed() const;
+	unsigned int GetTickRate() const;
+	unsigned int GetHashInterval() const;
+	unsigned long long GetTickNum() const;
+	unsigned long long GetTick() const;
+
+private:
+	unsigned long long Seed;
+	unsigned int TickRate;
+	unsigned int HashInterval;
+	unsigned long long TickNum;
+	std::vector<unsigned char> InputStream;
+	std::vector<unsigned long long> Hashes;
+
+	/*Play state*/
+	unsigned long long Tick;
+	size_t StreamOffset;
+	MADReplayInput RunInput;
+	unsigned long long RunLeft;
+};
+
+/**
+ * \brief MADReplayKeyframe 是录像文件尾部索引中的一项。
+ *
+ * `Tick` 为关键帧对应的tick(该tick的模拟已经完成);关键帧数据位于 [KeyOffset, KeyOffset + KeySize),
+ * 解压后为 RawSize 字节;之后 Tick + 1 起的输入位于 [InputOffset, InputOffset + InputSize),直到下一个关键帧。
+ */
+struct MADReplayKeyframe {
+	unsigned long long Tick;
+	unsigned long long KeyOffset;
+	unsigned long long KeySize;
+	unsigned long long RawSize;
+	unsigned long long InputOffset;
+	unsigned long long InputSize;
+
+	MADReplayKeyframe() {
+		Tick = 0;
+		KeyOffset = 0;
+		KeySize = 0;
+		RawSize = 0;
+		InputOffset = 0;
+		InputSize = 0;
+	}
+};
+
+/**
+ * MADReplayFileWriter 把录像直接写入文件:玩家输入流、定期的压缩世界关键帧,以及文件尾部的索引。
+ *
+ * 文件布局(小端序):
+ * - 文件头:u32 魔数, u16 版本, u16 保留, u64 种子, u32 tick频率, u32 关键帧间隔, u64 保留;
+ * - 依次排列的(关键帧数据, 输入段):关键帧为MADSnapshotRing::CaptureWorld生成的世界快照
+ *   (模拟中用到的模式解释器、追踪子弹与激光池也应一并传入,否则Seek之后它们的状态无法恢复),
+ *   经MADSnapshotRing::EncodeDelta压缩;输入段为该关键帧之后到下一个关键帧为止的(输入值, 重复次数)varint对;
+ * - 索引:每个关键帧一项,6个u64,见MADReplayKeyframe;
+ * - 文件尾:u64 索引偏移, u64 关键帧数量, u64 tick数, u32 索引魔数, u32 保留。
+ * 只需读取文件头与文件尾即可打开,读取任意tick只需解压一个关键帧并读取一段输入。
+ * 单个关键帧解压后不得超过 MAD_REPLAY_FILE_MAX_WORLD_SIZE 字节。
+ *
+ * 每个tick的调用顺序:NeedKeyframe()为true时 WriteKeyframe(世界快照) -> Record(输入) -> 执行模拟。
+ * 第一个关键帧必须在tick 0(第一次Record之前)写入。
+ *
+ * 注意:该类是线程不安全的!
+ */
+class MADReplayFileWriter
+{
+public:
+	MADReplayFileWriter();
+	~MADReplayFileWriter();
+
+public:
+	/*Record operator*/
+	MADDebuggerInfo_LIGHT Open(const std::string& _path, unsigned long long _seed, unsigned int _tick_rate,
+		unsigned int _keyframe_interval = MAD_REPLAY_DEFAULT_KEYFRAME_INTERVAL);
+	bool NeedKeyframe() const;
+	bool WriteKeyframe(const unsigned char* _world, size_t _size);
+	bool Record(MADReplayInput _input);
+	MADDebuggerInfo_LIGHT Close();
+
+	/*Get Data*/
+	bool IsOpen() const;
+	unsigned long long GetTickNum() const;
+	size_t GetKeyframeNum() const;
+
+private:
+	std::FILE* File;
+	unsigned long long Offset;
+	bool Failed;
+	unsigned int KeyframeInterval;
+	unsigned long long TickNum;
+	std::vector<MADReplayKeyframe> Keyframes;
+
+	/*Input segment after the newest keyframe*/
+	MADReplayInput RunInput;
+	unsigned long long RunLength;
+	std::vector<unsigned char> Segment;
+
+	/*Scratch*/
+	std::vector<unsigned char> Planar;
+	std::vector<unsigned char> Encoded;
+
+	/*Common function*/
+	bool WriteBytes(const unsigned char* _data, size_t _size);
+	bool FlushSegment();
+};
+
+/**
+ * MADReplayFile 通过内存映射读取MADReplayFileWriter生成的录像文件。
+ *
+ * - Open只读取文件头与文件尾,与录像长度无关;操作系统只在访问时才把用到的页读入内存,因此从不读取整个文件;
+ * - Seek在尾部索引中二分查找不晚于目标tick的最近关键帧,解压该关键帧,并把输入读取位置移到该关键帧之后;
+ *   调用者用MADSnapshotRing::RestoreWorld恢复世界,再按 Next -> 执行模拟 快进到目标tick,
+ *   快进的tick数不超过关键帧间隔;
+ * - Next依次读取输入,跨越关键帧时自动跳到下一个输入段。
+ *
+ * 也可以通过 Open(const unsigned char*, size_t) 直接读取内存中的录像,数据不会被复制。
+ *
+ * 注意:该类是线程不安全的!
+ */
+class MADReplayFile
+{
+public:
+	MADReplayFile();
+	~MADReplayFile();
+
+	MADReplayFile(const MADReplayFile&) = delete;
+	MADReplayFile& operator=(const MADReplayFile&) = delete;
+
+public:
+	/*File operator*/
+	MADDebuggerInfo_LIGHT Open(const std::string& _path);
+	MADDebuggerInfo_LIGHT Open(const unsigned char* _data, size_t _size);
+	void Close();
+
+	/*Play operator*/
+	bool Seek(unsigned long long _tick, std::vector<unsigned char>& out_world, unsigned long long* out_tick);
+	bool Next(MADReplayInput* out_input);
+
+	/*Get Data*/
+	bool IsOpen() const;
+	unsigned long long GetSeed() const;
+	unsigned int GetTickRate() const;
+	unsigned int GetKeyframeInterval() const;
+	unsigned long long GetTickNum() const;
+	size_t GetKeyframeNum() const;
+	bool GetKeyframe(size_t _index, MADReplayKeyframe* out_keyframe) const;
+	unsigned long long GetTick() const;
+
+private:
+	/*File data,mapped or borrowed*/
+	const unsigned char* Data;
+	size_t Size;
+	bool Mapped;
+
+	/*Header and tail*/
+	unsigned long long Seed;
+	unsigned int TickRate;
+	unsigned int KeyframeInterval;
+	unsigned long long TickNum;
+	unsigned long long IndexOffset;
+	size_t KeyframeNum;
+
+	/*Play state*/
+	unsigned long long Tick;
+	size_t Keyframe;
+	size_t SegmentOffset;
+	size_t SegmentEnd;
+	MADReplayInput RunInput;
+	unsigned long long RunLeft;
+
+	/*Common function*/
+	MADDebuggerInfo_LIGHT Parse();
+	bool EnterSegment(size_t _keyframe);
+};
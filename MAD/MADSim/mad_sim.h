@@ -0,0 +1,13 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+/*MAD APIs*/
+#include "mad_timestep.h"
+#include "mad_state_hash.h"
+#include "mad_replay.h"
+#include "mad_snapshot.h"
@@ -0,0 +1,703 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_snapshot.h"
+
+#include <cstring>
+
+/*Bytes per delta word,one byte plane per byte of the word*/
+#define MAD_SNAPSHOT_WORD 4
+
+static_assert(MAD_SNAPSHOT_WORD == sizeof(unsigned int), "Delta words are split and scanned as unsigned int");
+
+/*World snapshot content flags*/
+#define MAD_SNAPSHOT_HAS_ENTITIES 0x01u
+#define MAD_SNAPSHOT_HAS_TIMER 0x02u
+#define MAD_SNAPSHOT_HAS_RUNNER 0x04u
+#define MAD_SNAPSHOT_HAS_HOMING 0x08u
+#define MAD_SNAPSHOT_HAS_LASERS 0x10u
+#define MAD_SNAPSHOT_HAS_FIXED 0x20u
+#define MAD_SNAPSHOT_HAS_TIMELINE 0x40u
+
+/*Content flags of a world snapshot with the given optional parts*/
+static unsigned int GetWorldFlags(bool _entities, bool _timer, bool _runner, bool _homing, bool _lasers, bool _fixed,
+	bool _timeline)
+{
+	return (_entities ? MAD_SNAPSHOT_HAS_ENTITIES : 0u) | (_timer ? MAD_SNAPSHOT_HAS_TIMER : 0u) |
+		(_runner ? MAD_SNAPSHOT_HAS_RUNNER : 0u) | (_homing ? MAD_SNAPSHOT_HAS_HOMING : 0u) |
+		(_lasers ? MAD_SNAPSHOT_HAS_LASERS : 0u) | (_fixed ? MAD_SNAPSHOT_HAS_FIXED : 0u) |
+		(_timeline ? MAD_SNAPSHOT_HAS_TIMELINE : 0u);
+}
+
+/*Varint helpers,same encoding as the replay stream*/
+static void WriteVarint(std::vector<unsigned char>& out_data, unsigned long long _value)
+{
+	while (_value >= 0x80)
+	{
+		out_data.push_back(static_cast<unsigned char>((_value & 0x7F) | 0x80));
+		_value >>= 7;
+	}
+	out_data.push_back(static_cast<unsigned char>(_value));
+}
+
+static bool ReadVarint(const unsigned char* _data, size_t _size, size_t* io_offset, unsigned long long* out_value)
+{
+	unsigned long long l_value = 0;
+	for (int l_shift = 0; l_shift < 64; l_shift += 7)
+	{
+		if (*io_offset >= _size)
+		{
+			return false;
+		}
+		unsigned char l_byte = _data[(*io_offset)++];
+		l_value |= static_cast<unsigned long long>(l_byte & 0x7F) << l_shift;
+		if ((l_byte & 0x80) == 0)
+		{
+			*out_value = l_value;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*Start of each byte plane inside a planar buffer of _size bytes,out_offsets[MAD_SNAPSHOT_WORD] is _size*/
+static void GetPlaneOffsets(size_t _size, size_t* out_offsets)
+{
+	size_t l_offset = 0;
+	for (size_t p = 0; p < MAD_SNAPSHOT_WORD; ++p)
+	{
+		out_offsets[p] = l_offset;
+		l_offset += _size > p ? (_size - p + MAD_SNAPSHOT_WORD - 1) / MAD_SNAPSHOT_WORD : 0;
+	}
+	out_offsets[MAD_SNAPSHOT_WORD] = l_offset;
+}
+
+/*Whether a delta word is all zero*/
+static bool IsZeroWord(const unsigned char* _data)
+{
+	unsigned int l_word;
+	std::memcpy(&l_word, _data, sizeof(l_word));
+	return l_word == 0;
+}
+
+/**
+ * (内部函数)
+ * 异或两份数据的前 _words 个字,并把每个字的第p个字节写入第p个字节平面(标量路径)。
+ */
+static void SplitPlanesScalar(const unsigned char* _old, const unsigned char* _new, size_t _begin, size_t _words,
+	unsigned char* const* out_planes)
+{
+	for (size_t w = _begin; w < _words; ++w)
+	{
+		const unsigned char* l_old = _old + w * MAD_SNAPSHOT_WORD;
+		const unsigned char* l_new = _new + w * MAD_SNAPSHOT_WORD;
+		for (size_t p = 0; p < MAD_SNAPSHOT_WORD; ++p)
+		{
+			out_planes[p][w] = l_old[p] ^ l_new[p];
+		}
+	}
+}
+
+#if defined(MAD_SIMD_X86)
+/**
+ * (内部函数)
+ * 字节平面拆分的SSE2路径,每次处理16个字:先按偶数/奇数字节拆分一次,再对结果各拆分一次。
+ */
+MAD_TARGET_SSE2
+static void SplitPlanesSSE2(const unsigned char* _old, const unsigned char* _new, size_t _words,
+	unsigned char* const* out_planes)
+{
+	const __m128i l_low = _mm_set1_epi16(0x00FF);
+	size_t w = 0;
+	for (; w + 16 <= _words; w += 16)
+	{
+		const unsigned char* l_old = _old + w * MAD_SNAPSHOT_WORD;
+		const unsigned char* l_new = _new + w * MAD_SNAPSHOT_WORD;
+		__m128i l_v[4];
+		for (int k = 0; k < 4; ++k)
+		{
+			l_v[k] = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(l_old + k * 16)),
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(l_new + k * 16)));
+		}
+		__m128i l_even0 = _mm_packus_epi16(_mm_and_si128(l_v[0], l_low), _mm_and_si128(l_v[1], l_low));
+		__m128i l_odd0 = _mm_packus_epi16(_mm_srli_epi16(l_v[0], 8), _mm_srli_epi16(l_v[1], 8));
+		__m128i l_even1 = _mm_packus_epi16(_mm_and_si128(l_v[2], l_low), _mm_and_si128(l_v[3], l_low));
+		__m128i l_odd1 = _mm_packus_epi16(_mm_srli_epi16(l_v[2], 8), _mm_srli_epi16(l_v[3], 8));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out_planes[0] + w),
+			_mm_packus_epi16(_mm_and_si128(l_even0, l_low), _mm_and_si128(l_even1, l_low)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out_planes[1] + w),
+			_mm_packus_epi16(_mm_and_si128(l_odd0, l_low), _mm_and_si128(l_odd1, l_low)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out_planes[2] + w),
+			_mm_packus_epi16(_mm_srli_epi16(l_even0, 8), _mm_srli_epi16(l_even1, 8)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out_planes[3] + w),
+			_mm_packus_epi16(_mm_srli_epi16(l_odd0, 8), _mm_srli_epi16(l_odd1, 8)));
+	}
+	SplitPlanesScalar(_old, _new, w, _words, out_planes);
+}
+#endif
+
+/**
+ * (内部函数)
+ * 异或两份数据的前 _words 个字并拆分为字节平面,按当前SIMD等级选择实现,各路径结果逐位一致。
+ */
+static void SplitPlanes(const unsigned char* _old, const unsigned char* _new, size_t _words, unsigned char* const* out_planes)
+{
+#if defined(MAD_SIMD_X86)
+	if (MADSimd::GetLevel() != MADSimdLevel::Scalar)
+	{
+		SplitPlanesSSE2(_old, _new, _words, out_planes);
+		return;
+	}
+#endif
+	SplitPlanesScalar(_old, _new, 0, _words, out_planes);
+}
+
+/**
+ * 创建一个快照环。
+ *
+ * @param _capacity 最多保存的快照数量,至少为1
+ * @param _budget 所有快照合计的内存预算(字节),为0时只按数量限制
+ * @param _delta 是否以差分方式保存快照
+ */
+MADSnapshotRing::MADSnapshotRing(size_t _capacity, size_t _budget, bool _delta)
+{
+	Capacity = _capacity > 0 ? _capacity : 1;
+	Budget = _budget;
+	Delta = _delta;
+	Memory = 0;
+}
+
+/**
+ * MADSnapshotRing析构函数。
+ */
+MADSnapshotRing::~MADSnapshotRing()
+{
+}
+
+/**
+ * 保存一份快照,tick必须大于已保存的最新快照。
+ * 保存后按数量与内存预算淘汰最旧的快照。
+ *
+ * @param _tick 快照对应的tick
+ * @param _data 快照数据,通常由CaptureWorld生成
+ * @param _size 快照字节数
+ * @return 成功时返回true
+ */
+bool MADSnapshotRing::Push(unsigned long long _tick, const unsigned char* _data, size_t _size)
+{
+	if (_data == nullptr && _size != 0)
+	{
+		MAD_LOG_ERR("Try to push a null snapshot!");
+		return false;
+	}
+	if (!Entries.empty() && _tick <= Entries.back().Tick)
+	{
+		MAD_LOG_ERR("Try to push a snapshot older than the newest one!");
+		return false;
+	}
+	if (Delta)
+	{
+		/*The previous newest snapshot becomes a delta against the new one*/
+		if (!Entries.empty())
+		{
+			SnapshotEntry& l_prev = Entries.back();
+			EncodeDelta(Latest.data(), Latest.size(), _data, _size, Planar, Encoded);
+			l_prev.Data.assign(Encoded.begin(), Encoded.end());
+			Memory += l_prev.Data.size();
+			Memory -= Latest.size();
+		}
+		Latest.assign(_data, _data + _size);
+		Memory += _size;
+		Entries.emplace_back();
+		Entries.back().Tick = _tick;
+		Entries.back().Size = _size;
+	}
+	else
+	{
+		Entries.emplace_back();
+		Entries.back().Tick = _tick;
+		Entries.back().Size = _size;
+		Entries.back().Data.assign(_data, _data + _size);
+		Memory += _size;
+	}
+	Evict();
+	return true;
+}
+
+/**
+ * 保存一份快照,参见 Push(unsigned long long, const unsigned char*, size_t)。
+ *
+ * @param _tick 快照对应的tick
+ * @param _data 快照数据
+ * @return 成功时返回true
+ */
+bool MADSnapshotRing::Push(unsigned long long _tick, const std::vector<unsigned char>& _data)
+{
+	return Push(_tick, _data.data(), _data.size());
+}
+
+/**
+ * 读取指定tick的快照。差分模式下从最新的快照开始依次解码,代价与该快照之后的快照数量成正比。
+ *
+ * @param _tick 快照对应的tick
+ * @param out_data 输出的完整快照数据,已有容量会被复用
+ * @return 快照存在时返回true
+ */
+bool MADSnapshotRing::Load(unsigned long long _tick, std::vector<unsigned char>& out_data) const
+{
+	size_t l_index = Find(_tick);
+	if (l_index == Entries.size())
+	{
+		return false;
+	}
+	if (!Delta)
+	{
+		out_data.assign(Entries[l_index].Data.begin(), Entries[l_index].Data.end());
+		return true;
+	}
+	out_data.assign(Latest.begin(), Latest.end());
+	for (size_t i = Entries.size() - 1; i > l_index; --i)
+	{
+		const SnapshotEntry& l_entry = Entries[i - 1];
+		if (!ApplyDelta(l_entry.Data.data(), l_entry.Data.size(), l_entry.Size, out_data))
+		{
+			MAD_LOG_ERR("Try to load a snapshot from broken delta data!");
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * 回滚到指定tick:读取该tick的快照,并丢弃所有比它新的快照,之后从该tick继续Push。
+ *
+ * @param _tick 快照对应的tick
+ * @param out_data 输出的完整快照数据
+ * @return 快照存在时返回true
+ */
+bool MADSnapshotRing::Rewind(unsigned long long _tick, std::vector<unsigned char>& out_data)
+{
+	if (!Load(_tick, out_data))
+	{
+		return false;
+	}
+	while (Entries.back().Tick > _tick)
+	{
+		Memory -= Entries.back().Data.size();
+		Entries.pop_back();
+	}
+	if (Delta)
+	{
+		Memory -= Latest.size() + Entries.back().Data.size();
+		Latest.assign(out_data.begin(), out_data.end());
+		Entries.back().Data.clear();
+		Entries.back().Data.shrink_to_fit();
+		Memory += Latest.size();
+	}
+	return true;
+}
+
+/**
+ * 清空所有快照。
+ */
+void MADSnapshotRing::Clear()
+{
+	Entries.clear();
+	Latest.clear();
+	Memory = 0;
+}
+
+/**
+ * 获取已保存的快照数量。
+ *
+ * @return 快照数量
+ */
+size_t MADSnapshotRing::GetNum() const
+{
+	return Entries.size();
+}
+
+/**
+ * 获取最多保存的快照数量。
+ *
+ * @return 快照容量
+ */
+size_t MADSnapshotRing::GetCapacity() const
+{
+	return Capacity;
+}
+
+/**
+ * 获取所有快照数据合计占用的字节数,不含各数组的预留容量与临时缓冲区。
+ *
+ * @return 字节数
+ */
+size_t MADSnapshotRing::GetMemory() const
+{
+	return Memory;
+}
+
+/**
+ * 检查指定tick的快照是否存在。
+ *
+ * @param _tick 快照对应的tick
+ * @return 存在时返回true
+ */
+bool MADSnapshotRing::Has(unsigned long long _tick) const
+{
+	return Find(_tick) != Entries.size();
+}
+
+/**
+ * 获取最旧的快照的tick。
+ *
+ * @return tick;没有快照时返回0
+ */
+unsigned long long MADSnapshotRing::GetOldestTick() const
+{
+	return Entries.empty() ? 0 : Entries.front().Tick;
+}
+
+/**
+ * 获取最新的快照的tick。
+ *
+ * @return tick;没有快照时返回0
+ */
+unsigned long long MADSnapshotRing::GetNewestTick() const
+{
+	return Entries.empty() ? 0 : Entries.back().Tick;
+}
+
+/**
+ * 生成一份世界快照,依次保存子弹池、实体索引、时间轮、模式解释器、追踪子弹、激光池、定点子弹池与发射时间线。
+ * MADCollisionWorld 不需要保存,恢复后对子弹池重新Build即可。
+ *
+ * @param _pool 子弹池
+ * @param _entities 实体索引,可为nullptr
+ * @param _timer 时间轮,可为nullptr
+ * @param out_data 输出缓冲区,原有内容会被清空,已有容量会被复用
+ * @param _runner 模式解释器,可为nullptr
+ * @param _homing 追踪子弹,可为nullptr
+ * @param _lasers 直线激光池,可为nullptr
+ * @param _fixed 定点子弹池,可为nullptr
+ * @param _timeline 发射时间线,可为nullptr;其中的Script事件不会被保存
+ * @return 快照字节数
+ */
+size_t MADSnapshotRing::CaptureWorld(const MADBulletPool& _pool, const MADEntityIndex* _entities,
+	const MADBulletTimer* _timer, std::vector<unsigned char>& out_data, const MADPatternRunner* _runner,
+	const MADBulletHoming* _homing, const MADLaserPool* _lasers, const MADFixedBulletPool* _fixed,
+	const MADEmitterTimeline* _timeline)
+{
+	out_data.clear();
+	unsigned int l_flags = GetWorldFlags(_entities != nullptr, _timer != nullptr, _runner != nullptr,
+		_homing != nullptr, _lasers != nullptr, _fixed != nullptr, _timeline != nullptr);
+	MADBlobWriter l_writer(out_data);
+	l_writer.Write(MAD_SNAPSHOT_WORLD_TAG);
+	l_writer.Write(l_flags);
+	_pool.Snapshot(out_data);
+	if (_entities != nullptr)
+	{
+		_entities->Snapshot(out_data);
+	}
+	if (_timer != nullptr)
+	{
+		_timer->Snapshot(out_data);
+	}
+	if (_runner != nullptr)
+	{
+		_runner->Snapshot(out_data);
+	}
+	if (_homing != nullptr)
+	{
+		_homing->Snapshot(out_data);
+	}
+	if (_lasers != nullptr)
+	{
+		_lasers->Snapshot(out_data);
+	}
+	if (_fixed != nullptr)
+	{
+		_fixed->Snapshot(out_data);
+	}
+	if (_timeline != nullptr)
+	{
+		_timeline->Snapshot(out_data);
+	}
+	return out_data.size();
+}
+
+/**
+ * 从世界快照中恢复子弹池、实体索引、时间轮、模式解释器、追踪子弹、激光池、定点子弹池与发射时间线。
+ * 传入的对象必须与生成快照时一致:快照中有某个对象时必须传入该对象,反之亦然。
+ *
+ * @param _data 由CaptureWorld生成的快照数据
+ * @param _size 快照字节数
+ * @param _pool 子弹池
+ * @param _entities 实体索引,可为nullptr
+ * @param _timer 时间轮,可为nullptr
+ * @param _runner 模式解释器,可为nullptr
+ * @param _homing 追踪子弹,可为nullptr
+ * @param _lasers 直线激光池,可为nullptr
+ * @param _fixed 定点子弹池,可为nullptr
+ * @param _timeline 发射时间线,可为nullptr;恢复后其中的Script事件被取消,需要由脚本重新登记
+ * @return 成功时返回true
+ */
+bool MADSnapshotRing::RestoreWorld(const unsigned char* _data, size_t _size, MADBulletPool& _pool,
+	MADEntityIndex* _entities, MADBulletTimer* _timer, MADPatternRunner* _runner, MADBulletHoming* _homing,
+	MADLaserPool* _lasers, MADFixedBulletPool* _fixed, MADEmitterTimeline* _timeline)
+{
+	MADBlobReader l_reader(_data, _size);
+	unsigned int l_tag = 0;
+	unsigned int l_flags = 0;
+	l_reader.Read(&l_tag);
+	l_reader.Read(&l_flags);
+	unsigned int l_expect = GetWorldFlags(_entities != nullptr, _timer != nullptr, _runner != nullptr,
+		_homing != nullptr, _lasers != nullptr, _fixed != nullptr, _timeline != nullptr);
+	if (l_reader.IsFailed() || l_tag != MAD_SNAPSHOT_WORLD_TAG || l_flags != l_expect)
+	{
+		MAD_LOG_ERR("Try to restore a world from a snapshot with different content!");
+		return false;
+	}
+	bool l_result = _pool.Restore(l_reader);
+	if (_entities != nullptr)
+	{
+		l_result = _entities->Restore(l_reader) && l_result;
+	}
+	if (_timer != nullptr)
+	{
+		l_result = _timer->Restore(l_reader) && l_result;
+	}
+	if (_runner != nullptr)
+	{
+		l_result = _runner->Restore(l_reader) && l_result;
+	}
+	if (_homing != nullptr)
+	{
+		l_result = _homing->Restore(l_reader) && l_result;
+	}
+	if (_lasers != nullptr)
+	{
+		l_result = _lasers->Restore(l_reader) && l_result;
+	}
+	if (_fixed != nullptr)
+	{
+		l_result = _fixed->Restore(l_reader) && l_result;
+	}
+	if (_timeline != nullptr)
+	{
+		l_result = _timeline->Restore(l_reader) && l_result;
+	}
+	return l_result;
+}
+
+/**
+ * (内部函数)
+ * 二分查找指定tick的快照,找不到时返回Entries.size()。
+ */
+size_t MADSnapshotRing::Find(unsigned long long _tick) const
+{
+	size_t l_low = 0;
+	size_t l_high = Entries.size();
+	while (l_low < l_high)
+	{
+		size_t l_mid = l_low + (l_high - l_low) / 2;
+		if (Entries[l_mid].Tick < _tick)
+		{
+			l_low = l_mid + 1;
+		}
+		else
+		{
+			l_high = l_mid;
+		}
+	}
+	return l_low < Entries.size() && Entries[l_low].Tick == _tick ? l_low : Entries.size();
+}
+
+/**
+ * (内部函数)
+ * 按数量与内存预算淘汰最旧的快照,至少保留最新的一份。
+ * 差分模式下每份快照只依赖比它新的快照,淘汰最旧的快照不需要重新编码。
+ */
+void MADSnapshotRing::Evict()
+{
+	while (Entries.size() > 1 && (Entries.size() > Capacity || (Budget != 0 && Memory > Budget)))
+	{
+		Memory -= Entries.front().Data.size();
+		Entries.pop_front();
+	}
+}
+
+/**
+ * 把两份数据的异或差分拆分为字节平面,再编码为(0的游程,原样字节段)序列。
+ * 较短的一份视为在末尾补0。每段以varint开头:最低位为0表示游程,为1表示之后跟随原样字节,其余位为长度。
+ * _old 传入nullptr(_old_size为0)时即为对 _new 本身的压缩。
+ *
+ * @param _old 旧数据
+ * @param _old_size 旧数据字节数
+ * @param _new 新数据
+ * @param _new_size 新数据字节数
+ * @param io_planar 字节平面的临时缓冲区,可在多次调用之间复用
+ * @param out_data 输出的差分数据,原有内容会被清空
+ */
+void MADSnapshotRing::EncodeDelta(const unsigned char* _old, size_t _old_size, const unsigned char* _new, size_t _new_size,
+	std::vector<unsigned char>& io_planar, std::vector<unsigned char>& out_data)
+{
+	/*Xor into byte planes*/
+	size_t l_size = _old_size > _new_size ? _old_size : _new_size;
+	size_t l_common = _old_size < _new_size ? _old_size : _new_size;
+	size_t l_plane[MAD_SNAPSHOT_WORD + 1];
+	GetPlaneOffsets(l_size, l_plane);
+	io_planar.resize(l_size);
+	unsigned char* l_planar = io_planar.data();
+	size_t l_words = l_common / MAD_SNAPSHOT_WORD;
+	unsigned char* l_planes[MAD_SNAPSHOT_WORD];
+	for (size_t p = 0; p < MAD_SNAPSHOT_WORD; ++p)
+	{
+		l_planes[p] = l_planar + l_plane[p];
+	}
+	SplitPlanes(_old, _new, l_words, l_planes);
+	/*The word holding the end of the shorter side,then the longer side alone*/
+	const unsigned char* l_tail = _old_size > _new_size ? _old : _new;
+	size_t l_mixed_end = (l_common + MAD_SNAPSHOT_WORD - 1) / MAD_SNAPSHOT_WORD * MAD_SNAPSHOT_WORD;
+	l_mixed_end = l_mixed_end < l_size ? l_mixed_end : l_size;
+	size_t i = l_words * MAD_SNAPSHOT_WORD;
+	for (; i < l_mixed_end; ++i)
+	{
+		unsigned char l_old = i < _old_size ? _old[i] : 0;
+		unsigned char l_new = i < _new_size ? _new[i] : 0;
+		l_planar[l_plane[i % MAD_SNAPSHOT_WORD] + i / MAD_SNAPSHOT_WORD] = l_old ^ l_new;
+	}
+	for (; i + MAD_SNAPSHOT_WORD <= l_size; i += MAD_SNAPSHOT_WORD)
+	{
+		for (size_t p = 0; p < MAD_SNAPSHOT_WORD; ++p)
+		{
+			l_planes[p][i / MAD_SNAPSHOT_WORD] = l_tail[i + p];
+		}
+	}
+	for (; i < l_size; ++i)
+	{
+		l_planar[l_plane[i % MAD_SNAPSHOT_WORD] + i / MAD_SNAPSHOT_WORD] = l_tail[i];
+	}
+
+	/*Zero runs and literal runs,scanned a word at a time*/
+	out_data.clear();
+	i = 0;
+	while (i < l_size)
+	{
+		size_t l_begin = i;
+		unsigned long long l_chunk = 0;
+		while (i + sizeof(l_chunk) <= l_size)
+		{
+			std::memcpy(&l_chunk, l_planar + i, sizeof(l_chunk));
+			if (l_chunk != 0)
+			{
+				break;
+			}
+			i += sizeof(l_chunk);
+		}
+		while (i + MAD_SNAPSHOT_WORD <= l_size && IsZeroWord(l_planar + i))
+		{
+			i += MAD_SNAPSHOT_WORD;
+		}
+		if (i + MAD_SNAPSHOT_WORD > l_size)
+		{
+			while (i < l_size && l_planar[i] == 0)
+			{
+				++i;
+			}
+		}
+		if (i > l_begin)
+		{
+			WriteVarint(out_data, static_cast<unsigned long long>(i - l_begin) << 1);
+		}
+		if (i == l_size)
+		{
+			break;
+		}
+
+		/*A literal run ends at the first zero word,the last partial word always belongs to a literal run*/
+		l_begin = i;
+		while (i + MAD_SNAPSHOT_WORD <= l_size && !IsZeroWord(l_planar + i))
+		{
+			i += MAD_SNAPSHOT_WORD;
+		}
+		if (i + MAD_SNAPSHOT_WORD > l_size)
+		{
+			i = l_size;
+		}
+		WriteVarint(out_data, (static_cast<unsigned long long>(i - l_begin) << 1) | 1ull);
+		out_data.insert(out_data.end(), l_planar + l_begin, l_planar + i);
+	}
+}
+
+/**
+ * 把EncodeDelta生成的差分作用到 io_data 上:io_data 为差分的一侧时得到另一侧,为空时得到被压缩的数据。
+ * 游程直接跳过,只有原样字节段被异或回对应的位置,因此代价与差分大小成正比。
+ *
+ * @param _delta 差分数据
+ * @param _delta_size 差分字节数
+ * @param _size 另一侧数据的字节数
+ * @param io_data 输入一侧的数据,输出另一侧的数据
+ * @return 差分数据完整时返回true
+ */
+bool MADSnapshotRing::ApplyDelta(const unsigned char* _delta, size_t _delta_size, size_t _size, std::vector<unsigned char>& io_data)
+{
+	size_t l_size = _size > io_data.size() ? _size : io_data.size();
+	size_t l_plane[MAD_SNAPSHOT_WORD + 1];
+	GetPlaneOffsets(l_size, l_plane);
+	io_data.resize(l_size, 0);
+	unsigned char* l_out = io_data.data();
+
+	const unsigned char* l_data = _delta;
+	size_t l_data_size = _delta_size;
+	size_t l_offset = 0;
+	size_t l_pos = 0;
+	size_t p = 0;
+	while (l_offset < l_data_size)
+	{
+		unsigned long long l_token = 0;
+		if (!ReadVarint(l_data, l_data_size, &l_offset, &l_token))
+		{
+			return false;
+		}
+		unsigned long long l_length = l_token >> 1;
+		if (l_length > l_size - l_pos)
+		{
+			return false;
+		}
+		if ((l_token & 1ull) == 0)
+		{
+			l_pos += static_cast<size_t>(l_length);
+			continue;
+		}
+		if (l_length > l_data_size - l_offset)
+		{
+			return false;
+		}
+
+		/*Scatter the literal bytes back,a run may cross into the next plane*/
+		size_t l_left = static_cast<size_t>(l_length);
+		while (l_left > 0)
+		{
+			while (l_pos >= l_plane[p + 1])
+			{
+				++p;
+			}
+			size_t l_count = l_plane[p + 1] - l_pos;
+			l_count = l_count < l_left ? l_count : l_left;
+			unsigned char* l_dst = l_out + (l_pos - l_plane[p]) * MAD_SNAPSHOT_WORD + p;
+			for (size_t k = 0; k < l_count; ++k)
+			{
+				l_dst[k * MAD_SNAPSHOT_WORD] ^= l_data[l_offset + k];
+			}
+			l_offset += l_count;
+			l_pos += l_count;
+			l_left -= l_count;
+		}
+	}
+	io_data.resize(_size);
+	return true;
+}
@@ -0,0 +1,113 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "../MADBullet/mad_bullet_pool.h"
+#include "../MADBullet/mad_entity_index.h"
+#include "../MADBullet/mad_bullet_timer.h"
+#include "../MADBullet/mad_bullet_homing.h"
+#include "../MADBullet/mad_laser.h"
+#include "../MADBullet/mad_fixed_pool.h"
+#include "../MADPattern/mad_emitter_timeline.h"
+
+/*Tag written at the start of a world snapshot*/
+#define MAD_SNAPSHOT_WORLD_TAG 0x444C5257u
+
+/*Default number of snapshots kept,10 seconds at 60 ticks per second*/
+#define MAD_SNAPSHOT_DEFAULT_CAPACITY 600
+
+/*Default memory budget of a snapshot ring in bytes,enough for 600 ticks of about 50k moving bullets*/
+#define MAD_SNAPSHOT_DEFAULT_BUDGET (384ull << 20)
+
+/**
+ * MADSnapshotRing 保存最近若干tick的世界快照,用于回滚(rollback)与回放中的快速后退。
+ *
+ * 快照本身由 CaptureWorld 生成:子弹池、实体索引、时间轮、模式解释器、追踪子弹、激光池、定点子弹池与发射时间线的每个连续数组都按内存映像整体复制,
+ * 不逐颗子弹序列化。MADCollisionWorld 每帧由子弹池重新Build,不需要保存,恢复后重新Build即可。
+ * 发射时间线中的Script事件(Lua函数)无法序列化,恢复后需要由脚本重新登记。
+ * MADCurvyLaser 不参与世界快照,其节点由宿主每帧追加,回滚时需要由宿主重新生成。
+ *
+ * 开启差分(默认)时,只有最新的快照保存完整数据,其余每份快照只保存与后一份快照的异或差分:
+ * - 差分按4字节字拆成4个字节平面,相邻帧之间浮点数的高位字节几乎不变,异或后成为大段的0;
+ * - 每个平面再按(0的游程,原样字节段)编码,未变化的数组(队伍、外观、句柄表等)几乎不占空间;
+ * - 丢弃最旧的快照不影响其他快照,因此总是可以按数量与内存预算从最旧的一端淘汰;
+ * - 读取第k新的快照需要从最新快照开始依次解码k个差分,回滚几帧的代价很小。
+ * 关闭差分时每份快照原样保存,读取为一次复制。
+ *
+ * 内存预算同时限制所有快照与最新完整快照的总字节数,超出时淘汰最旧的快照,但至少保留最新的一份。
+ *
+ * 注意:
+ * -快照按本机字节序与结构体布局保存,只能在同一进程或同一平台的同一版本之间使用。
+ * -该类是线程不安全的!
+ */
+class MADSnapshotRing
+{
+public:
+	MADSnapshotRing(size_t _capacity = MAD_SNAPSHOT_DEFAULT_CAPACITY,
+		size_t _budget = MAD_SNAPSHOT_DEFAULT_BUDGET, bool _delta = true);
+	~MADSnapshotRing();
+
+private:
+	typedef struct SnapshotEntry
+	{
+		unsigned long long Tick = 0;
+		size_t Size = 0;
+		std::vector<unsigned char> Data;
+	}SnapshotEntry;
+
+public:
+	/*Snapshot operator*/
+	bool Push(unsigned long long _tick, const unsigned char* _data, size_t _size);
+	bool Push(unsigned long long _tick, const std::vector<unsigned char>& _data);
+	bool Load(unsigned long long _tick, std::vector<unsigned char>& out_data) const;
+	bool Rewind(unsigned long long _tick, std::vector<unsigned char>& out_data);
+	void Clear();
+
+	/*Get Data*/
+	size_t GetNum() const;
+	size_t GetCapacity() const;
+	size_t GetMemory() const;
+	bool Has(unsigned long long _tick) const;
+	unsigned long long GetOldestTick() const;
+	unsigned long long GetNewestTick() const;
+
+	/*World*/
+	static size_t CaptureWorld(const MADBulletPool& _pool, const MADEntityIndex* _entities, const MADBulletTimer* _timer,
+		std::vector<unsigned char>& out_data, const MADPatternRunner* _runner = nullptr,
+		const MADBulletHoming* _homing = nullptr, const MADLaserPool* _lasers = nullptr,
+		const MADFixedBulletPool* _fixed = nullptr, const MADEmitterTimeline* _timeline = nullptr);
+	static bool RestoreWorld(const unsigned char* _data, size_t _size, MADBulletPool& _pool, MADEntityIndex* _entities,
+		MADBulletTimer* _timer, MADPatternRunner* _runner = nullptr, MADBulletHoming* _homing = nullptr,
+		MADLaserPool* _lasers = nullptr, MADFixedBulletPool* _fixed = nullptr, MADEmitterTimeline* _timeline = nullptr);
+
+	/*Delta coding*/
+	static void EncodeDelta(const unsigned char* _old, size_t _old_size, const unsigned char* _new, size_t _new_size,
+		std::vector<unsigned char>& io_planar, std::vector<unsigned char>& out_data);
+	static bool ApplyDelta(const unsigned char* _delta, size_t _delta_size, size_t _size, std::vector<unsigned char>& io_data);
+
+private:
+	/*Config*/
+	size_t Capacity;
+	size_t Budget;
+	bool Delta;
+
+	/*Snapshots from oldest to newest,in delta mode the newest one lives in Latest*/
+	std::deque<SnapshotEntry> Entries;
+	std::vector<unsigned char> Latest;
+	size_t Memory;
+
+	/*Scratch*/
+	std::vector<unsigned char> Planar;
+	std::vector<unsigned char> Encoded;
+
+	/*Common function*/
+	size_t Find(unsigned long long _tick) const;
+	void Evict();
+};
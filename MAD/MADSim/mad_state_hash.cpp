@@ -0,0 +1,251 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_state_hash.h"
+
+#include <cstring>
+
+/*Mixing constants (from xxHash64 / MurmurHash3)*/
+#define MAD_HASH_PRIME_1 0x9E3779B185EBCA87ull
+#define MAD_HASH_PRIME_2 0xC2B2AE3D27D4EB4Full
+#define MAD_HASH_PRIME_3 0x165667B19E3779F9ull
+
+static inline unsigned long long RotateLeft(unsigned long long _value, int _bits)
+{
+	return (_value << _bits) | (_value >> (64 - _bits));
+}
+
+static inline unsigned long long MixWord(unsigned long long _state, unsigned long long _word)
+{
+	_word *= MAD_HASH_PRIME_2;
+	_word = RotateLeft(_word, 31);
+	_word *= MAD_HASH_PRIME_1;
+	_state ^= _word;
+	return RotateLeft(_state, 27) * MAD_HASH_PRIME_1 + MAD_HASH_PRIME_3;
+}
+
+static inline unsigned int FloatBits(float _value)
+{
+	unsigned int l_bits;
+	memcpy(&l_bits, &_value, sizeof(l_bits));
+	return l_bits;
+}
+
+/**
+ * 构造一个哈希计算器。
+ *
+ * @param _seed 初始种子,不同的种子得到互不相关的哈希值
+ */
+MADStateHash::MADStateHash(unsigned long long _seed)
+{
+	Reset(_seed);
+}
+
+/**
+ * MADStateHash析构函数。
+ */
+MADStateHash::~MADStateHash()
+{
+}
+
+/**
+ * 重置哈希状态。
+ *
+ * @param _seed 初始种子
+ */
+void MADStateHash::Reset(unsigned long long _seed)
+{
+	State = _seed + MAD_HASH_PRIME_3;
+	Length = 0;
+}
+
+/**
+ * 将一段内存按字节加入哈希。
+ * 数据按8字节一组混合,尾部不足8字节的部分单独补齐后混合。
+ * 结果与调用顺序及每次调用的切分方式有关,校验双方必须以相同的方式调用。
+ *
+ * @param _data 数据指针
+ * @param _bytes 数据字节数
+ */
+void MADStateHash::Add(const void* _data, size_t _bytes)
+{
+	const unsigned char* l_ptr = static_cast<const unsigned char*>(_data);
+	size_t l_words = _bytes / 8;
+	unsigned long long l_state = State;
+	for (size_t i = 0; i < l_words; ++i)
+	{
+		unsigned long long l_word;
+		memcpy(&l_word, l_ptr + i * 8, 8);
+		l_state = MixWord(l_state, l_word);
+	}
+	size_t l_tail = _bytes - l_words * 8;
+	if (l_tail > 0)
+	{
+		unsigned long long l_word = 0;
+		for (size_t i = 0; i < l_tail; ++i)
+		{
+			l_word |= static_cast<unsigned long long>(l_ptr[l_words * 8 + i]) << (i * 8);
+		}
+		l_state = MixWord(l_state, l_word);
+	}
+	State = l_state;
+	Length += _bytes;
+}
+
+/**
+ * 将一个整数加入哈希。
+ *
+ * @param _value 整数值
+ */
+void MADStateHash::AddInteger(unsigned long long _value)
+{
+	State = MixWord(State, _value);
+	Length += 8;
+}
+
+/**
+ * 将子弹池中所有影响模拟的状态加入哈希。
+ * 包括子弹数量、各子弹的存活时间、位置、速度、TeamMask、边界处理状态、标志位与参数化运动模型(按密集索引顺序),
+ * 以及每个子弹组的变换、父组与成员区间,和LOD的策略与内部状态;外观只影响显示,不参与计算。
+ *
+ * @param _pool 子弹池
+ */
+void MADStateHash::AddPool(const MADBulletPool& _pool)
+{
+	size_t l_num = _pool.GetNum();
+	AddInteger(l_num);
+	Add(_pool.GetAliveTimeData(), l_num * sizeof(float));
+	Add(_pool.GetPositionXData(), l_num * sizeof(float));
+	Add(_pool.GetPositionYData(), l_num * sizeof(float));
+	Add(_pool.GetDirXData(), l_num * sizeof(float));
+	Add(_pool.GetDirYData(), l_num * sizeof(float));
+	Add(_pool.GetTeamMaskData(), l_num * sizeof(long long));
+	Add(_pool.GetBoundaryData(), l_num * sizeof(MADBulletBoundary));
+	Add(_pool.GetBounceLeftData(), l_num * sizeof(unsigned short));
+	Add(_pool.GetFlagsData(), l_num * sizeof(unsigned char));
+
+	/*Motion states field by field,padding bytes never reach the hash*/
+	size_t l_parametric_num = _pool.GetParametricNum();
+	const MADBulletMotionState* l_motion = _pool.GetMotionData();
+	AddInteger(l_parametric_num);
+	for (size_t i = 0; i < l_parametric_num; ++i)
+	{
+		const MADBulletMotionState& l_state = l_motion[i];
+		AddInteger((static_cast<unsigned long long>(FloatBits(l_state.StartTime)) << 32) | static_cast<unsigned int>(l_state.Type));
+		AddInteger((static_cast<unsigned long long>(FloatBits(l_state.Origin_Y)) << 32) | FloatBits(l_state.Origin_X));
+		AddInteger((static_cast<unsigned long long>(FloatBits(l_state.Velocity_Y)) << 32) | FloatBits(l_state.Velocity_X));
+		AddInteger((static_cast<unsigned long long>(FloatBits(l_state.Param[1])) << 32) | FloatBits(l_state.Param[0]));
+		AddInteger((static_cast<unsigned long long>(FloatBits(l_state.Param[3])) << 32) | FloatBits(l_state.Param[2]));
+	}
+
+	/*Groups*/
+	AddInteger(_pool.GetGroupNum());
+	for (unsigned int g = 0; g < _pool.GetGroupNum(); ++g)
+	{
+		MADBulletGroupInfo l_info;
+		size_t l_begin = 0;
+		size_t l_count = 0;
+		if (!_pool.GetGroupInfo(g, &l_info) || !_pool.GetGroupRange(g, &l_begin, &l_count))
+		{
+			AddInteger(MAD_BULLET_INVALID_INDEX);
+			continue;
+		}
+		AddInteger(_pool.GetGroupParent(g));
+		AddInteger(l_begin);
+		AddInteger(l_count);
+		AddInteger((static_cast<unsigned long long>(FloatBits(l_info.Offset.y)) << 32) | FloatBits(l_info.Offset.x));
+		AddInteger((static_cast<unsigned long long>(FloatBits(l_info.Velocity.y)) << 32) | FloatBits(l_info.Velocity.x));
+		AddInteger((static_cast<unsigned long long>(FloatBits(l_info.AngularVelocity)) << 32) | FloatBits(l_info.Rotation));
+		AddInteger(FloatBits(l_info.TimeScale));
+	}
+
+	/*Level of detail*/
+	const MADBulletLodInfo& l_lod = _pool.GetLod();
+	size_t l_lod_parametric = 0;
+	size_t l_lod_plain = 0;
+	unsigned int l_lod_counter = 0;
+	float l_lod_debt = 0.0f;
+	_pool.GetLodState(&l_lod_parametric, &l_lod_plain, &l_lod_counter, &l_lod_debt);
+	AddInteger((static_cast<unsigned long long>(FloatBits(l_lod.Min.y)) << 32) | FloatBits(l_lod.Min.x));
+	AddInteger((static_cast<unsigned long long>(FloatBits(l_lod.Max.y)) << 32) | FloatBits(l_lod.Max.x));
+	AddInteger((static_cast<unsigned long long>(l_lod_counter) << 32) | l_lod.Interval);
+	AddInteger(l_lod_parametric);
+	AddInteger(l_lod_plain);
+	AddInteger(FloatBits(l_lod_debt));
+}
+
+/**
+ * 将定点子弹池中所有影响模拟的状态加入哈希。
+ * 包括子弹数量,以及各子弹的存活tick、位置、角度、速度与TeamMask(按密集索引顺序)。
+ *
+ * @param _pool 定点子弹池
+ */
+void MADStateHash::AddPool(const MADFixedBulletPool& _pool)
+{
+	size_t l_num = _pool.GetNum();
+	AddInteger(l_num);
+	Add(_pool.GetAliveTickData(), l_num * sizeof(unsigned int));
+	Add(_pool.GetPositionXData(), l_num * sizeof(int));
+	Add(_pool.GetPositionYData(), l_num * sizeof(int));
+	Add(_pool.GetAngleData(), l_num * sizeof(unsigned short));
+	Add(_pool.GetSpeedData(), l_num * sizeof(short));
+	Add(_pool.GetTeamMaskData(), l_num * sizeof(long long));
+}
+
+/**
+ * 将实体数组的状态加入哈希。
+ * 只包括位置、检测半径与TeamMask,UserData是宿主的指针,不参与计算。
+ *
+ * @param _entities 实体数组
+ * @param _num 实体数量
+ */
+void MADStateHash::AddEntities(const MADEntity* _entities, size_t _num)
+{
+	AddInteger(_num);
+	for (size_t i = 0; i < _num; ++i)
+	{
+		AddInteger((static_cast<unsigned long long>(FloatBits(_entities[i].Position.y)) << 32) |
+			FloatBits(_entities[i].Position.x));
+		AddInteger((static_cast<unsigned long long>(FloatBits(_entities[i].TestRadius)) << 32));
+		AddInteger(static_cast<unsigned long long>(_entities[i].TeamMask));
+	}
+}
+
+/**
+ * 获取当前的哈希值,不会改变哈希状态,可以继续加入数据。
+ *
+ * @return 64位哈希值
+ */
+unsigned long long MADStateHash::Get() const
+{
+	unsigned long long l_hash = State ^ Length;
+	l_hash ^= l_hash >> 33;
+	l_hash *= MAD_HASH_PRIME_2;
+	l_hash ^= l_hash >> 29;
+	l_hash *= MAD_HASH_PRIME_3;
+	l_hash ^= l_hash >> 32;
+	return l_hash;
+}
+
+/**
+ * 计算一个tick的世界状态哈希:tick序号、子弹池与实体数组。
+ * 录制与回放时在每个tick模拟结束后调用,比较两者即可校验确定性。
+ *
+ * @param _tick tick序号
+ * @param _pool 子弹池
+ * @param _entities 实体数组,可以为nullptr
+ * @param _num 实体数量
+ * @return 世界状态哈希
+ */
+unsigned long long MADStateHash::HashWorld(unsigned long long _tick, const MADBulletPool& _pool,
+	const MADEntity* _entities, size_t _num)
+{
+	MADStateHash l_hash;
+	l_hash.AddInteger(_tick);
+	l_hash.AddPool(_pool);
+	l_hash.AddEntities(_entities, _entities != nullptr ? _num : 0);
+	return l_hash.Get();
+}
@@ -0,0 +1,45 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include "../MADBullet/mad_bullet_pool.h"
+#include "../MADBullet/mad_fixed_pool.h"
+
+/**
+ * MADStateHash 是对模拟状态逐位求值的64位流式哈希。
+ *
+ * 浮点数按其二进制位参与计算,因此任何一位的差异(包括+0与-0)都会改变结果。
+ * 回放时在同一tick对同样的数据求哈希并与录像中的记录比较,即可确认模拟是否逐位一致。
+ *
+ * 注意:
+ * -该哈希只用于校验,不具备密码学强度。
+ * -数据按小端序读取,录像只能在小端平台之间比较。
+ */
+class MADStateHash
+{
+public:
+	MADStateHash(unsigned long long _seed = 0);
+	~MADStateHash();
+
+public:
+	/*Hash operator*/
+	void Reset(unsigned long long _seed = 0);
+	void Add(const void* _data, size_t _bytes);
+	void AddInteger(unsigned long long _value);
+	void AddPool(const MADBulletPool& _pool);
+	void AddPool(const MADFixedBulletPool& _pool);
+	void AddEntities(const MADEntity* _entities, size_t _num);
+	unsigned long long Get() const;
+
+	/*Quick hash*/
+	static unsigned long long HashWorld(unsigned long long _tick, const MADBulletPool& _pool,
+		const MADEntity* _entities, size_t _num);
+
+private:
+	unsigned long long State;
+	unsigned long long Length;
+};
@@ -0,0 +1,113 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#include "mad_timestep.h"
+
+/**
+ * 构造一个固定步长时钟。
+ *
+ * @param _tick_rate 每秒的tick数,为0时按60处理
+ * @param _max_ticks_per_frame 单帧最多执行的tick数,防止卡顿后出现"死亡螺旋"
+ */
+MADFixedTimestep::MADFixedTimestep(unsigned int _tick_rate, unsigned int _max_ticks_per_frame)
+{
+	if (_tick_rate == 0)
+	{
+		MAD_LOG_WARN("Tick rate of fixed timestep is 0,use 60 instead.");
+		_tick_rate = 60;
+	}
+	TickRate = _tick_rate;
+	MaxTicksPerFrame = _max_ticks_per_frame == 0 ? 1 : _max_ticks_per_frame;
+	TickSeconds = 1.0f / static_cast<float>(_tick_rate);
+	Accumulator = 0.0;
+	Tick = 0;
+}
+
+/**
+ * MADFixedTimestep析构函数。
+ */
+MADFixedTimestep::~MADFixedTimestep()
+{
+}
+
+/**
+ * 累加一帧的真实时间,返回本帧需要执行的tick数,并推进tick计数。
+ * 超出MaxTicksPerFrame的积压时间会被丢弃(模拟变慢,但不会改变结果)。
+ *
+ * @param _frame_seconds 本帧经过的真实时间(秒)
+ * @return 本帧需要执行的tick数
+ */
+unsigned int MADFixedTimestep::Advance(double _frame_seconds)
+{
+	if (_frame_seconds > 0.0)
+	{
+		Accumulator += _frame_seconds;
+	}
+	double l_tick_seconds = 1.0 / TickRate;
+	unsigned int l_ticks = 0;
+	while (Accumulator >= l_tick_seconds && l_ticks < MaxTicksPerFrame)
+	{
+		Accumulator -= l_tick_seconds;
+		l_ticks++;
+	}
+	if (l_ticks == MaxTicksPerFrame && Accumulator >= l_tick_seconds)
+	{
+		Accumulator = 0.0;
+	}
+	Tick += l_ticks;
+	return l_ticks;
+}
+
+/**
+ * 重置时钟。
+ *
+ * @param _tick 重置后的tick计数
+ */
+void MADFixedTimestep::Reset(unsigned long long _tick)
+{
+	Accumulator = 0.0;
+	Tick = _tick;
+}
+
+/**
+ * 获取每秒的tick数。
+ *
+ * @return tick频率
+ */
+unsigned int MADFixedTimestep::GetTickRate() const
+{
+	return TickRate;
+}
+
+/**
+ * 获取每个tick的固定步长,模拟中只应使用此值作为dt。
+ *
+ * @return tick步长(秒)
+ */
+float MADFixedTimestep::GetTickSeconds() const
+{
+	return TickSeconds;
+}
+
+/**
+ * 获取已执行的tick总数。
+ *
+ * @return tick计数
+ */
+unsigned long long MADFixedTimestep::GetTick() const
+{
+	return Tick;
+}
+
+/**
+ * 获取剩余时间占一个tick的比例,仅用于渲染插值,不要参与模拟计算。
+ *
+ * @return [0, 1)之间的插值系数
+ */
+double MADFixedTimestep::GetAlpha() const
+{
+	return Accumulator * TickRate;
+}
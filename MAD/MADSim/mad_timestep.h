@@ -0,0 +1,41 @@
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                      Marisa's Atelier of Danmaku                       */
+/*                              2026/10/16                                */
+/**************************************************************************/
+
+#pragma once
+
+#include "../MADBase/mad_base.h"
+
+/**
+ * MADFixedTimestep 把可变的帧时间转换为固定步长的模拟tick。
+ *
+ * 模拟只应以GetTickSeconds()为步长推进,帧时间只决定本帧要执行多少个tick,
+ * 因此相同的输入序列总是得到相同的模拟结果,与帧率无关。
+ * 剩余的不足一个tick的时间可通过GetAlpha()用于渲染插值。
+ */
+class MADFixedTimestep
+{
+public:
+	MADFixedTimestep(unsigned int _tick_rate = 60, unsigned int _max_ticks_per_frame = 8);
+	~MADFixedTimestep();
+
+public:
+	/*Clock operator*/
+	unsigned int Advance(double _frame_seconds);
+	void Reset(unsigned long long _tick = 0);
+
+	/*Get Data*/
+	unsigned int GetTickRate() const;
+	float GetTickSeconds() const;
+	unsigned long long GetTick() const;
+	double GetAlpha() const;
+
+private:
+	unsigned int TickRate;
+	unsigned int MaxTicksPerFrame;
+	float TickSeconds;
+	double Accumulator;
+	unsigned long long Tick;
+};
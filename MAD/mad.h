@@ -13,3 +13,7 @@
 #include "MADBase/mad_base.h"
 #include "MADProtocol/mad_protocol.h"
 #include "MADLua/mad_lua.h"
+#include "MADLua/mad_hit_queue.h"
+#include "MADBullet/mad_bullet.h"
+#include "MADSim/mad_sim.h"
+#include "MADPattern/mad_pattern.h"
@@ -1,7 +1,11 @@
 #include "../MAD/mad.h"
 
 #include <iostream>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
 using namespace std;
 
 void test_err_printer(const MADString& _str) {
@@ -16,6 +20,71 @@ void test_info_printer(const MADString&  _str) {
 	cout << "[MAD_TestAPP_INFO]: " << _str << '\n';
 }
 
+void test_quiet_printer(const MADString&) {
+}
+
+void test_replay_step(MADBulletPool& _pool, MADReplayInput _input) {
+	if (_input & 1)
+		_pool.Spawn(BulletInfo(MADVector2DF(0.0f, 0.0f), MADVector2DF(static_cast<float>(_input % 97) - 48.0f, 30.0f), 1));
+	_pool.Step(1.0f / 60.0f);
+	_pool.ApplyBoundary(MADVector2DF(-100.0f, -100.0f), MADVector2DF(100.0f, 100.0f));
+}
+
+void test_world_step(MADBulletPool& _pool, MADEntityIndex& _entities, MADBulletTimer& _timer, MADPatternRunner& _runner,
+	MADBulletHoming& _homing, MADLaserPool& _lasers, MADEmitterTimeline& _timeline, unsigned int _tick) {
+	if (_tick % 10 == 0)
+		_runner.Start("ring", MADPatternStartInfo());
+	if (_tick % 7 == 0)
+	{
+		MADPatternStartInfo info;
+		info.Position = MADVector2DF(static_cast<float>(_tick), 0.0f);
+		info.Target = 0;
+		_timeline.SchedulePattern(9, "ring", info);
+		_timeline.ScheduleUser(4, _tick);
+	}
+	_timeline.Advance();
+	_runner.Step(_pool, 1.0f / 60.0f);
+	if (_tick % 3 == 0 && _pool.GetNum() > 0)
+	{
+		MADBulletHandle bullet = _pool.GetHandle(_tick % _pool.GetNum());
+		_homing.Add(bullet, MADHomingInfo(2.0f, -1.0f, _tick % 4));
+		_timer.ScheduleExpire(bullet, 20);
+	}
+	if (_tick % 11 == 0)
+		_lasers.Spawn(MADLaserInfo(MADVector2DF(static_cast<float>(_tick), 0.0f), MADVector2DF(0.0f, static_cast<float>(_tick)), 2.0f, 1));
+	_homing.Update(_pool, _entities, 1.0f / 60.0f);
+	_timer.Advance(_pool);
+	_pool.Step(1.0f / 60.0f);
+}
+
+void test_dirty_stack() {
+	volatile unsigned char dirt[16384];
+	for (size_t i = 0; i < sizeof(dirt); ++i)
+		dirt[i] = 0xAB;
+}
+
+void test_spawn_field(MADBulletPool& _pool, int _num) {
+	for (int i = 0; i < _num; ++i)
+	{
+		float angle = static_cast<float>(i) * 0.61f;
+		_pool.Spawn(BulletInfo(MADVector2DF(static_cast<float>(i * 37 % 401) - 200.0f, static_cast<float>(i * 53 % 397) - 198.0f),
+			MADVector2DF(std::cos(angle) * 90.0f, std::sin(angle) * 90.0f), 1 + i % 3));
+	}
+}
+
+bool test_hit_less(const MADCollisionHit& _a, const MADCollisionHit& _b) {
+	return _a.Entity != _b.Entity ? _a.Entity < _b.Entity : _a.Bullet < _b.Bullet;
+}
+
+template <class T>
+bool test_restore_rejects(T& _object, const std::vector<unsigned char>& _blob) {
+	std::vector<unsigned char> broken = _blob;
+	broken[0] ^= 0xFF;
+	MADBlobReader cut_reader(_blob.data(), _blob.size() / 2);
+	MADBlobReader broken_reader(broken.data(), broken.size());
+	return !_object.Restore(cut_reader) && !_object.Restore(broken_reader);
+}
+
 #define TIME_POINT_START {auto start = std::chrono::high_resolution_clock::now();
 #define TIME_POINT_END auto finish = std::chrono::high_resolution_clock::now(); std::chrono::duration<double> elapsed = finish - start; MAD_LOG_INFO("TimePoint: " + to_string(elapsed.count()) + "s");}
 
@@ -35,4 +104,821 @@ int main()
 	mad_script->SetValueUserPtr("ptr",TestBuffer);
 	mad_script->RunDirectly();
 	mad_script->CallMain();
-}
\ No newline at end of file
+
+	/*LOD testing*/
+	MADBulletPool lod_pool, ref_pool;
+	BulletInfo far_info(MADVector2DF(500.0f, 0.0f), MADVector2DF(60.0f, 0.0f), 1);
+	MADBulletHandle lod_bullet = lod_pool.Spawn(far_info);
+	MADBulletHandle ref_bullet = ref_pool.Spawn(far_info);
+	lod_pool.SetLod(MADBulletLodInfo(MADVector2DF(-100.0f, -100.0f), MADVector2DF(100.0f, 100.0f), 4));
+	for (int i = 0; i < 8; ++i)
+	{
+		lod_pool.Step(1.0f / 64.0f);
+		ref_pool.Step(1.0f / 64.0f);
+		if (i == 1)
+		{
+			ref_pool.GetInfo(ref_bullet, &far_info);
+			far_info.OriginDir = MADVector2DF(-60.0f, 0.0f);
+			lod_pool.SetInfo(lod_bullet, far_info);
+			ref_pool.SetInfo(ref_bullet, far_info);
+		}
+	}
+	BulletInfo lod_result, ref_result;
+	lod_pool.GetInfo(lod_bullet, &lod_result);
+	ref_pool.GetInfo(ref_bullet, &ref_result);
+	if (std::fabs(lod_result.OriginPos.x - ref_result.OriginPos.x) > 1e-3f || std::fabs(lod_result.AliveTime - ref_result.AliveTime) > 1e-6f)
+		MAD_LOG_ERR("LOD pool diverged from the reference pool after SetInfo!");
+
+	/*Parametric SetInfo testing*/
+	MADBulletPool motion_pool, motion_ref;
+	MADBulletMotion motion_model[2] = { MADBulletMotion(MADBulletMotionType::Sine, 20.0f, 6.0f, 0.0f),
+		MADBulletMotion(MADBulletMotionType::Spiral, 10.0f, 2.0f, 0.0f, 30.0f) };
+	MADBulletHandle motion_bullet[2];
+	for (int i = 0; i < 2; ++i)
+	{
+		motion_bullet[i] = motion_pool.Spawn(BulletInfo(MADVector2DF(), MADVector2DF(100.0f, 0.0f), 1), motion_model[i]);
+		motion_ref.Spawn(BulletInfo(MADVector2DF(), MADVector2DF(100.0f, 0.0f), 1), motion_model[i]);
+	}
+	bool motion_synced = true;
+	for (int i = 0; i < 90; ++i)
+	{
+		motion_pool.Step(1.0f / 60.0f);
+		motion_ref.Step(1.0f / 60.0f);
+		for (int k = 0; i == 29 && k < 2; ++k)
+		{
+			BulletInfo motion_info;
+			motion_pool.GetInfo(motion_bullet[k], &motion_info);
+			motion_pool.SetInfo(motion_bullet[k], motion_info);
+		}
+		MADStateHash motion_state, ref_state;
+		motion_state.AddPool(motion_pool);
+		ref_state.AddPool(motion_ref);
+		motion_synced = motion_synced && motion_state.Get() == ref_state.Get();
+	}
+	for (int k = 0; k < 2; ++k)
+	{
+		BulletInfo before_info, after_info;
+		motion_pool.GetInfo(motion_bullet[k], &before_info);
+		before_info.OriginDir = MADVector2DF(0.0f, 100.0f);
+		motion_pool.SetInfo(motion_bullet[k], before_info);
+		motion_pool.GetInfo(motion_bullet[k], &after_info);
+		motion_synced = motion_synced && std::fabs(after_info.OriginPos.x - before_info.OriginPos.x) < 1e-3f &&
+			std::fabs(after_info.OriginPos.y - before_info.OriginPos.y) < 1e-3f &&
+			std::fabs(after_info.OriginDir.x) < 1e-3f && std::fabs(after_info.OriginDir.y - 100.0f) < 1e-3f;
+	}
+	if (!motion_synced)
+		MAD_LOG_ERR("SetInfo restarted or moved a parametric bullet!");
+
+	/*Homing testing*/
+	MADBulletPool homing_pool;
+	MADEntityIndex homing_entities;
+	MADBulletHoming homing;
+	homing_entities.Insert(MADEntity(MADVector2DF(0.0f, 200.0f), 8.0f, 1));
+	MADBulletHandle homing_bullet = homing_pool.Spawn(BulletInfo(MADVector2DF(), MADVector2DF(100.0f, 0.0f), 1),
+		MADBulletMotion(MADBulletMotionType::Spiral, 10.0f, 2.0f, 0.0f, 30.0f));
+	homing.Add(homing_bullet, MADHomingInfo(3.0f));
+	BulletInfo homing_last, homing_now;
+	homing_pool.GetInfo(homing_bullet, &homing_last);
+	bool homing_continuous = true;
+	for (int i = 0; i < 120; ++i)
+	{
+		homing.Update(homing_pool, homing_entities, 1.0f / 60.0f);
+		homing_pool.GetInfo(homing_bullet, &homing_now);
+		homing_continuous = homing_continuous && std::fabs(homing_now.OriginPos.x - homing_last.OriginPos.x) < 1e-2f &&
+			std::fabs(homing_now.OriginPos.y - homing_last.OriginPos.y) < 1e-2f;
+		float homing_speed = std::sqrt(homing_now.OriginDir.x * homing_now.OriginDir.x + homing_now.OriginDir.y * homing_now.OriginDir.y);
+		homing_pool.Step(1.0f / 60.0f);
+		homing_pool.GetInfo(homing_bullet, &homing_last);
+		float homing_dx = homing_last.OriginPos.x - homing_now.OriginPos.x;
+		float homing_dy = homing_last.OriginPos.y - homing_now.OriginPos.y;
+		homing_speed = std::max(homing_speed, std::sqrt(homing_last.OriginDir.x * homing_last.OriginDir.x + homing_last.OriginDir.y * homing_last.OriginDir.y));
+		homing_continuous = homing_continuous && std::sqrt(homing_dx * homing_dx + homing_dy * homing_dy) < homing_speed / 60.0f * 1.1f + 1e-2f;
+	}
+	if (!homing_continuous)
+		MAD_LOG_ERR("Homing broke the trajectory of a parametric bullet!");
+
+	/*Timer testing*/
+	MADBulletPool timer_pool;
+	MADBulletTimer timer((1ull << 24) - 70000);
+	MADBulletHandle timer_bullet[3];
+	timer_bullet[0] = timer_pool.Spawn(BulletInfo(MADVector2DF(), MADVector2DF(100.0f, 0.0f), 1));
+	timer_bullet[1] = timer_pool.Spawn(BulletInfo(MADVector2DF(), MADVector2DF(100.0f, 0.0f), 1));
+	timer_bullet[2] = timer_pool.Spawn(BulletInfo(MADVector2DF(), MADVector2DF(100.0f, 0.0f), 1),
+		MADBulletMotion(MADBulletMotionType::Sine, 20.0f, 6.0f, 0.0f));
+	timer.Schedule(5, MADBulletEvent(timer_bullet[0], MADBulletEventType::SetDir, 10.0f, 0.0f));
+	timer.Schedule(5, MADBulletEvent(timer_bullet[0], MADBulletEventType::ScaleSpeed, 2.0f));
+	timer.Schedule(5, MADBulletEvent(timer_bullet[0], MADBulletEventType::Rotate, 1.5707963f));
+	timer.ScheduleExpire(timer_bullet[1], 5);
+	timer.Schedule(5, MADBulletEvent(timer_bullet[1], MADBulletEventType::SetDir, 0.0f, 50.0f));
+	timer.Schedule(20, MADBulletEvent(timer_bullet[2], MADBulletEventType::SetDir, 0.0f, 100.0f));
+	unsigned long long timer_delay[] = { 1, 63, 64, 65, 4095, 4096, 4097, 69999, 70000, 70001, 70100 };
+	unsigned long long timer_start = timer.GetTick();
+	for (size_t k = 0; k < sizeof(timer_delay) / sizeof(timer_delay[0]); ++k)
+	{
+		MADBulletEvent user_event(MADBulletHandle(), MADBulletEventType::User);
+		user_event.UserData = timer_start + timer_delay[k];
+		timer.Schedule(timer_delay[k], user_event);
+	}
+	std::vector<MADBulletEvent> timer_user;
+	unsigned long long timer_order = 0;
+	bool timer_synced = true;
+	for (unsigned long long tick = 1; tick <= 70100; ++tick)
+	{
+		/*A late event due on the same tick as an earlier far one must still come out after it*/
+		if (timer.GetTick() == timer_start + 69999)
+		{
+			MADBulletEvent user_event(MADBulletHandle(), MADBulletEventType::User);
+			user_event.UserData = timer_start + 70000;
+			user_event.Param[0] = 1.0f;
+			timer.Schedule(1, user_event);
+			timer_order = timer_user.size() + 1;
+		}
+		BulletInfo before_info, after_info;
+		timer_pool.GetInfo(timer_bullet[2], &before_info);
+		size_t user_num = timer_user.size();
+		timer.Advance(timer_pool, &timer_user);
+		for (size_t k = user_num; k < timer_user.size(); ++k)
+			timer_synced = timer_synced && timer_user[k].UserData == timer.GetTick();
+		if (tick == 5)
+		{
+			BulletInfo dir_info;
+			timer_synced = timer_synced && timer_pool.GetInfo(timer_bullet[0], &dir_info) && !timer_pool.IsAlive(timer_bullet[1]) &&
+				std::fabs(dir_info.OriginDir.x) < 1e-3f && std::fabs(dir_info.OriginDir.y - 20.0f) < 1e-3f;
+		}
+		if (tick == 20)
+		{
+			timer_pool.GetInfo(timer_bullet[2], &after_info);
+			timer_synced = timer_synced && std::fabs(after_info.OriginPos.x - before_info.OriginPos.x) < 1e-3f &&
+				std::fabs(after_info.OriginPos.y - before_info.OriginPos.y) < 1e-3f && std::fabs(after_info.OriginDir.y - 100.0f) < 1e-3f;
+		}
+		if (tick <= 30)
+			timer_pool.Step(1.0f / 60.0f);
+	}
+	timer_synced = timer_synced && timer.GetNum() == 0 && timer_user.size() == sizeof(timer_delay) / sizeof(timer_delay[0]) + 1 &&
+		timer_order > 0 && timer_user[timer_order].Param[0] == 1.0f && timer_user[timer_order - 1].Param[0] == 0.0f;
+	if (!timer_synced)
+		MAD_LOG_ERR("Timer events fired out of order or on the wrong tick!");
+
+	/*SIMD testing*/
+	unsigned long long simd_hash[3] = { 0, 0, 0 };
+	for (int level = 0; level < 3; ++level)
+	{
+		MADSimd::SetLevelLimit(static_cast<MADSimdLevel>(level));
+		MADBulletPool simd_pool;
+		for (int i = 0; i < 1000; ++i)
+		{
+			float angle = static_cast<float>(i) * 0.37f;
+			simd_pool.Spawn(BulletInfo(MADVector2DF(static_cast<float>(i % 41) * 3.1f, static_cast<float>(i % 29) * -2.3f),
+				MADVector2DF(std::cos(angle) * (50.0f + i % 7), std::sin(angle) * (50.0f + i % 11)), 1));
+		}
+		for (int i = 0; i < 60; ++i)
+		{
+			simd_pool.Step(1.0f / 60.0f);
+			simd_pool.ApplyBoundary(MADVector2DF(-120.0f, -120.0f), MADVector2DF(120.0f, 120.0f));
+		}
+		MADStateHash simd_state;
+		simd_state.AddPool(simd_pool);
+		simd_hash[level] = simd_state.Get();
+	}
+	MADSimd::SetLevelLimit(MADSimdLevel::AVX2);
+	if (simd_hash[1] != simd_hash[0] || simd_hash[2] != simd_hash[0])
+		MAD_LOG_ERR("SIMD integration diverged from the scalar path!");
+
+	/*Replay testing*/
+	MADReplayRecorder replay_recorder;
+	MADBulletPool record_pool;
+	replay_recorder.Begin(7, 60, 10);
+	for (unsigned int tick = 1; tick <= 300; ++tick)
+	{
+		MADReplayInput input = (tick / 4) * 2654435761u >> 20;
+		replay_recorder.Record(input);
+		test_replay_step(record_pool, input);
+		replay_recorder.RecordHash(MADStateHash::HashWorld(tick, record_pool, nullptr, 0));
+	}
+	std::vector<unsigned char> replay_data;
+	replay_recorder.Finish(replay_data);
+	MADReplayPlayer replay_player;
+	MADBulletPool play_pool;
+	MADReplayInput play_input = 0;
+	bool replay_synced = replay_player.Open(replay_data.data(), replay_data.size()) == MAD_RESCODE_OK;
+	while (replay_synced && replay_player.Next(&play_input))
+	{
+		test_replay_step(play_pool, play_input);
+		replay_synced = replay_player.CheckHash(MADStateHash::HashWorld(replay_player.GetTick(), play_pool, nullptr, 0));
+	}
+	if (!replay_synced || replay_player.GetTick() != 300 ||
+		MADStateHash::HashWorld(300, play_pool, nullptr, 0) != MADStateHash::HashWorld(300, record_pool, nullptr, 0))
+		MAD_LOG_ERR("Replay did not reproduce the recorded state!");
+
+	/*Entity index restore testing*/
+	MADEntityIndex entity_index;
+	for (int i = 0; i < 16; ++i)
+		entity_index.Insert(MADEntity(MADVector2DF(static_cast<float>(i) * 40.0f, 10.0f), 8.0f, 1));
+	std::vector<unsigned char> index_blob;
+	entity_index.Snapshot(index_blob);
+	MADEntityIndex restored_index;
+	MADBlobReader index_reader(index_blob.data(), index_blob.size());
+	if (!restored_index.Restore(index_reader) || restored_index.GetNum() != entity_index.GetNum() ||
+		restored_index.FindNearest(MADVector2DF(205.0f, 0.0f), 1) != entity_index.FindNearest(MADVector2DF(205.0f, 0.0f), 1))
+		MAD_LOG_ERR("Entity index did not restore from its own snapshot!");
+	MAD_Debugger::GetInstance().SetPrinter(PrinterType::Error, test_quiet_printer);
+	bool index_rejected = true;
+	for (size_t cut = 0; cut < index_blob.size() / 2; ++cut)
+	{
+		MADBlobReader cut_reader(index_blob.data(), cut);
+		index_rejected = !restored_index.Restore(cut_reader) && index_rejected;
+	}
+	std::vector<unsigned char> broken_index = index_blob;
+	unsigned long long broken_entity_num = 0x7FFFFFFFull;
+	std::memcpy(broken_index.data() + 8, &broken_entity_num, sizeof(broken_entity_num));
+	MADBlobReader broken_reader(broken_index.data(), broken_index.size());
+	index_rejected = !restored_index.Restore(broken_reader) && index_rejected;
+	MAD_Debugger::GetInstance().SetPrinter(PrinterType::Error, test_err_printer);
+	if (!index_rejected || restored_index.GetNum() != 0)
+		MAD_LOG_ERR("Entity index accepted a truncated or corrupted snapshot!");
+
+	/*Pattern testing*/
+	MADPatternProgram pattern_program;
+	bool pattern_synced = pattern_program.Compile(
+		"pattern fold\n fire abs (10 + 20) * 3 abs 5 / 0 + 40\n fire abs 0 abs $1 / $2\nend\n"
+		"pattern burst\n repeat 70000\n  fire abs $rand * 360 abs 10 + $loop / 1000\n end\nend\n").InfoCode == MAD_RESCODE_OK;
+	float pattern_folded[2] = { 90.0f, 40.0f };
+	const unsigned int* pattern_code = pattern_program.GetCode() + pattern_program.GetEntry(pattern_program.FindPattern("fold"));
+	for (int k = 0; pattern_synced && k < 2; ++k)
+	{
+		float folded_value = 0.0f;
+		std::memcpy(&folded_value, pattern_code + 4 + k * 3, sizeof(folded_value));
+		pattern_synced = pattern_code[3 + k * 3] == static_cast<unsigned int>(MADPatternExprOp::Const) && folded_value == pattern_folded[k] &&
+			pattern_code[5 + k * 3] == static_cast<unsigned int>(MADPatternExprOp::End);
+	}
+	MADBulletPool pattern_pool;
+	MADPatternRunner pattern_runner(&pattern_program, 3);
+	MADPatternStartInfo pattern_info;
+	pattern_info.Params[0] = 50.0f;
+	pattern_runner.Start("fold", pattern_info);
+	pattern_runner.Step(pattern_pool, 1.0f / 60.0f);
+	BulletInfo fold_info[2] = { pattern_pool.GetInfoAt(0), pattern_pool.GetInfoAt(1) };
+	pattern_synced = pattern_synced && pattern_pool.GetNum() == 2 && pattern_runner.GetNum() == 0 &&
+		std::fabs(fold_info[0].OriginDir.x) < 1e-3f && std::fabs(fold_info[0].OriginDir.y - 40.0f) < 1e-3f &&
+		fold_info[1].OriginDir.x == 0.0f && fold_info[1].OriginDir.y == 0.0f;
+	unsigned long long pattern_hash[2] = { 0, 0 };
+	for (int run = 0; run < 2; ++run)
+	{
+		MADBulletPool burst_pool;
+		MADPatternRunner burst_runner(&pattern_program, 11);
+		burst_runner.Start("burst", MADPatternStartInfo());
+		burst_runner.Step(burst_pool, 1.0f / 60.0f);
+		pattern_synced = pattern_synced && burst_runner.GetNum() == 1 && burst_pool.GetNum() > 0 && burst_pool.GetNum() < 70000;
+		for (int tick = 0; tick < 8 && burst_runner.GetNum() > 0; ++tick)
+			burst_runner.Step(burst_pool, 1.0f / 60.0f);
+		pattern_synced = pattern_synced && burst_runner.GetNum() == 0 && burst_pool.GetNum() == 70000;
+		MADStateHash burst_state;
+		burst_state.AddPool(burst_pool);
+		pattern_hash[run] = burst_state.Get();
+	}
+	if (!pattern_synced || pattern_hash[0] != pattern_hash[1])
+		MAD_LOG_ERR("Pattern folding, division or burst yielding went wrong!");
+	MADScript* runner_script = MADScript::CreateScript(
+		"MAD_PatternRunner = 1\n"
+		"function Fire() runner_handle = StartPattern('fold', 0, 0, 0, 0) end\n");
+	if (!runner_script)
+		return 1;
+	runner_script->RunDirectly();
+	MADPatternRunner* bound_runner = new MADPatternRunner(&pattern_program, 3);
+	bound_runner->BindScript(runner_script);
+	runner_script->CallFunction("Fire", MADScriptDataStream());
+	bool runner_synced = runner_script->GetValueInteger("runner_handle") != 0 && bound_runner->GetNum() == 1;
+	delete bound_runner;
+	MAD_Debugger::GetInstance().SetPrinter(PrinterType::Error, test_quiet_printer);
+	runner_script->CallFunction("Fire", MADScriptDataStream());
+	MAD_Debugger::GetInstance().SetPrinter(PrinterType::Error, test_err_printer);
+	if (!runner_synced || runner_script->GetValueInteger("runner_handle") != 0)
+		MAD_LOG_ERR("Pattern runner was still reachable from Lua after it was destroyed!");
+
+	/*World snapshot testing*/
+	MADPatternProgram world_program;
+	world_program.Compile("pattern ring\n repeat 12\n  fire seq 30 abs 80\n  wait 1\n end\nend\n");
+	MADBulletPool world_pool, rewind_pool;
+	MADEntityIndex world_entities, rewind_entities;
+	MADBulletTimer world_timer, rewind_timer;
+	MADPatternRunner world_runner(&world_program, 5), rewind_runner(&world_program, 5);
+	MADBulletHoming world_homing, rewind_homing;
+	MADLaserPool world_lasers, rewind_lasers;
+	MADEmitterTimeline world_timeline(&world_runner), rewind_timeline(&rewind_runner);
+	MADSnapshotRing snapshot_ring;
+	std::vector<unsigned char> world_blob, world_blob_30, rewind_blob;
+	world_entities.Insert(MADEntity(MADVector2DF(0.0f, 120.0f), 6.0f, 2));
+	for (unsigned int tick = 1; tick <= 60; ++tick)
+	{
+		test_world_step(world_pool, world_entities, world_timer, world_runner, world_homing, world_lasers, world_timeline, tick);
+		MADSnapshotRing::CaptureWorld(world_pool, &world_entities, &world_timer, world_blob, &world_runner, &world_homing, &world_lasers,
+			nullptr, &world_timeline);
+		snapshot_ring.Push(tick, world_blob);
+		if (tick == 30)
+			world_blob_30 = world_blob;
+	}
+	bool world_restored = snapshot_ring.Rewind(30, rewind_blob) && rewind_blob == world_blob_30 &&
+		MADSnapshotRing::RestoreWorld(rewind_blob.data(), rewind_blob.size(), rewind_pool, &rewind_entities, &rewind_timer,
+			&rewind_runner, &rewind_homing, &rewind_lasers, nullptr, &rewind_timeline) && rewind_timeline.GetNum() > 0;
+	for (unsigned int tick = 31; world_restored && tick <= 60; ++tick)
+		test_world_step(rewind_pool, rewind_entities, rewind_timer, rewind_runner, rewind_homing, rewind_lasers, rewind_timeline, tick);
+	MADSnapshotRing::CaptureWorld(rewind_pool, &rewind_entities, &rewind_timer, rewind_blob, &rewind_runner, &rewind_homing, &rewind_lasers,
+		nullptr, &rewind_timeline);
+	std::vector<unsigned char> world_timeline_blob, rewind_timeline_blob;
+	world_timeline.Snapshot(world_timeline_blob);
+	test_dirty_stack();
+	rewind_timeline.Snapshot(rewind_timeline_blob);
+	if (!world_restored || rewind_blob != world_blob || rewind_timeline_blob != world_timeline_blob)
+		MAD_LOG_ERR("World rewound from the snapshot ring diverged from the original run!");
+	MAD_Debugger::GetInstance().SetPrinter(PrinterType::Error, test_quiet_printer);
+	std::vector<unsigned char> pool_blob, runner_blob, homing_blob, lasers_blob;
+	world_pool.Snapshot(pool_blob);
+	world_runner.Snapshot(runner_blob);
+	world_homing.Snapshot(homing_blob);
+	world_lasers.Snapshot(lasers_blob);
+	bool world_rejected = test_restore_rejects(rewind_pool, pool_blob) && test_restore_rejects(rewind_runner, runner_blob) &&
+		test_restore_rejects(rewind_homing, homing_blob) && test_restore_rejects(rewind_lasers, lasers_blob);
+	MAD_Debugger::GetInstance().SetPrinter(PrinterType::Error, test_err_printer);
+	if (!world_rejected)
+		MAD_LOG_ERR("World restorers accepted a truncated or corrupted snapshot!");
+
+	/*Replay file testing*/
+	MADReplayFileWriter replay_writer;
+	MADBulletPool file_pool;
+	std::vector<unsigned char> file_world;
+	unsigned long long file_hash_170 = 0;
+	replay_writer.Open("mad_test_replay.bin", 7, 60, 50);
+	for (unsigned int tick = 1; tick <= 300; ++tick)
+	{
+		MADReplayInput input = (tick / 3) * 2654435761u >> 18;
+		if (replay_writer.NeedKeyframe())
+		{
+			MADSnapshotRing::CaptureWorld(file_pool, nullptr, nullptr, file_world);
+			replay_writer.WriteKeyframe(file_world.data(), file_world.size());
+		}
+		replay_writer.Record(input);
+		test_replay_step(file_pool, input);
+		if (tick == 170)
+			file_hash_170 = MADStateHash::HashWorld(tick, file_pool, nullptr, 0);
+	}
+	bool file_synced = replay_writer.Close() == MAD_RESCODE_OK;
+	MADReplayFile replay_file;
+	MADBulletPool seek_pool, straight_pool;
+	MADReplayInput file_input = 0;
+	unsigned long long seek_tick = 0;
+	file_synced = file_synced && replay_file.Open("mad_test_replay.bin") == MAD_RESCODE_OK &&
+		replay_file.Seek(170, file_world, &seek_tick) && seek_tick <= 170 && seek_tick + 50 > 170 &&
+		MADSnapshotRing::RestoreWorld(file_world.data(), file_world.size(), seek_pool, nullptr, nullptr);
+	while (file_synced && replay_file.GetTick() < 170 && replay_file.Next(&file_input))
+		test_replay_step(seek_pool, file_input);
+	file_synced = file_synced && replay_file.Seek(0, file_world, &seek_tick) && seek_tick == 0;
+	while (file_synced && replay_file.GetTick() < 170 && replay_file.Next(&file_input))
+		test_replay_step(straight_pool, file_input);
+	replay_file.Close();
+	std::remove("mad_test_replay.bin");
+	if (!file_synced || MADStateHash::HashWorld(170, seek_pool, nullptr, 0) != file_hash_170 ||
+		MADStateHash::HashWorld(170, straight_pool, nullptr, 0) != file_hash_170)
+		MAD_LOG_ERR("Replay file seek and fast-forward diverged from straight playback!");
+
+	/*Fixed pool testing*/
+	unsigned long long fixed_hash[3] = { 0, 0, 0 };
+	std::vector<unsigned int> fixed_hits;
+	MADFixedBulletPool fixed_pool;
+	for (int level = 0; level < 3; ++level)
+	{
+		MADSimd::SetLevelLimit(static_cast<MADSimdLevel>(level));
+		fixed_pool.Clear();
+		for (int i = 0; i < 1000; ++i)
+			fixed_pool.Spawn(MADFixedBulletInfo(MADFixed::FromFloat(static_cast<float>(i % 37) * 2.5f), MADFixed::FromFloat(static_cast<float>(i % 23) * -3.0f),
+				static_cast<unsigned short>(i * 2477), MADFixed::SpeedFromFloat(1.0f + static_cast<float>(i % 5) * 0.25f), 1 + i % 2));
+		for (int i = 0; i < 60; ++i)
+		{
+			fixed_pool.Step();
+			fixed_pool.ApplyBoundary(MADFixed::FromFloat(-120.0f), MADFixed::FromFloat(-120.0f), MADFixed::FromFloat(120.0f), MADFixed::FromFloat(120.0f));
+		}
+		MADStateHash fixed_state;
+		fixed_state.AddPool(fixed_pool);
+		fixed_state.AddInteger(fixed_pool.QueryCircle(0, 0, MADFixed::FromFloat(60.0f), 1, fixed_hits));
+		fixed_hash[level] = fixed_state.Get();
+	}
+	MADSimd::SetLevelLimit(MADSimdLevel::AVX2);
+	if (fixed_hash[1] != fixed_hash[0] || fixed_hash[2] != fixed_hash[0])
+		MAD_LOG_ERR("Fixed-point kernels diverged from the scalar path!");
+	std::vector<unsigned char> fixed_blob;
+	fixed_pool.Snapshot(fixed_blob);
+	MADFixedBulletPool restored_fixed;
+	MADBlobReader fixed_reader(fixed_blob.data(), fixed_blob.size());
+	bool fixed_restored = restored_fixed.Restore(fixed_reader);
+	MADStateHash fixed_state, restored_state;
+	fixed_state.AddPool(fixed_pool);
+	restored_state.AddPool(restored_fixed);
+	MAD_Debugger::GetInstance().SetPrinter(PrinterType::Error, test_quiet_printer);
+	fixed_restored = fixed_restored && fixed_state.Get() == restored_state.Get() && test_restore_rejects(restored_fixed, fixed_blob);
+	MAD_Debugger::GetInstance().SetPrinter(PrinterType::Error, test_err_printer);
+	if (!fixed_restored)
+		MAD_LOG_ERR("Fixed pool restore accepted a broken snapshot or lost state!");
+
+	/*Collision testing*/
+	MADBulletPool collision_pool;
+	test_spawn_field(collision_pool, 3000);
+	collision_pool.Step(1.0f / 60.0f);
+	std::vector<MADEntity> collision_entities;
+	for (int i = 0; i < 24; ++i)
+		collision_entities.push_back(MADEntity(MADVector2DF(static_cast<float>(i * 17 % 300) - 149.5f, static_cast<float>(i * 29 % 300) - 149.75f),
+			3.0f + static_cast<float>(i % 7) * 4.0f, 1 + i % 3));
+	MADCollisionWorld collision_world(16.0f, 2.0f);
+	collision_world.Build(collision_pool);
+	std::vector<MADCollisionHit> collision_hits, brute_hits;
+	collision_world.Query(collision_entities.data(), collision_entities.size(), collision_hits);
+	for (unsigned int e = 0; e < collision_entities.size(); ++e)
+	{
+		const MADEntity& entity = collision_entities[e];
+		float radius = entity.TestRadius + 2.0f;
+		for (unsigned int i = 0; i < collision_pool.GetNum(); ++i)
+		{
+			float dx = collision_pool.GetPositionXData()[i] - entity.Position.x;
+			float dy = collision_pool.GetPositionYData()[i] - entity.Position.y;
+			if ((collision_pool.GetTeamMaskData()[i] & entity.TeamMask) != 0 && dx * dx + dy * dy <= radius * radius)
+				brute_hits.push_back(MADCollisionHit(i, e));
+		}
+	}
+	std::sort(collision_hits.begin(), collision_hits.end(), test_hit_less);
+	bool collision_synced = !brute_hits.empty() && collision_hits.size() == brute_hits.size() &&
+		std::equal(collision_hits.begin(), collision_hits.end(), brute_hits.begin(),
+			[](const MADCollisionHit& _a, const MADCollisionHit& _b) { return _a.Bullet == _b.Bullet && _a.Entity == _b.Entity; });
+	if (!collision_synced)
+		MAD_LOG_ERR("Collision grid disagreed with the brute force check!");
+
+	/*Job system testing*/
+	MADJobSystem jobs(4);
+	std::vector<unsigned int> job_visits(10000, 0);
+	jobs.ParallelFor(job_visits.size() / 100, 3, [&](size_t _begin, size_t _end, size_t) {
+		for (size_t k = _begin; k < _end; ++k)
+			jobs.ParallelFor(100, 16, [&](size_t _inner_begin, size_t _inner_end, size_t) {
+				for (size_t i = _inner_begin; i < _inner_end; ++i)
+					job_visits[k * 100 + i]++;
+			});
+	});
+	bool jobs_synced = std::count(job_visits.begin(), job_visits.end(), 1u) == static_cast<long>(job_visits.size());
+	MADBulletPool serial_pool, parallel_pool;
+	test_spawn_field(serial_pool, 20000);
+	test_spawn_field(parallel_pool, 20000);
+	for (int i = 0; i < 30; ++i)
+	{
+		serial_pool.Step(1.0f / 60.0f);
+		parallel_pool.Step(1.0f / 60.0f, nullptr, &jobs);
+		serial_pool.ApplyBoundary(MADVector2DF(-220.0f, -220.0f), MADVector2DF(220.0f, 220.0f));
+		parallel_pool.ApplyBoundary(MADVector2DF(-220.0f, -220.0f), MADVector2DF(220.0f, 220.0f));
+	}
+	MADStateHash serial_state, parallel_state;
+	serial_state.AddPool(serial_pool);
+	parallel_state.AddPool(parallel_pool);
+	MADCollisionWorld serial_world(16.0f, 2.0f), parallel_world(16.0f, 2.0f);
+	serial_world.Build(serial_pool);
+	parallel_world.Build(parallel_pool, &jobs);
+	std::vector<MADCollisionHit> serial_hits, parallel_hits;
+	serial_world.Query(collision_entities.data(), collision_entities.size(), serial_hits);
+	parallel_world.Query(collision_entities.data(), collision_entities.size(), parallel_hits, &jobs);
+	jobs_synced = jobs_synced && serial_state.Get() == parallel_state.Get() && !serial_hits.empty() && serial_hits.size() == parallel_hits.size() &&
+		std::equal(serial_hits.begin(), serial_hits.end(), parallel_hits.begin(),
+			[](const MADCollisionHit& _a, const MADCollisionHit& _b) { return _a.Bullet == _b.Bullet && _a.Entity == _b.Entity; });
+	if (!jobs_synced)
+		MAD_LOG_ERR("Parallel bullet phases diverged from the single thread run!");
+
+	/*Boundary testing*/
+	MADBulletPool boundary_pool;
+	MADBulletHandle boundary_bullet[6];
+	boundary_bullet[0] = boundary_pool.Spawn(BulletInfo(MADVector2DF(95.0f, 0.0f), MADVector2DF(640.0f, 0.0f), 1));
+	boundary_bullet[1] = boundary_pool.Spawn(BulletInfo(MADVector2DF(95.0f, 10.0f), MADVector2DF(640.0f, 0.0f), 1));
+	boundary_bullet[2] = boundary_pool.Spawn(BulletInfo(MADVector2DF(0.0f, 95.0f), MADVector2DF(0.0f, 640.0f), 1));
+	boundary_bullet[3] = boundary_pool.Spawn(BulletInfo(MADVector2DF(10.0f, 95.0f), MADVector2DF(0.0f, 640.0f), 1));
+	boundary_bullet[4] = boundary_pool.Spawn(BulletInfo(MADVector2DF(-95.0f, 0.0f), MADVector2DF(-640.0f, 0.0f), 1));
+	boundary_bullet[5] = boundary_pool.Spawn(BulletInfo(MADVector2DF(-95.0f, -20.0f), MADVector2DF(-640.0f, 0.0f), 1),
+		MADBulletMotion(MADBulletMotionType::Linear));
+	boundary_pool.SetBoundary(boundary_bullet[1], MADBulletBoundary::Wrap);
+	boundary_pool.SetBoundary(boundary_bullet[2], MADBulletBoundary::Reflect, 1);
+	boundary_pool.SetBoundary(boundary_bullet[3], MADBulletBoundary::Reflect, 0);
+	boundary_pool.SetBoundary(boundary_bullet[4], MADBulletBoundary::Ignore);
+	boundary_pool.SetBoundary(boundary_bullet[5], MADBulletBoundary::Reflect, 1);
+	boundary_pool.Step(1.0f / 64.0f);
+	bool boundary_synced = boundary_pool.ApplyBoundary(MADVector2DF(-100.0f, -100.0f), MADVector2DF(100.0f, 100.0f)) == 2;
+	boundary_pool.Step(1.0f / 64.0f);
+	BulletInfo boundary_info[6];
+	for (int i = 0; i < 6; ++i)
+		boundary_synced = boundary_synced && boundary_pool.GetInfo(boundary_bullet[i], &boundary_info[i]) == (i != 0 && i != 3);
+	boundary_synced = boundary_synced && boundary_info[1].OriginPos.x == -85.0f &&
+		boundary_info[2].OriginPos.y == 85.0f && boundary_info[2].OriginDir.y == -640.0f &&
+		boundary_pool.GetBounceLeft(boundary_pool.GetIndex(boundary_bullet[2])) == 0 &&
+		boundary_info[4].OriginPos.x == -115.0f && boundary_info[5].OriginPos.x == -85.0f && boundary_info[5].OriginDir.x == 640.0f;
+	if (!boundary_synced)
+		MAD_LOG_ERR("Boundary pass killed, wrapped or reflected the wrong bullets!");
+
+	/*Flush channel testing*/
+	MADFlushChannel flush_channel;
+	MADFlushFrame flush_frame = flush_channel.Acquire();
+	bool flush_synced = flush_frame.Data == nullptr && flush_frame.Num == 0 && !flush_channel.HasNewFrame();
+	flush_channel.Publish(collision_pool, 1);
+	flush_channel.Publish(collision_pool, 2);
+	std::vector<MADBulletFlushResData> flush_ref;
+	collision_pool.Flush(flush_ref);
+	flush_frame = flush_channel.Acquire();
+	flush_synced = flush_synced && flush_frame.Tick == 2 && flush_frame.Num == flush_ref.size() && !flush_channel.HasNewFrame() &&
+		std::memcmp(flush_frame.Data, flush_ref.data(), flush_ref.size() * sizeof(MADBulletFlushResData)) == 0 &&
+		flush_channel.Acquire().Tick == 2;
+	bool flush_torn = false;
+	std::thread flush_reader([&]() {
+		unsigned long long last_tick = 2;
+		while (last_tick < 3000)
+		{
+			MADFlushFrame frame = flush_channel.Acquire();
+			if (frame.Tick < last_tick)
+				flush_torn = true;
+			if (frame.Tick == last_tick)
+				continue;
+			if (frame.Num != frame.Tick % 50 + 1)
+				flush_torn = true;
+			for (size_t i = 0; i < frame.Num; ++i)
+				flush_torn = flush_torn || frame.Data[i].Position_X != static_cast<float>(frame.Tick);
+			last_tick = frame.Tick;
+		}
+	});
+	for (unsigned long long tick = 3; tick <= 3000; ++tick)
+	{
+		size_t num = tick % 50 + 1;
+		MADBulletFlushResData* out_data = flush_channel.BeginWrite(num);
+		for (size_t i = 0; i < num; ++i)
+		{
+			out_data[i].Position_X = static_cast<float>(tick);
+			out_data[i].Position_Y = out_data[i].Dir_X = out_data[i].Dir_Y = 0.0f;
+		}
+		flush_channel.EndWrite(num, tick);
+	}
+	flush_reader.join();
+	if (!flush_synced || flush_torn)
+		MAD_LOG_ERR("Flush channel handed out a stale or torn frame!");
+
+	/*Flush layout testing*/
+	MADBulletPool pack_pool;
+	MADBulletHandle pack_bullet = pack_pool.Spawn(BulletInfo(MADVector2DF(1.0f, -2.0f), MADVector2DF(0.5f, 65520.0f), 1));
+	pack_pool.SetAppearance(pack_bullet, 7, 9);
+	unsigned short pack_half[6];
+	bool pack_synced = pack_pool.FlushTo(pack_half, 1, MADFlushLayout(MADFlushFormat::Half4, 0, true)) == 1 &&
+		pack_half[0] == 0x3C00 && pack_half[1] == 0xC000 && pack_half[2] == 0x3800 && pack_half[3] == 0x7C00 &&
+		pack_half[4] == 7 && pack_half[5] == 9;
+	MAD_Debugger::GetInstance().SetPrinter(PrinterType::Error, test_quiet_printer);
+	pack_synced = pack_synced && pack_pool.FlushTo(pack_half, 1, MADFlushLayout(MADFlushFormat::Float4, 8)) == 0;
+	MAD_Debugger::GetInstance().SetPrinter(PrinterType::Error, test_err_printer);
+	std::vector<MADBulletFlushResData> pack_ref;
+	collision_pool.Flush(pack_ref);
+	std::vector<unsigned char> pack_buffer[3];
+	for (int level = 0; level < 3; ++level)
+	{
+		MADSimd::SetLevelLimit(static_cast<MADSimdLevel>(level));
+		pack_buffer[level].assign(pack_ref.size() * 32, 0xAB);
+		pack_synced = pack_synced && collision_pool.FlushTo(pack_buffer[level].data(), pack_ref.size(),
+			MADFlushLayout(MADFlushFormat::Float4, 32), level == 2 ? &jobs : nullptr) == pack_ref.size();
+	}
+	MADSimd::SetLevelLimit(MADSimdLevel::AVX2);
+	for (size_t i = 0; pack_synced && i < pack_ref.size(); ++i)
+		pack_synced = std::memcmp(pack_buffer[0].data() + i * 32, &pack_ref[i], 16) == 0 &&
+			pack_buffer[0][i * 32 + 16] == 0xAB && pack_buffer[0][i * 32 + 31] == 0xAB;
+	pack_synced = pack_synced && collision_pool.FlushTo(pack_buffer[0].data(), 10, MADFlushLayout(MADFlushFormat::Float4, 32)) == 10 &&
+		pack_buffer[1] == pack_buffer[0] && pack_buffer[2] == pack_buffer[0];
+	if (!pack_synced)
+		MAD_LOG_ERR("Strided flush wrote the wrong bytes or touched the padding!");
+
+	/*Swept collision testing*/
+	MADBulletPool swept_pool;
+	swept_pool.Spawn(BulletInfo(MADVector2DF(-100.0f, 0.0f), MADVector2DF(12000.0f, 0.0f), 1));
+	swept_pool.Spawn(BulletInfo(MADVector2DF(-50.0f, 0.0f), MADVector2DF(12000.0f, 0.0f), 1));
+	swept_pool.Spawn(BulletInfo(MADVector2DF(-100.0f, 10.0f), MADVector2DF(12000.0f, 0.0f), 1));
+	swept_pool.Step(1.0f / 60.0f);
+	MADEntity swept_entities[2] = { MADEntity(MADVector2DF(0.0f, 0.0f), 2.0f, 1), MADEntity(MADVector2DF(50.0f, 0.0f), 2.0f, 1) };
+	MADCollisionWorld swept_world(16.0f, 1.0f);
+	swept_world.Build(swept_pool);
+	std::vector<MADCollisionHit> swept_discrete;
+	std::vector<MADSweptHit> swept_hits;
+	swept_world.Query(swept_entities, 2, swept_discrete);
+	swept_world.QuerySwept(swept_entities, 2, 1.0f / 60.0f, swept_hits);
+	MADSweptHit swept_expect[4] = { MADSweptHit(1, 0, 0.235f), MADSweptHit(0, 0, 0.485f), MADSweptHit(1, 1, 0.485f), MADSweptHit(0, 1, 0.735f) };
+	bool swept_synced = swept_discrete.empty() && swept_hits.size() == 4;
+	for (size_t k = 0; swept_synced && k < 4; ++k)
+		swept_synced = swept_hits[k].Bullet == swept_expect[k].Bullet && swept_hits[k].Entity == swept_expect[k].Entity &&
+			std::fabs(swept_hits[k].Time - swept_expect[k].Time) < 1e-3f;
+	if (!swept_synced)
+		MAD_LOG_ERR("Swept collision missed a fast bullet or ordered its hits wrongly!");
+
+	/*Group testing*/
+	MADBulletPool group_pool;
+	unsigned int group_parent = group_pool.CreateGroup(MADBulletGroupInfo(MADVector2DF(100.0f, 0.0f), 0.0f, MADVector2DF(), 1.5707963f));
+	unsigned int group_child = group_pool.CreateGroup(MADBulletGroupInfo(MADVector2DF(10.0f, 0.0f), 0.0f, MADVector2DF(), 0.0f, 0.5f), group_parent);
+	unsigned int group_moving = group_pool.CreateGroup(MADBulletGroupInfo(MADVector2DF(), 0.0f, MADVector2DF(30.0f, 0.0f)));
+	MADBulletHandle group_member = group_pool.SpawnInGroup(group_child, BulletInfo(MADVector2DF(5.0f, 0.0f), MADVector2DF(), 1));
+	MADBulletHandle group_mover = group_pool.SpawnInGroup(group_moving, BulletInfo(MADVector2DF(), MADVector2DF(0.0f, 60.0f), 1));
+	group_pool.Spawn(BulletInfo(MADVector2DF(), MADVector2DF(1.0f, 0.0f), 1));
+	for (int i = 0; i < 60; ++i)
+		group_pool.Step(1.0f / 60.0f);
+	BulletInfo member_info, mover_info, frozen_info;
+	bool group_synced = group_pool.GetInfo(group_member, &member_info) && group_pool.GetInfo(group_mover, &mover_info) &&
+		std::fabs(member_info.OriginPos.x - 100.0f) < 1e-3f && std::fabs(member_info.OriginPos.y - 15.0f) < 1e-3f &&
+		std::fabs(member_info.AliveTime - 0.5f) < 1e-4f &&
+		std::fabs(mover_info.OriginPos.x - 30.0f) < 1e-3f && std::fabs(mover_info.OriginPos.y - 60.0f) < 1e-3f;
+	group_pool.SetGroupTimeScale(group_parent, 0.0f);
+	for (int i = 0; i < 60; ++i)
+		group_pool.Step(1.0f / 60.0f);
+	group_pool.GetInfo(group_member, &frozen_info);
+	group_synced = group_synced && frozen_info.OriginPos.x == member_info.OriginPos.x && frozen_info.OriginPos.y == member_info.OriginPos.y &&
+		frozen_info.AliveTime == member_info.AliveTime && group_pool.GetGroupParent(group_child) == group_parent;
+	if (!group_synced)
+		MAD_LOG_ERR("Bullet groups composed their transforms or time scales wrongly!");
+
+	/*Team bucket testing*/
+	MADBulletPool team_pool;
+	long long team_masks[4] = { 1, 2, 4, 3 };
+	for (int i = 0; i < 400; ++i)
+		team_pool.Spawn(BulletInfo(MADVector2DF(static_cast<float>(i % 20) * 10.0f - 95.0f, static_cast<float>(i / 20) * 10.0f - 95.0f),
+			MADVector2DF(), team_masks[i % 4]));
+	MADCollisionWorld team_world(16.0f, 0.0f);
+	team_world.Build(team_pool);
+	MADEntity team_entities[3] = { MADEntity(MADVector2DF(), 1000.0f, 4), MADEntity(MADVector2DF(), 1000.0f, 2), MADEntity(MADVector2DF(), 1000.0f, 8) };
+	std::vector<MADCollisionHit> team_hits;
+	team_world.Query(team_entities, 3, team_hits);
+	size_t team_count[3] = { 0, 0, 0 };
+	bool team_synced = team_world.GetBucketNum() == 4 && team_world.GetBulletNum() == 400;
+	for (size_t k = 0; k < team_hits.size(); ++k)
+	{
+		team_count[team_hits[k].Entity]++;
+		team_synced = team_synced && (team_pool.GetTeamMaskData()[team_hits[k].Bullet] & team_entities[team_hits[k].Entity].TeamMask) != 0;
+	}
+	team_synced = team_synced && team_count[0] == 100 && team_count[1] == 200 && team_count[2] == 0;
+	if (!team_synced)
+		MAD_LOG_ERR("Team buckets returned bullets of the wrong team!");
+
+	/*Graze testing*/
+	MADBulletPool graze_pool;
+	float graze_x[4] = { 2.0f, 8.0f, 12.5f, 20.0f };
+	MADBulletHandle graze_bullet[4];
+	for (int i = 0; i < 4; ++i)
+		graze_bullet[i] = graze_pool.Spawn(BulletInfo(MADVector2DF(graze_x[i], 0.0f), MADVector2DF(), 1));
+	MADEntity graze_entity(MADVector2DF(), 2.0f, 1);
+	MADCollisionWorld graze_world(16.0f, 1.0f);
+	std::vector<MADCollisionHit> graze_hits, grazes;
+	graze_world.Build(graze_pool);
+	bool graze_synced = graze_world.QueryGraze(&graze_entity, 1, 10.0f, graze_pool, graze_hits, grazes) == 2 &&
+		graze_hits.size() == 1 && graze_hits[0].Bullet == 0 && grazes[0].Bullet == 1 && grazes[1].Bullet == 2 &&
+		!graze_pool.IsGrazed(0) && graze_pool.IsGrazed(1) && graze_pool.IsGrazed(2) && !graze_pool.IsGrazed(3);
+	graze_hits.clear();
+	grazes.clear();
+	graze_world.Build(graze_pool);
+	graze_synced = graze_synced && graze_world.QueryGraze(&graze_entity, 1, 10.0f, graze_pool, graze_hits, grazes) == 0 && graze_hits.size() == 1;
+	graze_pool.SetGrazed(graze_bullet[2], false);
+	graze_world.Build(graze_pool);
+	graze_synced = graze_synced && graze_world.QueryGraze(&graze_entity, 1, 10.0f, graze_pool, graze_hits, grazes) == 1 && grazes[0].Bullet == 2;
+	if (!graze_synced)
+		MAD_LOG_ERR("Graze query counted a bullet twice or missed a near miss!");
+
+	/*Laser testing*/
+	MADLaserPool laser_pool;
+	MADBulletHandle laser_handle = laser_pool.Spawn(MADLaserInfo(MADVector2DF(0.0f, 0.0f), MADVector2DF(100.0f, 0.0f), 2.0f, 1));
+	laser_pool.Spawn(MADLaserInfo(MADVector2DF(0.0f, 10.0f), MADVector2DF(100.0f, 10.0f), 2.0f, 2));
+	laser_pool.Spawn(MADLaserInfo(MADVector2DF(0.0f, 20.0f), MADVector2DF(100.0f, 20.0f), 1.0f, 1));
+	MADEntity laser_entities[5] = { MADEntity(MADVector2DF(50.0f, 3.0f), 2.0f, 1), MADEntity(MADVector2DF(50.0f, 7.0f), 2.0f, 1),
+		MADEntity(MADVector2DF(105.0f, 0.0f), 2.0f, 1), MADEntity(MADVector2DF(103.0f, 0.0f), 2.0f, 1), MADEntity(MADVector2DF(50.0f, 21.0f), 1.0f, 1) };
+	std::vector<MADLaserHit> laser_hits;
+	std::vector<MADLaserVertex> laser_vertices;
+	bool laser_synced = laser_pool.Query(laser_entities, 5, laser_hits) == 3 &&
+		laser_hits[0].Laser == 0 && laser_hits[0].Entity == 0 && laser_hits[1].Laser == 0 && laser_hits[1].Entity == 3 &&
+		laser_hits[2].Laser == 2 && laser_hits[2].Entity == 4 && laser_pool.Flush(laser_vertices) == 12;
+	laser_hits.clear();
+	laser_synced = laser_synced && laser_pool.Kill(laser_handle) && !laser_pool.IsAlive(laser_handle) &&
+		laser_pool.Query(laser_entities, 5, laser_hits) == 1 && laser_hits[0].Laser == 0 && laser_hits[0].Entity == 4;
+	MADCurvyLaser curvy_laser(4, 1.0f, 1);
+	for (int i = 0; i < 5; ++i)
+		curvy_laser.PushNode(MADVector2DF(static_cast<float>(i * 10), 0.0f));
+	MADEntity curvy_entities[3] = { MADEntity(MADVector2DF(2.0f, 0.0f), 0.5f, 1), MADEntity(MADVector2DF(25.0f, 0.0f), 0.5f, 1),
+		MADEntity(MADVector2DF(12.0f, 1.0f), 0.5f, 1) };
+	laser_hits.clear();
+	laser_synced = laser_synced && curvy_laser.GetNodeNum() == 4 && curvy_laser.Query(curvy_entities, 3, 7, laser_hits) == 2 &&
+		laser_hits[0].Laser == 7 && laser_hits[0].Entity == 1 && laser_hits[0].Segment == 1 &&
+		laser_hits[1].Entity == 2 && laser_hits[1].Segment == 0;
+	if (!laser_synced)
+		MAD_LOG_ERR("Laser query missed a capsule or ignored the team mask!");
+
+	/*Cancel testing*/
+	MADBulletPool cancel_pool;
+	MADBulletHandle cancel_bullet[10];
+	for (int i = 0; i < 10; ++i)
+		cancel_bullet[i] = cancel_pool.Spawn(BulletInfo(MADVector2DF(static_cast<float>(i), 0.0f), MADVector2DF(), (i % 2 == 0) ? 1 : 2));
+	unsigned int cancel_group = cancel_pool.CreateGroup(MADBulletGroupInfo(MADVector2DF(100.0f, 0.0f)));
+	cancel_pool.SpawnInGroup(cancel_group, BulletInfo(MADVector2DF(1.0f, 0.0f), MADVector2DF(), 4));
+	cancel_pool.SpawnInGroup(cancel_group, BulletInfo(MADVector2DF(2.0f, 0.0f), MADVector2DF(), 4));
+	std::vector<MADVector2DF> cancel_pos;
+	bool cancel_synced = cancel_pool.CancelCircle(MADVector2DF(), 2.5f, -1, cancel_pos) == 3 && cancel_pos.size() == 3 &&
+		cancel_pos[0].x == 0.0f && cancel_pos[1].x == 1.0f && cancel_pos[2].x == 2.0f;
+	cancel_synced = cancel_synced && cancel_pool.CancelRect(MADVector2DF(3.0f, -1.0f), MADVector2DF(6.0f, 1.0f), 2, cancel_pos) == 2 &&
+		cancel_pos.size() == 2 && cancel_pos[0].x == 3.0f && cancel_pos[1].x == 5.0f;
+	cancel_synced = cancel_synced && cancel_pool.CancelTeam(1, cancel_pos) == 3 &&
+		cancel_pos[0].x == 4.0f && cancel_pos[1].x == 6.0f && cancel_pos[2].x == 8.0f;
+	cancel_synced = cancel_synced && cancel_pool.CancelGroup(cancel_group, cancel_pos) == 2 &&
+		cancel_pos[0].x == 101.0f && cancel_pos[1].x == 102.0f && cancel_pool.IsGroupAlive(cancel_group) &&
+		cancel_pool.GetNum() == 2 && cancel_pool.IsAlive(cancel_bullet[7]) && cancel_pool.IsAlive(cancel_bullet[9]);
+	if (!cancel_synced)
+		MAD_LOG_ERR("Cancel removed the wrong bullets or reported them out of order!");
+
+	/*Hit queue testing*/
+	MADScript* hit_script = MADScript::CreateScript(
+		"hit_num = 0 hit_team = 0 hit_entity = 0 hit_first = 0 hit_stale = 0\n"
+		"function OnHits(events, n)\n"
+		"  hit_num = hit_num + n + #events * 100\n"
+		"  for i = 1, n do\n"
+		"    local bullet, entity, team = events:Get(i)\n"
+		"    hit_team = hit_team + team\n"
+		"    if entity == target and events:Entity(i) == entity then hit_entity = hit_entity + 1 end\n"
+		"  end\n"
+		"  hit_first = events:Bullet(1)\n"
+		"  if events:Get(n + 1) == nil then hit_stale = 1 end\n"
+		"  saved_events = events\n"
+		"end\n"
+		"function CheckStale() if saved_events:Get(1) == nil then hit_stale = hit_stale + 10 end end\n");
+	if (!hit_script)
+		return 1;
+	hit_script->RunDirectly();
+	void* hit_target = nullptr;
+	hit_script->SetValueUserPtr("target", &hit_target);
+	MADBulletPool hit_pool;
+	hit_pool.Spawn(BulletInfo(MADVector2DF(50.0f, 0.0f), MADVector2DF(), 1));
+	MADBulletHandle hit_first = hit_pool.Spawn(BulletInfo(MADVector2DF(1.0f, 0.0f), MADVector2DF(), 2));
+	hit_pool.Spawn(BulletInfo(MADVector2DF(-1.0f, 0.0f), MADVector2DF(), 4));
+	MADEntity hit_entity(MADVector2DF(), 3.0f, 7);
+	hit_entity.UserData = &hit_target;
+	MADCollisionWorld hit_world(16.0f, 0.0f);
+	std::vector<MADCollisionHit> hit_hits;
+	hit_world.Build(hit_pool);
+	hit_world.Query(&hit_entity, 1, hit_hits);
+	MADHitQueue hit_queue;
+	bool hit_synced = hit_queue.PushHits(hit_pool, &hit_entity, hit_hits) == 2 && hit_queue.GetNum() == 2 &&
+		hit_queue.BindScript(hit_script, "OnHits") && hit_queue.Deliver() == MAD_RESCODE_OK && hit_queue.Is_Empty();
+	hit_script->CallFunction("CheckStale", MADScriptDataStream());
+	hit_synced = hit_synced && hit_script->GetValueInteger("hit_num") == 202 && hit_script->GetValueInteger("hit_team") == 6 &&
+		hit_script->GetValueInteger("hit_entity") == 2 && hit_script->GetValueInteger("hit_first") == MADHitQueue::PackHandle(hit_first) &&
+		hit_script->GetValueInteger("hit_stale") == 11 && hit_queue.Deliver() == MAD_RESCODE_OK &&
+		hit_script->GetValueInteger("hit_num") == 202;
+	hit_queue.Unbind();
+	if (!hit_synced)
+		MAD_LOG_ERR("Hit queue delivered the wrong events to the script!");
+
+	/*Emitter timeline testing*/
+	MADPatternRunner timeline_runner(&pattern_program, 5), restored_runner(&pattern_program, 5);
+	MADEmitterTimeline timeline(&timeline_runner), restored_timeline(&restored_runner);
+	timeline.ScheduleUser(5, 1);
+	timeline.ScheduleUser(3, 2);
+	timeline.ScheduleUser(3, 3);
+	MADTimelineHandle timeline_cancelled = timeline.ScheduleUser(4, 4);
+	timeline.SchedulePattern(2, "fold", MADPatternStartInfo());
+	bool timeline_synced = timeline.Cancel(timeline_cancelled) && !timeline.Cancel(timeline_cancelled) &&
+		!timeline.IsPending(timeline_cancelled) && timeline.GetNum() == 4;
+	std::vector<unsigned char> timeline_blob;
+	timeline.Snapshot(timeline_blob);
+	MADBlobReader timeline_reader(timeline_blob.data(), timeline_blob.size());
+	timeline_synced = timeline_synced && restored_timeline.Restore(timeline_reader) && restored_timeline.GetNum() == 4;
+	MADScript* timeline_script = MADScript::CreateScript(
+		"timeline_calls = 0\n"
+		"function Arm() ScheduleCall(4, function() timeline_calls = timeline_calls * 10 + 1 end) end\n");
+	if (!timeline_script)
+		return 1;
+	timeline_script->RunDirectly();
+	timeline.BindScript(timeline_script);
+	timeline_script->CallFunction("Arm", MADScriptDataStream());
+	size_t timeline_fired[5] = { 0, 1, 2, 1, 1 };
+	std::vector<unsigned long long> timeline_user, restored_user;
+	for (int tick = 0; tick < 5; ++tick)
+	{
+		size_t fired = timeline.Advance(&timeline_user);
+		size_t restored_fired = restored_timeline.Advance(&restored_user);
+		timeline_synced = timeline_synced && fired == timeline_fired[tick] &&
+			restored_fired + ((tick == 3) ? 1 : 0) == fired && timeline.GetTick() == static_cast<unsigned long long>(tick + 1);
+		if (tick == 1)
+			timeline_synced = timeline_synced && timeline_runner.GetNum() == 1 && restored_runner.GetNum() == 1;
+	}
+	timeline_synced = timeline_synced && timeline.GetNum() == 0 && timeline_user.size() == 3 &&
+		timeline_user[0] == 2 && timeline_user[1] == 3 && timeline_user[2] == 1 && restored_user == timeline_user &&
+		timeline_script->GetValueInteger("timeline_calls") == 1;
+	if (!timeline_synced)
+		MAD_LOG_ERR("Emitter timeline fired events at the wrong tick or out of order!");
+	MADScript* dropped_script = MADScript::CreateScript(
+		"MAD_EmitterTimeline = 1\n"
+		"function Arm() dropped_handle = ScheduleCall(1, function() end) end\n");
+	if (!dropped_script)
+		return 1;
+	dropped_script->RunDirectly();
+	MADEmitterTimeline* dropped_timeline = new MADEmitterTimeline(nullptr);
+	dropped_timeline->BindScript(dropped_script);
+	dropped_script->CallFunction("Arm", MADScriptDataStream());
+	bool dropped_synced = dropped_script->GetValueInteger("dropped_handle") != 0 && dropped_timeline->GetNum() == 1;
+	delete dropped_timeline;
+	MAD_Debugger::GetInstance().SetPrinter(PrinterType::Error, test_quiet_printer);
+	dropped_script->CallFunction("Arm", MADScriptDataStream());
+	MAD_Debugger::GetInstance().SetPrinter(PrinterType::Error, test_err_printer);
+	if (!dropped_synced || dropped_script->GetValueInteger("dropped_handle") != 0)
+		MAD_LOG_ERR("Emitter timeline was still reachable from Lua after it was destroyed!");
+}